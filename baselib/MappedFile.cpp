@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A read-only memory mapping of an entire file on disk
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "MappedFile.h"
+
+#if _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Creates a file mapping object with no file mapped
+//------------------------------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile() noexcept
+    : mpData(nullptr)
+    , mSize(0)
+    , mpMapHandle(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Moves the mapping from one object to another
+//------------------------------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : mpData(other.mpData)
+    , mSize(other.mSize)
+    , mpMapHandle(other.mpMapHandle)
+{
+    other.mpData = nullptr;
+    other.mSize = 0;
+    other.mpMapHandle = nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Unmaps the file, if mapped
+//------------------------------------------------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile() noexcept {
+    close();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Maps the entire contents of the specified file into memory for reading, returning 'false' on failure.
+// Note: any previously mapped file is unmapped first.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool MappedFile::open(const char* const filePath) noexcept {
+    close();
+
+    #if _WIN32
+        const HANDLE hFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize = {};
+        const bool bGotSize = GetFileSizeEx(hFile, &fileSize);
+
+        // Note: the file handle is not needed after creating the mapping, the mapping keeps the file open
+        const HANDLE hMapping = (bGotSize && (fileSize.QuadPart > 0)) ? CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        CloseHandle(hFile);
+
+        if (!hMapping)
+            return false;
+
+        const void* const pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (!pData) {
+            CloseHandle(hMapping);
+            return false;
+        }
+
+        mpData = (const std::byte*) pData;
+        mSize = (size_t) fileSize.QuadPart;
+        mpMapHandle = hMapping;
+    #else
+        const int fd = ::open(filePath, O_RDONLY);
+
+        if (fd < 0)
+            return false;
+
+        // Note: the file descriptor is not needed after mapping, the mapping keeps the file open
+        struct stat fileStat = {};
+        const bool bGotSize = (fstat(fd, &fileStat) == 0);
+        void* const pData = (bGotSize && (fileStat.st_size > 0)) ? mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+
+        if (pData == MAP_FAILED)
+            return false;
+
+        mpData = (const std::byte*) pData;
+        mSize = (size_t) fileStat.st_size;
+    #endif
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Unmaps the currently mapped file, if any
+//------------------------------------------------------------------------------------------------------------------------------------------
+void MappedFile::close() noexcept {
+    if (!mpData)
+        return;
+
+    #if _WIN32
+        UnmapViewOfFile(mpData);
+        CloseHandle((HANDLE) mpMapHandle);
+    #else
+        munmap((void*) mpData, mSize);
+    #endif
+
+    mpData = nullptr;
+    mSize = 0;
+    mpMapHandle = nullptr;
+}
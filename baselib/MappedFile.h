@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstddef>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A read-only memory mapping of an entire file on disk.
+// The file contents can be accessed directly through the mapping, with the OS paging in data on demand and sharing it with the file cache.
+// Memory mapping may not be possible in all cases (e.g empty files) so callers should be prepared to fall back to regular file I/O.
+//------------------------------------------------------------------------------------------------------------------------------------------
+class MappedFile {
+public:
+    MappedFile() noexcept;
+    MappedFile(MappedFile&& other) noexcept;
+    ~MappedFile() noexcept;
+
+    bool open(const char* const filePath) noexcept;
+    void close() noexcept;
+
+    inline bool isOpen() const noexcept { return (mpData != nullptr); }
+    inline const std::byte* getData() const noexcept { return mpData; }
+    inline size_t getSize() const noexcept { return mSize; }
+
+private:
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator = (const MappedFile& other) = delete;
+    MappedFile& operator = (MappedFile&& other) = delete;
+
+    const std::byte*    mpData;         // Start of the mapped file data or 'nullptr' if nothing is mapped
+    size_t              mSize;          // Size of the mapped file data in bytes
+    void*               mpMapHandle;    // Windows only: the handle to the file mapping object
+};
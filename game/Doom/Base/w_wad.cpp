@@ -9,6 +9,7 @@
 #include "Doom/cdmaptbl.h"
 #include "i_main.h"
 #include "PsyDoom/Game.h"
+#include "PsyDoom/MapLumpPipeline.h"
 #include "PsyDoom/ModMgr.h"
 #include "PsyDoom/WadList.h"
 
@@ -147,6 +148,7 @@ void W_OpenMapWad(const CdFileId fileId) noexcept {
 // Closes the currently open map WAD, if any
 //------------------------------------------------------------------------------------------------------------------------------------------
 void W_CloseMapWad() noexcept {
+    MapLumpPipeline::finish();
     gMapWad.close();
 }
 
@@ -185,9 +187,29 @@ int32_t W_MapLumpLength(const int32_t lumpIdx) noexcept {
 // The buffer must be big enough to accomodate the data. Optionally, decompression can be disabled.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void W_ReadMapLump(const int32_t lumpIdx, void* const pDest, const bool bDecompress) noexcept {
+    // Use the map lump pipeline if it has the lump, otherwise make sure it's done with the WAD before reading directly
+    if (MapLumpPipeline::readLump(lumpIdx, pDest, bDecompress))
+        return;
+
+    MapLumpPipeline::waitForIo();
     gMapWad.readLump(lumpIdx, pDest, bDecompress);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Starts reading and decompressing the specified map lumps in the background, in the order given.
+// While this is running 'W_ReadMapLump' will take the lumps from the background pipeline; see 'MapLumpPipeline' for more details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void W_MapStartLumpPipeline(const int32_t* const pLumpIdxs, const int32_t numLumps) noexcept {
+    MapLumpPipeline::start(gMapWad, pLumpIdxs, numLumps);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Waits for the background map lump pipeline to finish and frees up it's resources
+//------------------------------------------------------------------------------------------------------------------------------------------
+void W_MapFinishLumpPipeline() noexcept {
+    MapLumpPipeline::finish();
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // These functions have been relocated to the new WAD handling code.
 // Keeping these calls here however so previous code using them can still work without changes.
@@ -41,6 +41,8 @@ int32_t W_MapCheckNumForName(const WadLumpName lumpName) noexcept;
 int32_t W_MapGetNumForName(const WadLumpName lumpName) noexcept;
 int32_t W_MapLumpLength(const int32_t lumpIdx) noexcept;
 void W_ReadMapLump(const int32_t lumpIdx, void* const pDest, const bool bDecompress) noexcept;
+void W_MapStartLumpPipeline(const int32_t* const pLumpIdxs, const int32_t numLumps) noexcept;
+void W_MapFinishLumpPipeline() noexcept;
 void decode(const void* pSrc, void* pDst) noexcept;
 uint32_t getDecodedSize(const void* const pSrc) noexcept;
 
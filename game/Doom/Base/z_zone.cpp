@@ -4,7 +4,9 @@
 #include "EngineLimits.h"
 #include "i_main.h"
 #include "PsyDoom/Config/Config.h"
+#include "PsyDoom/ZoneTrace.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 
@@ -20,6 +22,83 @@ static std::unique_ptr<std::byte[]> gZoneHeap;
 // The main (and only) memory zone used by PSX DOOM
 memzone_t* gpMainMemZone;
 
+#if PSYDOOM_LIMIT_REMOVING
+    // Id given to free blocks which are in one of the zone's free lists, and the minimum block size needed to be in one
+    static constexpr int16_t FREELISTID = 0x1D4B;
+    static constexpr int32_t MIN_FREELIST_BLOCK_SIZE = (int32_t) sizeof(memblock_t);
+#endif
+
+static void Z_FreeBlock(memzone_t& zone, void* const ptr) noexcept;
+
+#if PSYDOOM_LIMIT_REMOVING
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom limit removing: adds the specified free block to the free list for it's size, if it is within the size range for free lists
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void Z_AddToFreeList(memzone_t& zone, memblock_t& block) noexcept {
+    if ((block.size < MIN_FREELIST_BLOCK_SIZE) || (block.size > Z_MAX_FREELIST_BLOCK_SIZE))
+        return;
+
+    memblock_t*& pListHead = zone.freelists[block.size / Z_FREELIST_GRANULARITY];
+    block.freeNext = pListHead;
+    block.freePrev = nullptr;
+
+    if (pListHead) {
+        pListHead->freePrev = &block;
+    }
+
+    pListHead = &block;
+    block.id = FREELISTID;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom limit removing: removes the specified block from the free list it is in, if any.
+// This must be done whenever a listed free block is allocated, resized or merged into another block.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void Z_RemoveFromFreeList(memzone_t& zone, memblock_t& block) noexcept {
+    if (block.id != FREELISTID)
+        return;
+
+    if (block.freePrev) {
+        block.freePrev->freeNext = block.freeNext;
+    } else {
+        zone.freelists[block.size / Z_FREELIST_GRANULARITY] = block.freeNext;
+    }
+
+    if (block.freeNext) {
+        block.freeNext->freePrev = block.freePrev;
+    }
+
+    block.freeNext = nullptr;
+    block.freePrev = nullptr;
+    block.id = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom limit removing: takes a free block for an allocation of the given size (including the header) from the zone's free lists.
+// Only considers blocks which would leave no more than 'MINFRAGMENT' bytes unused, so larger blocks are not broken up needlessly.
+// Returns 'nullptr' if there is no suitable block.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static memblock_t* Z_TakeFreeListBlock(memzone_t& zone, const int32_t allocSize) noexcept {
+    if (allocSize > Z_MAX_FREELIST_BLOCK_SIZE)
+        return nullptr;
+
+    const int32_t startListIdx = allocSize / Z_FREELIST_GRANULARITY;
+    const int32_t endListIdx = std::min((allocSize + MINFRAGMENT) / Z_FREELIST_GRANULARITY, Z_NUM_FREELISTS - 1);
+
+    for (int32_t listIdx = startListIdx; listIdx <= endListIdx; ++listIdx) {
+        memblock_t* const pBlock = zone.freelists[listIdx];
+
+        // Note: the first list may contain blocks slightly smaller than required, if the allocation size is not a multiple of the granularity
+        if (pBlock && (pBlock->size >= allocSize)) {
+            Z_RemoveFromFreeList(zone, *pBlock);
+            return pBlock;
+        }
+    }
+
+    return nullptr;
+}
+#endif  // #if PSYDOOM_LIMIT_REMOVING
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Initializes the zone memory management system. DOOM doesn't use any PsyQ SDK allocation functions AT ALL (either directly or indirectly)
 // so it just gobbles up the entire of the available heap space on the system for it's own purposes.
@@ -59,6 +138,11 @@ memzone_t* Z_InitZone(void* const pBase, const int32_t size) noexcept {
 
     pZone->blocklist.next = nullptr;
     pZone->blocklist.prev = nullptr;
+
+    #if PSYDOOM_LIMIT_REMOVING
+        std::memset(pZone->freelists, 0, sizeof(pZone->freelists));
+    #endif
+
     return pZone;
 }
 
@@ -80,6 +164,14 @@ void* Z_Malloc(memzone_t& zone, const int32_t size, const int16_t tag, void** co
     memblock_t* pBase = zone.rover;
     memblock_t* const pStart = pBase;
 
+    // PsyDoom limit removing: try to take a free block of the right size from the free lists first, which avoids walking the block list.
+    // If one is found then it is free and big enough, so the search below ends immediately.
+    #if PSYDOOM_LIMIT_REMOVING
+        if (memblock_t* const pFreeListBlock = Z_TakeFreeListBlock(zone, allocSize)) {
+            pBase = pFreeListBlock;
+        }
+    #endif
+
     while (pBase->user || (pBase->size < allocSize)) {
         // Set the rover to the next block if the current is free, so we can merge free blocks:
         memblock_t* const pRover = (pBase->user) ? pBase : pBase->next;
@@ -111,11 +203,26 @@ void* Z_Malloc(memzone_t& zone, const int32_t size, const int16_t tag, void** co
             }
 
             // Chuck out this block!
-            Z_Free2(*gpMainMemZone, &pRover[1]);
+            // PsyDoom: record the purge if tracing, and use an internal free function so it is not also recorded as a free by the game.
+            #if PSYDOOM_MODS
+                if (ZoneTrace::gbIsTracing) {
+                    ZoneTrace::recordPurge(&pRover[1], pRover->size, pRover->tag, ZONE_TRACE_CALL_SITE());
+                }
+
+                Z_FreeBlock(zone, &pRover[1]);
+            #else
+                Z_Free2(*gpMainMemZone, &pRover[1]);
+            #endif
         }
 
         // Merge adjacent free memory blocks where possible
         if (pBase != pRover) {
+            // PsyDoom limit removing: both blocks are changing so they can't be in the free lists anymore
+            #if PSYDOOM_LIMIT_REMOVING
+                Z_RemoveFromFreeList(zone, *pBase);
+                Z_RemoveFromFreeList(zone, *pRover);
+            #endif
+
             pBase->size += pRover->size;
             pBase->next = pRover->next;
 
@@ -125,6 +232,11 @@ void* Z_Malloc(memzone_t& zone, const int32_t size, const int16_t tag, void** co
         }
     }
 
+    // PsyDoom limit removing: the block being allocated can't be in the free lists anymore
+    #if PSYDOOM_LIMIT_REMOVING
+        Z_RemoveFromFreeList(zone, *pBase);
+    #endif
+
     // If there are enough free bytes following the allocation then make a new memory block
     // and add it into the linked list of blocks:
     const int32_t numUnusedBytes = pBase->size - allocSize;
@@ -133,6 +245,12 @@ void* Z_Malloc(memzone_t& zone, const int32_t size, const int16_t tag, void** co
         std::byte* const pUnusedBytes = (std::byte*) pBase + allocSize;
 
         memblock_t& newBlock = (memblock_t&) *pUnusedBytes;
+
+        // PsyDoom limit removing: make sure stale data is not mistaken for the id of a block in the free lists
+        #if PSYDOOM_LIMIT_REMOVING
+            newBlock.id = 0;
+        #endif
+
         newBlock.prev = pBase;
         newBlock.next = pBase->next;
 
@@ -166,6 +284,13 @@ void* Z_Malloc(memzone_t& zone, const int32_t size, const int16_t tag, void** co
     pBase->tag = tag;
     pBase->id = ZONEID;
 
+    // PsyDoom: record the allocation if tracing
+    #if PSYDOOM_MODS
+        if (ZoneTrace::gbIsTracing) {
+            ZoneTrace::recordMalloc(&pBase[1], size, tag, (ppUser != nullptr), false, ZONE_TRACE_CALL_SITE());
+        }
+    #endif
+
     // Move along the rover to the next block and return the usable memory allocated (past the allocated block header)
     zone.rover = (pBase->next) ? pBase->next : &zone.blocklist;
     return &pBase[1];
@@ -222,11 +347,26 @@ void* Z_EndMalloc(memzone_t& zone, const int32_t size, const int16_t tag, void**
             }
 
             // Chuck out this block!
-            Z_Free2(*gpMainMemZone, &pRover[1]);
+            // PsyDoom: record the purge if tracing, and use an internal free function so it is not also recorded as a free by the game.
+            #if PSYDOOM_MODS
+                if (ZoneTrace::gbIsTracing) {
+                    ZoneTrace::recordPurge(&pRover[1], pRover->size, pRover->tag, ZONE_TRACE_CALL_SITE());
+                }
+
+                Z_FreeBlock(zone, &pRover[1]);
+            #else
+                Z_Free2(*gpMainMemZone, &pRover[1]);
+            #endif
         }
 
         // Merge adjacent free memory blocks where possible
         if (pBase != pRover) {
+            // PsyDoom limit removing: both blocks are changing so they can't be in the free lists anymore
+            #if PSYDOOM_LIMIT_REMOVING
+                Z_RemoveFromFreeList(zone, *pBase);
+                Z_RemoveFromFreeList(zone, *pRover);
+            #endif
+
             pRover->size = pRover->size + pBase->size;
             pRover->next = pBase->next;
 
@@ -238,6 +378,11 @@ void* Z_EndMalloc(memzone_t& zone, const int32_t size, const int16_t tag, void**
         }
     }
 
+    // PsyDoom limit removing: the block being allocated can't be in the free lists anymore
+    #if PSYDOOM_LIMIT_REMOVING
+        Z_RemoveFromFreeList(zone, *pBase);
+    #endif
+
     // If there are enough free bytes following the allocation then make a new memory block and add it into the linked list of blocks.
     // Unlike the regular Z_Malloc, the new block is added BEFORE the allocated memory.
     const int32_t numUnusedBytes = pBase->size - allocSize;
@@ -276,6 +421,13 @@ void* Z_EndMalloc(memzone_t& zone, const int32_t size, const int16_t tag, void**
     pBase->id = ZONEID;
     pBase->tag = tag;
 
+    // PsyDoom: record the allocation if tracing
+    #if PSYDOOM_MODS
+        if (ZoneTrace::gbIsTracing) {
+            ZoneTrace::recordMalloc(&pBase[1], size, tag, (ppUser != nullptr), true, ZONE_TRACE_CALL_SITE());
+        }
+    #endif
+
     // Set the rover for the zone and return the usable memory allocated (past the allocated block header)
     zone.rover = &zone.blocklist;
     return (void*) &pBase[1];
@@ -284,8 +436,26 @@ void* Z_EndMalloc(memzone_t& zone, const int32_t size, const int16_t tag, void**
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Free the given block of memory.
 // Note that the zone param is actually not needed here to perform the dealloc, perhaps it was passed in case it was needed in future?
+// PsyDoom: the zone is now used for it's free lists in limit removing builds.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void Z_Free2([[maybe_unused]] memzone_t& zone, void* const ptr) noexcept {
+void Z_Free2(memzone_t& zone, void* const ptr) noexcept {
+    // PsyDoom: record the free if tracing, along with the size and tag of the block (if it is valid)
+    #if PSYDOOM_MODS
+        if (ZoneTrace::gbIsTracing) {
+            const memblock_t& block = ((const memblock_t*) ptr)[-1];
+            const bool bValidBlock = (block.id == ZONEID);
+            ZoneTrace::recordFree(ptr, (bValidBlock) ? block.size : 0, (bValidBlock) ? block.tag : 0, ZONE_TRACE_CALL_SITE());
+        }
+    #endif
+
+    Z_FreeBlock(zone, ptr);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does the work of freeing the given block of memory.
+// PsyDoom: split out from 'Z_Free2' so that blocks purged by the allocator are not recorded as being freed by the game in zone traces.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void Z_FreeBlock([[maybe_unused]] memzone_t& zone, void* const ptr) noexcept {
     // Get the memory block header which is located before the actual memory.
     // Verify also that the id is sane and that we are not just being passed a garbage pointer:
     memblock_t& block = ((memblock_t*) ptr)[-1];
@@ -303,17 +473,34 @@ void Z_Free2([[maybe_unused]] memzone_t& zone, void* const ptr) noexcept {
     block.user = nullptr;
     block.tag = 0;
     block.id = 0;
+
+    // PsyDoom limit removing: make the block available for fast allocation of the same size
+    #if PSYDOOM_LIMIT_REMOVING
+        Z_AddToFreeList(zone, block);
+    #endif
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Free memory blocks that have one or more of the given tag bits
 //------------------------------------------------------------------------------------------------------------------------------------------
 void Z_FreeTags(memzone_t& zone, const int16_t tagBits) noexcept {
-    // Free each block if it is in use and matches one of the given tags
+    // PsyDoom: record the call if tracing
+    #if PSYDOOM_MODS
+        if (ZoneTrace::gbIsTracing) {
+            ZoneTrace::recordFreeTags(tagBits, ZONE_TRACE_CALL_SITE());
+        }
+    #endif
+
+    // Free each block if it is in use and matches one of the given tags.
+    // PsyDoom: using the internal free function so that each block is not recorded as individually freed in zone traces.
     for (memblock_t* pBlock = &zone.blocklist; pBlock; pBlock = pBlock->next) {
         if (pBlock->user) {
             if ((pBlock->tag & tagBits) != 0) {
-                Z_Free2(zone, &pBlock[1]);
+                #if PSYDOOM_MODS
+                    Z_FreeBlock(zone, &pBlock[1]);
+                #else
+                    Z_Free2(zone, &pBlock[1]);
+                #endif
             }
         }
     }
@@ -326,6 +513,12 @@ void Z_FreeTags(memzone_t& zone, const int16_t tagBits) noexcept {
 
         // See if there are two adjacent free blocks
         if ((!pBlock->user) && pNextBlock && (!pNextBlock->user)) {
+            // PsyDoom limit removing: both blocks are changing so they can't be in the free lists anymore
+            #if PSYDOOM_LIMIT_REMOVING
+                Z_RemoveFromFreeList(zone, *pBlock);
+                Z_RemoveFromFreeList(zone, *pNextBlock);
+            #endif
+
             // Merge the two blocks together
             pBlock->size = pBlock->size + pNextBlock->size;
             pBlock->next = pNextBlock->next;
@@ -386,6 +579,30 @@ void Z_CheckHeap(const memzone_t& zone) noexcept {
             I_Error("Z_CheckHeap: next block doesn't have proper back link\n");
         }
     }
+
+    // PsyDoom limit removing: sanity check the free lists also.
+    // All blocks in the lists should be free, of the right size for the list they are in and properly linked.
+    #if PSYDOOM_LIMIT_REMOVING
+        for (int32_t listIdx = 0; listIdx < Z_NUM_FREELISTS; ++listIdx) {
+            const memblock_t* pPrevBlock = nullptr;
+
+            for (memblock_t* pBlock = zone.freelists[listIdx]; pBlock; pBlock = pBlock->freeNext) {
+                if ((pBlock->user) || (pBlock->id != FREELISTID)) {
+                    I_Error("Z_CheckHeap: block in free list is not free\n");
+                }
+
+                if (pBlock->size / Z_FREELIST_GRANULARITY != listIdx) {
+                    I_Error("Z_CheckHeap: block in wrong free list for it's size\n");
+                }
+
+                if (pBlock->freePrev != pPrevBlock) {
+                    I_Error("Z_CheckHeap: free list block doesn't have proper back link\n");
+                }
+
+                pPrevBlock = pBlock;
+            }
+        }
+    #endif
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -408,6 +625,13 @@ void Z_ChangeTag(void* const ptr, const int16_t tagBits) noexcept {
     }
 
     block.tag = (int16_t) tagBits;
+
+    // PsyDoom: record the tag change if tracing
+    #if PSYDOOM_MODS
+        if (ZoneTrace::gbIsTracing) {
+            ZoneTrace::recordChangeTag(ptr, tagBits, ZONE_TRACE_CALL_SITE());
+        }
+    #endif
 }
 
 #if PSYDOOM_MODS
@@ -424,6 +648,10 @@ void Z_SetUser(void* const ptr, void** const ppUser) noexcept {
     }
 
     block.user = ppUser;
+
+    if (ZoneTrace::gbIsTracing) {
+        ZoneTrace::recordSetUser(ptr, (ppUser != nullptr), ZONE_TRACE_CALL_SITE());
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -27,12 +27,30 @@ struct memblock_t {
     int32_t         lockframe;      // Don't purge on this frame
     memblock_t*     next;
     memblock_t*     prev;
+#if PSYDOOM_LIMIT_REMOVING
+    // PsyDoom limit removing: links for a free block in one of the zone's segregated free lists (null if not in a list).
+    // These are kept in the header rather than the unused memory of the free block, since some game code reads freed memory.
+    // For example 'P_RunThinkers' originally read the 'next' field of a thinker after freeing it.
+    memblock_t*     freeNext;
+    memblock_t*     freePrev;
+#endif
 };
 
+#if PSYDOOM_LIMIT_REMOVING
+    // PsyDoom limit removing: free blocks up to this size (including the header) are also kept in lists segregated by block size.
+    // This allows small allocations to be satisfied without walking the block list, which can get very long on big maps.
+    static constexpr int32_t Z_MAX_FREELIST_BLOCK_SIZE = 1024;
+    static constexpr int32_t Z_FREELIST_GRANULARITY = 8;
+    static constexpr int32_t Z_NUM_FREELISTS = Z_MAX_FREELIST_BLOCK_SIZE / Z_FREELIST_GRANULARITY + 1;
+#endif
+
 // Info for a memory allocation zone
 struct memzone_t {
     int32_t         size;           // Total bytes malloced, including header
     memblock_t*     rover;
+#if PSYDOOM_LIMIT_REMOVING
+    memblock_t*     freelists[Z_NUM_FREELISTS];     // PsyDoom: lists of free blocks indexed by block size (in 'Z_FREELIST_GRANULARITY' units)
+#endif
     memblock_t      blocklist;      // Start / end cap for linked list
 };
 
@@ -18,6 +18,7 @@
 #include "p_setup.h"
 #include "p_tick.h"
 #include "PsyDoom/Config/Config.h"
+#include "PsyDoom/SimProfiler.h"
 
 #include <algorithm>
 
@@ -48,6 +49,7 @@ static bool PB_BlockThingsIterator(const int32_t x, const int32_t y) noexcept;
 // Does movement and state ticking for all map objects except players
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_RunMobjBase() noexcept {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::RunMobjBase);     // PsyDoom: profile if enabled
     gpBaseThing = gMobjHead.next;
 
     // Run through all the map objects
@@ -59,6 +61,7 @@ void P_RunMobjBase() noexcept {
             // Note: clear the latecall here to signify (initially) no mobj action to execute during the 'latecall' phase.
             // The think function might set an action though, typically for a state transition or sometimes a missile explosion etc.
             mobj.latecall = nullptr;
+            SIM_PROFILE_SCOPE(SimProfiler::Category::MobjThink, SimProfiler::fnId(&P_MobjThinker), mobj.type);
             P_MobjThinker(mobj);
         }
 
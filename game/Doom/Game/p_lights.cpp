@@ -180,14 +180,10 @@ void EV_StartLightStrobing(line_t& line) noexcept {
 // Turns 'off' lights for sectors matching the given line's tag; makes those sectors use the lowest surrounding light level
 //------------------------------------------------------------------------------------------------------------------------------------------
 void EV_TurnTagLightsOff(line_t& line) noexcept {
-    // Turn 'off' the light for all sectors with a matching tag
-    sector_t* const pSectors = gpSectors;
-
-    for (int32_t sectorIdx = 0; sectorIdx < gNumSectors; ++sectorIdx) {
-        sector_t& sector = pSectors[sectorIdx];
-
-        if (sector.tag != line.tag)
-            continue;
+    // Turn 'off' the light for all sectors with a matching tag.
+    // PsyDoom: use 'P_FindSectorFromLineTag' to find the sectors, so the tag index is used instead of searching through all sectors.
+    for (int32_t sectorIdx = P_FindSectorFromLineTag(line, -1); sectorIdx >= 0; sectorIdx = P_FindSectorFromLineTag(line, sectorIdx)) {
+        sector_t& sector = gpSectors[sectorIdx];
 
         // Tag matches: find the lowest light level of surrounding sectors and use that as the new light level
         int16_t minLightLevel = sector.lightlevel;
@@ -210,14 +206,10 @@ void EV_TurnTagLightsOff(line_t& line) noexcept {
 // Uses the given light level as the 'on' light level, or the highest surrounding light level if '0' is specified.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void EV_LightTurnOn(line_t& line, const int32_t onLightLevel) noexcept {
-    // Turn 'on' the light for all sectors with a matching tag
-    sector_t* const pSectors = gpSectors;
-
-    for (int32_t sectorIdx = 0; sectorIdx < gNumSectors; ++sectorIdx) {
-        sector_t& sector = pSectors[sectorIdx];
-
-        if (sector.tag != line.tag)
-            continue;
+    // Turn 'on' the light for all sectors with a matching tag.
+    // PsyDoom: use 'P_FindSectorFromLineTag' to find the sectors, so the tag index is used instead of searching through all sectors.
+    for (int32_t sectorIdx = P_FindSectorFromLineTag(line, -1); sectorIdx >= 0; sectorIdx = P_FindSectorFromLineTag(line, sectorIdx)) {
+        sector_t& sector = gpSectors[sectorIdx];
 
         // Tag matches: use the given light level as the 'on' light level, or if '0' is specified for that
         // use the highest light level found in surrounding sectors.
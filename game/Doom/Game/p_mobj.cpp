@@ -23,6 +23,7 @@
 #include "p_setup.h"
 #include "p_tick.h"
 #include "PsyDoom/Game.h"
+#include "PsyDoom/SimProfiler.h"
 
 #include <algorithm>
 #include <cstdio>
@@ -161,6 +162,7 @@ bool P_SetMobjState(mobj_t& mobj, const statenum_t stateNum) noexcept {
     mobj.frame = state.frame;
 
     if (state.action) {
+        SIM_PROFILE_SCOPE(SimProfiler::Category::Action, SimProfiler::fnId(state.action.mobjFn), mobj.type);    // PsyDoom: profile if enabled
         state.action(mobj);
     }
 
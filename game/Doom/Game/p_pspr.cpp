@@ -20,6 +20,7 @@
 #include "p_tick.h"
 #include "PsyDoom/Config/Config.h"
 #include "PsyDoom/Game.h"
+#include "PsyDoom/SimProfiler.h"
 
 const weaponinfo_t gWeaponInfo[NUMWEAPONS] = {
     {   // Fist
@@ -228,6 +229,7 @@ void P_SetPsprite(player_t& player, const int32_t spriteIdx, const statenum_t st
 
         // Perform the state action
         if (state.action) {
+            SIM_PROFILE_SCOPE(SimProfiler::Category::WeaponAction, SimProfiler::fnId(state.action.psprFn));     // PsyDoom: profile if enabled
             state.action(player, sprite);
 
             // Finish if we no longer have a state
@@ -28,12 +28,16 @@
 #include "p_weak.h"
 #include "PsyDoom/DevMapAutoReloader.h"
 #include "PsyDoom/Game.h"
+#include "PsyDoom/LevelCache.h"
 #include "PsyDoom/MapHash.h"
 #include "PsyDoom/MapInfo/MapInfo.h"
 #include "PsyDoom/MapPatcher/MapPatcher.h"
 #include "PsyDoom/MobjSpritePrecacher.h"
 #include "PsyDoom/ModMgr.h"
+#include "PsyDoom/ProgArgs.h"
 #include "PsyDoom/ScriptingEngine.h"
+#include "PsyDoom/SectorPvs.h"
+#include "PsyDoom/TagIndex.h"
 
 #include <algorithm>
 #include <cstdio>
@@ -170,6 +174,11 @@ static void P_LoadVertexes(const int32_t lumpNum) noexcept {
     gNumVertexes = lumpSize / sizeof(mapvertex_t);
     gpVertexes = (vertex_t*) Z_Malloc(*gpMainMemZone, gNumVertexes * sizeof(vertex_t), PU_LEVEL, nullptr);
 
+    #if PSYDOOM_MODS
+        // PsyDoom: zero initialize so that any struct padding has a known value, for the level cache (see 'LevelCache::verify')
+        D_memset(gpVertexes, std::byte(0), gNumVertexes * sizeof(vertex_t));
+    #endif
+
     // Read the WAD vertexes into the temp buffer from the map WAD
     W_ReadMapLump(lumpNum, pTmpBufferBytes, true);
 
@@ -554,6 +563,11 @@ static void P_LoadNodes(const int32_t lumpNum) noexcept {
     gNumBspNodes = lumpSize / sizeof(mapnode_t);
     gpBspNodes = (node_t*) Z_Malloc(*gpMainMemZone, gNumBspNodes * sizeof(node_t), PU_LEVEL, nullptr);
 
+    #if PSYDOOM_MODS
+        // PsyDoom: zero initialize for the level cache, same as for vertexes (see 'P_LoadVertexes')
+        D_memset(gpBspNodes, std::byte(0), gNumBspNodes * sizeof(node_t));
+    #endif
+
     // Read the map lump containing the nodes into a temp buffer from the map WAD
     W_ReadMapLump(lumpNum, pTmpBufferBytes, true);
 
@@ -981,6 +995,11 @@ static void P_LoadLeafs(const int32_t lumpNum) noexcept {
     // Allocate room for all the leaf edges
     gpLeafEdges = (leafedge_t*) Z_Malloc(*gpMainMemZone, totalLeafEdges * sizeof(leafedge_t), PU_LEVEL, nullptr);
 
+    #if PSYDOOM_MODS
+        // PsyDoom: zero initialize for the level cache, same as for vertexes (see 'P_LoadVertexes')
+        D_memset(gpLeafEdges, std::byte(0), totalLeafEdges * sizeof(leafedge_t));
+    #endif
+
     // Convert WAD leaf edges to runtime leaf edges and link them in with other map data structures
     gTotalNumLeafEdges = 0;
 
@@ -1477,6 +1496,109 @@ static void P_Init() noexcept {
     P_InitPicAnims();
 }
 
+#if PSYDOOM_MODS
+// PsyDoom: the names of the lumps containing map geometry, in the order they are loaded
+static constexpr const char* const MAP_GEOMETRY_LUMP_NAMES[] = {
+    "BLOCKMAP", "VERTEXES", "SECTORS", "SIDEDEFS", "LINEDEFS", "SSECTORS", "NODES", "SEGS", "LEAFS", "REJECT"
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: starts reading and decompressing all of the map lumps needed by 'P_SetupLevel' in the background, in the order they are loaded.
+// This lets disk I/O and decompression overlap with the parsing done by the map loaders.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void P_StartMapLumpPipeline() noexcept {
+    int32_t lumpIdxs[C_ARRAY_SIZE(MAP_GEOMETRY_LUMP_NAMES) + 1];
+    int32_t numLumps = 0;
+
+    for (const char* const lumpName : MAP_GEOMETRY_LUMP_NAMES) {
+        lumpIdxs[numLumps++] = W_MapCheckNumForName(lumpName);
+    }
+
+    lumpIdxs[numLumps++] = W_MapCheckNumForName("THINGS");
+    W_MapStartLumpPipeline(lumpIdxs, numLumps);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: loads all of the map geometry lumps for the current map WAD and builds sector line lists etc.
+// Clears the map hash before loading, since each of the lumps loaded are added to it.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void P_LoadMapGeometry() noexcept {
+    MapHash::clear();
+    P_LoadBlockMap(W_MapGetNumForName("BLOCKMAP"));
+    P_LoadVertexes(W_MapGetNumForName("VERTEXES"));
+    P_LoadSectors(W_MapGetNumForName("SECTORS"));
+    P_LoadSideDefs(W_MapGetNumForName("SIDEDEFS"));
+    P_LoadLineDefs(W_MapGetNumForName("LINEDEFS"));
+    P_LoadSubSectors(W_MapGetNumForName("SSECTORS"));
+    P_LoadNodes(W_MapGetNumForName("NODES"));
+    P_LoadSegs(W_MapGetNumForName("SEGS"));
+    P_LoadLeafs(W_MapGetNumForName("LEAFS"));
+    P_LoadRejectMap(W_MapGetNumForName("REJECT"));
+    P_GroupLines();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: does the same job as 'P_LoadMapGeometry' but tries to load the geometry from the level cache first.
+// The geometry lumps are hashed to find the cache file; if there is no valid cache file then the map is loaded normally and then cached.
+// If level cache verification is enabled then the map is always loaded normally and then checked against the cache file.
+// Either way the map hash is left in the same state as 'P_LoadMapGeometry' leaves it, ready for the 'THINGS' lump to be added.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void P_LoadMapGeometryWithCache() noexcept {
+    // Hash all of the geometry lumps to get the key for the cache file
+    LevelCache::LevelInfo levelInfo = {};
+    levelInfo.bFinalDoomMap = gbLoadingFinalDoomMap;
+
+    {
+        std::vector<std::byte> lumpData;
+        MapHash::clear();
+
+        for (const char* const lumpName : MAP_GEOMETRY_LUMP_NAMES) {
+            const int32_t lumpNum = W_MapGetNumForName(lumpName);
+            const int32_t lumpSize = W_MapLumpLength(lumpNum);
+            lumpData.resize((size_t) lumpSize);
+            W_ReadMapLump(lumpNum, lumpData.data(), true);
+            MapHash::addData(lumpData.data(), lumpSize);
+        }
+
+        MapHash::finalize();
+        levelInfo.mapHashWord1 = MapHash::gWord1;
+        levelInfo.mapHashWord2 = MapHash::gWord2;
+    }
+
+    // Try loading from the cache first: on success the map hash already includes all of the geometry lumps
+    if ((!ProgArgs::gbVerifyLevelCache) && LevelCache::load(levelInfo)) {
+        if (levelInfo.startupWarning[0]) {
+            std::memcpy(gLevelStartupWarning, levelInfo.startupWarning, sizeof(gLevelStartupWarning));
+        }
+
+        return;
+    }
+
+    // Otherwise load the map normally, noting any startup warning issued for the geometry so it can be cached too.
+    // Preserve any startup warning issued before this point if the geometry doesn't have one of it's own.
+    char prevStartupWarning[C_ARRAY_SIZE(gLevelStartupWarning)];
+    std::memcpy(prevStartupWarning, gLevelStartupWarning, sizeof(prevStartupWarning));
+    gLevelStartupWarning[0] = 0;
+
+    P_LoadMapGeometry();
+
+    levelInfo.blockmapLumpSize = W_MapLumpLength(W_MapGetNumForName("BLOCKMAP"));
+    levelInfo.rejectMapSize = W_MapLumpLength(W_MapGetNumForName("REJECT"));
+    static_assert(sizeof(levelInfo.startupWarning) == sizeof(gLevelStartupWarning));
+    std::memcpy(levelInfo.startupWarning, gLevelStartupWarning, sizeof(levelInfo.startupWarning));
+
+    if (!gLevelStartupWarning[0]) {
+        std::memcpy(gLevelStartupWarning, prevStartupWarning, sizeof(gLevelStartupWarning));
+    }
+
+    if (ProgArgs::gbVerifyLevelCache) {
+        LevelCache::verify(levelInfo);
+    } else {
+        LevelCache::save(levelInfo);
+    }
+}
+#endif  // #if PSYDOOM_MODS
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Loads the specified level, textures and sets it up for gameplay by spawning things, players etc.
 // Note: while most of the loading and setup is done here for the level, sound and music are handled eleswhere.
@@ -1579,6 +1701,7 @@ void P_SetupLevel(const int32_t mapNum, [[maybe_unused]] const skill_t skill) no
     // PsyDoom: this no longer returns a data pointer with the new WAD code.
     #if PSYDOOM_MODS
         W_OpenMapWad(mapWadFile);
+        P_StartMapLumpPipeline();   // PsyDoom: read and decompress map lumps in the background while they are being parsed
     #else
         void* const pMapWadFileData = W_OpenMapWad(mapWadFile);
     #endif
@@ -1610,18 +1733,13 @@ void P_SetupLevel(const int32_t mapNum, [[maybe_unused]] const skill_t skill) no
     // Loading various map lumps.
     // PsyDoom: not using relative indexing anymore to load map lumps, search for the lump names instead.
     // PsyDoom: clear the map hash before starting to load level lumps that will add to the hash.
+    // PsyDoom: the level geometry may also come from the level cache if that is enabled.
     #if PSYDOOM_MODS
-        MapHash::clear();
-        P_LoadBlockMap(W_MapGetNumForName("BLOCKMAP"));
-        P_LoadVertexes(W_MapGetNumForName("VERTEXES"));
-        P_LoadSectors(W_MapGetNumForName("SECTORS"));
-        P_LoadSideDefs(W_MapGetNumForName("SIDEDEFS"));
-        P_LoadLineDefs(W_MapGetNumForName("LINEDEFS"));
-        P_LoadSubSectors(W_MapGetNumForName("SSECTORS"));
-        P_LoadNodes(W_MapGetNumForName("NODES"));
-        P_LoadSegs(W_MapGetNumForName("SEGS"));
-        P_LoadLeafs(W_MapGetNumForName("LEAFS"));
-        P_LoadRejectMap(W_MapGetNumForName("REJECT"));
+        if (LevelCache::isEnabled()) {
+            P_LoadMapGeometryWithCache();
+        } else {
+            P_LoadMapGeometry();
+        }
     #else
         P_LoadBlockMap(mapStartLump + ML_BLOCKMAP);
         P_LoadVertexes(mapStartLump + ML_VERTEXES);
@@ -1633,23 +1751,32 @@ void P_SetupLevel(const int32_t mapNum, [[maybe_unused]] const skill_t skill) no
         P_LoadSegs(mapStartLump + ML_SEGS);
         P_LoadLeafs(mapStartLump + ML_LEAFS);
         P_LoadRejectMap(mapStartLump + ML_REJECT);
-    #endif
 
-    // Build sector line lists etc.
-    P_GroupLines();
+        // Build sector line lists etc.
+        P_GroupLines();
+    #endif
 
     // Load and spawn map things; also initialize the next deathmatch start
     gpDeathmatchP = &gDeathmatchStarts[0];
 
     #if PSYDOOM_MODS
         P_LoadThings(W_MapGetNumForName("THINGS"));     // PsyDoom: not using relative indexing anymore to load map lumps, search for the lump names instead
-        ScriptingEngine::init();                        // PsyDoom: initialize the scripting engine if the map has Lua scripted actions
+        W_MapFinishLumpPipeline();                      // PsyDoom: all map lumps needed in the background have now been consumed
+        ScriptingEngine::readMapScript();               // PsyDoom: read the map's Lua script (if any), which counts towards the map hash
         MapHash::finalize();                            // PsyDoom: compute the final map hash
         MapPatcher::applyPatches();                     // PsyDoom: apply any patches to original map data that are relevant at this point, once all things have been loaded
+        TagIndex::build();                              // PsyDoom: index sectors and lines by tag, now that patches have been applied
+        ScriptingEngine::init();                        // PsyDoom: initialize the scripting engine if the map has Lua scripted actions; scripts may look up tags
     #else
         P_LoadThings(mapStartLump + ML_THINGS);
     #endif
 
+    // PsyDoom: add sectors which can never see each other to the reject map, if enabled.
+    // This must be done while the map WAD is still open, so the size of the 'REJECT' lump can be found.
+    #if PSYDOOM_MODS
+        SectorPvs::applyToRejectMap(W_MapLumpLength(W_MapGetNumForName("REJECT")));
+    #endif
+
     // Spawn special thinkers such as light flashes etc. and free up the loaded WAD data.
     // PsyDoom: the WAD manager is now responsible for freeing up resources used by the map WAD.
     P_SpawnSpecials();
@@ -11,6 +11,8 @@
 #include "p_shoot.h"
 #include "p_tick.h"
 #include "PsyDoom/Game.h"
+#include "PsyDoom/SectorPvs.h"
+#include "PsyDoom/SimProfiler.h"
 
 #include <algorithm>
 
@@ -29,6 +31,8 @@ static int32_t      gT2ys;              // Sight line end, whole coords: y
 // Updates target visibility checking for all map objects that are due an update
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_CheckSights() noexcept {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::CheckSights);     // PsyDoom: profile if enabled
+
     for (mobj_t* pmobj = gMobjHead.next; pmobj != &gMobjHead; pmobj = pmobj->next) {
         // Must be killable (enemy) to do sight checking.
         //
@@ -50,6 +54,7 @@ void P_CheckSights() noexcept {
             // See if we can see the target - if any.
             // Add or remove the visibility flag based on this:
             mobj_t* const pMobjTarget = pmobj->target;
+            SIM_PROFILE_SCOPE(SimProfiler::Category::Sight, SimProfiler::fnId(&P_CheckSight), pmobj->type);
 
             if (pMobjTarget && P_CheckSight(*pmobj, *pMobjTarget)) {
                 pmobj->flags |= MF_SEETARGET;
@@ -84,8 +89,32 @@ bool P_CheckSight(mobj_t& mobj1, mobj_t& mobj2) noexcept {
     const int32_t rejectMapByte = rejectMapEntry / 8;
     const int32_t rejectMapBit = rejectMapEntry & 7;
 
-    if ((gpRejectMatrix[rejectMapByte] & (1 << rejectMapBit)) != 0)
-        return false;
+    #if PSYDOOM_MODS
+        const bool bCollectSightStats = SectorPvs::gbCollectSightStats;
+        bool bIsPvsReject = false;
+
+        if (bCollectSightStats) {
+            SectorPvs::gSightStats.numSightChecks++;
+        }
+    #endif
+
+    if ((gpRejectMatrix[rejectMapByte] & (1 << rejectMapBit)) != 0) {
+        // PsyDoom: if gathering sight check stats then do the full sight check for pairs of sectors rejected by the sector PVS.
+        // This verifies the PVS while counting the BSP traversals it avoids, and the result is the same either way.
+        #if PSYDOOM_MODS
+            bIsPvsReject = (bCollectSightStats && SectorPvs::isPvsRejectEntry(rejectMapEntry));
+
+            if (!bIsPvsReject) {
+                if (bCollectSightStats) {
+                    SectorPvs::gSightStats.numLumpRejects++;
+                }
+
+                return false;
+            }
+        #else
+            return false;
+        #endif
+    }
 
     // Store the start and end points of the sight line.
     // Note that the coordinates are truncated to be on odd integer coordinates.
@@ -119,7 +148,18 @@ bool P_CheckSight(mobj_t& mobj1, mobj_t& mobj2) noexcept {
 
     // Do a raycast against the BSP tree and return if sight is unobstructed.
     // Also narrows the vertical sight range with each lower and upper wall encountered.
-    return PS_CrossBSPNode(gNumBspNodes - 1);
+    // PsyDoom: record the result if gathering sight check stats.
+    #if PSYDOOM_MODS
+        const bool bCanSee = PS_CrossBSPNode(gNumBspNodes - 1);
+
+        if (bCollectSightStats) {
+            SectorPvs::recordTraversal(bIsPvsReject, bCanSee);
+        }
+
+        return bCanSee;
+    #else
+        return PS_CrossBSPNode(gNumBspNodes - 1);
+    #endif
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -29,6 +29,8 @@
 #include "PsyDoom/Game.h"
 #include "PsyDoom/ParserTokenizer.h"
 #include "PsyDoom/ScriptingEngine.h"
+#include "PsyDoom/SimProfiler.h"
+#include "PsyDoom/TagIndex.h"
 
 #include <cstdlib>
 #include <memory>
@@ -534,18 +536,23 @@ fixed_t P_FindHighestCeilingSurrounding(sector_t& sector) noexcept {
 // Returns the index of the next matching sector found, or '-1' if there was no next matching sector.
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t P_FindSectorFromLineTag(line_t& line, const int32_t searchStart) noexcept {
-    const int32_t lineTag = line.tag;
-    sector_t* const pSectors = gpSectors;
-    const int32_t numSectors = gNumSectors;
+    // PsyDoom: use the tag index rather than searching through all sectors; the results are the same and in the same order
+    #if PSYDOOM_MODS
+        return TagIndex::findNextSector(line.tag, searchStart);
+    #else
+        const int32_t lineTag = line.tag;
+        sector_t* const pSectors = gpSectors;
+        const int32_t numSectors = gNumSectors;
 
-    for (int32_t sectorIdx = searchStart + 1; sectorIdx < numSectors; ++sectorIdx) {
-        sector_t& sector = pSectors[sectorIdx];
+        for (int32_t sectorIdx = searchStart + 1; sectorIdx < numSectors; ++sectorIdx) {
+            sector_t& sector = pSectors[sectorIdx];
 
-        if (sector.tag == lineTag)
-            return sectorIdx;
-    }
+            if (sector.tag == lineTag)
+                return sectorIdx;
+        }
 
-    return -1;
+        return -1;
+    #endif
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -1269,6 +1276,8 @@ void P_PlayerInSpecialSector(player_t& player) noexcept {
 // PSX: also animates the fire sky if the level has that.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_UpdateSpecials() noexcept {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::UpdateSpecials);      // PsyDoom: profile if enabled
+
     // Animate flats and wall textures
     for (anim_t* pAnim = &gAnims[0]; pAnim < gpLastAnim; ++pAnim) {
         // Skip over this entry if it isn't time to advance the animation
@@ -14,6 +14,7 @@
 #include "p_mobj.h"
 #include "p_move.h"
 #include "p_setup.h"
+#include "p_spec.h"
 #include "p_tick.h"
 
 #include <cstdlib>
@@ -66,16 +67,11 @@ bool EV_Teleport(line_t& line, mobj_t& mobj) noexcept {
     if (mobj.flags & MF_MISSILE)
         return false;
 
-    // Search for a teleport destination marker in a sector with a tag matching the given line
+    // Search for a teleport destination marker in a sector with a tag matching the given line.
+    // PsyDoom: use 'P_FindSectorFromLineTag' to find the sectors, so the tag index is used instead of searching through all sectors.
     sector_t* const pSectors = gpSectors;
 
-    for (int32_t sectorIdx = 0; sectorIdx < gNumSectors; ++sectorIdx) {
-        // Ignore this sector if it doesn't have the right tag
-        sector_t& sector = pSectors[sectorIdx];
-
-        if (sector.tag != line.tag)
-            continue;
-
+    for (int32_t sectorIdx = P_FindSectorFromLineTag(line, -1); sectorIdx >= 0; sectorIdx = P_FindSectorFromLineTag(line, sectorIdx)) {
         // Try to find a teleport destination that is in the target sector
         for (mobj_t* pDstMarker = gMobjHead.next; pDstMarker != &gMobjHead; pDstMarker = pDstMarker->next) {
             // Ignore if the marker is not a teleport marker or not in this sector
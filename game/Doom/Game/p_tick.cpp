@@ -38,7 +38,10 @@
 #include "PsyDoom/PsxPadButtons.h"
 #include "PsyDoom/SaveAndLoad.h"
 #include "PsyDoom/ScriptingEngine.h"
+#include "PsyDoom/SectorPvs.h"
+#include "PsyDoom/SimProfiler.h"
 #include "PsyDoom/Video.h"
+#include "PsyDoom/ZoneTrace.h"
 #include "PsyQ/LIBGPU.h"
 #include "Wess/psxcd.h"
 #include "Wess/psxspu.h"
@@ -127,21 +130,30 @@ void P_RemoveThinker(thinker_t& thinker) noexcept {
 // Execute think logic for all thinkers
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_RunThinkers() noexcept {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::RunThinkers);     // PsyDoom: profile if enabled
     gNumActiveThinkers = 0;
 
-    for (thinker_t* pThinker = gThinkerCap.next; pThinker != &gThinkerCap; pThinker = pThinker->next) {
+    thinker_t* pThinker = gThinkerCap.next;
+
+    while (pThinker != &gThinkerCap) {
         if ((intptr_t) pThinker->function == (intptr_t) -1) {
-            // Time to remove this thinker, it's function has been zapped
+            // Time to remove this thinker, it's function has been zapped.
+            // PsyDoom: get the next thinker before freeing this one - the original code read the 'next' field of the thinker after freeing it.
+            // Note: the next thinker must NOT be fetched before running a thinker, since any thinkers it spawns must still run this tic.
+            thinker_t* const pNextThinker = pThinker->next;
             pThinker->next->prev = pThinker->prev;
             pThinker->prev->next = pThinker->next;
             Z_Free2(*gpMainMemZone, pThinker);
+            pThinker = pNextThinker;
         } else {
             // Run the thinker if it has a think function and increment the active count stat
             if (pThinker->function) {
+                SIM_PROFILE_SCOPE(SimProfiler::Category::Thinker, SimProfiler::fnId(pThinker->function));
                 pThinker->function(*pThinker);
             }
 
             gNumActiveThinkers++;
+            pThinker = pThinker->next;
         }
     }
 }
@@ -150,10 +162,25 @@ void P_RunThinkers() noexcept {
 // Execute the 'late call' update function for all map objects
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_RunMobjLate() noexcept {
-    for (mobj_t* pMobj = gMobjHead.next; pMobj != &gMobjHead; pMobj = pMobj->next) {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::RunMobjLate);     // PsyDoom: profile if enabled
+
+    mobj_t* pMobj = gMobjHead.next;
+
+    while (pMobj != &gMobjHead) {
+        // PsyDoom: if the late call removes this thing then get the next thing beforehand - the original code read it from freed memory.
+        // Note: for any other late call the next thing must only be fetched afterwards, since it might spawn or remove other things.
+        mobj_t* pNextMobj = nullptr;
+
         if (pMobj->latecall) {
+            if (pMobj->latecall == &P_RemoveMobj) {
+                pNextMobj = pMobj->next;
+            }
+
+            SIM_PROFILE_SCOPE(SimProfiler::Category::LateCall, SimProfiler::fnId(pMobj->latecall), pMobj->type);
             pMobj->latecall(*pMobj);
         }
+
+        pMobj = (pNextMobj) ? pNextMobj : pMobj->next;
     }
 }
 
@@ -668,8 +695,9 @@ gameaction_t P_Ticker() noexcept {
             gStatusBar.messageTicsLeft = 30;
         }
 
-        // PsyDoom: update the frame start times for interpolation and snap the player's position
-        if (PlayerPrefs::gbUncapFramerate) {
+        // PsyDoom: update the frame start times for interpolation and snap the player's position.
+        // Nothing is drawn for a max speed simulation so this can be skipped in that case.
+        if (PlayerPrefs::gbUncapFramerate && (!ProgArgs::gbMaxSpeedSim)) {
             R_SnapPlayerInterpolation();
             R_InterpBeginPlayerFrame();
 
@@ -731,9 +759,14 @@ gameaction_t P_Ticker() noexcept {
         P_RespawnSpecials();
         ST_Ticker();
 
-        // PsyDoom: allow the developer map auto-reloader to do it's thing and trigger a map reload if required
+        // PsyDoom: allow the developer map auto-reloader to do it's thing and trigger a map reload if required.
+        // Also sample the state of the zone heap if tracing it.
         #if PSYDOOM_MODS
             DevMapAutoReloader::update();
+
+            if (ZoneTrace::gbIsTracing) {
+                ZoneTrace::onGameTic(gGameTic);
+            }
         #endif
     }
 
@@ -752,6 +785,7 @@ gameaction_t P_Ticker() noexcept {
 
         // Do automap and player updates (controls, movement etc.)
         AM_Control(player);
+        SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::PlayerThink);     // PsyDoom: profile if enabled
         P_PlayerThink(player);
     }
 
@@ -799,6 +833,15 @@ void P_Drawer() noexcept {
             gTotalVBlanks += demoTickVBlanks;
             gLastTotalVBlanks = gTotalVBlanks;
             gElapsedVBlanks = demoTickVBlanks;
+
+            // PsyDoom: if requested, check that the Vulkan renderer builds the same frame with and without job threads (no actual drawing)
+            #if PSYDOOM_VULKAN_RENDERER
+                if (ProgArgs::gbCheckVkDrawJobs && (!(gPlayers[gCurPlayerIndex].automapflags & AF_ACTIVE))) {
+                    I_IncDrawnFrameCount();
+                    RV_CheckDrawJobs();
+                }
+            #endif
+
             return;
         }
     #endif
@@ -913,9 +956,15 @@ void P_Start() noexcept {
 // Shuts down main gameplay
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_Stop([[maybe_unused]] const gameaction_t exitAction) noexcept {
-    // PsyDoom: end the level timer
+    // PsyDoom: end the level timer and summarize zone heap usage and sight checks for the level if gathering stats for them
     #if PSYDOOM_MODS
         Game::stopLevelTimer();
+
+        if (ZoneTrace::gbIsTracing) {
+            ZoneTrace::onLevelEnd(gGameMap);
+        }
+
+        SectorPvs::onLevelEnd(gGameMap);
     #endif
 
     // Finish up any GPU related work
@@ -4,6 +4,7 @@
 // The module is initialized on starting a level and frees resources on ending a level.
 // 
 // Note: if the Vulkan renderer is not supported then initializing VK level data is a no-op.
+// The exception to this is the draw check debug mode ('-vkdrawcheck'), which builds Vulkan renderer geometry without a GPU.
 //------------------------------------------------------------------------------------------------------------------------------------------
 #include "rv_data.h"
 
@@ -12,7 +13,11 @@
 #include "Asserts.h"
 #include "Doom/Game/p_setup.h"
 #include "Doom/Renderer/r_local.h"
+#include "PsyDoom/ProgArgs.h"
 #include "PsyDoom/Video.h"
+#include "rv_geomcache.h"
+#include "rv_jobs.h"
+#include "rv_main.h"
 #include "rv_utils.h"
 
 #include <cmath>
@@ -43,6 +48,8 @@ static void RV_InitSegs() noexcept {
         dstSeg.length = (float) std::sqrt(edgeDx * edgeDx + edgeDy * edgeDy);
 
         dstSeg.uOffset = RV_FixedToFloat(srcSeg.offset);
+        dstSeg.texOffsetU = 0;
+        dstSeg.texOffsetV = 0;
         dstSeg.angle = srcSeg.angle;
         dstSeg.flags = srcSeg.flags;
         dstSeg.sidedef = srcSeg.sidedef;
@@ -85,12 +92,14 @@ void RV_InitLevelData() noexcept {
     ASSERT(gpLeafEdges);
 
     // If Vulkan is not supported then this is a no-op
-    if (Video::gBackendType != Video::BackendType::Vulkan)
+    if ((Video::gBackendType != Video::BackendType::Vulkan) && (!ProgArgs::gbCheckVkDrawJobs))
         return;
 
-    // Initialize basic data structures
+    // Initialize basic data structures, the world geometry cache and start the threads used to build frames in parallel (if any)
     RV_InitSegs();
     RV_InitLeafEdges();
+    RV_InitGeomCache();
+    RV_InitJobThreads();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -98,9 +107,16 @@ void RV_InitLevelData() noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 void RV_FreeLevelData() noexcept {
     // If Vulkan is not supported then this is a no-op
-    if (Video::gBackendType != Video::BackendType::Vulkan)
+    if ((Video::gBackendType != Video::BackendType::Vulkan) && (!ProgArgs::gbCheckVkDrawJobs))
         return;
 
+    // Print the results of the draw check debug mode for the level, if active
+    if (ProgArgs::gbCheckVkDrawJobs) {
+        RV_PrintDrawJobsCheckResults();
+    }
+
+    RV_ShutdownJobThreads();
+    RV_FreeGeomCache();
     gpRvLeafEdges.reset();
     gpRvSegs.reset();
 }
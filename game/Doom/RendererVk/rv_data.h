@@ -17,6 +17,8 @@ struct rvseg_t {
     float       v2x, v2y;       // Vertex 2: xy position (Doom world coord system)
     float       uOffset;        // Texture coordinate 'U' offset for the seg
     float       length;         // Length of the line segment
+    fixed_t     texOffsetU;     // Interpolated texture offsets of the seg's side for the current frame (see 'RV_PrepSubsecWallsForDraw')
+    fixed_t     texOffsetV;
     angle_t     angle;          // Precomputed angle for the line segment direction
     uint32_t    flags;          // Flags for the line segment (SGF_XXX flags)
     side_t*     sidedef;        // Which side the segment belongs to
@@ -14,14 +14,12 @@
 #include "PsyDoom/Vulkan/VTypes.h"
 #include "rv_bsp.h"
 #include "rv_data.h"
+#include "rv_geomcache.h"
 #include "rv_main.h"
 #include "rv_utils.h"
 
 #include <cmath>
 
-static int32_t gNextFloorDrawSubsecIdx;     // Index of the next draw subsector to have its floor drawn
-static int32_t gNextCeilDrawSubsecIdx;      // Index of the next draw subsector to have its ceiling drawn
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Figures out a 2D point (on the XZ plane) to act as the center of a triangle fan type arrangement for the subsector.
 // The subsector is convex so we should be able to do a triangle fan from this point to every other subector edge, in order to fill it.
@@ -53,11 +51,8 @@ static void RV_DrawPlane(
     const uint8_t colR,
     const uint8_t colG,
     const uint8_t colB,
-    texture_t& tex
+    const texture_t& tex
 ) noexcept {
-    // Upload the texture to VRAM if required
-    RV_UploadDirtyTex(tex);
-
     // Get the texture page location for this texture
     uint16_t texWinX, texWinY;
     uint16_t texWinW, texWinH;
@@ -77,9 +72,8 @@ static void RV_DrawPlane(
     float uOffset, vOffset;
 
     {
-        sector_t& sector = *subsec.sector;
-        const fixed_t texOffsetX = (IsFloor) ? sector.floorTexOffsetX.renderValue() : sector.ceilTexOffsetX.renderValue();
-        const fixed_t texOffsetY = (IsFloor) ? sector.floorTexOffsetY.renderValue() : sector.ceilTexOffsetY.renderValue();
+        fixed_t texOffsetX, texOffsetY;
+        RV_GetSectorFlatTexOffsets(*subsec.sector, IsFloor, texOffsetX, texOffsetY);
         const fixed_t wrapTexOffsetX = (texOffsetX & ((texWinX << FRACBITS) - 1));
         const fixed_t wrapTexOffsetY = (texOffsetY & ((texWinY << FRACBITS) - 1));
         uOffset = RV_FixedToFloat(wrapTexOffsetX);
@@ -133,151 +127,140 @@ static void RV_DrawPlane(
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draw the floor or ceiling plane for the specified subsector.
-// Assumes the correct drawing pipeline has been set beforehand.
+// The plane is drawn from the geometry cache, which is rebuilt first if anything affecting the plane has changed.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void RV_DrawFlat(const subsector_t& subsec, const bool bDrawFloor, const uint8_t colR, const uint8_t colG, const uint8_t colB) noexcept {
+template <bool IsFloor>
+static void RV_DrawFlat(const subsector_t& subsec) noexcept {
     // Ignore degenerate subsectors: I don't think this should ever be the case but add for safety
     if (subsec.numLeafEdges <= 2)
         return;
 
-    // Drawing the floor or ceiling?
+    // Draw the floor plane if the view is above it and if it's a normal floor (not a sky floor).
+    // Draw the ceiling plane if the view is below it and if it's a normal ceiling (not a sky ceiling).
+    // Note that sky floors are new engine feature added by PsyDoom.
     const sector_t& sector = *subsec.sector;
+    const fixed_t planeH = (IsFloor) ? sector.floorDrawH : sector.ceilingDrawH;
+    const int32_t planePic = (IsFloor) ? sector.floorpic : sector.ceilingpic;
+    const float planeHf = RV_FixedToFloat(planeH);
+    const bool bViewFacingPlane = (IsFloor) ? (gViewZf > planeHf) : (gViewZf < planeHf);
 
-    if (bDrawFloor) {
-        // Draw the floor plane if the view is above it and if it's a normal floor (not a sky floor).
-        // Note that sky floors are new engine feature added by PsyDoom.
-        const float floorH = RV_FixedToFloat(sector.floorDrawH);
-
-        if (gViewZf > floorH) {
-            if (sector.floorpic >= 0) {
-                texture_t& floorTex = gpFlatTextures[gpFlatTranslation[sector.floorpic]];
-                RV_DrawPlane<true>(subsec, floorH, colR, colG, colB, floorTex);
-            }
-        }
-    }
-    else {
-        // Draw the ceiling plane if the view is below it and if it's a normal ceiling (not a sky ceiling).
-        const float ceilH = RV_FixedToFloat(sector.ceilingDrawH);
-
-        if (gViewZf < ceilH) {
-            if (sector.ceilingpic >= 0) {
-                texture_t& ceilingTex = gpFlatTextures[gpFlatTranslation[sector.ceilingpic]];
-                RV_DrawPlane<false>(subsec, ceilH, colR, colG, colB, ceilingTex);
-            }
-        }
-    }
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-// Must be called before drawing subsectors and their flats.
-// Initializes which subsector floor and ceiling is to be drawn next.
-//------------------------------------------------------------------------------------------------------------------------------------------
-void RV_InitNextDrawFlats() noexcept {
-    const int32_t lastSubsecIdx = (int32_t) gRvDrawSubsecs.size() - 1;
-    gNextFloorDrawSubsecIdx = lastSubsecIdx;
-    gNextCeilDrawSubsecIdx = lastSubsecIdx;
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-// Draws floors starting at the given draw subsector index. Tries to batch together as many similar floors (same height) as possible.
-// We draw flats in this way to try and avoid artifacts where sprites that extend into the floor/ceiling get cut off by neighboring flats.
-// Sprites which exhibit this problem are explosions and fireballs. Merging flat planes helps avoid it.
-//------------------------------------------------------------------------------------------------------------------------------------------
-void RV_DrawSubsecFloors(const int32_t fromDrawSubsecIdx) noexcept {
-    ASSERT((fromDrawSubsecIdx >= 0) && (fromDrawSubsecIdx < (int32_t) gRvDrawSubsecs.size()));
-
-    // If we've already drawn the floors for this subsector then we are done
-    if (gNextFloorDrawSubsecIdx != fromDrawSubsecIdx)
+    if ((!bViewFacingPlane) || (planePic < 0))
         return;
 
-    while (true) {
-        // Get the light/color value for the sector
-        const subsector_t& subsec = *gRvDrawSubsecs[gNextFloorDrawSubsecIdx];
-        const sector_t& sector = *subsec.sector;
+    // Rebuild the cached plane if anything affecting it has changed
+    rvsubsecgeom_t& subsecGeom = gpRvSubsecGeom[&subsec - gpSubsectors];
+    rvflatgeom_t& cache = (IsFloor) ? subsecGeom.floor : subsecGeom.ceiling;
+    const uint32_t sectorVersion = RV_GetSectorGeomVersion(sector);
 
+    if ((cache.cacheEpoch != gRvGeomCacheEpoch) || (cache.sectorVersion != sectorVersion)) {
+        // Get the light/color value for the plane
         uint8_t secR;
         uint8_t secG;
         uint8_t secB;
-        R_GetSectorDrawColor(sector, sector.floorDrawH, secR, secG, secB);
+        R_GetSectorDrawColor(sector, planeH, secR, secG, secB);
 
-        // Draw the floor
-        RV_DrawFlat(subsec, true, secR, secG, secB);
-        gNextFloorDrawSubsecIdx--;
+        // Draw the plane to the cache
+        cache.geom.clear();
+        VDrawing::DrawStream* const pPrevDrawStream = VDrawing::beginDrawStream(cache.geom);
 
-        // Should we end the draw batch here?
-        // Stop if there is no next draw sector, if this subsector (or the next) is not batchable or if the floor height changes.
-        if (gNextFloorDrawSubsecIdx < 0)
-            break;
+        const texture_t& planeTex = gpFlatTextures[gpFlatTranslation[planePic]];
+        RV_DrawPlane<IsFloor>(subsec, planeHf, secR, secG, secB, planeTex);
 
-        const subsector_t& nextSubsec = *gRvDrawSubsecs[gNextFloorDrawSubsecIdx];
-        const sector_t& nextSector = *nextSubsec.sector;
-        const bool bAllowBatching = (subsec.bVkCanBatchFlats && nextSubsec.bVkCanBatchFlats);
+        VDrawing::endDrawStream(pPrevDrawStream);
+        cache.cacheEpoch = gRvGeomCacheEpoch;
+        cache.sectorVersion = sectorVersion;
+    }
 
-        if (!bAllowBatching)
-            break;
+    // Draw the plane
+    VDrawing::submitDrawStream(cache.geom);
+}
 
-        if (nextSector.floorDrawH != sector.floorDrawH)
-            break;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the floor or ceiling for the given draw subsector can be drawn in the same batch as the one for the draw subsector before it.
+// Flats are batched while both subsectors allow it, and until there is a change in height or a change in sky status.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <bool IsFloor>
+static bool RV_CanBatchSubsecFlats(const int32_t prevDrawSubsecIdx, const int32_t drawSubsecIdx) noexcept {
+    const subsector_t& prevSubsec = *gRvDrawSubsecs[prevDrawSubsecIdx];
+    const subsector_t& subsec = *gRvDrawSubsecs[drawSubsecIdx];
 
-        // Also break the batch if there is a change in sky floor status.
-        // If we don't do this then sky walls can sometimes bleed through to other neighboring floors:
-        const bool bIsSkyFloor = (sector.floorpic == -1);
-        const bool bIsNextSkyFloor = (nextSector.floorpic == -1);
+    if ((!prevSubsec.bVkCanBatchFlats) || (!subsec.bVkCanBatchFlats))
+        return false;
 
-        if (bIsSkyFloor != bIsNextSkyFloor)
-            break;
+    // Note: the batch must also be broken if there is a change in sky status.
+    // If we don't do this then sky walls can sometimes bleed through to other neighboring flats.
+    const sector_t& prevSector = *prevSubsec.sector;
+    const sector_t& sector = *subsec.sector;
+
+    if constexpr (IsFloor) {
+        return ((sector.floorDrawH == prevSector.floorDrawH) && ((sector.floorpic == -1) == (prevSector.floorpic == -1)));
+    } else {
+        return ((sector.ceilingDrawH == prevSector.ceilingDrawH) && ((sector.ceilingpic == -1) == (prevSector.ceilingpic == -1)));
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Draws ceilings starting at the given draw subsector index. Tries to batch together as many similar ceilings (same height) as possible.
-// We draw flats in this way to try and avoid artifacts where sprites that extend into the floor/ceiling get cut off by neighboring flats.
-// Sprites which exhibit this problem are explosions and fireballs. Merging flat planes helps avoid it.
+// Draws floors or ceilings starting at the given draw subsector index, if the subsector starts a new batch of flats.
+// Tries to batch together as many similar flats (same height) as possible.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void RV_DrawSubsecCeilings(const int32_t fromDrawSubsecIdx) noexcept {
-    ASSERT((fromDrawSubsecIdx >= 0) && (fromDrawSubsecIdx < (int32_t) gRvDrawSubsecs.size()));
-
-    // If we've already drawn the ceilings for this subsector then we are done
-    if (gNextCeilDrawSubsecIdx != fromDrawSubsecIdx)
+template <bool IsFloor>
+static void RV_DrawSubsecFlats(const int32_t fromDrawSubsecIdx) noexcept {
+    const int32_t lastDrawSubsecIdx = (int32_t) gRvDrawSubsecs.size() - 1;
+    ASSERT((fromDrawSubsecIdx >= 0) && (fromDrawSubsecIdx <= lastDrawSubsecIdx));
+
+    // If this subsector's flat is part of a batch started by the previous draw subsector then it has already been drawn.
+    // Note: deciding this from the subsectors alone (rather than remembering which subsector is next) allows subsectors to be drawn in
+    // separate jobs, while still giving exactly the same batches.
+    if ((fromDrawSubsecIdx < lastDrawSubsecIdx) && RV_CanBatchSubsecFlats<IsFloor>(fromDrawSubsecIdx + 1, fromDrawSubsecIdx))
         return;
 
-    while (true) {
-        // Get the light/color value for the sector
-        const subsector_t& subsec = *gRvDrawSubsecs[gNextCeilDrawSubsecIdx];
-        const sector_t& sector = *subsec.sector;
+    for (int32_t drawSubsecIdx = fromDrawSubsecIdx; drawSubsecIdx >= 0; --drawSubsecIdx) {
+        // Draw the floor or ceiling
+        RV_DrawFlat<IsFloor>(*gRvDrawSubsecs[drawSubsecIdx]);
 
-        uint8_t secR;
-        uint8_t secG;
-        uint8_t secB;
-        R_GetSectorDrawColor(sector, sector.ceilingDrawH, secR, secG, secB);
-
-        // Draw the ceiling
-        RV_DrawFlat(subsec, false, secR, secG, secB);
-        gNextCeilDrawSubsecIdx--;
-
-        // Should we end the draw batch here?
-        // Stop if there is no next draw sector, if this subsector (or the next) is not batchable or if the ceiling height changes.
-        if (gNextCeilDrawSubsecIdx < 0)
+        // Should we end the draw batch here? Stop if there is no next draw sector or if the next flat can't be batched with this one.
+        if ((drawSubsecIdx > 0) && (!RV_CanBatchSubsecFlats<IsFloor>(drawSubsecIdx, drawSubsecIdx - 1)))
             break;
+    }
+}
 
-        const subsector_t& nextSubsec = *gRvDrawSubsecs[gNextCeilDrawSubsecIdx];
-        const sector_t& nextSector = *nextSubsec.sector;
-        const bool bAllowBatching = (subsec.bVkCanBatchFlats && nextSubsec.bVkCanBatchFlats);
-
-        if (!bAllowBatching)
-            break;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Must be called for each draw subsector before its flats are drawn, and on the main thread.
+// Uploads the floor and ceiling textures to VRAM if required and if they will be drawn.
+// This is done separately from drawing, so that flats can be drawn on other threads.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_PrepSubsecFlatsForDraw(const subsector_t& subsec) noexcept {
+    // Note: these checks must match the ones in 'RV_DrawFlat'
+    if (subsec.numLeafEdges <= 2)
+        return;
 
-        if (nextSector.ceilingDrawH != sector.ceilingDrawH)
-            break;
+    const sector_t& sector = *subsec.sector;
 
-        // Also break the batch if there is a change in sky ceiling status.
-        // If we don't do this then sky walls can sometimes bleed through to other neighboring ceilings:
-        const bool bIsSkyCeil = (sector.ceilingpic == -1);
-        const bool bIsNextSkyCeil = (nextSector.ceilingpic == -1);
+    if ((gViewZf > RV_FixedToFloat(sector.floorDrawH)) && (sector.floorpic >= 0)) {
+        RV_UploadDirtyTex(gpFlatTextures[gpFlatTranslation[sector.floorpic]]);
+    }
 
-        if (bIsSkyCeil != bIsNextSkyCeil)
-            break;
+    if ((gViewZf < RV_FixedToFloat(sector.ceilingDrawH)) && (sector.ceilingpic >= 0)) {
+        RV_UploadDirtyTex(gpFlatTextures[gpFlatTranslation[sector.ceilingpic]]);
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws floors starting at the given draw subsector index. Tries to batch together as many similar floors (same height) as possible.
+// We draw flats in this way to try and avoid artifacts where sprites that extend into the floor/ceiling get cut off by neighboring flats.
+// Sprites which exhibit this problem are explosions and fireballs. Merging flat planes helps avoid it.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_DrawSubsecFloors(const int32_t fromDrawSubsecIdx) noexcept {
+    RV_DrawSubsecFlats<true>(fromDrawSubsecIdx);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws ceilings starting at the given draw subsector index. Tries to batch together as many similar ceilings (same height) as possible.
+// We draw flats in this way to try and avoid artifacts where sprites that extend into the floor/ceiling get cut off by neighboring flats.
+// Sprites which exhibit this problem are explosions and fireballs. Merging flat planes helps avoid it.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_DrawSubsecCeilings(const int32_t fromDrawSubsecIdx) noexcept {
+    RV_DrawSubsecFlats<false>(fromDrawSubsecIdx);
+}
+
 #endif  // #if PSYDOOM_VULKAN_RENDERER
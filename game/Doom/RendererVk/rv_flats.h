@@ -6,7 +6,7 @@ struct subsector_t;
 
 #include <cstdint>
 
-void RV_InitNextDrawFlats() noexcept;
+void RV_PrepSubsecFlatsForDraw(const subsector_t& subsec) noexcept;
 void RV_DrawSubsecFloors(const int32_t fromDrawSubsecIdx) noexcept;
 void RV_DrawSubsecCeilings(const int32_t fromDrawSubsecIdx) noexcept;
 
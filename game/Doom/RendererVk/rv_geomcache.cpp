@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Caching of static world geometry for the new Vulkan renderer.
+//
+// Most of the walls and flats in a level never change, so rather than regenerating all of their vertices every frame the Vulkan renderer
+// keeps the vertices generated for each subsector and re-uses them until something affecting them changes. Changes are detected by
+// keeping a copy of the state of each sector that affects its geometry (heights, textures, lighting etc.) and comparing that against the
+// current sector state once per frame for the sectors that are drawn. When the state changes the sector's 'geometry version' is bumped,
+// which invalidates all cached geometry built using the sector.
+//
+// Doing things this way means the cache does not need to be told about changes made by sector movers, lighting effects, scrolling flats,
+// Lua scripts and so on: any change to a sector that would affect its geometry is automatically detected. It also handles interpolated
+// sector movement, which changes the draw height of a sector every frame (not just on the game tics where the sector moves).
+//
+// Some global drawing state also affects the geometry generated (the current palette, view lighting etc.) and when any of that changes
+// the entire cache is invalidated by moving onto a new 'cache epoch'.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "rv_geomcache.h"
+
+#if PSYDOOM_VULKAN_RENDERER
+
+#include "Doom/Base/i_main.h"
+#include "Doom/Game/g_game.h"
+#include "Doom/Game/p_setup.h"
+#include "Doom/Renderer/r_data.h"
+#include "Doom/Renderer/r_local.h"
+#include "Doom/Renderer/r_main.h"
+#include "PsyDoom/Vulkan/VTypes.h"
+#include "rv_main.h"
+
+#include <cstring>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// The state of a sector which affects the geometry generated for it (walls and flats)
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SectorGeomState {
+    fixed_t     floorDrawH;
+    fixed_t     ceilingDrawH;
+    int32_t     floorTexNum;            // Floor and ceiling textures (after animation) or '-1' for a sky
+    int32_t     ceilTexNum;
+    fixed_t     floorTexOffsetX;        // Flat texture offsets (interpolated)
+    fixed_t     floorTexOffsetY;
+    fixed_t     ceilTexOffsetX;
+    fixed_t     ceilTexOffsetY;
+    int32_t     lightlevel;             // Lighting and 2-colored lighting parameters
+    int32_t     colorid;
+    int32_t     ceilColorid;
+    fixed_t     lowerColorZ;
+    fixed_t     upperColorZ;
+    fixed_t     shadeHeightDiv;
+};
+
+// N.B: sector geometry states are compared with 'memcmp', so there must be no padding!
+static_assert(sizeof(SectorGeomState) == sizeof(int32_t) * 14);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tracks changes to the geometry state for a sector
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SectorGeomInfo {
+    SectorGeomState     state;              // The state of the sector when it was last checked
+    uint32_t            version;            // Incremented whenever the state changes
+    uint32_t            checkedFrameNum;    // Which frame the sector state was last checked in
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Global drawing state which affects the geometry generated for all sectors
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct GlobalGeomState {
+    uint16_t        clutX;
+    uint16_t        clutY;
+    VPipelineType   opaqueGeomPipeline;
+    bool            bDoViewLighting;
+    uint32_t        extraLight;
+};
+
+std::unique_ptr<rvsubsecgeom_t[]>   gpRvSubsecGeom;         // Cached geometry for each subsector in the level: same count as in 'p_setup.cpp'
+uint32_t                            gRvGeomCacheEpoch;      // Geometry built in a previous epoch is invalid
+
+static std::unique_ptr<SectorGeomInfo[]>    gpSectorGeomInfo;           // Geometry change tracking for each sector in the level
+static GlobalGeomState                      gGlobalGeomState;           // The global draw state for the current cache epoch
+static uint32_t                             gGeomCacheFrameNum;         // Incremented at the start of each frame
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the current geometry state for the specified sector
+//------------------------------------------------------------------------------------------------------------------------------------------
+static SectorGeomState RV_GetSectorGeomState(sector_t& sector) noexcept {
+    SectorGeomState state = {};
+    state.floorDrawH = sector.floorDrawH;
+    state.ceilingDrawH = sector.ceilingDrawH;
+    state.floorTexNum = (sector.floorpic >= 0) ? gpFlatTranslation[sector.floorpic] : -1;
+    state.ceilTexNum = (sector.ceilingpic >= 0) ? gpFlatTranslation[sector.ceilingpic] : -1;
+    state.floorTexOffsetX = sector.floorTexOffsetX.renderValue();
+    state.floorTexOffsetY = sector.floorTexOffsetY.renderValue();
+    state.ceilTexOffsetX = sector.ceilTexOffsetX.renderValue();
+    state.ceilTexOffsetY = sector.ceilTexOffsetY.renderValue();
+    state.lightlevel = sector.lightlevel;
+    state.colorid = sector.colorid;
+    state.ceilColorid = sector.ceilColorid;
+    state.lowerColorZ = sector.lowerColorZ;
+    state.upperColorZ = sector.upperColorZ;
+    state.shadeHeightDiv = sector.shadeHeightDiv;
+    return state;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Initializes the geometry cache for the current level; the cache starts out empty
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_InitGeomCache() noexcept {
+    gpRvSubsecGeom.reset(new rvsubsecgeom_t[gNumSubsectors]());
+    gpSectorGeomInfo.reset(new SectorGeomInfo[gNumSectors]());
+
+    // Note: cached geometry is initially built in epoch '0' which makes it invalid, since the first frame will begin epoch '1'
+    gRvGeomCacheEpoch = 0;
+    gGlobalGeomState = {};
+    gGeomCacheFrameNum = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Frees all cached geometry and change tracking for the current level
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_FreeGeomCache() noexcept {
+    gpSectorGeomInfo.reset();
+    gpRvSubsecGeom.reset();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Must be called at the start of each frame, after the draw parameters for the frame have been determined.
+// Invalidates all cached geometry if any of the global draw state which affects geometry has changed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_BeginGeomCacheFrame() noexcept {
+    gGeomCacheFrameNum++;
+
+    GlobalGeomState globalState = {};
+    globalState.clutX = gClutX;
+    globalState.clutY = gClutY;
+    globalState.opaqueGeomPipeline = gOpaqueGeomPipeline;
+    globalState.bDoViewLighting = gbDoViewLighting;
+    globalState.extraLight = gPlayers[gCurPlayerIndex].extralight;
+
+    const bool bGlobalStateChanged = (
+        (globalState.clutX != gGlobalGeomState.clutX) ||
+        (globalState.clutY != gGlobalGeomState.clutY) ||
+        (globalState.opaqueGeomPipeline != gGlobalGeomState.opaqueGeomPipeline) ||
+        (globalState.bDoViewLighting != gGlobalGeomState.bDoViewLighting) ||
+        (globalState.extraLight != gGlobalGeomState.extraLight)
+    );
+
+    if ((gRvGeomCacheEpoch == 0) || bGlobalStateChanged) {
+        gGlobalGeomState = globalState;
+        gRvGeomCacheEpoch++;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Checks for changes to the geometry state of the given sector (once per frame) and bumps the sector's geometry version if it changed.
+// This must be done on the main thread for each sector that geometry is drawn for, before any of that geometry is drawn.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_UpdateSectorGeomVersion(sector_t& sector) noexcept {
+    const int32_t sectorIdx = (int32_t)(&sector - gpSectors);
+    ASSERT((sectorIdx >= 0) && (sectorIdx < gNumSectors));
+    SectorGeomInfo& info = gpSectorGeomInfo[sectorIdx];
+
+    if (info.checkedFrameNum == gGeomCacheFrameNum)
+        return;
+
+    info.checkedFrameNum = gGeomCacheFrameNum;
+    const SectorGeomState state = RV_GetSectorGeomState(sector);
+
+    // Note: versions start at '1' so that '0' can be used to mean 'no sector'
+    if ((info.version == 0) || (std::memcmp(&state, &info.state, sizeof(SectorGeomState)) != 0)) {
+        info.state = state;
+        info.version++;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns the current geometry version for the specified sector, which must have been updated for this frame
+//------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t RV_GetSectorGeomVersion(const sector_t& sector) noexcept {
+    const int32_t sectorIdx = (int32_t)(&sector - gpSectors);
+    ASSERT((sectorIdx >= 0) && (sectorIdx < gNumSectors));
+    const SectorGeomInfo& info = gpSectorGeomInfo[sectorIdx];
+
+    ASSERT_LOG(info.checkedFrameNum == gGeomCacheFrameNum, "Sector geometry version not updated for this frame!");
+    return info.version;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns the interpolated floor or ceiling texture offsets for the specified sector, as resolved when its geometry version was updated.
+// Unlike querying the sector's interpolated offsets directly this does not modify the sector, so it can be done from any thread.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_GetSectorFlatTexOffsets(const sector_t& sector, const bool bFloor, fixed_t& texOffsetX, fixed_t& texOffsetY) noexcept {
+    const int32_t sectorIdx = (int32_t)(&sector - gpSectors);
+    ASSERT((sectorIdx >= 0) && (sectorIdx < gNumSectors));
+    const SectorGeomInfo& info = gpSectorGeomInfo[sectorIdx];
+
+    ASSERT_LOG(info.checkedFrameNum == gGeomCacheFrameNum, "Sector geometry version not updated for this frame!");
+    texOffsetX = (bFloor) ? info.state.floorTexOffsetX : info.state.ceilTexOffsetX;
+    texOffsetY = (bFloor) ? info.state.floorTexOffsetY : info.state.ceilTexOffsetY;
+}
+
+#endif  // #if PSYDOOM_VULKAN_RENDERER
@@ -0,0 +1,65 @@
+#pragma once
+
+#if PSYDOOM_VULKAN_RENDERER
+
+#include "Doom/doomdef.h"
+#include "PsyDoom/Vulkan/VDrawing.h"
+
+#include <memory>
+#include <vector>
+
+struct sector_t;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Cached geometry for a floor or ceiling plane in a subsector
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct rvflatgeom_t {
+    uint32_t                cacheEpoch;         // Which cache epoch the geometry was built in (see 'gRvGeomCacheEpoch')
+    uint32_t                sectorVersion;      // Which version of the sector's geometry state the geometry was built from
+    VDrawing::DrawStream    geom;               // The cached geometry
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Holds everything about a seg which affects the opaque walls generated for it, other than the state of the front and back sectors
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct rvsegwallskey_t {
+    uint32_t    backSectorVersion;      // Geometry version for the back sector or '0' if the seg is one sided or not drawn
+    fixed_t     texOffsetU;             // Texture offsets for the seg's side
+    fixed_t     texOffsetV;
+    int32_t     topTexNum;              // Top, bottom and mid textures (after animation) for the seg's side
+    int32_t     bottomTexNum;
+    int32_t     midTexNum;
+    uint32_t    lineFlags;              // Flags for the seg's line
+    bool        bDrawn;                 // Whether the seg is drawn at all (front facing and visible)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Cached geometry for all of the opaque walls in a subsector
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct rvwallsgeom_t {
+    uint32_t                        cacheEpoch;         // Which cache epoch the geometry was built in (see 'gRvGeomCacheEpoch')
+    uint32_t                        sectorVersion;      // Which version of the front sector's geometry state the geometry was built from
+    std::vector<rvsegwallskey_t>    segKeys;            // The state of each seg in the subsector when the geometry was built
+    VDrawing::DrawStream            geom;               // The cached geometry
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// All of the cached geometry for a subsector
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct rvsubsecgeom_t {
+    rvwallsgeom_t   walls;
+    rvflatgeom_t    floor;
+    rvflatgeom_t    ceiling;
+};
+
+extern std::unique_ptr<rvsubsecgeom_t[]>    gpRvSubsecGeom;
+extern uint32_t                             gRvGeomCacheEpoch;
+
+void RV_InitGeomCache() noexcept;
+void RV_FreeGeomCache() noexcept;
+void RV_BeginGeomCacheFrame() noexcept;
+void RV_UpdateSectorGeomVersion(sector_t& sector) noexcept;
+uint32_t RV_GetSectorGeomVersion(const sector_t& sector) noexcept;
+void RV_GetSectorFlatTexOffsets(const sector_t& sector, const bool bFloor, fixed_t& texOffsetX, fixed_t& texOffsetY) noexcept;
+
+#endif  // #if PSYDOOM_VULKAN_RENDERER
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A small pool of worker threads used by the new Vulkan renderer to build parts of a frame in parallel.
+// Work is split up into a number of numbered jobs which are claimed by the workers (and the calling thread) until all are done.
+// The number of threads is decided by the 'VulkanRendererThreads' config setting; if that is '0' or '1' then no workers are started.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "rv_jobs.h"
+
+#if PSYDOOM_VULKAN_RENDERER
+
+#include "Asserts.h"
+#include "PsyDoom/Config/Config.h"
+#include "PsyDoom/ProgArgs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker thread pool and the synchronization for it
+static std::vector<std::thread>     gJobWorkers;
+static std::mutex                   gJobMutex;
+static std::condition_variable      gJobStartCV;            // Signalled when there is a new batch of jobs to do (or when quitting)
+static std::condition_variable      gJobDoneCV;             // Signalled when the last busy worker finishes with the current batch of jobs
+static uint64_t                     gJobBatchId;            // Incremented for each new batch of jobs
+static int32_t                      gNumJobWorkersBusy;     // How many workers are still working on the current batch of jobs
+static bool                         gbQuitJobWorkers;       // Set when the workers should exit
+
+// The current batch of jobs being done
+static RV_JobFunc                   gJobFunc;
+static int32_t                      gNumJobs;
+static std::atomic<int32_t>         gNextJobIdx;            // Index of the next job for a thread to claim
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does jobs from the current batch until there are no more left to claim.
+// This is called by the worker threads and also the thread which started the batch of jobs.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_DoJobs() noexcept {
+    const RV_JobFunc jobFunc = gJobFunc;
+    const int32_t numJobs = gNumJobs;
+
+    while (true) {
+        const int32_t jobIdx = gNextJobIdx.fetch_add(1, std::memory_order_relaxed);
+
+        if (jobIdx >= numJobs)
+            break;
+
+        jobFunc(jobIdx);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Entry point for worker threads: waits for batches of jobs to do until told to quit
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_JobWorkerMain() noexcept {
+    uint64_t lastBatchId = 0;
+    std::unique_lock<std::mutex> lock(gJobMutex);
+
+    while (true) {
+        gJobStartCV.wait(lock, [&]() noexcept { return (gbQuitJobWorkers || (gJobBatchId != lastBatchId)); });
+
+        if (gbQuitJobWorkers)
+            break;
+
+        lastBatchId = gJobBatchId;
+
+        lock.unlock();
+        RV_DoJobs();
+        lock.lock();
+
+        gNumJobWorkersBusy--;
+
+        if (gNumJobWorkersBusy == 0) {
+            gJobDoneCV.notify_one();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Starts up the worker threads used to build frames in parallel, if the game config asks for more than one thread.
+// For the draw check debug mode workers are always started (as many as the CPU has hardware threads) so the check can be done.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_InitJobThreads() noexcept {
+    ASSERT(gJobWorkers.empty());
+
+    const int32_t cfgNumThreads = Config::gVulkanRendererThreads;
+    const bool bAutoNumThreads = ((cfgNumThreads < 0) || ProgArgs::gbCheckVkDrawJobs);
+    const int32_t numThreads = (bAutoNumThreads) ? (int32_t) std::thread::hardware_concurrency() : cfgNumThreads;
+
+    gJobBatchId = 0;
+    gNumJobWorkersBusy = 0;
+    gbQuitJobWorkers = false;
+
+    for (int32_t i = 1; i < numThreads; ++i) {
+        gJobWorkers.emplace_back(RV_JobWorkerMain);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells all worker threads to exit and waits for them to finish
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_ShutdownJobThreads() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(gJobMutex);
+        gbQuitJobWorkers = true;
+    }
+
+    gJobStartCV.notify_all();
+
+    for (std::thread& worker : gJobWorkers) {
+        worker.join();
+    }
+
+    gJobWorkers.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns the number of threads that jobs are done on, including the thread which runs the jobs
+//------------------------------------------------------------------------------------------------------------------------------------------
+int32_t RV_GetNumJobThreads() noexcept {
+    return (int32_t) gJobWorkers.size() + 1;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does the specified number of jobs using the given function and waits for them all to finish.
+// The calling thread helps out with the jobs. Jobs are started in order of their index, but may finish in any order.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_RunJobs(const int32_t numJobs, const RV_JobFunc jobFunc) noexcept {
+    ASSERT(jobFunc);
+
+    if (numJobs <= 0)
+        return;
+
+    gJobFunc = jobFunc;
+    gNumJobs = numJobs;
+    gNextJobIdx.store(0, std::memory_order_relaxed);
+
+    // Kick off the workers (if any and if there is more than one job) and help out on this thread, then wait for everything to finish
+    if ((!gJobWorkers.empty()) && (numJobs > 1)) {
+        {
+            std::lock_guard<std::mutex> lock(gJobMutex);
+            gJobBatchId++;
+            gNumJobWorkersBusy = (int32_t) gJobWorkers.size();
+        }
+
+        gJobStartCV.notify_all();
+        RV_DoJobs();
+
+        std::unique_lock<std::mutex> lock(gJobMutex);
+        gJobDoneCV.wait(lock, [&]() noexcept { return (gNumJobWorkersBusy == 0); });
+    } else {
+        RV_DoJobs();
+    }
+
+    gJobFunc = nullptr;
+    gNumJobs = 0;
+}
+
+#endif  // #if PSYDOOM_VULKAN_RENDERER
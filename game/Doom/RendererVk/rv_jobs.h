@@ -0,0 +1,19 @@
+#pragma once
+
+#if PSYDOOM_VULKAN_RENDERER
+
+#include <cstdint>
+
+// How many jobs to split work into for each job thread, where work can be split finely.
+// Having more jobs than threads helps to even out the load when some jobs take longer than others.
+static constexpr int32_t RV_JOBS_PER_THREAD = 4;
+
+// Function called to do a single job: receives the index of the job to do
+typedef void (*RV_JobFunc)(const int32_t jobIdx);
+
+void RV_InitJobThreads() noexcept;
+void RV_ShutdownJobThreads() noexcept;
+int32_t RV_GetNumJobThreads() noexcept;
+void RV_RunJobs(const int32_t numJobs, const RV_JobFunc jobFunc) noexcept;
+
+#endif  // #if PSYDOOM_VULKAN_RENDERER
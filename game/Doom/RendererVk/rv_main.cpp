@@ -18,6 +18,7 @@
 #include "Doom/Renderer/r_things.h"
 #include "PsyDoom/Config/Config.h"
 #include "PsyDoom/PlayerPrefs.h"
+#include "PsyDoom/ProgArgs.h"
 #include "PsyDoom/Utils.h"
 #include "PsyDoom/Vulkan/VDrawing.h"
 #include "PsyDoom/Vulkan/VRenderer.h"
@@ -25,12 +26,19 @@
 #include "PsyQ/LIBGPU.h"
 #include "rv_bsp.h"
 #include "rv_flats.h"
+#include "rv_geomcache.h"
+#include "rv_jobs.h"
 #include "rv_occlusion.h"
 #include "rv_sky.h"
 #include "rv_sprites.h"
 #include "rv_utils.h"
 #include "rv_walls.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
 float           gViewXf, gViewYf, gViewZf;      // View position in floating point format
 float           gViewAnglef;                    // View angle in radians (float)
 float           gViewCosf, gViewSinf;           // Sin and cosine for view angle
@@ -39,6 +47,21 @@ Matrix4f        gSpriteBillboardMatrix;         // A transform matrix containing
 Matrix4f        gViewProjMatrix;                // The combined view and projection transform matrix for the scene
 VPipelineType   gOpaqueGeomPipeline;            // The pipeline to use for drawing opaque geometry
 
+// Minimum number of draw subsectors to draw in each world drawing job: avoids making jobs which are too small to be worthwhile
+static constexpr int32_t MIN_SUBSECS_PER_DRAW_JOB = 64;
+
+// The draw streams recorded by each world drawing job for the current frame, and how many jobs there are
+static std::vector<VDrawing::DrawStream> gWorldDrawJobStreams;
+static int32_t gNumWorldDrawJobs;
+
+// Draw streams used by the draw check debug mode ('-vkdrawcheck') to capture the world drawing done with and without jobs
+static VDrawing::DrawStream gDrawCheckStream_NoJobs;
+static VDrawing::DrawStream gDrawCheckStream_Jobs;
+
+// Stats for the draw check debug mode: how many frames have been checked and how many had differences
+static uint32_t gNumDrawCheckFrames;
+static uint32_t gNumDrawCheckMismatches;
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Determine various parameters affecting the draw, including view position, projection matrix and so on
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -160,6 +183,181 @@ static void RV_SetShaderUniformsFor3D() noexcept {
     VDrawing::setDrawUniforms(uniforms);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does all the preparation for drawing the draw subsectors that must be done on the main thread, and in back to front order.
+// This includes updating sector shading params, uploading textures to VRAM, marking walls as seen for the automap, checking for changes
+// to the geometry of sectors and resolving interpolated texture offsets. Once this is done the world can be drawn in any order, and from
+// any thread.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_PrepDrawSubsecs() noexcept {
+    // Increment the marker used to determine when to update the shading params for each sector.
+    // Also invalidate all cached world geometry if the draw params for this frame require it.
+    gValidCount++;
+    RV_BeginGeomCacheFrame();
+
+    const int32_t numDrawSubsecs = (int32_t) gRvDrawSubsecs.size();
+
+    for (int32_t drawSubsecIdx = numDrawSubsecs - 1; drawSubsecIdx >= 0; --drawSubsecIdx) {
+        subsector_t& subsec = *gRvDrawSubsecs[drawSubsecIdx];
+        R_UpdateShadingParams(*subsec.sector);
+        RV_UpdateSectorGeomVersion(*subsec.sector);
+        RV_PrepSubsecWallsForDraw(subsec);
+        RV_PrepSubsecFlatsForDraw(subsec);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws all of the geometry and sprites for the given range of draw subsectors, back to front.
+// The range of subsectors drawn is from 'begDrawSubsecIdx' down to 'endDrawSubsecIdx', not including the end index.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_DrawSubsecRange(const int32_t begDrawSubsecIdx, const int32_t endDrawSubsecIdx) noexcept {
+    for (int32_t drawSubsecIdx = begDrawSubsecIdx; drawSubsecIdx > endDrawSubsecIdx; --drawSubsecIdx) {
+        subsector_t& subsec = *gRvDrawSubsecs[drawSubsecIdx];
+
+        // Draw all subsector sky walls, blended and masked walls
+        RV_DrawSubsecSkyWalls(drawSubsecIdx);
+        RV_DrawSubsecBlendedWalls(subsec);
+
+        // Draw all subsector opaque elements and then sprites on top of that.
+        // Most of the time these should all be on the same draw pipeline, so we can do batching.
+        RV_DrawSubsecOpaqueWalls(subsec);
+        RV_DrawSubsecFloors(drawSubsecIdx);
+        RV_DrawSubsecCeilings(drawSubsecIdx);
+        RV_DrawSubsecSpriteFrags(drawSubsecIdx);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A job which draws a contiguous range of draw subsectors to the draw stream for the job.
+// Job '0' draws the subsectors furthest away, and the last job draws the ones nearest to the viewer.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_DoWorldDrawJob(const int32_t jobIdx) noexcept {
+    const int32_t numDrawSubsecs = (int32_t) gRvDrawSubsecs.size();
+    const int32_t begDrawSubsecIdx = numDrawSubsecs - 1 - (int32_t)(((int64_t) numDrawSubsecs * jobIdx) / gNumWorldDrawJobs);
+    const int32_t endDrawSubsecIdx = numDrawSubsecs - 1 - (int32_t)(((int64_t) numDrawSubsecs * (jobIdx + 1)) / gNumWorldDrawJobs);
+
+    VDrawing::DrawStream& stream = gWorldDrawJobStreams[jobIdx];
+    stream.clear();
+
+    VDrawing::DrawStream* const pPrevDrawStream = VDrawing::beginDrawStream(stream);
+    RV_DrawSubsecRange(begDrawSubsecIdx, endDrawSubsecIdx);
+    VDrawing::endDrawStream(pPrevDrawStream);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws all of the subsectors in the world back to front, after they have been prepared for drawing.
+// If allowed the drawing is split up into jobs and spread over multiple threads, with the results being stitched together afterwards
+// in back to front order. The drawing produced is exactly the same regardless of whether jobs are used or not.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_DrawWorld(const bool bUseJobs) noexcept {
+    // Decide how many jobs to use, if allowed.
+    // If there is just one job then draw everything directly, since there is nothing to be gained by recording a draw stream.
+    const int32_t numDrawSubsecs = (int32_t) gRvDrawSubsecs.size();
+    const int32_t maxJobs = (bUseJobs) ? RV_GetNumJobThreads() * RV_JOBS_PER_THREAD : 1;
+    const int32_t numJobs = std::clamp(numDrawSubsecs / MIN_SUBSECS_PER_DRAW_JOB, 1, maxJobs);
+
+    if (numJobs <= 1) {
+        RV_DrawSubsecRange(numDrawSubsecs - 1, -1);
+        return;
+    }
+
+    // Draw all of the subsectors using jobs, then add what each job drew to the frame in order
+    if ((int32_t) gWorldDrawJobStreams.size() < numJobs) {
+        gWorldDrawJobStreams.resize((size_t) numJobs);
+    }
+
+    gNumWorldDrawJobs = numJobs;
+    RV_RunJobs(numJobs, RV_DoWorldDrawJob);
+
+    for (int32_t jobIdx = 0; jobIdx < numJobs; ++jobIdx) {
+        VDrawing::submitDrawStream(gWorldDrawJobStreams[jobIdx]);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Captures the world drawing for the current frame to the given draw stream, with or without using jobs.
+// Assumes all of the drawing for the frame has already been prepared.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_CaptureWorldDraw(VDrawing::DrawStream& stream, const bool bUseJobs) noexcept {
+    stream.clear();
+
+    VDrawing::DrawStream* const pPrevDrawStream = VDrawing::beginDrawStream(stream);
+    VDrawing::setDrawPipeline(gOpaqueGeomPipeline);
+    RV_BuildSpriteFragLists(bUseJobs);
+    RV_DrawWorld(bUseJobs);
+    VDrawing::endDrawStream(pPrevDrawStream);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if two draw streams contain exactly the same drawing
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool RV_DrawStreamsMatch(const VDrawing::DrawStream& stream1, const VDrawing::DrawStream& stream2) noexcept {
+    if ((stream1.verts.size() != stream2.verts.size()) || (stream1.runs.size() != stream2.runs.size()))
+        return false;
+
+    for (size_t i = 0; i < stream1.runs.size(); ++i) {
+        const VDrawing::DrawStream::PipelineRun& run1 = stream1.runs[i];
+        const VDrawing::DrawStream::PipelineRun& run2 = stream2.runs[i];
+
+        if ((run1.pipelineType != run2.pipelineType) || (run1.numVerts != run2.numVerts))
+            return false;
+    }
+
+    return (std::memcmp(stream1.verts.data(), stream2.verts.data(), sizeof(VVertex_Draw) * stream1.verts.size()) == 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Debug mode for headless demo playback ('-vkdrawcheck'): builds the world drawing for the current frame without and with jobs,
+// and checks that the results are exactly the same. This runs entirely on the CPU and nothing is actually rendered.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_CheckDrawJobs() noexcept {
+    // Figure out what to draw and prepare it, like for a normal frame
+    gValidCount++;
+    RV_DetermineDrawParams();
+    RV_ClearOcclussion();
+    RV_BuildDrawSubsecList();
+    RV_PrepDrawSubsecs();
+
+    // Capture the drawing with and without jobs and compare
+    RV_CaptureWorldDraw(gDrawCheckStream_NoJobs, false);
+    RV_CaptureWorldDraw(gDrawCheckStream_Jobs, true);
+    gNumDrawCheckFrames++;
+
+    if (!RV_DrawStreamsMatch(gDrawCheckStream_NoJobs, gDrawCheckStream_Jobs)) {
+        if (gNumDrawCheckMismatches == 0) {
+            std::printf(
+                "Vulkan draw check: drawing with jobs does not match drawing without jobs! First mismatch on frame %u (%u vs %u verts)\n",
+                gNumDrawCheckFrames,
+                (uint32_t) gDrawCheckStream_NoJobs.verts.size(),
+                (uint32_t) gDrawCheckStream_Jobs.verts.size()
+            );
+        }
+
+        gNumDrawCheckMismatches++;
+    }
+
+    // Cleanup after drawing the world: need to clear the draw order for each drawn subsector
+    RV_ClearSubsecDrawIndexes();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints the results of the draw check debug mode ('-vkdrawcheck') for the current level, if any frames were checked.
+// Also resets the results for the next level.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_PrintDrawJobsCheckResults() noexcept {
+    if (gNumDrawCheckFrames > 0) {
+        std::printf(
+            "Vulkan draw check: %u frame(s) checked using %d thread(s), %u mismatch(es)\n",
+            gNumDrawCheckFrames,
+            RV_GetNumJobThreads(),
+            gNumDrawCheckMismatches
+        );
+    }
+
+    gNumDrawCheckFrames = 0;
+    gNumDrawCheckMismatches = 0;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Renders the player's view.
 // Some of the high level logic here is copied from the original renderer's 'R_RenderPlayerView'.
@@ -178,13 +376,14 @@ void RV_RenderPlayerView() noexcept {
     RV_ClearOcclussion();
     RV_BuildDrawSubsecList();
 
-    // Build the list of sprite fragments to be drawn for each subsector
-    RV_BuildSpriteFragLists();
+    // Do all the preparation for drawing that must be done on this thread.
+    // After this we can build the sprite fragments and draw the world using jobs, if there are job threads.
+    RV_PrepDrawSubsecs();
 
-    // Init which subsectors are to have flats and sky walls drawn next.
-    // We try and batch all those for performance reasons, and also to avoid visual artifacts with sprite clipping.
-    RV_InitNextDrawFlats();
-    RV_InitNextDrawSkyWalls();
+    const bool bUseJobs = (RV_GetNumJobThreads() > 1);
+
+    // Build the list of sprite fragments to be drawn for each subsector
+    RV_BuildSpriteFragLists(bUseJobs);
 
     // Upload a new sky texture for this frame if required.
     // Also draw the base (background) sky that is needed in some scenarios.
@@ -199,29 +398,8 @@ void RV_RenderPlayerView() noexcept {
     VDrawing::setDrawPipeline(gOpaqueGeomPipeline);
     RV_SetShaderUniformsFor3D();
 
-    // Increment the marker used to determine when to update the shading params for each sector
-    gValidCount++;
-
     // Draw all of the subsectors back to front
-    const int32_t numDrawSubsecs = (int32_t) gRvDrawSubsecs.size();
-
-    for (int32_t drawSubsecIdx = numDrawSubsecs - 1; drawSubsecIdx >= 0; --drawSubsecIdx) {
-        // Make sure the shading params for the sector are up to date
-        subsector_t& subsec = *gRvDrawSubsecs[drawSubsecIdx];
-        sector_t& sector = *subsec.sector;
-        R_UpdateShadingParams(sector);
-
-        // Draw all subsector sky walls, blended and masked walls
-        RV_DrawSubsecSkyWalls(drawSubsecIdx);
-        RV_DrawSubsecBlendedWalls(subsec);
-
-        // Draw all subsector opaque elements and then sprites on top of that.
-        // Most of the time these should all be on the same draw pipeline, so we can do batching.
-        RV_DrawSubsecOpaqueWalls(subsec);
-        RV_DrawSubsecFloors(drawSubsecIdx);
-        RV_DrawSubsecCeilings(drawSubsecIdx);
-        RV_DrawSubsecSpriteFrags(drawSubsecIdx);
-    }
+    RV_DrawWorld(bUseJobs);
 
     // Cleanup after drawing the world: need to clear the draw order for each drawn subsector
     RV_ClearSubsecDrawIndexes();
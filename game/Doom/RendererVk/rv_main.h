@@ -21,5 +21,7 @@ extern Matrix4f         gViewProjMatrix;
 extern VPipelineType    gOpaqueGeomPipeline;
 
 void RV_RenderPlayerView() noexcept;
+void RV_CheckDrawJobs() noexcept;
+void RV_PrintDrawJobsCheckResults() noexcept;
 
 #endif  // #if PSYDOOM_VULKAN_RENDERER
@@ -18,9 +18,11 @@
 #include "PsyDoom/Vulkan/VTypes.h"
 #include "rv_bsp.h"
 #include "rv_data.h"
+#include "rv_jobs.h"
 #include "rv_main.h"
 #include "rv_utils.h"
 
+#include <algorithm>
 #include <vector>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -54,18 +56,43 @@ struct SplitTestLine {
     float y;            // At what height is the test line: used to decide whether 2-sided lines should be treated as blocking
 };
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A sprite fragment covering the entire sprite for a thing, before it is split up on subsector boundaries.
+// Also holds the position of the thing, which is used to resolve cases where we can't split and need to decide on a sprite subsector.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct ThingSpriteFrag {
+    SpriteFrag  frag;
+    float       thingPos[3];        // N.B: in Vulkan coords (where 'y' is up and 'z' is foward)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Output from a job which splits up thing sprites into fragments.
+// Holds the fragments generated and the draw subsectors they are for, in the order they were generated.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SpriteSplitJobOutput {
+    std::vector<SpriteFrag>     frags;
+    std::vector<int32_t>        drawSubsecIdxs;
+};
+
+// Minimum number of things to split up sprites for in each job: avoids making jobs which are too small to be worthwhile
+static constexpr int32_t MIN_THINGS_PER_SPRITE_SPLIT_JOB = 16;
+
 // All of the sprite fragments to be drawn in this frame
 static std::vector<SpriteFrag> gRvSpriteFrags;
 
 // The sprite fragment linked list for each draw subsector (-1 if no sprite fragments)
 static std::vector<int32_t> gRvDrawSubsecSprFrags;
 
-// Depth sorted sprite fragments to be drawn for the current draw subsector.
-// This temporary list is re-used for each subsector to avoid allocations.
-static std::vector<const SpriteFrag*> gRvSortedFrags;
+// Whole sprite fragments for all of the things to be drawn in this frame, in draw subsector order
+static std::vector<ThingSpriteFrag> gRvThingSprFrags;
+
+// The output for each sprite splitting job, for the current frame
+static std::vector<SpriteSplitJobOutput> gSpriteSplitJobOutputs;
+static int32_t gNumSpriteSplitJobs;
 
-// XYZ position for the current thing which is having sprite fragments generated
-static float gSpriteFragThingPos[3];
+// Depth sorted sprite fragments to be drawn for the current draw subsector.
+// This temporary list is re-used for each subsector to avoid allocations, and each thread drawing sprites has its own list.
+static thread_local std::vector<const SpriteFrag*> gRvSortedFrags;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Get and cache the texture to use for the given thing and sprite frame, and get whether it is flipped.
@@ -287,7 +314,7 @@ static void RV_DrawSpriteFrag(const SpriteFrag& sprFrag) noexcept {
 // Makes the sprite fragment visit the specified subsector.
 // Adds it to the draw list of sprite fragments for that subsector.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void RV_SpriteFrag_VisitSubsector(const subsector_t& subsec, const SpriteFrag& frag) noexcept {
+static void RV_SpriteFrag_VisitSubsector(const subsector_t& subsec, const SpriteFrag& frag, SpriteSplitJobOutput& output) noexcept {
     // If the subsector is not drawn then ignore and don't assign the sprite to a draw list
     const int32_t drawSubsecIdx = subsec.vkDrawSubsecIdx;
 
@@ -296,11 +323,9 @@ static void RV_SpriteFrag_VisitSubsector(const subsector_t& subsec, const Sprite
 
     ASSERT((size_t) drawSubsecIdx < gRvDrawSubsecSprFrags.size());
 
-    // Add this sprite fragment to the draw list for the subsector
-    const int32_t sprFragIdx = (int32_t) gRvSpriteFrags.size();
-    SpriteFrag& drawFrag = gRvSpriteFrags.emplace_back(frag);
-    drawFrag.nextSubsecFragIdx = gRvDrawSubsecSprFrags[drawSubsecIdx];
-    gRvDrawSubsecSprFrags[drawSubsecIdx] = sprFragIdx;
+    // Save the sprite fragment for adding to the draw list for the subsector later
+    output.frags.push_back(frag);
+    output.drawSubsecIdxs.push_back(drawSubsecIdx);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -417,16 +442,22 @@ static bool RV_SpriteSplitTest_VisitBspNode(const int32_t nodeIdx, const SplitTe
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Does recursive traversal of the BSP tree against the specified sprite fragment.
 // Splits up the fragment along BSP split boundaries as needed and assigns the fragments to appropriate destination subsectors.
+// The position of the thing that the sprite fragment belongs to must also be given, in Vulkan coords.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void RV_SpriteFrag_VisitBspNode(const int32_t nodeIdx, SpriteFrag& frag) noexcept {
+static void RV_SpriteFrag_VisitBspNode(
+    const int32_t nodeIdx,
+    SpriteFrag& frag,
+    const float thingPos[3],
+    SpriteSplitJobOutput& output
+) noexcept {
     // Is this node number a subsector? If so then add the sprite fragment to it's draw lists
     if (nodeIdx & NF_SUBSECTOR) {
         // Note: this strange check is in the PC engine too...
         // Under what circumstances can the node number be '-1'?
         if (nodeIdx == -1) {
-            RV_SpriteFrag_VisitSubsector(gpSubsectors[0], frag);
+            RV_SpriteFrag_VisitSubsector(gpSubsectors[0], frag, output);
         } else {
-            RV_SpriteFrag_VisitSubsector(gpSubsectors[nodeIdx & (~NF_SUBSECTOR)], frag);
+            RV_SpriteFrag_VisitSubsector(gpSubsectors[nodeIdx & (~NF_SUBSECTOR)], frag, output);
         }
     } else {
         // This is not a subsector, continue traversing the BSP tree and splitting the sprite fragment
@@ -456,9 +487,9 @@ static void RV_SpriteFrag_VisitBspNode(const int32_t nodeIdx, SpriteFrag& frag)
         if (bSide1 == bSide2) {
             // No split needed, just recurse into the appropriate side
             if (bSide1) {
-                RV_SpriteFrag_VisitBspNode(node.children[0], frag);
+                RV_SpriteFrag_VisitBspNode(node.children[0], frag, thingPos, output);
             } else {
-                RV_SpriteFrag_VisitBspNode(node.children[1], frag);
+                RV_SpriteFrag_VisitBspNode(node.children[1], frag, thingPos, output);
             }
         } else {
             // Need to split (less common case): need to compute where the split would happen.
@@ -497,14 +528,14 @@ static void RV_SpriteFrag_VisitBspNode(const int32_t nodeIdx, SpriteFrag& frag)
             if (!RV_SpriteSplitTest_VisitBspNode(nodeIdx, splitLine)) {
                 // Can't split, decide which part of the tree to place the sprite fragment in based on the sprite's center point.
                 // If splits are not possible then ultimately we will tend to put the thing's sprite parts closest to it's home subsector for rendering.
-                const float lprod_center = nodeDx * (gSpriteFragThingPos[2] - nodePy);
-                const float rprod_center = nodeDy * (gSpriteFragThingPos[0] - nodePx);
+                const float lprod_center = nodeDx * (thingPos[2] - nodePy);
+                const float rprod_center = nodeDy * (thingPos[0] - nodePx);
                 const bool bCenterSide = (lprod_center < rprod_center);
 
                 if (bCenterSide) {
-                    RV_SpriteFrag_VisitBspNode(node.children[0], frag);
+                    RV_SpriteFrag_VisitBspNode(node.children[0], frag, thingPos, output);
                 } else {
-                    RV_SpriteFrag_VisitBspNode(node.children[1], frag);
+                    RV_SpriteFrag_VisitBspNode(node.children[1], frag, thingPos, output);
                 }
             }
             else {
@@ -524,11 +555,11 @@ static void RV_SpriteFrag_VisitBspNode(const int32_t nodeIdx, SpriteFrag& frag)
                 // Recurse using the split fragments.
                 // Splits shouldn't happen TOO often so hopefully stack space should not be an issue.
                 if (bSide1) {
-                    RV_SpriteFrag_VisitBspNode(node.children[0], frag1);
-                    RV_SpriteFrag_VisitBspNode(node.children[1], frag2);
+                    RV_SpriteFrag_VisitBspNode(node.children[0], frag1, thingPos, output);
+                    RV_SpriteFrag_VisitBspNode(node.children[1], frag2, thingPos, output);
                 } else {
-                    RV_SpriteFrag_VisitBspNode(node.children[1], frag1);
-                    RV_SpriteFrag_VisitBspNode(node.children[0], frag2);
+                    RV_SpriteFrag_VisitBspNode(node.children[1], frag1, thingPos, output);
+                    RV_SpriteFrag_VisitBspNode(node.children[0], frag2, thingPos, output);
                 }
             }
         }
@@ -536,9 +567,10 @@ static void RV_SpriteFrag_VisitBspNode(const int32_t nodeIdx, SpriteFrag& frag)
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Creates all of the sprite fragments for sprites contained in the specfied subsector
+// Creates whole (unsplit) sprite fragments for all the sprites contained in the specfied subsector.
+// Note: this caches sprite textures in VRAM as it goes, so it must be done on the main thread and in draw subsector order.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void RV_BuildSubsectorSpriteFrags(const subsector_t& subsec, [[maybe_unused]] const int32_t drawSubsecIdx) noexcept {
+static void RV_BuildSubsectorThingSpriteFrags(const subsector_t& subsec, [[maybe_unused]] const int32_t drawSubsecIdx) noexcept {
     // Sanity check!
     ASSERT((size_t) drawSubsecIdx < gRvDrawSubsecs.size());
 
@@ -573,25 +605,45 @@ static void RV_BuildSubsectorSpriteFrags(const subsector_t& subsec, [[maybe_unus
         uint8_t secB;
         R_GetSectorDrawColor(*subsec.sector, thingZ, secR, secG, secB);
 
-        // Allocate and initialize a full sprite fragment for the thing
-        SpriteFrag sprFrag;
-        RV_InitSpriteFrag(*pThing, sprFrag, thingX, thingY, thingZ, secR, secG, secB);
+        // Allocate and initialize a full sprite fragment for the thing, and remember the position of the thing for when it is split
+        ThingSpriteFrag& thingFrag = gRvThingSprFrags.emplace_back();
+        RV_InitSpriteFrag(*pThing, thingFrag.frag, thingX, thingY, thingZ, secR, secG, secB);
 
-        // Split up the sprite fragment into further small pieces (on subsector boundaries) if neccessary and remember the position of the thing being split.
-        // The thing position is used to resolve cases that we can't split and where we need to decide on a sprite subsector.
-        gSpriteFragThingPos[0] = RV_FixedToFloat(thingX);
-        gSpriteFragThingPos[1] = RV_FixedToFloat(thingZ);   // N.B: converting to Vulkan coords (where 'y' is up and 'z' is foward)
-        gSpriteFragThingPos[2] = RV_FixedToFloat(thingY);
+        thingFrag.thingPos[0] = RV_FixedToFloat(thingX);
+        thingFrag.thingPos[1] = RV_FixedToFloat(thingZ);    // N.B: converting to Vulkan coords (where 'y' is up and 'z' is foward)
+        thingFrag.thingPos[2] = RV_FixedToFloat(thingY);
+    }
+}
 
-        const int32_t bspRootNodeIdx = gNumBspNodes - 1;
-        RV_SpriteFrag_VisitBspNode(bspRootNodeIdx, sprFrag);
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A job which splits up the sprite fragments for a range of things into further small pieces (on subsector boundaries) if neccessary.
+// Does not modify any shared state, so it can be done on any thread.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void RV_DoSpriteSplitJob(const int32_t jobIdx) noexcept {
+    // Which range of things are we doing?
+    const int32_t numThings = (int32_t) gRvThingSprFrags.size();
+    const int32_t begThingIdx = (int32_t)(((int64_t) numThings * jobIdx) / gNumSpriteSplitJobs);
+    const int32_t endThingIdx = (int32_t)(((int64_t) numThings * (jobIdx + 1)) / gNumSpriteSplitJobs);
+
+    // Split up each thing's sprite fragment, starting at the root of the BSP tree
+    SpriteSplitJobOutput& output = gSpriteSplitJobOutputs[jobIdx];
+    output.frags.clear();
+    output.drawSubsecIdxs.clear();
+
+    const int32_t bspRootNodeIdx = gNumBspNodes - 1;
+
+    for (int32_t thingIdx = begThingIdx; thingIdx < endThingIdx; ++thingIdx) {
+        ThingSpriteFrag& thingFrag = gRvThingSprFrags[thingIdx];
+        RV_SpriteFrag_VisitBspNode(bspRootNodeIdx, thingFrag.frag, thingFrag.thingPos, output);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Builds a list of all the sprite fragments to be drawn for this frame
+// Builds a list of all the sprite fragments to be drawn for this frame.
+// If allowed, the work of splitting up sprites on subsector boundaries is split into jobs and spread over multiple threads.
+// The sprite fragment lists produced are exactly the same regardless of whether jobs are used or not.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void RV_BuildSpriteFragLists() noexcept {
+void RV_BuildSpriteFragLists(const bool bUseJobs) noexcept {
     // Clear the list of sprite fragments to draw and init each draw subsector as having no sprite frags.
     // ALso prealloc a minimum amount of memory for all of the draw vectors.
     const int32_t numDrawSubsecs = (int32_t) gRvDrawSubsecs.size();
@@ -601,11 +653,39 @@ void RV_BuildSpriteFragLists() noexcept {
     gRvDrawSubsecSprFrags.clear();
     gRvDrawSubsecSprFrags.reserve(4196);
     gRvDrawSubsecSprFrags.resize((size_t) numDrawSubsecs, -1);
-    gRvSortedFrags.reserve(256);
+    gRvThingSprFrags.clear();
+    gRvThingSprFrags.reserve(1024);
 
-    // Run through all of the draw subsectors and build a list of sprite fragments for each
+    // Run through all of the draw subsectors and make a whole sprite fragment for each thing to be drawn
     for (int32_t drawSubsecIdx = 0; drawSubsecIdx < numDrawSubsecs; ++drawSubsecIdx) {
-        RV_BuildSubsectorSpriteFrags(*gRvDrawSubsecs[drawSubsecIdx], drawSubsecIdx);
+        RV_BuildSubsectorThingSpriteFrags(*gRvDrawSubsecs[drawSubsecIdx], drawSubsecIdx);
+    }
+
+    // Split up all of the thing sprites, using jobs if allowed and if there are enough things to be worth it
+    const int32_t numThings = (int32_t) gRvThingSprFrags.size();
+    const int32_t maxJobs = (bUseJobs) ? RV_GetNumJobThreads() * RV_JOBS_PER_THREAD : 1;
+    const int32_t numJobs = std::clamp(numThings / MIN_THINGS_PER_SPRITE_SPLIT_JOB, 1, maxJobs);
+
+    if ((int32_t) gSpriteSplitJobOutputs.size() < numJobs) {
+        gSpriteSplitJobOutputs.resize((size_t) numJobs);
+    }
+
+    gNumSpriteSplitJobs = numJobs;
+    RV_RunJobs(numJobs, RV_DoSpriteSplitJob);
+
+    // Add the sprite fragments produced by each job to the draw list for its subsector.
+    // Note: jobs are added in thing order, so the draw lists are exactly the same as if all things were done in one go.
+    for (int32_t jobIdx = 0; jobIdx < numJobs; ++jobIdx) {
+        const SpriteSplitJobOutput& output = gSpriteSplitJobOutputs[jobIdx];
+        const int32_t numFrags = (int32_t) output.frags.size();
+
+        for (int32_t i = 0; i < numFrags; ++i) {
+            const int32_t drawSubsecIdx = output.drawSubsecIdxs[i];
+            const int32_t sprFragIdx = (int32_t) gRvSpriteFrags.size();
+            SpriteFrag& drawFrag = gRvSpriteFrags.emplace_back(output.frags[i]);
+            drawFrag.nextSubsecFragIdx = gRvDrawSubsecSprFrags[drawSubsecIdx];
+            gRvDrawSubsecSprFrags[drawSubsecIdx] = sprFragIdx;
+        }
     }
 }
 
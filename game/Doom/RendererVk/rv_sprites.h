@@ -6,7 +6,7 @@ struct subsector_t;
 
 #include <cstdint>
 
-void RV_BuildSpriteFragLists() noexcept;
+void RV_BuildSpriteFragLists(const bool bUseJobs) noexcept;
 void RV_DrawSubsecSpriteFrags(const int32_t drawSubsecIdx) noexcept;
 void RV_DrawWeapon() noexcept;
 
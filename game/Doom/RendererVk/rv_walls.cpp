@@ -14,14 +14,13 @@
 #include "PsyDoom/Vulkan/VTypes.h"
 #include "rv_bsp.h"
 #include "rv_data.h"
+#include "rv_geomcache.h"
 #include "rv_main.h"
 #include "rv_sky.h"
 #include "rv_utils.h"
 
 #include <cmath>
 
-static int32_t gNextSkyWallDrawSubsecIdx;       // Index of the next draw subsector to have its sky walls drawn
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draw a wall (upper, mid, lower) for a seg
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -43,9 +42,6 @@ static void RV_DrawWall(
     texture_t& tex,
     const bool bBlend
 ) noexcept {
-    // Upload the texture to VRAM if required
-    RV_UploadDirtyTex(tex);
-
     // Get the texture page location for this texture
     uint16_t texWinX, texWinY;
     uint16_t texWinW, texWinH;
@@ -82,7 +78,6 @@ static void RV_DrawWall(
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draw the fully opaque upper, lower and mid walls for a seg.
-// Also marks the wall as viewed for the automap, if it's visible.
 //
 // Note: unlike the original PSX renderer 'R_DrawWalls' there is no height limitation placed on wall textures here.
 // Therefore no stretching will occur when uv coords exceed 256 pixel limit, and this may result in rendering differences in a few places.
@@ -95,10 +90,8 @@ static void RV_DrawSegSolid(const rvseg_t& seg, const subsector_t& subsec) noexc
     if ((seg.flags & SGF_VISIBLE_COLS) == 0)
         return;
 
-    // This line is now viewed by the player: show in the automap if the line is viewable there
-    side_t& side = *seg.sidedef;
+    const side_t& side = *seg.sidedef;
     line_t& line = *seg.linedef;
-    line.flags |= ML_MAPPED;
 
     // Get the xz positions of the seg endpoints and the seg length
     const float x1 = seg.v1x;
@@ -117,8 +110,8 @@ static void RV_DrawSegSolid(const rvseg_t& seg, const subsector_t& subsec) noexc
     const fixed_t fby = frontSec.floorDrawH;
 
     // Get u and v offsets for the seg and the u1/u2 coordinates
-    const float uOffset = RV_FixedToFloat(side.textureoffset.renderValue()) + seg.uOffset;
-    const float vOffset = RV_FixedToFloat(side.rowoffset.renderValue());
+    const float uOffset = RV_FixedToFloat(seg.texOffsetU) + seg.uOffset;
+    const float vOffset = RV_FixedToFloat(seg.texOffsetV);
     const float u1 = uOffset;
     const float u2 = uOffset + segLen;
 
@@ -263,7 +256,7 @@ static void RV_DrawSegBlended(const rvseg_t& seg, const subsector_t& subsec) noe
     const fixed_t fby = frontSec.floorDrawH;
 
     // Get the mid texture for the seg; if it doesn't exist then don't draw
-    side_t& side = *seg.sidedef;
+    const side_t& side = *seg.sidedef;
     const int32_t midTexIdx = side.midtexture;
 
     if (midTexIdx < 0)
@@ -272,8 +265,8 @@ static void RV_DrawSegBlended(const rvseg_t& seg, const subsector_t& subsec) noe
     texture_t& tex_m = gpTextures[gpTextureTranslation[side.midtexture]];
 
     // Get u and v offsets for the seg and the u1/u2 coordinates
-    const float uOffset = RV_FixedToFloat(side.textureoffset.renderValue()) + seg.uOffset;
-    const float vOffset = RV_FixedToFloat(side.rowoffset.renderValue());
+    const float uOffset = RV_FixedToFloat(seg.texOffsetU) + seg.uOffset;
+    const float vOffset = RV_FixedToFloat(seg.texOffsetV);
     const float u1 = uOffset;
     const float u2 = uOffset + segLen;
 
@@ -431,24 +424,167 @@ static void RV_DrawSegSkyWalls(const rvseg_t& seg, const subsector_t& subsec) no
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Must be called before drawing sky walls.
-// Initializes which subsector is to have sky walls drawn next.
+// Tells if the sky walls for the given draw subsector can be drawn in the same batch as the sky walls for the draw subsector before it.
+// Sky walls are batched until there is a change in ceiling height or a change in sky status.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool RV_CanBatchSubsecSkyWalls(const int32_t prevDrawSubsecIdx, const int32_t drawSubsecIdx) noexcept {
+    const sector_t& prevSector = *gRvDrawSubsecs[prevDrawSubsecIdx]->sector;
+    const sector_t& sector = *gRvDrawSubsecs[drawSubsecIdx]->sector;
+
+    if (sector.ceilingDrawH != prevSector.ceilingDrawH)
+        return false;
+
+    const bool bPrevHasSkyCeil = (prevSector.ceilingpic == -1);
+    const bool bPrevHasSkyFloor = (prevSector.floorpic == -1);
+    const bool bHasSkyCeil = (sector.ceilingpic == -1);
+    const bool bHasSkyFloor = (sector.floorpic == -1);
+
+    return ((bPrevHasSkyCeil == bHasSkyCeil) && (bPrevHasSkyFloor == bHasSkyFloor));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Must be called for each draw subsector before its walls are drawn, and on the main thread.
+// Marks the visible walls of the subsector as seen for the automap and uploads any wall textures that will be drawn to VRAM if required.
+// This is done separately from drawing, so that walls can be drawn on other threads.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void RV_PrepSubsecWallsForDraw(subsector_t& subsec) noexcept {
+    const sector_t& frontSec = *subsec.sector;
+    rvseg_t* const pBegSeg = gpRvSegs.get() + subsec.firstseg;
+    rvseg_t* const pEndSeg = pBegSeg + subsec.numsegs;
+
+    for (rvseg_t* pSeg = pBegSeg; pSeg < pEndSeg; ++pSeg) {
+        // Ignore the line segment if it's not front facing or visible
+        rvseg_t& seg = *pSeg;
+
+        if (seg.flags & SGF_BACKFACING)
+            continue;
+
+        if ((seg.flags & SGF_VISIBLE_COLS) == 0)
+            continue;
+
+        // This line is now viewed by the player: show in the automap if the line is viewable there
+        side_t& side = *seg.sidedef;
+        line_t& line = *seg.linedef;
+        line.flags |= ML_MAPPED;
+
+        // Check the back sector for geometry changes, since walls are cached and the back sector affects them.
+        if (seg.backsector) {
+            RV_UpdateSectorGeomVersion(*seg.backsector);
+        }
+
+        // Resolve the interpolated side texture offsets for drawing here, since querying them can modify the side.
+        // Drawing (possibly on other threads) uses the offsets saved to the seg and never touches the interpolated values.
+        seg.texOffsetU = side.textureoffset.renderValue();
+        seg.texOffsetV = side.rowoffset.renderValue();
+
+        // Upload textures for the upper and lower walls, if they are drawn (see 'RV_DrawSegSolid')
+        if (const sector_t* const pBackSec = seg.backsector) {
+            const bool bHasUpperWall = ((pBackSec->ceilingDrawH < frontSec.ceilingDrawH) && (side.toptexture >= 0));
+            const bool bHasLowerWall = ((pBackSec->floorDrawH > frontSec.floorDrawH) && (side.bottomtexture >= 0));
+
+            if (bHasUpperWall && (pBackSec->ceilingpic != -1)) {
+                RV_UploadDirtyTex(gpTextures[gpTextureTranslation[side.toptexture]]);
+            }
+
+            if (bHasLowerWall && (pBackSec->floorpic != -1)) {
+                RV_UploadDirtyTex(gpTextures[gpTextureTranslation[side.bottomtexture]]);
+            }
+        }
+
+        // Upload the texture for the mid wall, if it is drawn: one sided walls are always drawn, two sided walls only if masked or blended
+        const bool bIsBlendedSeg = (line.flags & (ML_MIDTRANSLUCENT | ML_MIDMASKED));
+
+        if ((side.midtexture >= 0) && (bIsBlendedSeg || (!seg.backsector))) {
+            RV_UploadDirtyTex(gpTextures[gpTextureTranslation[side.midtexture]]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the key for the opaque walls generated for a seg, which changes whenever anything about the seg affecting the walls changes.
+// Note: the state of the front sector is not included in the key, that is checked separately.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void RV_InitNextDrawSkyWalls() noexcept {
-    gNextSkyWallDrawSubsecIdx = (int32_t) gRvDrawSubsecs.size() - 1;
+static rvsegwallskey_t RV_GetSegWallsKey(const rvseg_t& seg) noexcept {
+    rvsegwallskey_t key = {};
+    key.bDrawn = (((seg.flags & SGF_BACKFACING) == 0) && (seg.flags & SGF_VISIBLE_COLS));
+
+    if (!key.bDrawn)
+        return key;
+
+    const side_t& side = *seg.sidedef;
+    const line_t& line = *seg.linedef;
+
+    key.backSectorVersion = (seg.backsector) ? RV_GetSectorGeomVersion(*seg.backsector) : 0;
+    key.texOffsetU = seg.texOffsetU;
+    key.texOffsetV = seg.texOffsetV;
+    key.topTexNum = (side.toptexture >= 0) ? gpTextureTranslation[side.toptexture] : -1;
+    key.bottomTexNum = (side.bottomtexture >= 0) ? gpTextureTranslation[side.bottomtexture] : -1;
+    key.midTexNum = (side.midtexture >= 0) ? gpTextureTranslation[side.midtexture] : -1;
+    key.lineFlags = line.flags & (ML_DONTPEGTOP | ML_DONTPEGBOTTOM | ML_MIDMASKED | ML_MIDTRANSLUCENT);
+    return key;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Draw all fully opaque upper, lower and mid walls for the given subsector
+// Tells if two seg wall keys are the same
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool RV_SegWallsKeysMatch(const rvsegwallskey_t& key1, const rvsegwallskey_t& key2) noexcept {
+    return (
+        (key1.backSectorVersion == key2.backSectorVersion) &&
+        (key1.texOffsetU == key2.texOffsetU) &&
+        (key1.texOffsetV == key2.texOffsetV) &&
+        (key1.topTexNum == key2.topTexNum) &&
+        (key1.bottomTexNum == key2.bottomTexNum) &&
+        (key1.midTexNum == key2.midTexNum) &&
+        (key1.lineFlags == key2.lineFlags) &&
+        (key1.bDrawn == key2.bDrawn)
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draw all fully opaque upper, lower and mid walls for the given subsector.
+// The walls are drawn from the geometry cache, which is rebuilt first if anything affecting the walls has changed.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void RV_DrawSubsecOpaqueWalls(subsector_t& subsec) noexcept {
-    // Draw all opaque segs in the subsector
+    // Check if the cached walls for the subsector are still valid, and update the key for each seg while we are at it
+    rvwallsgeom_t& cache = gpRvSubsecGeom[&subsec - gpSubsectors].walls;
+    const uint32_t sectorVersion = RV_GetSectorGeomVersion(*subsec.sector);
+    const int32_t numSegs = subsec.numsegs;
+
+    bool bCacheValid = ((cache.cacheEpoch == gRvGeomCacheEpoch) && (cache.sectorVersion == sectorVersion));
+
+    if ((int32_t) cache.segKeys.size() != numSegs) {
+        cache.segKeys.resize((size_t) numSegs);
+        bCacheValid = false;
+    }
+
     const rvseg_t* const pBegSeg = gpRvSegs.get() + subsec.firstseg;
-    const rvseg_t* const pEndSeg = pBegSeg + subsec.numsegs;
+    const rvseg_t* const pEndSeg = pBegSeg + numSegs;
 
-    for (const rvseg_t* pSeg = pBegSeg; pSeg < pEndSeg; ++pSeg) {
-        RV_DrawSegSolid(*pSeg, subsec);
+    for (int32_t i = 0; i < numSegs; ++i) {
+        const rvsegwallskey_t key = RV_GetSegWallsKey(pBegSeg[i]);
+
+        if (!RV_SegWallsKeysMatch(key, cache.segKeys[i])) {
+            cache.segKeys[i] = key;
+            bCacheValid = false;
+        }
+    }
+
+    // Rebuild the cached walls if required by drawing all opaque segs in the subsector to the cache
+    if (!bCacheValid) {
+        cache.geom.clear();
+        VDrawing::DrawStream* const pPrevDrawStream = VDrawing::beginDrawStream(cache.geom);
+
+        for (const rvseg_t* pSeg = pBegSeg; pSeg < pEndSeg; ++pSeg) {
+            RV_DrawSegSolid(*pSeg, subsec);
+        }
+
+        VDrawing::endDrawStream(pPrevDrawStream);
+        cache.cacheEpoch = gRvGeomCacheEpoch;
+        cache.sectorVersion = sectorVersion;
     }
+
+    // Draw the walls
+    VDrawing::submitDrawStream(cache.geom);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -470,46 +606,27 @@ void RV_DrawSubsecBlendedWalls(subsector_t& subsec) noexcept {
 // Sky walls use a different draw pipeline to all other level geometry and sprites, therefore it's best if we can group them where possible.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void RV_DrawSubsecSkyWalls(const int32_t fromDrawSubsecIdx) noexcept {
-    ASSERT((fromDrawSubsecIdx >= 0) && (fromDrawSubsecIdx < (int32_t) gRvDrawSubsecs.size()));
+    const int32_t lastDrawSubsecIdx = (int32_t) gRvDrawSubsecs.size() - 1;
+    ASSERT((fromDrawSubsecIdx >= 0) && (fromDrawSubsecIdx <= lastDrawSubsecIdx));
 
-    // If we've already drawn the sky walls for this subsector then we are done
-    if (gNextSkyWallDrawSubsecIdx != fromDrawSubsecIdx)
+    // If this subsector's sky walls are part of a batch started by the previous draw subsector then they have already been drawn.
+    // Note: deciding this from the subsectors alone (rather than remembering which subsector is next) allows subsectors to be drawn in
+    // separate jobs, while still giving exactly the same batches.
+    if ((fromDrawSubsecIdx < lastDrawSubsecIdx) && RV_CanBatchSubsecSkyWalls(fromDrawSubsecIdx + 1, fromDrawSubsecIdx))
         return;
 
-    while (true) {
+    for (int32_t drawSubsecIdx = fromDrawSubsecIdx; drawSubsecIdx >= 0; --drawSubsecIdx) {
         // Draw any sky walls required for all segs in this subsector
-        const subsector_t& subsec = *gRvDrawSubsecs[gNextSkyWallDrawSubsecIdx];
-        const sector_t& sector = *subsec.sector;
+        const subsector_t& subsec = *gRvDrawSubsecs[drawSubsecIdx];
+        const rvseg_t* const pBegSeg = gpRvSegs.get() + subsec.firstseg;
+        const rvseg_t* const pEndSeg = pBegSeg + subsec.numsegs;
 
-        {
-            const rvseg_t* const pBegSeg = gpRvSegs.get() + subsec.firstseg;
-            const rvseg_t* const pEndSeg = pBegSeg + subsec.numsegs;
-
-            for (const rvseg_t* pSeg = pBegSeg; pSeg < pEndSeg; ++pSeg) {
-                RV_DrawSegSkyWalls(*pSeg, subsec);
-            }
+        for (const rvseg_t* pSeg = pBegSeg; pSeg < pEndSeg; ++pSeg) {
+            RV_DrawSegSkyWalls(*pSeg, subsec);
         }
 
         // Should we end the draw batch here? Stop if there is no next draw sector, or if the sky status or ceiling height changes
-        gNextSkyWallDrawSubsecIdx--;
-
-        if (gNextSkyWallDrawSubsecIdx < 0)
-            break;
-
-        const sector_t& nextSector = *gRvDrawSubsecs[gNextSkyWallDrawSubsecIdx]->sector;
-
-        if (nextSector.ceilingDrawH != sector.ceilingDrawH)
-            break;
-
-        const bool bHasSkyCeil = (sector.ceilingpic == -1);
-        const bool bHasSkyFloor = (sector.floorpic == -1);
-        const bool bNextHasSkyCeil = (nextSector.ceilingpic == -1);
-        const bool bNextHasSkyFloor = (nextSector.floorpic == -1);
-
-        if (bHasSkyCeil != bNextHasSkyCeil)
-            break;
-
-        if (bHasSkyFloor != bNextHasSkyFloor)
+        if ((drawSubsecIdx > 0) && (!RV_CanBatchSubsecSkyWalls(drawSubsecIdx, drawSubsecIdx - 1)))
             break;
     }
 }
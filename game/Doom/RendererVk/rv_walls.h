@@ -7,7 +7,7 @@ struct subsector_t;
 
 #include <cstdint>
 
-void RV_InitNextDrawSkyWalls() noexcept;
+void RV_PrepSubsecWallsForDraw(subsector_t& subsec) noexcept;
 void RV_DrawSubsecOpaqueWalls(subsector_t& subsec) noexcept;
 void RV_DrawSubsecBlendedWalls(subsector_t& subsec) noexcept;
 void RV_DrawSubsecSkyWalls(const int32_t fromDrawSubsecIdx) noexcept;
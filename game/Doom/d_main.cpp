@@ -18,7 +18,9 @@
 #include "Game/p_switch.h"
 #include "Game/p_tick.h"
 #include "Game/sprinfo.h"
+#include "psx_main.h"
 #include "PsyDoom/Config/Config.h"
+#include "PsyDoom/DemoBatch.h"
 #include "PsyDoom/DemoPlayer.h"
 #include "PsyDoom/DemoRecorder.h"
 #include "PsyDoom/Game.h"
@@ -30,8 +32,10 @@
 #include "PsyDoom/PlayerPrefs.h"
 #include "PsyDoom/ProgArgs.h"
 #include "PsyDoom/PsxPadButtons.h"
+#include "PsyDoom/SimProfiler.h"
 #include "PsyDoom/Utils.h"
 #include "PsyDoom/Video.h"
+#include "PsyDoom/ZoneTrace.h"
 #include "PsyQ/LIBGPU.h"
 #include "Renderer/r_data.h"
 #include "Renderer/r_main.h"
@@ -114,6 +118,10 @@ bool gbDidAbortGame = false;
     // Note also that we DON'T have to make this long vs short tick interpolation adjustment when we are using demo timings with PAL since
     // player ticks are perfectly synchronized (they fire at the same time) as world ticks in that situation.
     bool gbIsLongGameTick;
+
+    // Max speed simulation ('-maxspeed'): how many game tics have been run for the current demo and how long (in seconds) they took
+    static uint32_t gMaxSpeedSimNumTics;
+    static double   gMaxSpeedSimDuration;
 #endif
 
 // Debug draw string position
@@ -194,6 +202,12 @@ void D_DoomMain() noexcept {
 
     // Initializing standard DOOM subsystems, zone memory management, WAD, platform stuff, renderer etc.
     Z_Init();
+
+    // PsyDoom: start recording zone allocator calls if requested
+    #if PSYDOOM_MODS
+        ZoneTrace::init(ProgArgs::gZoneTraceFilePath, gpMainMemZone->size);
+    #endif
+
     I_Init();
     W_Init();
     R_Init();
@@ -215,6 +229,7 @@ void D_DoomMain() noexcept {
         const auto dmainCleanup = finally([]() noexcept {
             MapInfo::shutdown();
             W_Shutdown();
+            ZoneTrace::shutdown();
         });
 
         // PsyDoom: are we warping straight to a map and bypassing menus?
@@ -263,6 +278,16 @@ void D_DoomMain() noexcept {
         // This way it will be waiting for the player upon opening that menu:
         PlayerPrefs::pushLastPassword();
 
+        // PsyDoom: play and verify a batch of demo files and exit if commanded.
+        // If any demo fails then the program exits with error code '1'.
+        if (ProgArgs::gDemoBatchFilePath[0]) {
+            if (!DemoBatch::run(ProgArgs::gDemoBatchFilePath, ProgArgs::gDemoBatchReportFilePath, ProgArgs::gDemoBatchNumJobs)) {
+                gbCheckDemoResultFailed = true;
+            }
+
+            return;
+        }
+
         // PsyDoom: play a single demo file and exit if commanded.
         // Also, if in headless mode then don't run the main game - only single demo playback is allowed.
         if (ProgArgs::gPlayDemoFilePath[0]) {
@@ -454,8 +479,32 @@ gameaction_t RunDemoAtPath(const char* const filePath) noexcept {
     gpDemoBuffer = fileData.bytes.get();
     gpDemoBufferEnd = fileData.bytes.get() + fileData.size;
 
+    gMaxSpeedSimNumTics = 0;
+    gMaxSpeedSimDuration = 0.0;
+
+    #if PSYDOOM_SIM_PROFILER
+        SimProfiler::clear();
+    #endif
+
     const gameaction_t exitAction = G_PlayDemoPtr();
 
+    // If running a max speed simulation then report how fast the game logic ran
+    if (ProgArgs::gbMaxSpeedSim) {
+        const double ticsPerSec = (gMaxSpeedSimDuration > 0.0) ? (double) gMaxSpeedSimNumTics / gMaxSpeedSimDuration : 0.0;
+        std::printf(
+            "Max speed simulation: %u tics in %.3f seconds (%.1f tics/sec) for demo '%s'\n",
+            gMaxSpeedSimNumTics,
+            gMaxSpeedSimDuration,
+            ticsPerSec,
+            filePath
+        );
+    }
+
+    // Report where the game simulation spent its time, if the profiler is compiled in
+    #if PSYDOOM_SIM_PROFILER
+        SimProfiler::printReport(filePath);
+    #endif
+
     // Cleanup after we are done and return the exit action
     gpDemoBuffer = nullptr;
     gpDemoBufferEnd = nullptr;
@@ -769,6 +818,12 @@ gameaction_t MiniLoop(
         uint32_t profilerNumFramesElapsed = 0;                              // How many frames have elapsed for the frame profiler
         gPerfAvgFps = 0;                                                    // Don't know this yet, frame profiler will tell us later!
         gPerfAvgUsec = 0;                                                   // Don't know this yet, frame profiler will tell us later!
+
+        // PsyDoom: when running a max speed simulation skip all input, sound and frame timing work in between ticks.
+        // Headless mode has no inputs or sound output anyway and demo playback does not depend on any of this, so results are identical.
+        const bool bMaxSpeedSim = ProgArgs::gbMaxSpeedSim;
+        const int32_t maxSpeedSimStartTic = gGameTic;
+        const frametimer_t::time_point maxSpeedSimStartTime = frameStartTime;
     #endif
 
     // Continue running the game loop until something causes us to exit
@@ -806,9 +861,15 @@ gameaction_t MiniLoop(
 
                 // Note: ensure we have the latest input events prior to this with a call to 'Input::update'
                 TickInputs& tickInputs = gTickInputs[gCurPlayerIndex];
-                Input::update();
-                P_GatherTickInputs(tickInputs);
-                gTicButtons = I_ReadGamepad();
+
+                if (!bMaxSpeedSim) {
+                    Input::update();
+                    P_GatherTickInputs(tickInputs);
+                    gTicButtons = I_ReadGamepad();
+                } else {
+                    tickInputs.reset();
+                    gTicButtons = 0;
+                }
             #else
                 for (uint32_t playerIdx = 0; playerIdx < MAXPLAYERS; ++playerIdx) {
                     gOldTicButtons[playerIdx] = gTicButtons[playerIdx];
@@ -982,14 +1043,17 @@ gameaction_t MiniLoop(
         // Unless the ticker has requested that we hold onto them.
         // Also check if the app wants to quit, because the window was closed.
         #if PSYDOOM_MODS
-            if (!gbKeepInputEvents) {
+            if (bMaxSpeedSim) {
+                gbKeepInputEvents = false;
+            }
+            else if (!gbKeepInputEvents) {
                 Utils::checkForRendererToggleInput();
                 Input::consumeEvents();
             } else {
                 gbKeepInputEvents = false;  // Temporary request only!
             }
 
-            if (Input::isQuitRequested()) {
+            if ((!bMaxSpeedSim) && Input::isQuitRequested()) {
                 exitAction = ga_quitapp;
                 break;
             }
@@ -1001,7 +1065,9 @@ gameaction_t MiniLoop(
         // Do we need to update sound? (sound updates at 15 Hz)
         // PsyDoom: allow updates at any rate so sounds start as soon as possible.
         #if PSYDOOM_MODS
-            S_UpdateSounds();
+            if (!bMaxSpeedSim) {
+                S_UpdateSounds();
+            }
         #else
             if (gGameTic > gPrevGameTic) {
                 S_UpdateSounds();
@@ -1012,6 +1078,9 @@ gameaction_t MiniLoop(
         gbIsFirstTick = false;
 
         #if PSYDOOM_MODS
+            if (bMaxSpeedSim)
+                continue;
+
             // PsyDoom: wrap up timing this frame's duration
             const frametimer_t::time_point now = frametimer_t::now();
             gPrevFrameDuration = std::chrono::duration<double>(now - frameStartTime).count();
@@ -1040,9 +1109,15 @@ gameaction_t MiniLoop(
         #endif
     }
 
-    // PsyDoom: one last sound update before we exit
+    // PsyDoom: one last sound update before we exit.
+    // If running a max speed simulation then also add the tics simulated and the time taken to the totals for the demo.
     #if PSYDOOM_MODS
-        S_UpdateSounds();
+        if (bMaxSpeedSim) {
+            gMaxSpeedSimNumTics += (uint32_t)(gGameTic - maxSpeedSimStartTic);
+            gMaxSpeedSimDuration += std::chrono::duration<double>(frametimer_t::now() - maxSpeedSimStartTime).count();
+        } else {
+            S_UpdateSounds();
+        }
     #endif
 
     // Run cleanup logic for this game loop ending
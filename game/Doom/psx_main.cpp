@@ -15,6 +15,7 @@
 #include "PsyDoom/PsxVm.h"
 #include "PsyDoom/Utils.h"
 #include "PsyDoom/Video.h"
+#include "Wess/psxcd.h"
 
 #if PSYDOOM_MODS
     // PsyDoom: a flag set to 'true' if the result of demo playback is unexpected/wrong (when checking demo results).
@@ -96,7 +97,7 @@ int psx_main(const int argc, const char* const* const argv) noexcept {
 
     // PsyDoom: cleanup logic after Doom itself is done and save player prefs (unless headless mode)
     #if PSYDOOM_MODS
-        const bool bIsCheckingADemoResult = (ProgArgs::gCheckDemoResultFilePath[0] != 0);
+        const bool bIsCheckingADemoResult = ((ProgArgs::gCheckDemoResultFilePath[0] != 0) || (ProgArgs::gDemoBatchFilePath[0] != 0));
 
         if (!ProgArgs::gbHeadlessMode) {
             PlayerPrefs::save();
@@ -104,6 +105,7 @@ int psx_main(const int argc, const char* const* const argv) noexcept {
 
         IntroLogos::shutdown();
         Video::shutdownVideo();
+        psxcd_exit();
         PsxVm::shutdown();
         Cheats::shutdown();
         ModMgr::shutdown();
@@ -0,0 +1,658 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Compressed disc image ('.pdz' file) reading and creation.
+//
+// Groups are compressed using a simple LZ77 scheme which is fast to decode. The compressed data is a series of sequences, each consisting
+// of a token byte followed by some literal bytes and then a match (a copy of previously decoded data):
+//
+//  - Token byte: literal count in the high 4 bits and match length (minus 'MIN_MATCH_LEN') in the low 4 bits.
+//    If either value is '15' then extra length bytes follow: each is added to the value and a byte less than '255' ends the length.
+//  - Extra literal count bytes (if any), then the literal bytes.
+//  - Match distance: 16-bit little endian, '1' means the previous byte.
+//  - Extra match length bytes (if any).
+//
+// The last sequence has only literals, and decoding stops once the end of the group is reached after the literals.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "CompressedDiscImage.h"
+
+#include "Asserts.h"
+#include "DiscInfo.h"
+#include "DiscReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static constexpr int32_t RAW_SECTOR_SIZE    = 2352;     // Size of a raw CD sector, used to size groups
+static constexpr int32_t MIN_MATCH_LEN      = 4;        // Minimum length of a match in the compressed data
+static constexpr int32_t MAX_MATCH_DIST     = 65535;    // Maximum distance back that a match can copy from
+static constexpr int32_t HASH_BITS          = 15;       // Compression: size of the hash table used to find matches, in bits
+static constexpr int32_t MAX_CHAIN_LENGTH   = 32;       // Compression: the maximum number of previous positions checked when searching for a match
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Compression helper: hashes the 4 bytes at the given location
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t hash4(const std::byte* const pBytes) noexcept {
+    uint32_t value;
+    std::memcpy(&value, pBytes, sizeof(value));
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Compression helper: writes the extra bytes for a literal count or match length which doesn't fit in a token
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeExtraLength(std::vector<std::byte>& output, int32_t length) noexcept {
+    for (; length >= 255; length -= 255) {
+        output.push_back(std::byte(255));
+    }
+
+    output.push_back((std::byte) length);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Compression helper: writes a sequence of literals followed by an optional match (if the match length is non zero)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeSequence(
+    std::vector<std::byte>& output,
+    const std::byte* const pLiterals,
+    const int32_t numLiterals,
+    const int32_t matchLen,
+    const int32_t matchDist
+) noexcept {
+    const int32_t matchLenCode = (matchLen > 0) ? matchLen - MIN_MATCH_LEN : 0;
+    output.push_back((std::byte)((std::min(numLiterals, 15) << 4) | std::min(matchLenCode, 15)));
+
+    if (numLiterals >= 15) {
+        writeExtraLength(output, numLiterals - 15);
+    }
+
+    output.insert(output.end(), pLiterals, pLiterals + numLiterals);
+
+    if (matchLen > 0) {
+        output.push_back((std::byte)(matchDist & 0xFF));
+        output.push_back((std::byte)(matchDist >> 8));
+
+        if (matchLenCode >= 15) {
+            writeExtraLength(output, matchLenCode - 15);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Compresses the given group of data and saves the result to the given output.
+// Matches are found using hash chains, which is slow-ish but gives a better result; compression only happens once when creating an image.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void compressGroup(const std::byte* const pSrc, const int32_t srcSize, std::vector<std::byte>& output) noexcept {
+    output.clear();
+
+    std::vector<int32_t> hashHeads((size_t) 1 << HASH_BITS, -1);
+    std::vector<int32_t> prevPositions((size_t) srcSize, -1);
+
+    const auto addPosition = [&](const int32_t pos) noexcept {
+        const uint32_t hash = hash4(pSrc + pos);
+        prevPositions[pos] = hashHeads[hash];
+        hashHeads[hash] = pos;
+    };
+
+    int32_t literalsStart = 0;
+    int32_t pos = 0;
+
+    while (pos + MIN_MATCH_LEN <= srcSize) {
+        // Find the longest match for this position amongst previous positions with the same hash
+        int32_t bestMatchLen = 0;
+        int32_t bestMatchDist = 0;
+        int32_t candidatePos = hashHeads[hash4(pSrc + pos)];
+
+        for (int32_t chainIdx = 0; (chainIdx < MAX_CHAIN_LENGTH) && (candidatePos >= 0); ++chainIdx) {
+            if (pos - candidatePos > MAX_MATCH_DIST)
+                break;
+
+            const int32_t maxMatchLen = srcSize - pos;
+            int32_t matchLen = 0;
+
+            while ((matchLen < maxMatchLen) && (pSrc[candidatePos + matchLen] == pSrc[pos + matchLen])) {
+                ++matchLen;
+            }
+
+            if (matchLen > bestMatchLen) {
+                bestMatchLen = matchLen;
+                bestMatchDist = pos - candidatePos;
+
+                if (matchLen == maxMatchLen)
+                    break;
+            }
+
+            candidatePos = prevPositions[candidatePos];
+        }
+
+        addPosition(pos);
+
+        if (bestMatchLen < MIN_MATCH_LEN) {
+            ++pos;
+            continue;
+        }
+
+        // Found a match: output it along with all of the literals before it and skip past it
+        writeSequence(output, pSrc + literalsStart, pos - literalsStart, bestMatchLen, bestMatchDist);
+
+        for (int32_t matchPos = pos + 1; (matchPos < pos + bestMatchLen) && (matchPos + MIN_MATCH_LEN <= srcSize); ++matchPos) {
+            addPosition(matchPos);
+        }
+
+        pos += bestMatchLen;
+        literalsStart = pos;
+    }
+
+    // Output the final literals
+    writeSequence(output, pSrc + literalsStart, srcSize - literalsStart, 0, 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decompression helper: reads the extra bytes for a literal count or match length which doesn't fit in a token.
+// Returns 'false' if the data is truncated.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readExtraLength(const std::byte* const pSrc, const int32_t srcSize, int32_t& srcPos, int32_t& length) noexcept {
+    while (srcPos < srcSize) {
+        const int32_t lengthByte = (int32_t) pSrc[srcPos++];
+        length += lengthByte;
+
+        if (lengthByte < 255)
+            return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decompresses the given group of data, which must decompress to exactly the given size.
+// Returns 'false' if the data is not valid.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool decompressGroup(const std::byte* const pSrc, const int32_t srcSize, std::byte* const pDst, const int32_t dstSize) noexcept {
+    int32_t srcPos = 0;
+    int32_t dstPos = 0;
+
+    while (srcPos < srcSize) {
+        // Read the token and copy the literals
+        const int32_t token = (int32_t) pSrc[srcPos++];
+        int32_t numLiterals = token >> 4;
+
+        if ((numLiterals == 15) && (!readExtraLength(pSrc, srcSize, srcPos, numLiterals)))
+            return false;
+
+        if ((numLiterals > srcSize - srcPos) || (numLiterals > dstSize - dstPos))
+            return false;
+
+        std::memcpy(pDst + dstPos, pSrc + srcPos, (size_t) numLiterals);
+        srcPos += numLiterals;
+        dstPos += numLiterals;
+
+        // If this is the end of the output then this is the last sequence, and it must also be the end of the input
+        if (dstPos == dstSize)
+            return (srcPos == srcSize);
+
+        // Otherwise read and copy the match.
+        // Note: the match can overlap the bytes being written, so it must be copied byte by byte in that case.
+        if (srcPos + 2 > srcSize)
+            return false;
+
+        const int32_t matchDist = (int32_t) pSrc[srcPos] | ((int32_t) pSrc[srcPos + 1] << 8);
+        srcPos += 2;
+        int32_t matchLen = (token & 0xF) + MIN_MATCH_LEN;
+
+        if (((token & 0xF) == 15) && (!readExtraLength(pSrc, srcSize, srcPos, matchLen)))
+            return false;
+
+        if ((matchDist <= 0) || (matchDist > dstPos) || (matchLen > dstSize - dstPos))
+            return false;
+
+        const std::byte* const pMatch = pDst + dstPos - matchDist;
+
+        if (matchDist >= matchLen) {
+            std::memcpy(pDst + dstPos, pMatch, (size_t) matchLen);
+        } else {
+            for (int32_t i = 0; i < matchLen; ++i) {
+                pDst[dstPos + i] = pMatch[i];
+            }
+        }
+
+        dstPos += matchLen;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the total size of the given file in bytes, leaving the current file position unchanged. Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool getFileSize(std::FILE* const pFile, uint64_t& fileSize) noexcept {
+    const long curPos = std::ftell(pFile);
+
+    if ((curPos < 0) || (std::fseek(pFile, 0, SEEK_END) != 0))
+        return false;
+
+    const long endPos = std::ftell(pFile);
+
+    if ((std::fseek(pFile, curPos, SEEK_SET) != 0) || (endPos < 0))
+        return false;
+
+    fileSize = (uint64_t) endPos;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads and validates the header of a compressed disc image from the given file.
+// Returns 'false' if the file is not a valid image.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readFileHeader(std::FILE* const pFile, CompressedDiscImage::FileHeader& header) noexcept {
+    if (std::fread(&header, sizeof(header), 1, pFile) != 1)
+        return false;
+
+    if (std::memcmp(header.magic, CompressedDiscImage::FILE_MAGIC, sizeof(header.magic)) != 0)
+        return false;
+
+    // Note: groups are always a whole number of raw CD sectors (see 'create'), which also limits the number of groups
+    const bool bValidHeader = (
+        (header.version == CompressedDiscImage::FILE_VERSION) &&
+        (header.groupSize > 0) &&
+        (header.groupSize <= (uint32_t) CompressedDiscImage::MAX_GROUP_SIZE) &&
+        (header.groupSize % RAW_SECTOR_SIZE == 0) &&
+        (header.imageSize <= INT32_MAX) &&
+        (header.numGroups == (header.imageSize + header.groupSize - 1) / header.groupSize)
+    );
+
+    if (!bValidHeader)
+        return false;
+
+    // The track entries and the seek index must fit in the file, so a corrupt header can't cause huge allocations when they are read
+    uint64_t fileSize = 0;
+
+    if (!getFileSize(pFile, fileSize))
+        return false;
+
+    const uint64_t tableSize = (
+        (uint64_t) header.numTracks * sizeof(CompressedDiscImage::TrackEntry) +
+        ((uint64_t) header.numGroups + 1) * sizeof(uint64_t)
+    );
+
+    return (sizeof(header) + tableSize <= fileSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the specified file is a compressed disc image
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool CompressedDiscImage::isCompressedDiscImage(const char* const filePath) noexcept {
+    std::FILE* const pFile = std::fopen(filePath, "rb");
+
+    if (!pFile)
+        return false;
+
+    char magic[sizeof(FILE_MAGIC)] = {};
+    const bool bIsImage = ((std::fread(magic, sizeof(magic), 1, pFile) == 1) && (std::memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0));
+    std::fclose(pFile);
+    return bIsImage;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the track list for the given compressed disc image into the given disc info.
+// If there is an error 'false' is returned and an error message set.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool CompressedDiscImage::readDiscInfo(const char* const filePath, DiscInfo& discInfo, std::string& errorMsg) noexcept {
+    discInfo.tracks.clear();
+    std::FILE* const pFile = std::fopen(filePath, "rb");
+
+    if (!pFile) {
+        errorMsg = "Failed to open the compressed disc image '";
+        errorMsg += filePath;
+        errorMsg += "'";
+        return false;
+    }
+
+    // Read the header and the entry for each track
+    FileHeader header = {};
+    bool bReadOk = readFileHeader(pFile, header);
+
+    for (uint32_t trackIdx = 0; bReadOk && (trackIdx < header.numTracks); ++trackIdx) {
+        TrackEntry entry = {};
+
+        if (std::fread(&entry, sizeof(entry), 1, pFile) != 1) {
+            bReadOk = false;
+            break;
+        }
+
+        // Make sure the track is in range of the image before adding it
+        const bool bValidTrack = (
+            (entry.imageOffset >= 0) &&
+            (entry.blockSize > 0) &&
+            (entry.blockCount >= 0) &&
+            (entry.blockPayloadOffset >= 0) &&
+            (entry.blockPayloadSize > 0) &&
+            (entry.blockPayloadOffset + entry.blockPayloadSize <= entry.blockSize) &&
+            ((uint64_t) entry.imageOffset + (uint64_t) entry.blockCount * (uint64_t) entry.blockSize <= header.imageSize)
+        );
+
+        if (!bValidTrack) {
+            bReadOk = false;
+            break;
+        }
+
+        DiscTrack& track = discInfo.tracks.emplace_back();
+        track.sourceFilePath = filePath;
+        track.sourceFileTotalSize = (int32_t) header.imageSize;
+        track.trackNum = entry.trackNum;
+        track.fileOffset = entry.imageOffset;
+        track.blockSize = entry.blockSize;
+        track.blockCount = entry.blockCount;
+        track.trackPhysicalSize = entry.blockCount * entry.blockSize;
+        track.trackPayloadSize = entry.blockCount * entry.blockPayloadSize;
+        track.blockPayloadOffset = entry.blockPayloadOffset;
+        track.blockPayloadSize = entry.blockPayloadSize;
+        track.bIsData = (entry.bIsData != 0);
+        track.index0 = entry.index0;
+        track.index1 = entry.index1;
+        track.bIsCompressedImage = true;
+    }
+
+    std::fclose(pFile);
+
+    if (!bReadOk) {
+        discInfo.tracks.clear();
+        errorMsg = "The compressed disc image '";
+        errorMsg += filePath;
+        errorMsg += "' is invalid, corrupt or an unsupported version!";
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Creates a compressed disc image at the given path containing all of the tracks in the given disc.
+// Each group in the image contains the given number of raw CD sectors (2,352 bytes).
+// If there is an error 'false' is returned and an error message set.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool CompressedDiscImage::create(
+    const DiscInfo& srcDisc,
+    const char* const filePath,
+    const int32_t groupSectors,
+    std::string& errorMsg
+) noexcept {
+    // Make up the header and the entry for each track.
+    // The tracks are stored one after the other in the uncompressed image, leaving out pre-gaps and anything else between them.
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.numTracks = (uint32_t) srcDisc.tracks.size();
+    header.groupSize = (uint32_t) std::clamp(groupSectors * RAW_SECTOR_SIZE, RAW_SECTOR_SIZE, MAX_GROUP_SIZE);
+
+    std::vector<TrackEntry> trackEntries;
+    trackEntries.reserve(srcDisc.tracks.size());
+
+    for (const DiscTrack& track : srcDisc.tracks) {
+        TrackEntry& entry = trackEntries.emplace_back();
+        entry.trackNum = track.trackNum;
+        entry.imageOffset = (int32_t) header.imageSize;
+        entry.blockSize = track.blockSize;
+        entry.blockCount = track.blockCount;
+        entry.blockPayloadOffset = track.blockPayloadOffset;
+        entry.blockPayloadSize = track.blockPayloadSize;
+        entry.bIsData = (track.bIsData) ? 1 : 0;
+        entry.index0 = track.index0;
+        entry.index1 = track.index1;
+
+        header.imageSize += (uint64_t) track.trackPhysicalSize;
+    }
+
+    if (header.imageSize > INT32_MAX) {
+        errorMsg = "The disc is too big to be stored in a compressed disc image!";
+        return false;
+    }
+
+    header.numGroups = (uint32_t)((header.imageSize + header.groupSize - 1) / header.groupSize);
+
+    // Open the output file and write the header and track entries.
+    // Leave room for the seek index, which gets written at the end once all the groups have been compressed.
+    std::FILE* const pFile = std::fopen(filePath, "wb");
+
+    if (!pFile) {
+        errorMsg = "Failed to open the output file '";
+        errorMsg += filePath;
+        errorMsg += "' for writing!";
+        return false;
+    }
+
+    std::vector<uint64_t> seekIndex((size_t) header.numGroups + 1, 0);
+    const uint64_t seekIndexOffset = sizeof(FileHeader) + trackEntries.size() * sizeof(TrackEntry);
+
+    bool bWriteOk = (
+        (std::fwrite(&header, sizeof(header), 1, pFile) == 1) &&
+        (trackEntries.empty() || (std::fwrite(trackEntries.data(), sizeof(TrackEntry), trackEntries.size(), pFile) == trackEntries.size())) &&
+        (std::fwrite(seekIndex.data(), sizeof(uint64_t), seekIndex.size(), pFile) == seekIndex.size())
+    );
+
+    // Read the raw data for each group from the source disc and compress it
+    DiscReader discReader(srcDisc);
+    std::vector<std::byte> groupData(header.groupSize);
+    std::vector<std::byte> compressedData;
+    uint64_t fileOffset = seekIndexOffset + seekIndex.size() * sizeof(uint64_t);
+    size_t trackIdx = 0;
+
+    for (uint32_t groupIdx = 0; bWriteOk && (groupIdx < header.numGroups); ++groupIdx) {
+        const uint64_t groupStart = (uint64_t) groupIdx * header.groupSize;
+        const int32_t groupSize = (int32_t) std::min<uint64_t>(header.groupSize, header.imageSize - groupStart);
+
+        // Gather the data for the group, which might span multiple tracks
+        for (int32_t groupOffset = 0; groupOffset < groupSize;) {
+            const uint64_t imageOffset = groupStart + (uint64_t) groupOffset;
+
+            while ((uint64_t) trackEntries[trackIdx].imageOffset + (uint64_t) srcDisc.tracks[trackIdx].trackPhysicalSize <= imageOffset) {
+                ++trackIdx;
+            }
+
+            const DiscTrack& track = srcDisc.tracks[trackIdx];
+            const int32_t trackOffset = (int32_t)(imageOffset - (uint64_t) trackEntries[trackIdx].imageOffset);
+            const int32_t readSize = std::min(groupSize - groupOffset, track.trackPhysicalSize - trackOffset);
+
+            if ((!discReader.setTrackNum(track.trackNum)) || (!discReader.readRaw(trackOffset, groupData.data() + groupOffset, readSize))) {
+                errorMsg = "Failed to read the data for track ";
+                errorMsg += std::to_string(track.trackNum);
+                errorMsg += " of the source disc!";
+                std::fclose(pFile);
+                std::remove(filePath);
+                return false;
+            }
+
+            groupOffset += readSize;
+        }
+
+        // Compress the group and store it uncompressed if compression doesn't make it any smaller
+        compressGroup(groupData.data(), groupSize, compressedData);
+
+        if (compressedData.size() >= (size_t) groupSize) {
+            compressedData.assign(groupData.data(), groupData.data() + groupSize);
+        }
+
+        seekIndex[groupIdx] = fileOffset;
+        fileOffset += compressedData.size();
+        bWriteOk = (std::fwrite(compressedData.data(), compressedData.size(), 1, pFile) == 1);
+    }
+
+    // Write the seek index now that the location of every group is known
+    seekIndex[header.numGroups] = fileOffset;
+
+    bWriteOk = (
+        bWriteOk &&
+        (std::fseek(pFile, (long) seekIndexOffset, SEEK_SET) == 0) &&
+        (std::fwrite(seekIndex.data(), sizeof(uint64_t), seekIndex.size(), pFile) == seekIndex.size())
+    );
+
+    if ((std::fclose(pFile) != 0) || (!bWriteOk)) {
+        errorMsg = "Failed to write to the output file '";
+        errorMsg += filePath;
+        errorMsg += "'!";
+        std::remove(filePath);
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Creates a compressed disc image reader with no file open
+//------------------------------------------------------------------------------------------------------------------------------------------
+CompressedDiscImage::CompressedDiscImage() noexcept
+    : mpFile(nullptr)
+    , mImageSize(0)
+    , mGroupSize(0)
+    , mUseCounter(0)
+    , mSeekIndex()
+    , mCompressedData()
+    , mCachedGroups()
+{
+    for (CachedGroup& cachedGroup : mCachedGroups) {
+        cachedGroup.groupIdx = -1;
+    }
+}
+
+CompressedDiscImage::~CompressedDiscImage() noexcept {
+    close();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Opens the specified compressed disc image for reading, returning 'false' on failure.
+// Any previously open image is closed first.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool CompressedDiscImage::open(const char* const filePath) noexcept {
+    close();
+    std::FILE* const pFile = std::fopen(filePath, "rb");
+
+    if (!pFile)
+        return false;
+
+    // Read the header, skip the track entries and read the seek index
+    FileHeader header = {};
+    bool bReadOk = (
+        readFileHeader(pFile, header) &&
+        (std::fseek(pFile, (long)(header.numTracks * sizeof(TrackEntry)), SEEK_CUR) == 0)
+    );
+
+    if (bReadOk) {
+        mSeekIndex.resize((size_t) header.numGroups + 1);
+        bReadOk = (std::fread(mSeekIndex.data(), sizeof(uint64_t), mSeekIndex.size(), pFile) == mSeekIndex.size());
+    }
+
+    // Sanity check the seek index: compressed groups must not be empty or bigger than the uncompressed group size
+    for (uint32_t groupIdx = 0; bReadOk && (groupIdx < header.numGroups); ++groupIdx) {
+        const uint64_t compressedSize = mSeekIndex[groupIdx + 1] - mSeekIndex[groupIdx];
+        bReadOk = ((mSeekIndex[groupIdx + 1] > mSeekIndex[groupIdx]) && (compressedSize <= header.groupSize));
+    }
+
+    if (!bReadOk) {
+        std::fclose(pFile);
+        mSeekIndex.clear();
+        return false;
+    }
+
+    mpFile = pFile;
+    mImageSize = header.imageSize;
+    mGroupSize = header.groupSize;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Closes the currently open image, if any
+//------------------------------------------------------------------------------------------------------------------------------------------
+void CompressedDiscImage::close() noexcept {
+    if (mpFile) {
+        std::fclose((std::FILE*) mpFile);
+        mpFile = nullptr;
+    }
+
+    mImageSize = 0;
+    mGroupSize = 0;
+    mUseCounter = 0;
+    mSeekIndex.clear();
+
+    for (CachedGroup& cachedGroup : mCachedGroups) {
+        cachedGroup.groupIdx = -1;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the given number of bytes from the uncompressed image at the given offset, returning 'false' on failure
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool CompressedDiscImage::read(const uint64_t imageOffset, std::byte* pDstBytes, const int32_t numBytes) noexcept {
+    ASSERT(numBytes >= 0);
+
+    if ((!mpFile) || (imageOffset + (uint64_t) numBytes > mImageSize))
+        return false;
+
+    uint64_t curOffset = imageOffset;
+    int32_t bytesLeft = numBytes;
+
+    while (bytesLeft > 0) {
+        const CachedGroup* const pGroup = getGroup((int32_t)(curOffset / mGroupSize));
+
+        if (!pGroup)
+            return false;
+
+        const int32_t groupOffset = (int32_t)(curOffset % mGroupSize);
+        const int32_t copySize = std::min(bytesLeft, (int32_t) pGroup->data.size() - groupOffset);
+        std::memcpy(pDstBytes, pGroup->data.data() + groupOffset, (size_t) copySize);
+
+        pDstBytes += copySize;
+        curOffset += (uint64_t) copySize;
+        bytesLeft -= copySize;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the decompressed data for the given group, decompressing it if it is not in the cache.
+// Returns 'nullptr' if reading or decompressing the group fails.
+//------------------------------------------------------------------------------------------------------------------------------------------
+const CompressedDiscImage::CachedGroup* CompressedDiscImage::getGroup(const int32_t groupIdx) noexcept {
+    ASSERT((groupIdx >= 0) && ((size_t) groupIdx + 1 < mSeekIndex.size()));
+    mUseCounter++;
+
+    // Use the group from the cache if it's there, otherwise replace the least recently used group
+    CachedGroup* pLruGroup = &mCachedGroups[0];
+
+    for (CachedGroup& cachedGroup : mCachedGroups) {
+        if (cachedGroup.groupIdx == groupIdx) {
+            cachedGroup.lastUse = mUseCounter;
+            return &cachedGroup;
+        }
+
+        if ((cachedGroup.groupIdx < 0) || ((pLruGroup->groupIdx >= 0) && (mUseCounter - cachedGroup.lastUse > mUseCounter - pLruGroup->lastUse))) {
+            pLruGroup = &cachedGroup;
+        }
+    }
+
+    // Read the compressed data for the group
+    const uint64_t groupStart = (uint64_t) groupIdx * mGroupSize;
+    const int32_t groupSize = (int32_t) std::min<uint64_t>(mGroupSize, mImageSize - groupStart);
+    const int32_t compressedSize = (int32_t)(mSeekIndex[groupIdx + 1] - mSeekIndex[groupIdx]);
+
+    mCompressedData.resize((size_t) compressedSize);
+    pLruGroup->groupIdx = -1;
+    pLruGroup->data.resize((size_t) groupSize);
+
+    std::FILE* const pFile = (std::FILE*) mpFile;
+
+    if (std::fseek(pFile, (long) mSeekIndex[groupIdx], SEEK_SET) != 0)
+        return nullptr;
+
+    if (std::fread(mCompressedData.data(), (size_t) compressedSize, 1, pFile) != 1)
+        return nullptr;
+
+    // Decompress the group, or just copy it if it was stored uncompressed
+    if (compressedSize == groupSize) {
+        std::memcpy(pLruGroup->data.data(), mCompressedData.data(), (size_t) groupSize);
+    } else if (!decompressGroup(mCompressedData.data(), compressedSize, pLruGroup->data.data(), groupSize)) {
+        return nullptr;
+    }
+
+    pLruGroup->groupIdx = groupIdx;
+    pLruGroup->lastUse = mUseCounter;
+    return pLruGroup;
+}
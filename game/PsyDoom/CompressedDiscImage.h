@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct DiscInfo;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A compressed disc image ('.pdz' file): an alternative to a .cue file and its .bin files which takes up less disk space.
+//
+// The file holds the raw data for every track on the disc (including any sector framing) as a single uncompressed 'image', which is split
+// into fixed size groups of sectors that are compressed individually. A seek index gives the location of every group in the file, so any
+// part of the image can be read by decompressing just the group(s) containing it. Only the data actually belonging to tracks is stored,
+// pre-gaps and any other data in the original .bin files which is outside of a track are dropped.
+//
+// File layout:
+//  - FileHeader
+//  - TrackEntry for each track, in track number order
+//  - Seek index: 'numGroups + 1' 64-bit file offsets giving where each compressed group starts (and where the last group ends).
+//  - Compressed groups. If a compressed group is the same size as the uncompressed group then the data is stored uncompressed.
+//
+// All values are little endian. Readers of the image keep a small cache of recently decompressed groups, since reads are usually small
+// and sequential.
+//------------------------------------------------------------------------------------------------------------------------------------------
+class CompressedDiscImage {
+public:
+    static constexpr char       FILE_MAGIC[8]           = { 'P', 'S', 'Y', 'D', 'I', 'S', 'C', 'Z' };
+    static constexpr uint32_t   FILE_VERSION            = 1;
+    static constexpr int32_t    DEFAULT_GROUP_SECTORS   = 16;   // Default number of raw 2,352 byte sectors in each compressed group
+    static constexpr int32_t    MAX_GROUP_SIZE          = 1024 * 1024;
+    static constexpr uint32_t   NUM_CACHED_GROUPS       = 4;    // How many decompressed groups each reader keeps around
+
+    // Header for the file
+    struct FileHeader {
+        char        magic[8];           // Should be 'FILE_MAGIC'
+        uint32_t    version;            // Should be 'FILE_VERSION'
+        uint32_t    numTracks;          // Number of track entries following the header
+        uint32_t    groupSize;          // Size of each uncompressed group in bytes; the last group may be smaller
+        uint32_t    numGroups;          // Number of compressed groups in the file
+        uint64_t    imageSize;          // Total size of the uncompressed image in bytes
+    };
+
+    static_assert(sizeof(FileHeader) == 32);
+
+    // Describes a track on the disc and where it's data is in the uncompressed image: same meaning as the equivalent 'DiscTrack' fields
+    struct TrackEntry {
+        int32_t     trackNum;
+        int32_t     imageOffset;
+        int32_t     blockSize;
+        int32_t     blockCount;
+        int32_t     blockPayloadOffset;
+        int32_t     blockPayloadSize;
+        int32_t     bIsData;
+        int32_t     index0;
+        int32_t     index1;
+    };
+
+    static_assert(sizeof(TrackEntry) == 36);
+
+    static bool isCompressedDiscImage(const char* const filePath) noexcept;
+    static bool readDiscInfo(const char* const filePath, DiscInfo& discInfo, std::string& errorMsg) noexcept;
+
+    static bool create(
+        const DiscInfo& srcDisc,
+        const char* const filePath,
+        const int32_t groupSectors,
+        std::string& errorMsg
+    ) noexcept;
+
+    CompressedDiscImage() noexcept;
+    ~CompressedDiscImage() noexcept;
+
+    bool open(const char* const filePath) noexcept;
+    void close() noexcept;
+    inline bool isOpen() const noexcept { return (mpFile != nullptr); }
+    inline uint64_t getImageSize() const noexcept { return mImageSize; }
+    bool read(const uint64_t imageOffset, std::byte* pDstBytes, const int32_t numBytes) noexcept;
+
+private:
+    CompressedDiscImage(const CompressedDiscImage& other) = delete;
+    CompressedDiscImage& operator = (const CompressedDiscImage& other) = delete;
+
+    // A decompressed group in the cache
+    struct CachedGroup {
+        int32_t                 groupIdx;       // Which group this is or '-1' if the cache entry is unused
+        uint32_t                lastUse;        // When the group was last used, for evicting the least recently used group
+        std::vector<std::byte>  data;           // The decompressed data for the group
+    };
+
+    const CachedGroup* getGroup(const int32_t groupIdx) noexcept;
+
+    void*                   mpFile;                             // The open image file
+    uint64_t                mImageSize;                         // Total size of the uncompressed image
+    uint32_t                mGroupSize;                         // Size of each uncompressed group
+    uint32_t                mUseCounter;                        // Incremented every time a group is used, for tracking the least recently used group
+    std::vector<uint64_t>   mSeekIndex;                         // Where each compressed group starts in the file, plus the end of the last group
+    std::vector<std::byte>  mCompressedData;                    // Temporary buffer to hold compressed data read from the file
+    CachedGroup             mCachedGroups[NUM_CACHED_GROUPS];   // Recently decompressed groups
+};
@@ -32,6 +32,9 @@ bool            gbInterpolateWeapon;
 int32_t         gMainMemoryHeapSize;
 bool            gbSkipIntros;
 bool            gbUseFastLoading;
+bool            gbUseLevelCache;
+bool            gbUseSectorPvs;
+bool            gbMemoryMapDiscImage;
 bool            gbEnableSinglePlayerLevelTimer;
 int32_t         gUsePalTimings;
 bool            gbUseDemoTimings;
@@ -85,12 +88,15 @@ bool            gbVulkanBrightenAutomap;
 bool            gbUseVulkan32BitShading;
 int32_t         gVramSizeInMegabytes;
 std::string     gVulkanPreferredDevicesRegex;
+int32_t         gClassicRendererThreads;
+int32_t         gVulkanRendererThreads;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Audio config settings
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t     gAudioBufferSize;
 int32_t     gSpuRamSize;
+bool        gbAudioThreadMusicTiming;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Input config settings
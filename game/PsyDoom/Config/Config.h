@@ -19,6 +19,9 @@ extern bool             gbInterpolateWeapon;
 extern int32_t          gMainMemoryHeapSize;
 extern bool             gbSkipIntros;
 extern bool             gbUseFastLoading;
+extern bool             gbUseLevelCache;
+extern bool             gbUseSectorPvs;
+extern bool             gbMemoryMapDiscImage;
 extern bool             gbEnableSinglePlayerLevelTimer;
 extern int32_t          gUsePalTimings;
 extern bool             gbUseDemoTimings;
@@ -72,12 +75,15 @@ extern bool             gbVulkanBrightenAutomap;
 extern bool             gbUseVulkan32BitShading;
 extern int32_t          gVramSizeInMegabytes;
 extern std::string      gVulkanPreferredDevicesRegex;
+extern int32_t          gClassicRendererThreads;
+extern int32_t          gVulkanRendererThreads;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Audio settings
 //------------------------------------------------------------------------------------------------------------------------------------------
 extern int32_t      gAudioBufferSize;
 extern int32_t      gSpuRamSize;
+extern bool         gbAudioThreadMusicTiming;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Input settings
@@ -51,6 +51,17 @@ void initCfgSerialization_Audio() noexcept {
         gSpuRamSize,
         -1
     );
+
+    cfg.audioThreadMusicTiming = makeConfigField(
+        "AudioThreadMusicTiming",
+        "If enabled (1) then the music and sound sequencer is stepped by the audio thread, based on the\n"
+        "number of sound samples generated, rather than by the main game loop. This makes music tempo\n"
+        "stable regardless of framerate, hitches or level loads and allows note events to start on the\n"
+        "exact sample they are due at. If disabled (0) then the sequencer is updated by the main game\n"
+        "loop using elapsed wall clock time, which was the previous behavior.",
+        gbAudioThreadMusicTiming,
+        false
+    );
 }
 
 END_NAMESPACE(ConfigSerialization)
@@ -114,6 +114,38 @@ void initCfgSerialization_Game() noexcept {
         false
     );
 
+    cfg.useLevelCache = makeConfigField(
+        "UseLevelCache",
+        "If enabled (1) then PsyDoom saves the map geometry it builds when loading a level to a cache file\n"
+        "in the user data folder and reuses it the next time the same map is loaded. This skips most of\n"
+        "the level setup work, which can take a long time for very large user maps. Cache files are keyed\n"
+        "by the contents of the map and the version of PsyDoom, and are simply rebuilt if they don't match.\n"
+        "Original maps load quickly enough that there is little benefit for them.",
+        gbUseLevelCache,
+        false
+    );
+
+    cfg.useSectorPvs = makeConfigField(
+        "UseSectorPvs",
+        "If enabled (1) then PsyDoom works out which sectors can never see each other when loading a level\n"
+        "and adds them to the map's reject table. This lets monster sight checks skip an expensive trace\n"
+        "through the map for those sectors, which helps maps with an empty or weak 'REJECT' lump. Sight\n"
+        "results are never changed by this, so demos stay in sync. The result is saved to a cache file in\n"
+        "the user data folder for each map, so the work is only done the first time a map is loaded.",
+        gbUseSectorPvs,
+        false
+    );
+
+    cfg.memoryMapDiscImage = makeConfigField(
+        "MemoryMapDiscImage",
+        "If enabled (1) then PsyDoom memory maps the files for the game disc image instead of reading them\n"
+        "using regular file I/O. This makes reading data from the disc faster, especially for raw '.bin'\n"
+        "images with 2,352 byte sectors. If a file can't be memory mapped then regular file I/O is used.\n"
+        "You may want to disable this if the disc image is on a network drive or removable media.",
+        gbMemoryMapDiscImage,
+        true
+    );
+
     cfg.enableSinglePlayerLevelTimer = makeConfigField(
         "EnableSinglePlayerLevelTimer",
         "Enable an optional end of level time display, in single player mode?\n"
@@ -19,6 +19,9 @@ struct Config_Game {
     ConfigField     mainMemoryHeapSize;
     ConfigField     skipIntros;
     ConfigField     useFastLoading;
+    ConfigField     useLevelCache;
+    ConfigField     useSectorPvs;
+    ConfigField     memoryMapDiscImage;
     ConfigField     enableSinglePlayerLevelTimer;
     ConfigField     usePalTimings;
     ConfigField     useDemoTimings;
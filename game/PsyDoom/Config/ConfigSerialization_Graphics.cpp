@@ -279,6 +279,32 @@ void initCfgSerialization_Graphics() noexcept {
         gVulkanPreferredDevicesRegex,
         ""
     );
+
+    cfg.classicRendererThreads = makeConfigField(
+        "ClassicRendererThreads",
+        "Classic renderer only: how many threads to use for drawing (rasterizing) the game's graphics.\n"
+        "When more than one thread is used, drawing for each frame is split up into small screen tiles and\n"
+        "the tiles are drawn in parallel. The output is exactly the same as drawing with a single thread.\n"
+        "This can help performance at very high VRAM sizes or on slow machines.\n"
+        "\n"
+        "If '0' or '1' is specified then drawing is done immediately on the game thread (the default).\n"
+        "If '-1' is specified then the number of threads is decided automatically from the CPU core count.",
+        gClassicRendererThreads,
+        0
+    );
+
+    cfg.vulkanRendererThreads = makeConfigField(
+        "VulkanRendererThreads",
+        "Vulkan renderer only: how many threads to use for building the geometry of the 3D world each frame.\n"
+        "When more than one thread is used, the walls, floors, ceilings and sprites for each frame are\n"
+        "generated in parallel. The output is exactly the same as building the frame with a single thread.\n"
+        "This can help performance on very large maps at high framerates, where the CPU is the bottleneck.\n"
+        "\n"
+        "If '0' or '1' is specified then the frame is built on the game thread only (the default).\n"
+        "If '-1' is specified then the number of threads is decided automatically from the CPU core count.",
+        gVulkanRendererThreads,
+        0
+    );
 }
 
 END_NAMESPACE(ConfigSerialization)
@@ -30,6 +30,8 @@ struct Config_Graphics {
     ConfigField     vulkanBrightenAutomap;
     ConfigField     vramSizeInMegabytes;
     ConfigField     vulkanPreferredDevicesRegex;
+    ConfigField     classicRendererThreads;
+    ConfigField     vulkanRendererThreads;
 
     inline ConfigFieldList getFieldList() noexcept {
         static_assert(sizeof(*this) % sizeof(ConfigField) == 0);
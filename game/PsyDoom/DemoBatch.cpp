@@ -0,0 +1,418 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Batch demo verification: plays back a list of demos headless and checks each against its expected result.
+// See the header for more details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "DemoBatch.h"
+
+#include "Doom/Base/i_main.h"
+#include "Doom/d_main.h"
+#include "Doom/psx_main.h"
+#include "Doom/Renderer/r_data.h"
+#include "FileUtils.h"
+#include "Finally.h"
+#include "ProgArgs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rapidjson/document.h>
+#include <rapidjson/filewritestream.h>
+#include <rapidjson/prettywriter.h>
+
+// Playing each demo in a forked worker process is supported on Linux and macOS
+#if defined(__linux__) || defined(__APPLE__)
+    #define PSYDOOM_DEMO_BATCH_FORK 1
+
+    #include <fcntl.h>
+    #include <sys/param.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#else
+    #define PSYDOOM_DEMO_BATCH_FORK 0
+#endif
+
+BEGIN_NAMESPACE(DemoBatch)
+
+// The outcome of playing back a demo
+enum class DemoStatus : uint8_t {
+    Pending,    // Not played yet
+    Pass,       // Played and the result matched the expected result
+    Fail,       // Played but the result did not match the expected result (or the demo could not be played)
+    Error       // The worker process playing the demo crashed or raised a fatal error
+};
+
+// A demo to be played and checked, along with the result of doing that
+struct DemoEntry {
+    std::string     demoFilePath;
+    std::string     resultFilePath;
+    DemoStatus      status;
+    double          time;           // Time taken to play the demo in seconds (including process startup and teardown, if using workers)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the display name for a demo status
+//------------------------------------------------------------------------------------------------------------------------------------------
+static const char* getStatusName(const DemoStatus status) noexcept {
+    switch (status) {
+        case DemoStatus::Pending:   return "pending";
+        case DemoStatus::Pass:      return "pass";
+        case DemoStatus::Fail:      return "fail";
+        case DemoStatus::Error:     return "error";
+    }
+
+    return "unknown";
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes a path from the manifest relative to the folder containing the manifest, unless it is an absolute path
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::string resolveManifestPath(const std::string& manifestDir, const char* const path) noexcept {
+    const bool bIsAbsolutePath = (
+        (path[0] == '/') ||
+        (path[0] == '\\') ||
+        ((path[0] != 0) && (path[1] == ':'))    // Windows drive letter
+    );
+
+    return (bIsAbsolutePath) ? std::string(path) : manifestDir + path;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the list of demos to play from the given json manifest file.
+// Returns 'false' and prints an error on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readManifest(const char* const manifestFilePath, std::vector<DemoEntry>& demos) noexcept {
+    const FileData fileData = FileUtils::getContentsOfFile(manifestFilePath, 8, std::byte(0));
+
+    if (!fileData.bytes) {
+        std::printf("Demo batch: unable to read manifest file '%s'!\n", manifestFilePath);
+        return false;
+    }
+
+    rapidjson::Document document;
+
+    if (document.ParseInsitu((char*) fileData.bytes.get()).HasParseError() || (!document.IsObject())) {
+        std::printf("Demo batch: failed to parse manifest file '%s'!\n", manifestFilePath);
+        return false;
+    }
+
+    const auto demosIter = document.FindMember("demos");
+
+    if ((demosIter == document.MemberEnd()) || (!demosIter->value.IsArray())) {
+        std::printf("Demo batch: manifest file '%s' has no 'demos' array!\n", manifestFilePath);
+        return false;
+    }
+
+    std::string manifestDir;
+    FileUtils::getParentPath(manifestFilePath, manifestDir);
+
+    for (const rapidjson::Value& demoJson : demosIter->value.GetArray()) {
+        const auto demoIter = (demoJson.IsObject()) ? demoJson.FindMember("demo") : demoJson.MemberEnd();
+        const auto resultIter = (demoJson.IsObject()) ? demoJson.FindMember("result") : demoJson.MemberEnd();
+
+        const bool bValidEntry = (
+            demoJson.IsObject() &&
+            (demoIter != demoJson.MemberEnd()) && demoIter->value.IsString() &&
+            (resultIter != demoJson.MemberEnd()) && resultIter->value.IsString()
+        );
+
+        if (!bValidEntry) {
+            std::printf("Demo batch: manifest entry %zu must be an object with 'demo' and 'result' strings!\n", demos.size());
+            return false;
+        }
+
+        DemoEntry& demo = demos.emplace_back();
+        demo.demoFilePath = resolveManifestPath(manifestDir, demoIter->value.GetString());
+        demo.resultFilePath = resolveManifestPath(manifestDir, resultIter->value.GetString());
+        demo.status = DemoStatus::Pending;
+        demo.time = 0;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Plays the given demo in this process and checks the result; returns 'true' if the result matched
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool playAndCheckDemo(const DemoEntry& demo) noexcept {
+    // Note: 'P_Stop' does the actual checking of the result when demo playback ends
+    ProgArgs::gCheckDemoResultFilePath = demo.resultFilePath.c_str();
+    gbCheckDemoResultFailed = false;
+
+    RunDemoAtPath(demo.demoFilePath.c_str());
+
+    ProgArgs::gCheckDemoResultFilePath = "";
+    return (!gbCheckDemoResultFailed);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints the outcome for a single demo as soon as it is known
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printDemoOutcome(const DemoEntry& demo, const size_t numDone, const size_t numDemos) noexcept {
+    std::printf("[%zu/%zu] %-5s %8.2fs  %s\n", numDone, numDemos, getStatusName(demo.status), demo.time, demo.demoFilePath.c_str());
+    std::fflush(stdout);
+}
+
+#if PSYDOOM_DEMO_BATCH_FORK
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Called in a newly forked worker process: gives the worker its own copy of every regular file that was open for reading.
+// After a fork the parent and child share file offsets for the files they have open, so workers reading the same file (the game disc,
+// WADs etc.) at the same time would otherwise interfere with each other. The file descriptors (and any 'FILE' objects using them) stay
+// the same, only what they refer to is changed, so nothing else needs to know about this.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void reopenInheritedFiles() noexcept {
+    const int maxFd = (int) std::min<long>(sysconf(_SC_OPEN_MAX), 65536);
+
+    for (int fd = 3; fd < maxFd; ++fd) {
+        struct stat fileStat = {};
+
+        if ((fstat(fd, &fileStat) != 0) || (!S_ISREG(fileStat.st_mode)))
+            continue;
+
+        const int fileFlags = fcntl(fd, F_GETFL);
+
+        if ((fileFlags < 0) || ((fileFlags & O_ACCMODE) != O_RDONLY))
+            continue;
+
+        // Open the same file again to get a new, unshared file offset and continue on from the same position as before
+        #if defined(__APPLE__)
+            char filePath[MAXPATHLEN];
+
+            if (fcntl(fd, F_GETPATH, filePath) == -1)
+                continue;
+        #else
+            char filePath[64];
+            std::snprintf(filePath, sizeof(filePath), "/proc/self/fd/%d", fd);
+        #endif
+
+        const off_t fileOffset = lseek(fd, 0, SEEK_CUR);
+        const int newFd = open(filePath, O_RDONLY);
+
+        if (newFd < 0)
+            continue;
+
+        dup2(newFd, fd);
+        close(newFd);
+        lseek(fd, fileOffset, SEEK_SET);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Plays all the demos using forked worker processes, running up to the given number of workers at a time
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void runWithWorkers(std::vector<DemoEntry>& demos, const uint32_t numJobs) noexcept {
+    struct Worker {
+        pid_t                                   pid;
+        size_t                                  demoIdx;
+        std::chrono::steady_clock::time_point   startTime;
+    };
+
+    std::vector<Worker> workers;
+    size_t nextDemoIdx = 0;
+    size_t numDone = 0;
+
+    while (numDone < demos.size()) {
+        // Start as many workers as we can
+        while ((workers.size() < numJobs) && (nextDemoIdx < demos.size())) {
+            // Flush output before forking so that buffered output is not duplicated by the worker
+            std::fflush(nullptr);
+            const pid_t pid = fork();
+
+            if (pid == 0) {
+                // In the worker: play the demo and exit immediately, without any cleanup.
+                // The exit code tells the parent whether the result matched.
+                reopenInheritedFiles();
+                const bool bPassed = playAndCheckDemo(demos[nextDemoIdx]);
+                std::fflush(nullptr);
+                std::_Exit((bPassed) ? 0 : 1);
+            }
+
+            if (pid < 0) {
+                // Failed to fork: play the demo in this process instead
+                DemoEntry& demo = demos[nextDemoIdx];
+                const auto startTime = std::chrono::steady_clock::now();
+                demo.status = (playAndCheckDemo(demo)) ? DemoStatus::Pass : DemoStatus::Fail;
+                demo.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                printDemoOutcome(demo, ++numDone, demos.size());
+            } else {
+                workers.push_back(Worker{ pid, nextDemoIdx, std::chrono::steady_clock::now() });
+            }
+
+            nextDemoIdx++;
+        }
+
+        if (workers.empty())
+            continue;
+
+        // Wait for any worker to finish and record the result
+        int waitStatus = 0;
+        const pid_t finishedPid = waitpid(-1, &waitStatus, 0);
+
+        if (finishedPid < 0)
+            break;
+
+        const auto workerIter = std::find_if(workers.begin(), workers.end(), [=](const Worker& worker) noexcept {
+            return (worker.pid == finishedPid);
+        });
+
+        if (workerIter == workers.end())
+            continue;
+
+        DemoEntry& demo = demos[workerIter->demoIdx];
+        demo.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - workerIter->startTime).count();
+
+        if (WIFEXITED(waitStatus) && (WEXITSTATUS(waitStatus) <= 1)) {
+            demo.status = (WEXITSTATUS(waitStatus) == 0) ? DemoStatus::Pass : DemoStatus::Fail;
+        } else {
+            demo.status = DemoStatus::Error;
+        }
+
+        workers.erase(workerIter);
+        printDemoOutcome(demo, ++numDone, demos.size());
+    }
+
+    // If waiting failed for some reason then any demos still pending are errors
+    for (DemoEntry& demo : demos) {
+        if (demo.status == DemoStatus::Pending) {
+            demo.status = DemoStatus::Error;
+        }
+    }
+}
+#endif  // #if PSYDOOM_DEMO_BATCH_FORK
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Plays all the demos one after another in this process
+//------------------------------------------------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void runInProcess(std::vector<DemoEntry>& demos) noexcept {
+    size_t numDone = 0;
+
+    for (DemoEntry& demo : demos) {
+        const auto startTime = std::chrono::steady_clock::now();
+        demo.status = (playAndCheckDemo(demo)) ? DemoStatus::Pass : DemoStatus::Fail;
+        demo.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        printDemoOutcome(demo, ++numDone, demos.size());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes a json report containing the outcome of each demo to the given file.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool writeReport(
+    const char* const reportFilePath,
+    const std::vector<DemoEntry>& demos,
+    const uint32_t numJobs,
+    const double totalTime
+) noexcept {
+    rapidjson::Document document;
+    rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
+    document.SetObject();
+
+    uint32_t numPassed = 0;
+    uint32_t numFailed = 0;
+    uint32_t numErrors = 0;
+    rapidjson::Value demosJson(rapidjson::kArrayType);
+
+    for (const DemoEntry& demo : demos) {
+        numPassed += (demo.status == DemoStatus::Pass) ? 1 : 0;
+        numFailed += (demo.status == DemoStatus::Fail) ? 1 : 0;
+        numErrors += (demo.status == DemoStatus::Error) ? 1 : 0;
+
+        rapidjson::Value demoJson(rapidjson::kObjectType);
+        demoJson.AddMember("demo", rapidjson::Value(demo.demoFilePath.c_str(), allocator), allocator);
+        demoJson.AddMember("result", rapidjson::Value(demo.resultFilePath.c_str(), allocator), allocator);
+        demoJson.AddMember("status", rapidjson::StringRef(getStatusName(demo.status)), allocator);
+        demoJson.AddMember("time", demo.time, allocator);
+        demosJson.PushBack(demoJson, allocator);
+    }
+
+    document.AddMember("numDemos", (uint32_t) demos.size(), allocator);
+    document.AddMember("numPassed", numPassed, allocator);
+    document.AddMember("numFailed", numFailed, allocator);
+    document.AddMember("numErrors", numErrors, allocator);
+    document.AddMember("numJobs", numJobs, allocator);
+    document.AddMember("totalTime", totalTime, allocator);
+    document.AddMember("demos", demosJson, allocator);
+
+    // Write the report to the given file
+    std::FILE* const pFile = std::fopen(reportFilePath, "w");
+
+    if (!pFile)
+        return false;
+
+    auto closeFile = finally([&]() noexcept {
+        std::fflush(pFile);
+        std::fclose(pFile);
+    });
+
+    try {
+        char writeBuffer[4096];
+        rapidjson::FileWriteStream writeStream(pFile, writeBuffer, C_ARRAY_SIZE(writeBuffer));
+        rapidjson::PrettyWriter<rapidjson::FileWriteStream> fileWriter(writeStream);
+        document.Accept(fileWriter);
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Plays back and verifies all the demos in the given manifest file using the given number of worker processes (or the number of hardware
+// threads if '0'), optionally writing a json report. Prints the outcome of each demo and a summary. Returns 'true' if all demos passed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool run(const char* const manifestFilePath, const char* const reportFilePath, const uint32_t numJobs) noexcept {
+    std::vector<DemoEntry> demos;
+
+    if (!readManifest(manifestFilePath, demos))
+        return false;
+
+    // Load anything that would otherwise be loaded by every demo up front, so it is shared by all the workers
+    if (!gTex_LOADING.bIsCached) {
+        I_LoadAndCacheTexLump(gTex_LOADING, "LOADING", 0);
+    }
+
+    // Play all the demos
+    #if PSYDOOM_DEMO_BATCH_FORK
+        const uint32_t actualNumJobs = (numJobs > 0) ? numJobs : std::max(std::thread::hardware_concurrency(), 1u);
+    #else
+        const uint32_t actualNumJobs = 1;
+    #endif
+
+    std::printf("Demo batch: playing %zu demo(s) with %u worker(s)...\n", demos.size(), actualNumJobs);
+    const auto startTime = std::chrono::steady_clock::now();
+
+    #if PSYDOOM_DEMO_BATCH_FORK
+        runWithWorkers(demos, actualNumJobs);
+    #else
+        runInProcess(demos);
+    #endif
+
+    const double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // Print a summary and write the report
+    const size_t numPassed = std::count_if(demos.begin(), demos.end(), [](const DemoEntry& demo) noexcept {
+        return (demo.status == DemoStatus::Pass);
+    });
+
+    std::printf("Demo batch: %zu of %zu demo(s) passed in %.2fs\n", numPassed, demos.size(), totalTime);
+
+    for (const DemoEntry& demo : demos) {
+        if (demo.status != DemoStatus::Pass) {
+            std::printf("  %-5s %s\n", getStatusName(demo.status), demo.demoFilePath.c_str());
+        }
+    }
+
+    if (reportFilePath[0] && (!writeReport(reportFilePath, demos, actualNumJobs, totalTime))) {
+        std::printf("Demo batch: failed to write the report file '%s'!\n", reportFilePath);
+    }
+
+    return (numPassed == demos.size());
+}
+
+END_NAMESPACE(DemoBatch)
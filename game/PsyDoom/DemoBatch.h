@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Batch demo verification: plays back a list of demos headless and checks each against its expected result, producing a single report.
+// The game disc and WADs are loaded once and on platforms supporting 'fork()' each demo is then played in a forked copy of the process,
+// with a number of these worker processes running at the same time. Elsewhere the demos are played one after another in-process.
+//
+// The manifest is a json file with the following format (relative paths are relative to the manifest file):
+//  {
+//      "demos": [
+//          { "demo": "MAP01.LMP", "result": "MAP01_result.json" },
+//          ...
+//      ]
+//  }
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(DemoBatch)
+
+bool run(const char* const manifestFilePath, const char* const reportFilePath, const uint32_t numJobs) noexcept;
+
+END_NAMESPACE(DemoBatch)
@@ -1,5 +1,6 @@
 #include "DiscInfo.h"
 
+#include "CompressedDiscImage.h"
 #include "FileUtils.h"
 
 #include <algorithm>
@@ -447,9 +448,13 @@ bool DiscInfo::parseFromCueStr(const char* const str, const char* const cueBaseP
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Parse the .cue from the given file; if there is an error 'false' is returned and an error message potentially set
+// Parse the .cue from the given file; if there is an error 'false' is returned and an error message potentially set.
+// Note: the file can also be a compressed disc image ('.pdz' file), in which case the track list is read from that instead.
 //------------------------------------------------------------------------------------------------------------------------------------------
 bool DiscInfo::parseFromCueFile(const char* const filePath, std::string& errorMsg) noexcept {
+    if (CompressedDiscImage::isCompressedDiscImage(filePath))
+        return CompressedDiscImage::readDiscInfo(filePath, *this, errorMsg);
+
     // Note: all paths specified in the .cue file will be relative to the .cue file itself.
     // Determine that base folder to which all paths are relative to here:
     std::string cueBasePath;
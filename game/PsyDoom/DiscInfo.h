@@ -48,6 +48,7 @@ struct DiscTrack {
     bool            bIsData;                // Audio or data track?
     int32_t         index0;                 // Raw CD-ROM sector (2,352 byte) where the pre-gap for the track starts, as read from the .cue file
     int32_t         index1;                 // Raw CD-ROM sector (2,352 byte) where the actual track data starts, as read from the .cue file
+    bool            bIsCompressedImage;     // If set then the source file is a compressed disc image ('.pdz' file) rather than raw track data
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -6,6 +6,24 @@
 #include <algorithm>
 #include <cstring>
 
+// Whether to memory map the files for tracks when opening them
+static bool gbUseMemoryMapping = false;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Set whether disc readers should try to memory map the files for tracks, instead of reading them using regular file I/O.
+// If mapping a file fails then regular file I/O is used instead. Only affects tracks opened after the call.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void DiscReader::setUseMemoryMapping(const bool bUseMemoryMapping) noexcept {
+    gbUseMemoryMapping = bUseMemoryMapping;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if disc readers try to memory map the files for tracks
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool DiscReader::getUseMemoryMapping() noexcept {
+    return gbUseMemoryMapping;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Initialize the disc reader: the reference to the disc info must remain valid for the lifetime of this object
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -15,6 +33,9 @@ DiscReader::DiscReader(const DiscInfo& discInfo) noexcept
     , mCurTrackIdx(-1)
     , mCurOffset(0)
     , mpOpenFile(nullptr)
+    , mMappedFile()
+    , mCompressedImage()
+    , mRawSectorBuffer()
 {
 }
 
@@ -48,12 +69,25 @@ bool DiscReader::setTrackNum(int32_t trackNum) noexcept {
 
     // Open the file for the new track if it's different to the current file
     if ((!mpCurTrack) || (mpCurTrack->sourceFilePath != pTrack->sourceFilePath)) {
-        // Need to switch files: close the old track and open the new one
+        // Need to switch files: close the old track and open the new one.
+        // Compressed disc images have their own reader. For other files try to memory map the file first if that is enabled,
+        // and fallback to regular file I/O if that fails.
         closeTrack();
-        mpOpenFile = std::fopen(pTrack->sourceFilePath.c_str(), "rb");
 
-        if (!mpOpenFile)
-            return false;
+        if (pTrack->bIsCompressedImage) {
+            if (!mCompressedImage.open(pTrack->sourceFilePath.c_str()))
+                return false;
+        }
+        else if (gbUseMemoryMapping) {
+            mMappedFile.open(pTrack->sourceFilePath.c_str());
+        }
+
+        if ((!mMappedFile.isOpen()) && (!mCompressedImage.isOpen())) {
+            mpOpenFile = std::fopen(pTrack->sourceFilePath.c_str(), "rb");
+
+            if (!mpOpenFile)
+                return false;
+        }
     }
 
     // Success - save the current track number and track!
@@ -76,7 +110,7 @@ bool DiscReader::setTrackNum(int32_t trackNum) noexcept {
 // Is a track currently open for reading?
 //------------------------------------------------------------------------------------------------------------------------------------------
 bool DiscReader::isTrackOpen() noexcept {
-    return (mpOpenFile != nullptr);
+    return ((mpOpenFile != nullptr) || mMappedFile.isOpen() || mCompressedImage.isOpen());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -90,6 +124,8 @@ void DiscReader::closeTrack() noexcept {
         mpOpenFile = nullptr;
     }
 
+    mMappedFile.close();
+    mCompressedImage.close();
     mCurOffset = 0;
     mCurTrackIdx = -1;
     mpCurTrack = nullptr;
@@ -103,7 +139,7 @@ bool DiscReader::trackSeekAbs(const int32_t offsetAbs) noexcept {
     if (!mpCurTrack)
         return false;
 
-    ASSERT(mpOpenFile);
+    ASSERT(isTrackOpen());
 
     if ((offsetAbs < 0) || (offsetAbs > mpCurTrack->trackPayloadSize))
         return false;
@@ -113,13 +149,7 @@ bool DiscReader::trackSeekAbs(const int32_t offsetAbs) noexcept {
         return true;
 
     // Do the seek and save the result if successful
-    const int32_t physicalOffset = dataOffsetToPhysical(offsetAbs);
-
-    if (std::fseek((FILE*) mpOpenFile, physicalOffset, SEEK_SET) != 0)
-        return false;
-
-    mCurOffset = offsetAbs;
-    return true;
+    return seekToDataOffset(offsetAbs);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -130,7 +160,7 @@ bool DiscReader::trackSeekRel(const int32_t offsetRel) noexcept {
     if (!mpCurTrack)
         return false;
 
-    ASSERT(mpOpenFile);
+    ASSERT(isTrackOpen());
     const int32_t newOffset = mCurOffset + offsetRel;
 
     if ((newOffset < 0) || (newOffset > mpCurTrack->trackPayloadSize))
@@ -141,13 +171,7 @@ bool DiscReader::trackSeekRel(const int32_t offsetRel) noexcept {
         return true;
 
     // Do the seek and save the result if successful
-    const int32_t physicalOffset = dataOffsetToPhysical(newOffset);
-
-    if (std::fseek((FILE*) mpOpenFile, physicalOffset, SEEK_SET) != 0)
-        return false;
-
-    mCurOffset = newOffset;
-    return true;
+    return seekToDataOffset(newOffset);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -159,37 +183,62 @@ bool DiscReader::read(void* const pBuffer, const int32_t numBytes) noexcept {
     ASSERT(pBuffer);
     ASSERT(numBytes >= 0);
 
-    // If there is no track open then the read fails
-    if (!mpCurTrack) {
+    // If there is no track open or the read goes past the end of the track then the read fails
+    if ((!mpCurTrack) || (numBytes > mpCurTrack->trackPayloadSize - mCurOffset)) {
         std::memset(pBuffer, 0, (size_t) numBytes);
         return false;
     }
 
-    // Continue reading until there no bytes left
-    const int32_t blockPayloadSize = mpCurTrack->blockPayloadSize;
+    if (numBytes <= 0)
+        return true;
 
-    std::byte* pDstBytes = (std::byte*) pBuffer;
-    int32_t bytesLeft = numBytes;
+    // Read from the memory mapping or compressed image if we have one, otherwise from the file
+    std::byte* const pDstBytes = (std::byte*) pBuffer;
+    const bool bReadOk = (mpOpenFile) ? readFromFile(pDstBytes, numBytes) : readFromMemoryOrImage(pDstBytes, numBytes);
 
-    while (bytesLeft > 0) {
-        // How many bytes are left in this sector? Try and read as much as we can or need from the sector:
-        const int32_t sectorBytesLeft = blockPayloadSize - (mCurOffset % blockPayloadSize);
-        const int32_t thisReadSize = std::min(bytesLeft, sectorBytesLeft);
+    if (!bReadOk) {
+        std::memset(pBuffer, 0, (size_t) numBytes);
+        return false;
+    }
 
-        if (std::fread(pDstBytes, thisReadSize, 1, (FILE*) mpOpenFile) != 1) {
-            std::memset(pBuffer, 0, (size_t) numBytes);
-            return false;
-        }
+    return true;
+}
 
-        // Read succeeded: seek to the next sector if we have consumed all of this sector's bytes
-        bytesLeft -= thisReadSize;
-        pDstBytes += thisReadSize;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Try to read the specified number of raw bytes from the current track, at the given physical offset within the track.
+// Unlike 'read' this includes any sector framing (e.g for raw 2,352 byte sectors) and doesn't change the current offset in the track.
+// If the read fails for some reason then all bytes are zeroed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool DiscReader::readRaw(const int32_t physicalOffset, void* const pBuffer, const int32_t numBytes) noexcept {
+    ASSERT(pBuffer);
+    ASSERT(numBytes >= 0);
 
-        // Try to seek past what we just read and issue an error if that fails
-        if (!trackSeekRel(thisReadSize)) {
-            std::memset(pBuffer, 0, (size_t) numBytes);
-            return false;
-        }
+    // If there is no track open or the read is not within the track then the read fails
+    const bool bValidRead = (
+        mpCurTrack &&
+        (physicalOffset >= 0) &&
+        (physicalOffset <= mpCurTrack->trackPhysicalSize) &&
+        (numBytes <= mpCurTrack->trackPhysicalSize - physicalOffset)
+    );
+
+    if (!bValidRead) {
+        std::memset(pBuffer, 0, (size_t) numBytes);
+        return false;
+    }
+
+    if (numBytes <= 0)
+        return true;
+
+    // Do the read, restoring the file position afterwards if reading from a file
+    bool bReadOk = readPhysical(mpCurTrack->fileOffset + physicalOffset, (std::byte*) pBuffer, numBytes);
+
+    if (mpOpenFile) {
+        bReadOk = (seekToDataOffset(mCurOffset) && bReadOk);
+    }
+
+    if (!bReadOk) {
+        std::memset(pBuffer, 0, (size_t) numBytes);
+        return false;
     }
 
     return true;
@@ -215,3 +264,169 @@ int32_t DiscReader::dataOffsetToPhysical(const int32_t dataOffset) const noexcep
         return 0;
     }
 }
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Go to the given data offset in the current track, moving the file position to match if reading from a regular file.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool DiscReader::seekToDataOffset(const int32_t dataOffset) noexcept {
+    if (mpOpenFile) {
+        const int32_t physicalOffset = dataOffsetToPhysical(dataOffset);
+
+        if (std::fseek((FILE*) mpOpenFile, physicalOffset, SEEK_SET) != 0)
+            return false;
+    }
+
+    mCurOffset = dataOffset;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Read the given number of bytes at the given physical offset in the file (or compressed image) for the track.
+// Note: when reading from a file this moves the file position, which the caller must restore.
+// Returns 'false' on failure, which includes the data being past the end of a truncated file.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool DiscReader::readPhysical(const int32_t physicalOffset, std::byte* const pDstBytes, const int32_t numBytes) noexcept {
+    ASSERT(physicalOffset >= 0);
+    ASSERT(numBytes >= 0);
+
+    if (mMappedFile.isOpen()) {
+        if ((size_t) physicalOffset + (size_t) numBytes > mMappedFile.getSize())
+            return false;
+
+        std::memcpy(pDstBytes, mMappedFile.getData() + physicalOffset, (size_t) numBytes);
+        return true;
+    }
+
+    if (mCompressedImage.isOpen())
+        return mCompressedImage.read((uint64_t) physicalOffset, pDstBytes, numBytes);
+
+    FILE* const pFile = (FILE*) mpOpenFile;
+    return ((std::fseek(pFile, physicalOffset, SEEK_SET) == 0) && (std::fread(pDstBytes, (size_t) numBytes, 1, pFile) == 1));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Read the given number of payload bytes from the memory mapped file or compressed image for the track, at the current offset.
+// The read must be within the bounds of the track. Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool DiscReader::readFromMemoryOrImage(std::byte* const pDstBytes, const int32_t numBytes) noexcept {
+    ASSERT(numBytes > 0);
+
+    const int32_t blockSize = mpCurTrack->blockSize;
+    const int32_t blockPayloadSize = mpCurTrack->blockPayloadSize;
+
+    // If there is no sector framing then the data is contiguous and can be read all at once
+    if (blockSize == blockPayloadSize) {
+        if (!readPhysical(dataOffsetToPhysical(mCurOffset), pDstBytes, numBytes))
+            return false;
+
+        mCurOffset += numBytes;
+        return true;
+    }
+
+    // Otherwise read the payload for each sector, skipping over the framing around it
+    int32_t physicalOffset = dataOffsetToPhysical(mCurOffset);
+    int32_t copySize = std::min(numBytes, blockPayloadSize - (mCurOffset % blockPayloadSize));
+    int32_t bytesLeft = numBytes;
+    std::byte* pCurDstBytes = pDstBytes;
+
+    while (true) {
+        if (!readPhysical(physicalOffset, pCurDstBytes, copySize))
+            return false;
+
+        pCurDstBytes += copySize;
+        bytesLeft -= copySize;
+
+        if (bytesLeft <= 0)
+            break;
+
+        physicalOffset += copySize + (blockSize - blockPayloadSize);
+        copySize = std::min(bytesLeft, blockPayloadSize);
+    }
+
+    mCurOffset += numBytes;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Read the given number of payload bytes from the file for the track, at the current offset.
+// The read must be within the bounds of the track. Returns 'false' on failure.
+//
+// If there is sector framing then the data for many raw sectors is read in one go, and the payload for each sector is copied out of that.
+// This is much faster than doing a read and a seek for each individual sector.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool DiscReader::readFromFile(std::byte* pDstBytes, const int32_t numBytes) noexcept {
+    ASSERT(numBytes > 0);
+    FILE* const pFile = (FILE*) mpOpenFile;
+
+    const int32_t blockSize = mpCurTrack->blockSize;
+    const int32_t blockPayloadSize = mpCurTrack->blockPayloadSize;
+
+    // If there is no sector framing then the data is contiguous and can be read all at once
+    if (blockSize == blockPayloadSize) {
+        if (std::fread(pDstBytes, (size_t) numBytes, 1, pFile) != 1) {
+            seekToDataOffset(mCurOffset);   // Try to restore the file position
+            return false;
+        }
+
+        mCurOffset += numBytes;
+        return true;
+    }
+
+    // Otherwise read as many raw sectors as we can at a time, until we are done
+    int32_t bytesLeft = numBytes;
+
+    while (bytesLeft > 0) {
+        // Figure out how many sectors and payload bytes to read this time round.
+        // Note that the read starts at the current position in the first sector's payload and ends partway through the last sector's payload.
+        const int32_t sectorOffset = mCurOffset % blockPayloadSize;
+        const int32_t numSectors = std::min((sectorOffset + bytesLeft + blockPayloadSize - 1) / blockPayloadSize, MAX_BULK_READ_SECTORS);
+        const int32_t readSize = std::min(bytesLeft, numSectors * blockPayloadSize - sectorOffset);
+        const int32_t lastSectorPayloadEnd = sectorOffset + readSize - (numSectors - 1) * blockPayloadSize;
+        const int32_t rawReadSize = (numSectors - 1) * blockSize + lastSectorPayloadEnd - sectorOffset;
+
+        if (numSectors <= 1) {
+            // Reading from a single sector: read straight into the destination
+            if (std::fread(pDstBytes, (size_t) readSize, 1, pFile) != 1) {
+                seekToDataOffset(mCurOffset);
+                return false;
+            }
+        } else {
+            // Reading from multiple sectors: read all the raw sectors then copy out the payload for each one
+            if (mRawSectorBuffer.size() < (size_t) rawReadSize) {
+                mRawSectorBuffer.resize((size_t) MAX_BULK_READ_SECTORS * blockSize);
+            }
+
+            if (std::fread(mRawSectorBuffer.data(), (size_t) rawReadSize, 1, pFile) != 1) {
+                seekToDataOffset(mCurOffset);
+                return false;
+            }
+
+            const std::byte* pSrcBytes = mRawSectorBuffer.data();
+            std::byte* pCurDstBytes = pDstBytes;
+            int32_t copySize = blockPayloadSize - sectorOffset;
+
+            for (int32_t sectorIdx = 0; sectorIdx < numSectors; ++sectorIdx) {
+                if (sectorIdx + 1 == numSectors) {
+                    copySize = lastSectorPayloadEnd - ((sectorIdx == 0) ? sectorOffset : 0);
+                }
+
+                std::memcpy(pCurDstBytes, pSrcBytes, (size_t) copySize);
+                pCurDstBytes += copySize;
+                pSrcBytes += copySize + (blockSize - blockPayloadSize);
+                copySize = blockPayloadSize;
+            }
+        }
+
+        // Advance past what was read.
+        // If the read ended at the end of a sector's payload then the file needs to be moved past the framing to the next sector's payload.
+        pDstBytes += readSize;
+        bytesLeft -= readSize;
+        mCurOffset += readSize;
+
+        if ((lastSectorPayloadEnd == blockPayloadSize) && (!seekToDataOffset(mCurOffset)))
+            return false;
+    }
+
+    return true;
+}
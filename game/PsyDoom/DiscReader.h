@@ -1,17 +1,30 @@
 #pragma once
 
+#include "CompressedDiscImage.h"
 #include "Macros.h"
+#include "MappedFile.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 struct DiscInfo;
 struct DiscTrack;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Provides access to the data in CD image
+// Provides access to the data in CD image.
+// Reads spanning multiple sectors are done in bulk, reading many raw sectors at once and then extracting the payload data for each sector.
+// Optionally, the file for the track being read can be memory mapped, in which case reads are just copies from the mapping.
+// Tracks from a compressed disc image ('.pdz' file) are also supported, with data being decompressed as it is read.
 //------------------------------------------------------------------------------------------------------------------------------------------
 class DiscReader {
 public:
+    // The maximum number of raw sectors read in one go when reading from a track with sector framing (e.g 2,352 byte sectors)
+    static constexpr int32_t MAX_BULK_READ_SECTORS = 32;
+
+    static void setUseMemoryMapping(const bool bUseMemoryMapping) noexcept;
+    static bool getUseMemoryMapping() noexcept;
+
     DiscReader(const DiscInfo& discInfo) noexcept;
     ~DiscReader() noexcept;
 
@@ -25,14 +38,26 @@ public:
     bool trackSeekAbs(const int32_t offsetAbs) noexcept;
     bool trackSeekRel(const int32_t offsetRel) noexcept;
     bool read(void* const pBuffer, const int32_t numBytes) noexcept;
+    bool readRaw(const int32_t physicalOffset, void* const pBuffer, const int32_t numBytes) noexcept;
     int32_t tell() const noexcept;
 
 private:
     int32_t dataOffsetToPhysical(const int32_t dataOffset) const noexcept;
+    bool seekToDataOffset(const int32_t dataOffset) noexcept;
+    bool readPhysical(const int32_t physicalOffset, std::byte* const pDstBytes, const int32_t numBytes) noexcept;
+    bool readFromMemoryOrImage(std::byte* const pDstBytes, const int32_t numBytes) noexcept;
+    bool readFromFile(std::byte* pDstBytes, const int32_t numBytes) noexcept;
 
     const DiscInfo&     mDiscInfo;      // Information for the disc being read from
     const DiscTrack*    mpCurTrack;     // Pointer to the current track open for the disc reader
     int32_t             mCurTrackIdx;   // Current track index in the disc that is open for reading or '-1' if none
     int32_t             mCurOffset;     // Current byte offset in the actual track data we are at (NOT physical offset in the file)
-    void*               mpOpenFile;     // Handle to the open file for the current track
+    void*               mpOpenFile;     // Handle to the open file for the current track, if the file is not memory mapped or a compressed image
+    MappedFile          mMappedFile;    // Memory mapping of the file for the current track, if memory mapping is enabled and possible
+
+    // The compressed disc image open for the current track, if the track is from a compressed image
+    CompressedDiscImage     mCompressedImage;
+
+    // Temporary buffer used to hold multiple raw sectors read from the file at once
+    std::vector<std::byte>  mRawSectorBuffer;
 };
@@ -2,15 +2,20 @@
 
 #include "Asserts.h"
 #include "FatalErrors.h"
+#include "ModMgr.h"
 #include "SmallString.h"
 #include "Wess/psxcd.h"
 
+#include <cstring>
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Initializes the file reader with no file open
 //------------------------------------------------------------------------------------------------------------------------------------------
 GameFileReader::GameFileReader() noexcept
     : mCdFile()
     , mpFile(nullptr)
+    , mMappedFile()
+    , mMappedOffset(0)
 {
 }
 
@@ -27,23 +32,29 @@ GameFileReader::~GameFileReader() noexcept {
 GameFileReader::GameFileReader(GameFileReader&& other) noexcept
     : mCdFile(other.mCdFile)
     , mpFile(other.mpFile)
+    , mMappedFile(std::move(other.mMappedFile))
+    , mMappedOffset(other.mMappedOffset)
 {
     other.mCdFile = {};
     other.mpFile = nullptr;
+    other.mMappedOffset = 0;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Tells if a file is currently open for reading
 //------------------------------------------------------------------------------------------------------------------------------------------
 bool GameFileReader::isOpen() noexcept {
-    return ((mCdFile.fileHandle > 0) || (mCdFile.overrideFileHandle > 0) || mpFile);
+    return ((mCdFile.fileHandle > 0) || (mCdFile.overrideFileHandle > 0) || mpFile || mMappedFile.isOpen());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Closes the file currently being read
 //------------------------------------------------------------------------------------------------------------------------------------------
 void GameFileReader::close() noexcept {
-    if (mpFile) {
+    if (mMappedFile.isOpen()) {
+        mMappedFile.close();
+        mMappedOffset = 0;
+    } else if (mpFile) {
         std::fclose(mpFile);
         mpFile = nullptr;
     } else {
@@ -58,6 +69,13 @@ void GameFileReader::close() noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 void GameFileReader::open(const char* const filePath) noexcept {
     ASSERT(!isOpen());
+
+    // PsyDoom: prefer to memory map the file if possible, fall back to regular file I/O otherwise
+    if (mMappedFile.open(filePath)) {
+        mMappedOffset = 0;
+        return;
+    }
+
     mpFile = std::fopen(filePath, "rb");
 
     if (!mpFile) {
@@ -71,6 +89,15 @@ void GameFileReader::open(const char* const filePath) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 void GameFileReader::open(const CdFileId fileId) noexcept {
     ASSERT(!isOpen());
+
+    // If the file is overriden on disk then try to memory map the override, otherwise read through the 'psxcd' library
+    if (ModMgr::areOverridesAvailableForFile(fileId)) {
+        if (mMappedFile.open(ModMgr::getOverridenFilePath(fileId).c_str())) {
+            mMappedOffset = 0;
+            return;
+        }
+    }
+
     mCdFile = *psxcd_open(fileId);      // Note: will always return a valid pointer or fail with a fatal error!
 }
 
@@ -81,7 +108,13 @@ void GameFileReader::open(const CdFileId fileId) noexcept {
 void GameFileReader::seekRelative(const int32_t offset) noexcept {
     ASSERT(isOpen());
 
-    if (mpFile) {
+    if (mMappedFile.isOpen()) {
+        if ((offset < 0) ? ((size_t) -(int64_t) offset > mMappedOffset) : ((size_t) offset > mMappedFile.getSize() - mMappedOffset)) {
+            FatalErrors::raiseF("GameFileReader::seek: operation failed - IO error!");
+        }
+
+        mMappedOffset = (size_t)((int64_t) mMappedOffset + offset);
+    } else if (mpFile) {
         if (std::fseek(mpFile, offset, SEEK_CUR) != 0) {
             FatalErrors::raiseF("GameFileReader::seek: operation failed - IO error!");
         }
@@ -99,7 +132,13 @@ void GameFileReader::seekRelative(const int32_t offset) noexcept {
 void GameFileReader::seekAbsolute(const int32_t offset) noexcept {
     ASSERT(isOpen());
 
-    if (mpFile) {
+    if (mMappedFile.isOpen()) {
+        if ((offset < 0) || ((size_t) offset > mMappedFile.getSize())) {
+            FatalErrors::raiseF("GameFileReader::seek: operation failed - IO error!");
+        }
+
+        mMappedOffset = (size_t) offset;
+    } else if (mpFile) {
         if (std::fseek(mpFile, offset, SEEK_SET) != 0) {
             FatalErrors::raiseF("GameFileReader::seek: operation failed - IO error!");
         }
@@ -122,7 +161,14 @@ void GameFileReader::read(void* const pBuffer, const int32_t numBytes) noexcept
     if (numBytes <= 0)
         return;
 
-    if (mpFile) {
+    if (mMappedFile.isOpen()) {
+        if ((size_t) numBytes > mMappedFile.getSize() - mMappedOffset) {
+            FatalErrors::raiseF("GameFileReader::read: operation failed - IO error!");
+        }
+
+        std::memcpy(pBuffer, mMappedFile.getData() + mMappedOffset, (size_t) numBytes);
+        mMappedOffset += (size_t) numBytes;
+    } else if (mpFile) {
         if (std::fread(pBuffer, (uint32_t) numBytes, 1, mpFile) != 1) {
             FatalErrors::raiseF("GameFileReader::read: operation failed - IO error!");
         }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MappedFile.h"
 #include "Wess/psxcd.h"
 
 #include <cstdio>
@@ -10,6 +11,9 @@
 //  (2) A file within the game's CD image that has been overriden on disk.
 //  (3) A real file on disk.
 //
+// Real files on disk (including file overrides) are memory mapped where possible, in which case the file data can also be accessed directly
+// through 'getMappedData'. Files within the game's CD image are always read through the 'psxcd' library.
+//
 // Note: if any IO errors occur then the problem will be treated as fatal and the game will be terminated.
 //------------------------------------------------------------------------------------------------------------------------------------------
 class GameFileReader {
@@ -26,6 +30,10 @@ public:
     void seekAbsolute(const int32_t offset) noexcept;
     void read(void* const pBuffer, const int32_t numBytes) noexcept;
 
+    // Gives the data for the entire file if it is memory mapped, otherwise 'nullptr'
+    inline const std::byte* getMappedData() const noexcept { return mMappedFile.getData(); }
+    inline size_t getMappedSize() const noexcept { return mMappedFile.getSize(); }
+
     // Convenience overload
     template <class T>
     void read(T& value) noexcept { read(&value, sizeof(T)); }
@@ -35,6 +43,8 @@ private:
     GameFileReader& operator = (const GameFileReader& other) = delete;
     GameFileReader& operator = (GameFileReader&& other) = delete;
 
-    PsxCd_File      mCdFile;    // If reading from a file on-disk, this is the index of the file slot open in the 'psxcd' library
-    FILE*           mpFile;     // If reading from a real file, this is the file being read
+    PsxCd_File      mCdFile;            // If reading from a file on-disk, this is the index of the file slot open in the 'psxcd' library
+    FILE*           mpFile;             // If reading from a real file, this is the file being read
+    MappedFile      mMappedFile;        // If reading from a real file that could be memory mapped, this is the mapping for the file
+    size_t          mMappedOffset;      // If reading from a memory mapped file, the current offset in the file
 };
@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records the stream of LIBGPU primitives and VRAM uploads over a range of frames to a binary file.
+// See the header for more details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "GpuCapture.h"
+
+#include "Gpu.h"
+#include "ProgArgs.h"
+#include "PsxVm.h"
+
+#include <cstdio>
+#include <cstring>
+
+BEGIN_NAMESPACE(GpuCapture)
+
+bool gbIsCapturing = false;
+
+static std::FILE*   gpCaptureFile;              // The file being written to, or null if not capturing
+static bool         gbCaptureDone;              // True once the capture has finished (or failed to start), so it does not begin again
+static uint32_t     gNumFramesPresented;        // How many frames have been presented in total
+static uint32_t     gNumFramesCaptured;         // How many frames have been captured so far
+static uint64_t     gNumBytesWritten;           // Size of the capture file so far
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Write the given bytes to the capture file
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeBytes(const void* const pData, const size_t size) noexcept {
+    if (size > 0) {
+        std::fwrite(pData, 1, size, gpCaptureFile);
+        gNumBytesWritten += size;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Write a record header to the capture file
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeRecordHeader(const RecordType type, const uint32_t size) noexcept {
+    RecordHeader header = {};
+    header.type = type;
+    header.size = size;
+    writeBytes(&header, sizeof(header));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Begins capturing to the file specified by the program arguments, if that can be done.
+// Writes the file header along with the current GPU state and VRAM contents.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void beginCapture() noexcept {
+    gbCaptureDone = true;   // Only ever attempt to capture once
+    gpCaptureFile = std::fopen(ProgArgs::gGpuCaptureFilePath, "wb");
+
+    if (!gpCaptureFile) {
+        std::printf("GPU capture: failed to open '%s' for writing! Nothing will be captured.\n", ProgArgs::gGpuCaptureFilePath);
+        return;
+    }
+
+    // Use a large buffer since there are many small writes
+    std::setvbuf(gpCaptureFile, nullptr, _IOFBF, 1024 * 1024);
+
+    gbIsCapturing = true;
+    gNumFramesCaptured = 0;
+    gNumBytesWritten = 0;
+
+    // Write the file header
+    Gpu::Core& gpu = PsxVm::gGpu;
+
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.vramW = gpu.ramPixelW;
+    header.vramH = gpu.ramPixelH;
+    header.bLimitRemoving = (PSYDOOM_LIMIT_REMOVING) ? 1 : 0;
+    writeBytes(&header, sizeof(header));
+
+    // Save the initial state of the GPU and VRAM
+    Gpu::flush(gpu);
+    recordGpuState();
+
+    SRECT vramRect = {};
+    vramRect.w = (int16_t) gpu.ramPixelW;
+    vramRect.h = (int16_t) gpu.ramPixelH;
+    recordLoadImage(vramRect, gpu.pRam);
+
+    std::printf("GPU capture: recording %u frame(s) to '%s'...\n", ProgArgs::gGpuCaptureNumFrames, ProgArgs::gGpuCaptureFilePath);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Ends the capture in progress, if any, and closes the capture file
+//------------------------------------------------------------------------------------------------------------------------------------------
+void shutdown() noexcept {
+    if (gpCaptureFile) {
+        std::fclose(gpCaptureFile);
+        gpCaptureFile = nullptr;
+
+        std::printf(
+            "GPU capture: recorded %u frame(s), %.2f MiB to '%s'\n",
+            gNumFramesCaptured,
+            (double) gNumBytesWritten / (1024.0 * 1024.0),
+            ProgArgs::gGpuCaptureFilePath
+        );
+    }
+
+    gbIsCapturing = false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Called whenever a frame is presented: marks the end of the frame in the capture, or begins/ends the capture when appropriate.
+// Capturing begins once 'ProgArgs::gGpuCaptureStartFrame' frames have been presented.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void onFrameEnd() noexcept {
+    gNumFramesPresented++;
+
+    if (gbIsCapturing) {
+        writeRecordHeader(RecordType::FrameEnd, 0);
+        gNumFramesCaptured++;
+
+        if (gNumFramesCaptured >= ProgArgs::gGpuCaptureNumFrames) {
+            shutdown();
+        }
+    }
+    else if ((!gbCaptureDone) && ProgArgs::gGpuCaptureFilePath[0] && (gNumFramesPresented >= ProgArgs::gGpuCaptureStartFrame)) {
+        beginCapture();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records the current GPU draw state; should be called whenever it is modified directly rather than via a primitive
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordGpuState() noexcept {
+    const Gpu::Core& gpu = PsxVm::gGpu;
+
+    GpuStateRecord state = {};
+    state.drawOffsetX = gpu.drawOffsetX;
+    state.drawOffsetY = gpu.drawOffsetY;
+    state.drawAreaLx = gpu.drawAreaLx;
+    state.drawAreaRx = gpu.drawAreaRx;
+    state.drawAreaTy = gpu.drawAreaTy;
+    state.drawAreaBy = gpu.drawAreaBy;
+    state.texPageX = gpu.texPageX;
+    state.texPageY = gpu.texPageY;
+    state.texPageXMask = gpu.texPageXMask;
+    state.texPageYMask = gpu.texPageYMask;
+    state.texWinX = gpu.texWinX;
+    state.texWinY = gpu.texWinY;
+    state.texWinXMask = gpu.texWinXMask;
+    state.texWinYMask = gpu.texWinYMask;
+    state.clutX = gpu.clutX;
+    state.clutY = gpu.clutY;
+    state.blendMode = (uint8_t) gpu.blendMode;
+    state.texFmt = (uint8_t) gpu.texFmt;
+    state.bDisableMasking = gpu.bDisableMasking;
+
+    writeRecordHeader(RecordType::GpuState, sizeof(state));
+    writeBytes(&state, sizeof(state));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records the clearing of an area of VRAM
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordClearRect(const uint16_t color, const uint16_t x, const uint16_t y, const uint16_t w, const uint16_t h) noexcept {
+    ClearRectRecord clear = {};
+    clear.color = color;
+    clear.x = x;
+    clear.y = y;
+    clear.w = w;
+    clear.h = h;
+
+    writeRecordHeader(RecordType::ClearRect, sizeof(clear));
+    writeBytes(&clear, sizeof(clear));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records an upload of 16-bit image data to VRAM
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordLoadImage(const SRECT& dstRect, const uint16_t* const pImageData) noexcept {
+    const uint32_t imageSize = (uint32_t) dstRect.w * (uint32_t) dstRect.h * sizeof(uint16_t);
+    writeRecordHeader(RecordType::LoadImage, (uint32_t) sizeof(SRECT) + imageSize);
+    writeBytes(&dstRect, sizeof(SRECT));
+    writeBytes(pImageData, imageSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a copy from one area of VRAM to another
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordMoveImage(const SRECT& srcRect, const int32_t dstX, const int32_t dstY) noexcept {
+    MoveImageRecord move = {};
+    move.srcRect = srcRect;
+    move.dstX = dstX;
+    move.dstY = dstY;
+
+    writeRecordHeader(RecordType::MoveImage, sizeof(move));
+    writeBytes(&move, sizeof(move));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a LIBGPU primitive, exactly as it was submitted
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordPrim(const RecordType type, const void* const pPrim, const uint32_t primSize) noexcept {
+    writeRecordHeader(type, primSize);
+    writeBytes(pPrim, primSize);
+}
+
+END_NAMESPACE(GpuCapture)
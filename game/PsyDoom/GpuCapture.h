@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Macros.h"
+#include "PsyQ/LIBGPU.h"
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records the stream of LIBGPU primitives submitted to the PSX GPU (and any VRAM uploads) over a range of frames to a binary file.
+// The 'GpuReplay' tool can play back the file on a fresh GPU core to benchmark and regression test the classic renderer headlessly.
+//
+// File format (all values little endian):
+//  (1) A 'FileHeader'.
+//  (2) A 'GpuState' record and a 'LoadImage' record covering all of VRAM, which capture the state of the GPU when recording started.
+//  (3) A sequence of records, each of which is a 'RecordHeader' followed by 'size' bytes of data.
+//      For primitive records the data is the LIBGPU primitive struct exactly as submitted.
+//      A 'FrameEnd' record marks the point where a frame was presented.
+//
+// Notes:
+//  (1) The layout of LIBGPU primitives depends on whether the build is limit removing, so the file can only be replayed by a build
+//      with the same setting. The header records this.
+//  (2) Only the classic renderer draws via the PSX GPU, so captures are only meaningful when that renderer is in use.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(GpuCapture)
+
+static constexpr char       FILE_MAGIC[8] = { 'P', 'S', 'Y', 'G', 'C', 'A', 'P', 0 };
+static constexpr uint32_t   FILE_VERSION = 1;
+
+// What type of data a record in the capture file holds
+enum class RecordType : uint8_t {
+    FrameEnd,       // A frame was presented: no data
+    GpuState,       // The GPU draw state was set directly (rather than via a primitive): a 'GpuStateRecord'
+    ClearRect,      // A region of VRAM was cleared: a 'ClearRectRecord'
+    LoadImage,      // Data was uploaded to VRAM: an 'SRECT' for the destination followed by 'w * h' 16-bit pixels
+    MoveImage,      // One part of VRAM was copied to another: a 'MoveImageRecord'
+    DR_MODE,        // Primitive: sets texture page and window
+    DR_TWIN,        // Primitive: sets texture window
+    SPRT,           // Primitive: sprite (8x8 sprites are recorded as normal sprites)
+    LINE_F2,        // Primitive: flat shaded line
+    POLY_FT3,       // Primitive: flat shaded and textured triangle
+    POLY_F4,        // Primitive: flat shaded quad
+    POLY_FT4,       // Primitive: flat shaded and textured quad
+    FLOORROW_FT,    // Primitive: Doom floor row
+    WALLCOL_GT,     // Primitive: Doom wall column
+    NUM_TYPES
+};
+
+// Header at the start of a capture file
+struct FileHeader {
+    char        magic[8];           // Should equal 'FILE_MAGIC'
+    uint32_t    version;            // Should equal 'FILE_VERSION'
+    uint16_t    vramW;              // Size of VRAM (in 16-bit pixels) for the GPU the capture was made with
+    uint16_t    vramH;
+    uint8_t     bLimitRemoving;     // Whether the capture was made by a limit removing build (affects the LIBGPU primitive layouts)
+    uint8_t     pad[3];
+};
+
+// Header for each record in a capture file
+struct RecordHeader {
+    RecordType  type;               // What type of record this is
+    uint8_t     pad[3];
+    uint32_t    size;               // Size of the record data which follows, in bytes
+};
+
+// The GPU draw state that is not set by primitives
+struct GpuStateRecord {
+    int16_t     drawOffsetX;
+    int16_t     drawOffsetY;
+    uint16_t    drawAreaLx;
+    uint16_t    drawAreaRx;
+    uint16_t    drawAreaTy;
+    uint16_t    drawAreaBy;
+    uint16_t    texPageX;
+    uint16_t    texPageY;
+    uint16_t    texPageXMask;
+    uint16_t    texPageYMask;
+    uint16_t    texWinX;
+    uint16_t    texWinY;
+    uint16_t    texWinXMask;
+    uint16_t    texWinYMask;
+    uint16_t    clutX;
+    uint16_t    clutY;
+    uint8_t     blendMode;
+    uint8_t     texFmt;
+    uint8_t     bDisableMasking;
+    uint8_t     pad;
+};
+
+struct ClearRectRecord {
+    uint16_t    color;              // 16-bit color to clear to
+    uint16_t    x;
+    uint16_t    y;
+    uint16_t    w;
+    uint16_t    h;
+};
+
+struct MoveImageRecord {
+    SRECT       srcRect;
+    int32_t     dstX;
+    int32_t     dstY;
+};
+
+// True while frames are being recorded; recording functions must only be called when this is set
+extern bool gbIsCapturing;
+
+void shutdown() noexcept;
+void onFrameEnd() noexcept;
+void recordGpuState() noexcept;
+void recordClearRect(const uint16_t color, const uint16_t x, const uint16_t y, const uint16_t w, const uint16_t h) noexcept;
+void recordLoadImage(const SRECT& dstRect, const uint16_t* const pImageData) noexcept;
+void recordMoveImage(const SRECT& srcRect, const int32_t dstX, const int32_t dstY) noexcept;
+void recordPrim(const RecordType type, const void* const pPrim, const uint32_t primSize) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Helper to record a LIBGPU primitive of the given type
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class PrimT>
+inline void recordPrim(const RecordType type, const PrimT& prim) noexcept {
+    recordPrim(type, &prim, (uint32_t) sizeof(PrimT));
+}
+
+END_NAMESPACE(GpuCapture)
@@ -0,0 +1,383 @@
+#include "LIBGPU_CmdDecode.h"
+
+#include "Asserts.h"
+#include "Gpu.h"
+
+BEGIN_NAMESPACE(LIBGPU_CmdDecode)
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the color to draw a primitive with.
+// If the primitive is not colored then the given value is used for all components, which should be the value for '1.0' or full strength.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class PrimT>
+static Gpu::Color24F getPrimColor(const PrimT& prim, const uint8_t unmodulatedValue) noexcept {
+    const bool bColorPrim = ((prim.code & 0x1) == 0);
+
+    Gpu::Color24F color = {};
+    color.comp.r = (bColorPrim) ? prim.r0 : unmodulatedValue;
+    color.comp.g = (bColorPrim) ? prim.g0 : unmodulatedValue;
+    color.comp.b = (bColorPrim) ? prim.b0 : unmodulatedValue;
+    return color;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the given shape with the textured or textured and blended draw mode
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class ShapeT>
+static void drawTextured(Gpu::Core& gpu, const ShapeT& shape, const bool bBlend) noexcept {
+    if (bBlend) {
+        Gpu::draw<Gpu::DrawMode::TexturedBlended>(gpu, shape);
+    } else {
+        Gpu::draw<Gpu::DrawMode::Textured>(gpu, shape);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Set the GPU texture page, texture format, and blending (semi-transparency) mode from a 16-bit word as encoded by LIBGPU
+//------------------------------------------------------------------------------------------------------------------------------------------
+void setGpuTexPageId(Gpu::Core& gpu, const uint16_t texPageId) noexcept {
+    // Set texture format
+    switch (texPageId & 0x3) {
+        case 0: gpu.texFmt = Gpu::TexFmt::Bpp4;     break;
+        case 1: gpu.texFmt = Gpu::TexFmt::Bpp8;     break;
+        case 2: gpu.texFmt = Gpu::TexFmt::Bpp16;    break;
+        default: break;
+    }
+
+    // Set blend/semi-transparency mode
+    switch ((texPageId >> 2) & 0x3) {
+        case 0: gpu.blendMode = Gpu::BlendMode::Alpha50;    break;
+        case 1: gpu.blendMode = Gpu::BlendMode::Add;        break;
+        case 2: gpu.blendMode = Gpu::BlendMode::Subtract;   break;
+        case 3: gpu.blendMode = Gpu::BlendMode::Add25;      break;
+        default: break;
+    }
+
+    // Set the texture page position and size.
+    // The size will 1024x512 pixels if limit removing, or 256x256 under the original limits.
+    gpu.texPageX = ((texPageId >> 4) & 0x7Fu) * 64u;
+    gpu.texPageY = ((texPageId >> 11) & 0x1Fu) * 256u;
+
+    #if PSYDOOM_LIMIT_REMOVING
+        gpu.texPageXMask = 0x3FF;
+        gpu.texPageYMask = 0x1FF;
+    #else
+        gpu.texPageXMask = 0xFF;
+        gpu.texPageYMask = 0xFF;
+    #endif
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Set the GPU CLUT position, from a 16-bit word as encoded by LIBGPU
+//------------------------------------------------------------------------------------------------------------------------------------------
+void setGpuClutId(Gpu::Core& gpu, const uint16_t clutId) noexcept {
+    const uint16_t clutX = (clutId & 0x3Fu) << 4;       // Clut X position is restricted to multiples of 16
+    const uint16_t clutY = (clutId >> 6u) & 0xFFFu;
+    gpu.clutX = clutX;
+    gpu.clutY = clutY;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Set the GPU texture window from a 32-bit word as encoded by LIBGPU
+//------------------------------------------------------------------------------------------------------------------------------------------
+void setGpuTexWin(Gpu::Core& gpu, const uint32_t texWin) noexcept {
+    // Note: all offsets are in multiples of 8 units.
+    // The masks also only allow for power of two textures.
+    // Both these restrictions are required by the PsyQ SDK when encoding a texture window.
+    //
+    // PsyDoom limit removing: offsets are now in multiples of either 2 or 4 units.
+    // The maximum texture size is now also extended to 1024x512.
+    #if PSYDOOM_LIMIT_REMOVING
+        const uint16_t twOffsetX = ((texWin >> 0) & 0x1FFu) << 1;
+        const uint16_t twOffsetY = ((texWin >> 9) & 0x7Fu) << 2;
+        const uint16_t twSizeX = ((texWin >> 16) & 0x1FFu) << 1;
+        const uint16_t twSizeY = ((texWin >> 25) & 0x7Fu) << 2;
+
+        gpu.texWinX = twOffsetX;
+        gpu.texWinY = twOffsetY;
+    #else
+        const uint8_t twOffsetX = (texWin >> 10) & 0x1Fu;
+        const uint8_t twOffsetY = (texWin >> 15) & 0x1Fu;
+        const uint8_t twSizeX = (texWin >> 0) & 0x1Fu;
+        const uint8_t twSizeY = (texWin >> 5) & 0x1Fu;
+
+        gpu.texWinX = twOffsetX * 8;
+        gpu.texWinY = twOffsetY * 8;
+    #endif
+
+    if (twSizeX != 0) {
+        #if PSYDOOM_LIMIT_REMOVING
+            const uint16_t texW = twSizeX;
+        #else
+            const uint8_t texW = (uint8_t) -(int8_t)(twSizeX << 3);
+        #endif
+
+        gpu.texWinXMask = texW - 1;
+    } else {
+        #if PSYDOOM_LIMIT_REMOVING
+            gpu.texWinXMask = 0x3FFu;   // 1024 pixel range
+        #else
+            gpu.texWinXMask = 0xFFu;    // 256 pixel range
+        #endif
+    }
+
+    if (twSizeY != 0) {
+        #if PSYDOOM_LIMIT_REMOVING
+            const uint16_t texH = twSizeY;
+        #else
+            const uint8_t texH = (uint8_t) -(int8_t)(twSizeY << 3);
+        #endif
+
+        gpu.texWinYMask = texH - 1;
+    } else {
+        #if PSYDOOM_LIMIT_REMOVING
+            gpu.texWinYMask = 0x1FFu;   // 512 pixel range
+        #else
+            gpu.texWinYMask = 0xFFu;    // 256 pixel range
+        #endif
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Set the GPU masking mode from the 'code' field of a draw primitive
+//------------------------------------------------------------------------------------------------------------------------------------------
+void setGpuMaskingMode(Gpu::Core& gpu, const uint8_t primCode) noexcept {
+    gpu.bDisableMasking = (primCode & 0x80);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command primitive to set the drawing mode: sets the texture page and window.
+// Originally this command would have also set the dithering and 'draw in display area' flag but both of those are no longer supported by
+// PsyDoom's new PSX GPU implementation, so we ignore those aspects of the command.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const DR_MODE& drawMode) noexcept {
+    const uint16_t texPageId = drawMode.code[0] & 0xFFFF;
+    setGpuTexPageId(gpu, texPageId);
+    setGpuTexWin(gpu, drawMode.code[1]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command primitive to set the texture window
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const DR_TWIN& texWin) noexcept {
+    setGpuTexWin(gpu, texWin.code[0]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw a variable sized sprite
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const SPRT& sprite) noexcept {
+    // Set the CLUT to use and masking mode
+    setGpuClutId(gpu, sprite.clut);
+    setGpuMaskingMode(gpu, sprite.code);
+
+    // Setup the rectangle to be drawn then submit to the GPU
+    Gpu::DrawRect drawRect = {};
+    drawRect.x = sprite.x0;
+    drawRect.y = sprite.y0;
+    drawRect.w = sprite.w;
+    drawRect.h = sprite.h;
+    drawRect.u = sprite.u0;
+    drawRect.v = sprite.v0;
+    drawRect.color = getPrimColor(sprite, 128);     // Note: '128' is '1.0' or full strength color if we don't want to modulate
+
+    drawTextured(gpu, drawRect, (sprite.code & 0x2));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw a line
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const LINE_F2& line) noexcept {
+    ASSERT_LOG((line.code & 0x2) == 0, "Blending not supported for lines! Doom shouldn't need this functionality!");
+
+    Gpu::DrawLine drawLine = {};
+    drawLine.x1 = line.x0;
+    drawLine.y1 = line.y0;
+    drawLine.x2 = line.x1;
+    drawLine.y2 = line.y1;
+    drawLine.color = getPrimColor(line, 255);       // Note: '255' is '1.0' or full strength color if we don't want to modulate
+
+    Gpu::draw<Gpu::DrawMode::Colored>(gpu, drawLine);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw a flat shaded and textured triangle
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const POLY_FT3& poly) noexcept {
+    // Set texture page and format, the CLUT to use and masking mode
+    setGpuTexPageId(gpu, poly.tpage);
+    setGpuClutId(gpu, poly.clut);
+    setGpuMaskingMode(gpu, poly.code);
+
+    // Setup the triangle to be drawn then submit to the GPU
+    Gpu::DrawTriangle drawTri = {};
+    drawTri.x1 = poly.x0;
+    drawTri.y1 = poly.y0;
+    drawTri.u1 = poly.u0;
+    drawTri.v1 = poly.v0;
+    drawTri.x2 = poly.x1;
+    drawTri.y2 = poly.y1;
+    drawTri.u2 = poly.u1;
+    drawTri.v2 = poly.v1;
+    drawTri.x3 = poly.x2;
+    drawTri.y3 = poly.y2;
+    drawTri.u3 = poly.u2;
+    drawTri.v3 = poly.v2;
+    drawTri.color = getPrimColor(poly, 128);        // Note: '128' is '1.0' or full strength color if we don't want to modulate
+
+    drawTextured(gpu, drawTri, (poly.code & 0x2));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw non-textured (color only) quad
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const POLY_F4& poly) noexcept {
+    // Setup the triangles to be drawn then submit to the GPU
+    const Gpu::Color24F color = getPrimColor(poly, 255);    // Note: '255' is '1.0' or full strength color if we don't want to modulate
+
+    Gpu::DrawTriangle drawTri1 = {};
+    drawTri1.x1 = poly.x0;
+    drawTri1.y1 = poly.y0;
+    drawTri1.x2 = poly.x1;
+    drawTri1.y2 = poly.y1;
+    drawTri1.x3 = poly.x2;
+    drawTri1.y3 = poly.y2;
+    drawTri1.color = color;
+
+    Gpu::DrawTriangle drawTri2 = {};
+    drawTri2.x1 = poly.x1;
+    drawTri2.y1 = poly.y1;
+    drawTri2.x2 = poly.x2;
+    drawTri2.y2 = poly.y2;
+    drawTri2.x3 = poly.x3;
+    drawTri2.y3 = poly.y3;
+    drawTri2.color = color;
+
+    if (poly.code & 0x2) {
+        Gpu::draw<Gpu::DrawMode::ColoredBlended>(gpu, drawTri1);
+        Gpu::draw<Gpu::DrawMode::ColoredBlended>(gpu, drawTri2);
+    } else {
+        Gpu::draw<Gpu::DrawMode::Colored>(gpu, drawTri1);
+        Gpu::draw<Gpu::DrawMode::Colored>(gpu, drawTri2);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw a textured quad
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const POLY_FT4& poly) noexcept {
+    // Set texture page and format, the CLUT to use and masking mode
+    setGpuTexPageId(gpu, poly.tpage);
+    setGpuClutId(gpu, poly.clut);
+    setGpuMaskingMode(gpu, poly.code);
+
+    // Setup the triangles to be drawn then submit to the GPU
+    const Gpu::Color24F color = getPrimColor(poly, 128);    // Note: '128' is '1.0' or full strength color if we don't want to modulate
+    const bool bBlendPoly = (poly.code & 0x2);
+
+    Gpu::DrawTriangle drawTri1 = {};
+    drawTri1.x1 = poly.x0;
+    drawTri1.y1 = poly.y0;
+    drawTri1.u1 = poly.u0;
+    drawTri1.v1 = poly.v0;
+    drawTri1.x2 = poly.x1;
+    drawTri1.y2 = poly.y1;
+    drawTri1.u2 = poly.u1;
+    drawTri1.v2 = poly.v1;
+    drawTri1.x3 = poly.x2;
+    drawTri1.y3 = poly.y2;
+    drawTri1.u3 = poly.u2;
+    drawTri1.v3 = poly.v2;
+    drawTri1.color = color;
+
+    Gpu::DrawTriangle drawTri2 = {};
+    drawTri2.x1 = poly.x1;
+    drawTri2.y1 = poly.y1;
+    drawTri2.u1 = poly.u1;
+    drawTri2.v1 = poly.v1;
+    drawTri2.x2 = poly.x2;
+    drawTri2.y2 = poly.y2;
+    drawTri2.u2 = poly.u2;
+    drawTri2.v2 = poly.v2;
+    drawTri2.x3 = poly.x3;
+    drawTri2.y3 = poly.y3;
+    drawTri2.u3 = poly.u3;
+    drawTri2.v3 = poly.v3;
+    drawTri2.color = color;
+
+    drawTextured(gpu, drawTri1, bBlendPoly);
+    drawTextured(gpu, drawTri2, bBlendPoly);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw a textured row of Doom floor pixels
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const FLOORROW_FT& row) noexcept {
+    // Set texture page and format, the CLUT to use and masking mode
+    setGpuTexPageId(gpu, row.tpage);
+    setGpuClutId(gpu, row.clut);
+    setGpuMaskingMode(gpu, row.code);
+
+    // Setup the row to be drawn then submit to the GPU
+    Gpu::DrawFloorRow drawRow = {};
+    drawRow.x1 = row.x0;
+    drawRow.x2 = row.x1;
+    drawRow.y = row.y0;
+    drawRow.u1 = row.u0;
+    drawRow.v1 = row.v0;
+    drawRow.u2 = row.u1;
+    drawRow.v2 = row.v1;
+    drawRow.color = getPrimColor(row, 128);     // Note: '128' is '1.0' or full strength color if we don't want to modulate
+
+    drawTextured(gpu, drawRow, (row.code & 0x2));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Handle a command to draw a textured column of Doom wall pixels
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(Gpu::Core& gpu, const WALLCOL_GT& col) noexcept {
+    // Set texture page and format, the CLUT to use and masking mode
+    setGpuTexPageId(gpu, col.tpage);
+    setGpuClutId(gpu, col.clut);
+    setGpuMaskingMode(gpu, col.code);
+
+    // Setup the column to be drawn then submit to the GPU.
+    // Optimization: submit as a flat shaded column unless it has two different colors.
+    const bool bColorCol = ((col.code & 0x1) == 0);
+    const bool bBlendCol = (col.code & 0x2);
+    const bool bColorsDiffer = ((col.r0 != col.r1) || (col.g0 != col.g1) || (col.b0 != col.b1));
+    const bool bIsFlatColored = ((!bColorCol) || (!bColorsDiffer));
+
+    if (bIsFlatColored) {
+        // Usual case in original PSX doom levels: just submit a flat colored textured wall column
+        Gpu::DrawWallCol drawCol = {};
+        drawCol.y1 = col.y0;
+        drawCol.y2 = col.y1;
+        drawCol.x = col.x0;
+        drawCol.u = col.u0;
+        drawCol.v1 = col.v0;
+        drawCol.v2 = col.v1;
+        drawCol.color = getPrimColor(col, 128);     // Note: '128' is '1.0' or full strength color if we don't want to modulate
+
+        drawTextured(gpu, drawCol, bBlendCol);
+    } else {
+        // Wall column is using dual colored lighting: submit as a gouraud shaded wall column
+        Gpu::DrawWallColGouraud drawCol = {};
+        drawCol.y1 = col.y0;
+        drawCol.y2 = col.y1;
+        drawCol.x = col.x0;
+        drawCol.u = col.u0;
+        drawCol.v1 = col.v0;
+        drawCol.v2 = col.v1;
+        drawCol.color1.comp.r = col.r0;
+        drawCol.color1.comp.g = col.g0;
+        drawCol.color1.comp.b = col.b0;
+        drawCol.color2.comp.r = col.r1;
+        drawCol.color2.comp.g = col.g1;
+        drawCol.color2.comp.b = col.b1;
+
+        drawTextured(gpu, drawCol, bBlendCol);
+    }
+}
+
+END_NAMESPACE(LIBGPU_CmdDecode)
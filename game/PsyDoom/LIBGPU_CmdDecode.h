@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Macros.h"
+#include "PsyQ/LIBGPU.h"
+
+#include <cstdint>
+
+namespace Gpu {
+    struct Core;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decodes LIBGPU format drawing commands/primitives and draws them on a given emulated PlayStation 1 GPU core.
+// This is the part of 'LIBGPU_CmdDispatch' which is independent of the game, so that tools (e.g 'GpuReplay') can decode primitives in
+// exactly the same way as the classic renderer does. It has no knowledge of the Vulkan renderer, which is handled by 'LIBGPU_CmdDispatch'.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(LIBGPU_CmdDecode)
+
+// Helpers to set GPU state
+void setGpuTexPageId(Gpu::Core& gpu, const uint16_t texPageId) noexcept;
+void setGpuClutId(Gpu::Core& gpu, const uint16_t clutId) noexcept;
+void setGpuTexWin(Gpu::Core& gpu, const uint32_t texWin) noexcept;
+void setGpuMaskingMode(Gpu::Core& gpu, const uint8_t primCode) noexcept;
+
+// Primitive submission
+void submit(Gpu::Core& gpu, const DR_MODE& drawMode) noexcept;
+void submit(Gpu::Core& gpu, const DR_TWIN& texWin) noexcept;
+void submit(Gpu::Core& gpu, const SPRT& sprite) noexcept;
+void submit(Gpu::Core& gpu, const LINE_F2& line) noexcept;
+void submit(Gpu::Core& gpu, const POLY_FT3& poly) noexcept;
+void submit(Gpu::Core& gpu, const POLY_F4& poly) noexcept;
+void submit(Gpu::Core& gpu, const POLY_FT4& poly) noexcept;
+void submit(Gpu::Core& gpu, const FLOORROW_FT& row) noexcept;
+void submit(Gpu::Core& gpu, const WALLCOL_GT& col) noexcept;
+
+END_NAMESPACE(LIBGPU_CmdDecode)
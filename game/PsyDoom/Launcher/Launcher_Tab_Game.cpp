@@ -474,7 +474,7 @@ static void makeDefaultCueFileSelector(Tab_Game& tab, const int lx, const int rx
             Tab_Game& tab = *(Tab_Game*) pUserData;
 
             const auto pFileChooser = std::make_unique<Fl_Native_File_Chooser>();
-            pFileChooser->filter("CUE Sheet Files\t*.{cue}");
+            pFileChooser->filter("CUE Sheet Files\t*.{cue}\nCompressed Disc Images\t*.{pdz}");
             pFileChooser->type(Fl_Native_File_Chooser::BROWSE_FILE);
             pFileChooser->title("Choose a default game disc .cue file");
 
@@ -170,7 +170,7 @@ static void makeCueFileSelector(Tab_Launcher& tab, const int lx, const int rx, c
             Tab_Launcher& tab = *(Tab_Launcher*) pUserData;
 
             const auto pFileChooser = std::make_unique<Fl_Native_File_Chooser>();
-            pFileChooser->filter("CUE Sheet Files\t*.{cue}");
+            pFileChooser->filter("CUE Sheet Files\t*.{cue}\nCompressed Disc Images\t*.{pdz}");
             pFileChooser->type(Fl_Native_File_Chooser::BROWSE_FILE);
             pFileChooser->title("Choose a game disc .cue file");
 
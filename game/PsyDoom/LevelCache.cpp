@@ -0,0 +1,573 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Saves and loads the level geometry built by 'P_SetupLevel' to and from cache files.
+// See the header for more details.
+//
+// File format (native endian, since the file is only ever used by the same build of PsyDoom on the same machine):
+//  (1) A 'FileHeader'.
+//  (2) The arrays of level data in the order listed by 'LevelData', each starting on an 8 byte boundary.
+//      Runtime structs are stored exactly as they are in memory except for pointers, which are stored as an index into the array
+//      they point to plus '1'. A value of '0' is a null pointer. Render-only fields are zeroed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "LevelCache.h"
+
+#include "Config/Config.h"
+#include "Doom/Base/z_zone.h"
+#include "Doom/Base/w_wad.h"
+#include "Doom/d_main.h"
+#include "Doom/Game/g_game.h"
+#include "Doom/Game/p_setup.h"
+#include "Doom/Renderer/r_data.h"
+#include "Doom/Renderer/r_local.h"
+#include "FileUtils.h"
+#include "ProgArgs.h"
+#include "Utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <md5.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+BEGIN_NAMESPACE(LevelCache)
+
+static constexpr char       FILE_MAGIC[8] = { 'P', 'S', 'Y', 'L', 'V', 'L', 'C', 0 };
+static constexpr uint32_t   FILE_VERSION = 1;
+static constexpr uint32_t   ENDIAN_CHECK = 0x01020304;
+
+// Header at the start of a level cache file
+struct FileHeader {
+    char        magic[8];               // Should equal 'FILE_MAGIC'
+    uint32_t    version;                // Should equal 'FILE_VERSION'
+    uint32_t    endianCheck;            // Should equal 'ENDIAN_CHECK'
+    char        gameVersion[16];        // Version of PsyDoom which wrote the file
+    uint64_t    mapHashWord1;           // Map hash of the geometry lumps
+    uint64_t    mapHashWord2;
+    uint64_t    texNamesHashWord1;      // Hash of the wall and flat texture names at the time the file was written
+    uint64_t    texNamesHashWord2;
+    uint8_t     bLimitRemoving;         // Whether the file was written by a limit removing build
+    uint8_t     bFinalDoomMap;          // Whether the map is in Final Doom format
+    uint8_t     pad[2];
+    uint16_t    structSizes[8];         // Sizes of the runtime structs saved, to catch layout changes
+    int32_t     blockmapLumpSize;       // Size of each of the arrays which follow (element counts, or bytes for the blockmap and reject map)
+    int32_t     numVertexes;
+    int32_t     numSectors;
+    int32_t     numSides;
+    int32_t     numLines;
+    int32_t     numSubsectors;
+    int32_t     numBspNodes;
+    int32_t     numSegs;
+    int32_t     numLeafEdges;
+    int32_t     rejectMapSize;
+    int32_t     numLineRefs;
+    int32_t     skyTexIdx;              // Index of the sky texture or '-1' if none
+    char        startupWarning[64];     // Level startup warning issued while building the geometry
+};
+
+// Pointers to all of the level data arrays and their sizes
+struct LevelData {
+    uint16_t*       pBlockmapLump;
+    int32_t         blockmapLumpSize;
+    vertex_t*       pVertexes;
+    int32_t         numVertexes;
+    sector_t*       pSectors;
+    int32_t         numSectors;
+    side_t*         pSides;
+    int32_t         numSides;
+    line_t*         pLines;
+    int32_t         numLines;
+    subsector_t*    pSubsectors;
+    int32_t         numSubsectors;
+    node_t*         pBspNodes;
+    int32_t         numBspNodes;
+    seg_t*          pSegs;
+    int32_t         numSegs;
+    leafedge_t*     pLeafEdges;
+    int32_t         numLeafEdges;
+    uint8_t*        pRejectMatrix;
+    int32_t         rejectMapSize;
+    line_t**        pLineRefs;
+    int32_t         numLineRefs;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the path to the cache file for the specified map hash
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::string getCacheFilePath(const uint64_t mapHashWord1, const uint64_t mapHashWord2) noexcept {
+    const std::string userDataFolder = Utils::getOrCreateUserDataFolder();
+    char fileName[64];
+    std::snprintf(fileName, C_ARRAY_SIZE(fileName), "LEVELCACHE_%016llX%016llX.BIN", (unsigned long long) mapHashWord1, (unsigned long long) mapHashWord2);
+    return userDataFolder + fileName;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Hashes the names of all wall and flat textures.
+// Sectors and sides store texture indexes which are resolved by name, so cached data is only valid for the same set of textures.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getTexNamesHash(uint64_t& hashWord1, uint64_t& hashWord2) noexcept {
+    MD5 md5Hasher;
+    md5Hasher.add(&gNumTexLumps, sizeof(gNumTexLumps));
+    md5Hasher.add(&gNumFlatLumps, sizeof(gNumFlatLumps));
+
+    const auto addTexNames = [&](const texture_t* const pTextures, const int32_t numTextures) noexcept {
+        for (int32_t texIdx = 0; texIdx < numTextures; ++texIdx) {
+            const uint64_t lumpName = W_GetLumpName(pTextures[texIdx].lumpNum).word() & WAD_LUMPNAME_MASK;
+            md5Hasher.add(&lumpName, sizeof(lumpName));
+        }
+    };
+
+    addTexNames(gpTextures, gNumTexLumps);
+    addTexNames(gpFlatTextures, gNumFlatLumps);
+
+    uint8_t md5[16] = {};
+    md5Hasher.getHash(md5);
+    std::memcpy(&hashWord1, md5, sizeof(uint64_t));
+    std::memcpy(&hashWord2, md5 + sizeof(uint64_t), sizeof(uint64_t));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes a file header for the current build, level and set of textures. The array sizes are left zeroed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static FileHeader makeFileHeader(const LevelInfo& info) noexcept {
+    FileHeader hdr = {};
+    std::memcpy(hdr.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    hdr.version = FILE_VERSION;
+    hdr.endianCheck = ENDIAN_CHECK;
+    #ifdef GAME_VERSION_STR
+        std::snprintf(hdr.gameVersion, C_ARRAY_SIZE(hdr.gameVersion), "%s", GAME_VERSION_STR);
+    #endif
+
+    hdr.mapHashWord1 = info.mapHashWord1;
+    hdr.mapHashWord2 = info.mapHashWord2;
+    getTexNamesHash(hdr.texNamesHashWord1, hdr.texNamesHashWord2);
+    hdr.bLimitRemoving = (PSYDOOM_LIMIT_REMOVING) ? 1 : 0;
+    hdr.bFinalDoomMap = (info.bFinalDoomMap) ? 1 : 0;
+    hdr.structSizes[0] = (uint16_t) sizeof(vertex_t);
+    hdr.structSizes[1] = (uint16_t) sizeof(sector_t);
+    hdr.structSizes[2] = (uint16_t) sizeof(side_t);
+    hdr.structSizes[3] = (uint16_t) sizeof(line_t);
+    hdr.structSizes[4] = (uint16_t) sizeof(subsector_t);
+    hdr.structSizes[5] = (uint16_t) sizeof(node_t);
+    hdr.structSizes[6] = (uint16_t) sizeof(seg_t);
+    hdr.structSizes[7] = (uint16_t) sizeof(leafedge_t);
+    return hdr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if a cache file header matches the one expected for the current build, level and set of textures (ignoring array sizes)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool isFileHeaderCompatible(const FileHeader& hdr, const FileHeader& expectedHdr) noexcept {
+    return (
+        (std::memcmp(hdr.magic, expectedHdr.magic, sizeof(hdr.magic)) == 0) &&
+        (hdr.version == expectedHdr.version) &&
+        (hdr.endianCheck == expectedHdr.endianCheck) &&
+        (std::memcmp(hdr.gameVersion, expectedHdr.gameVersion, sizeof(hdr.gameVersion)) == 0) &&
+        (hdr.mapHashWord1 == expectedHdr.mapHashWord1) &&
+        (hdr.mapHashWord2 == expectedHdr.mapHashWord2) &&
+        (hdr.texNamesHashWord1 == expectedHdr.texNamesHashWord1) &&
+        (hdr.texNamesHashWord2 == expectedHdr.texNamesHashWord2) &&
+        (hdr.bLimitRemoving == expectedHdr.bLimitRemoving) &&
+        (hdr.bFinalDoomMap == expectedHdr.bFinalDoomMap) &&
+        (std::memcmp(hdr.structSizes, expectedHdr.structSizes, sizeof(hdr.structSizes)) == 0)
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Copies the array sizes in the given level data to a file header or vice versa
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void setFileHeaderArraySizes(FileHeader& hdr, const LevelData& data) noexcept {
+    hdr.blockmapLumpSize = data.blockmapLumpSize;
+    hdr.numVertexes = data.numVertexes;
+    hdr.numSectors = data.numSectors;
+    hdr.numSides = data.numSides;
+    hdr.numLines = data.numLines;
+    hdr.numSubsectors = data.numSubsectors;
+    hdr.numBspNodes = data.numBspNodes;
+    hdr.numSegs = data.numSegs;
+    hdr.numLeafEdges = data.numLeafEdges;
+    hdr.rejectMapSize = data.rejectMapSize;
+    hdr.numLineRefs = data.numLineRefs;
+}
+
+static void setLevelDataArraySizes(LevelData& data, const FileHeader& hdr) noexcept {
+    data.blockmapLumpSize = hdr.blockmapLumpSize;
+    data.numVertexes = hdr.numVertexes;
+    data.numSectors = hdr.numSectors;
+    data.numSides = hdr.numSides;
+    data.numLines = hdr.numLines;
+    data.numSubsectors = hdr.numSubsectors;
+    data.numBspNodes = hdr.numBspNodes;
+    data.numSegs = hdr.numSegs;
+    data.numLeafEdges = hdr.numLeafEdges;
+    data.rejectMapSize = hdr.rejectMapSize;
+    data.numLineRefs = hdr.numLineRefs;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the level data for the currently loaded level.
+// All sector line lists are allocated together by 'P_GroupLines', so the first sector's list is the start of the line references array.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static LevelData getCurrentLevelData(const LevelInfo& info) noexcept {
+    LevelData data = {};
+    data.pBlockmapLump = gpBlockmapLump;
+    data.blockmapLumpSize = info.blockmapLumpSize;
+    data.pVertexes = gpVertexes;
+    data.numVertexes = gNumVertexes;
+    data.pSectors = gpSectors;
+    data.numSectors = gNumSectors;
+    data.pSides = gpSides;
+    data.numSides = gNumSides;
+    data.pLines = gpLines;
+    data.numLines = gNumLines;
+    data.pSubsectors = gpSubsectors;
+    data.numSubsectors = gNumSubsectors;
+    data.pBspNodes = gpBspNodes;
+    data.numBspNodes = gNumBspNodes;
+    data.pSegs = gpSegs;
+    data.numSegs = gNumSegs;
+    data.pLeafEdges = gpLeafEdges;
+    data.numLeafEdges = gTotalNumLeafEdges;
+    data.pRejectMatrix = gpRejectMatrix;
+    data.rejectMapSize = info.rejectMapSize;
+    data.pLineRefs = (gNumSectors > 0) ? gpSectors[0].lines : nullptr;
+
+    for (int32_t secIdx = 0; secIdx < gNumSectors; ++secIdx) {
+        data.numLineRefs += gpSectors[secIdx].linecount;
+    }
+
+    return data;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Figures out where each array is located in a cache file with the given array sizes and returns the total size of the file.
+// If file data is given then the level data is pointed to the arrays within it, otherwise just the size is computed.
+// Returns '0' if the array sizes are invalid.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static size_t layoutFile(const FileHeader& hdr, std::byte* const pFileData, LevelData& data) noexcept {
+    setLevelDataArraySizes(data, hdr);
+    size_t offset = sizeof(FileHeader);
+    bool bValidSizes = true;
+
+    const auto addArray = [&](auto*& pArray, const int32_t count) noexcept {
+        typedef std::remove_reference_t<decltype(*pArray)> elem_t;
+        bValidSizes &= (count >= 0);
+        offset = (offset + 7) & ~(size_t) 7;
+
+        if (pFileData) {
+            pArray = (elem_t*)(pFileData + offset);
+        }
+
+        offset += (size_t) std::max(count, 0) * sizeof(elem_t);
+    };
+
+    addArray(data.pBlockmapLump, (data.blockmapLumpSize + 1) / 2);
+    addArray(data.pVertexes, data.numVertexes);
+    addArray(data.pSectors, data.numSectors);
+    addArray(data.pSides, data.numSides);
+    addArray(data.pLines, data.numLines);
+    addArray(data.pSubsectors, data.numSubsectors);
+    addArray(data.pBspNodes, data.numBspNodes);
+    addArray(data.pSegs, data.numSegs);
+    addArray(data.pLeafEdges, data.numLeafEdges);
+    addArray(data.pRejectMatrix, data.rejectMapSize);
+    addArray(data.pLineRefs, data.numLineRefs);
+
+    // The blockmap must at least have it's header
+    bValidSizes &= (data.blockmapLumpSize >= 8);
+    return (bValidSizes) ? offset : 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Calls the given function for every pointer in the level data which references another array in the level data.
+// The function is given the pointer field as well as the members of 'LevelData' for the array pointed to and it's size.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class Func>
+static void forEachPointer(LevelData& data, const Func& func) noexcept {
+    for (int32_t i = 0; i < data.numSectors; ++i) {
+        sector_t& sec = data.pSectors[i];
+        func(sec.soundorg.subsector, &LevelData::pSubsectors, &LevelData::numSubsectors);
+        func(sec.lines, &LevelData::pLineRefs, &LevelData::numLineRefs);
+    }
+
+    for (int32_t i = 0; i < data.numSides; ++i) {
+        func(data.pSides[i].sector, &LevelData::pSectors, &LevelData::numSectors);
+    }
+
+    for (int32_t i = 0; i < data.numLines; ++i) {
+        line_t& line = data.pLines[i];
+        func(line.vertex1, &LevelData::pVertexes, &LevelData::numVertexes);
+        func(line.vertex2, &LevelData::pVertexes, &LevelData::numVertexes);
+        func(line.frontsector, &LevelData::pSectors, &LevelData::numSectors);
+        func(line.backsector, &LevelData::pSectors, &LevelData::numSectors);
+    }
+
+    for (int32_t i = 0; i < data.numSubsectors; ++i) {
+        func(data.pSubsectors[i].sector, &LevelData::pSectors, &LevelData::numSectors);
+    }
+
+    for (int32_t i = 0; i < data.numSegs; ++i) {
+        seg_t& seg = data.pSegs[i];
+        func(seg.vertex1, &LevelData::pVertexes, &LevelData::numVertexes);
+        func(seg.vertex2, &LevelData::pVertexes, &LevelData::numVertexes);
+        func(seg.sidedef, &LevelData::pSides, &LevelData::numSides);
+        func(seg.linedef, &LevelData::pLines, &LevelData::numLines);
+        func(seg.frontsector, &LevelData::pSectors, &LevelData::numSectors);
+        func(seg.backsector, &LevelData::pSectors, &LevelData::numSectors);
+    }
+
+    for (int32_t i = 0; i < data.numLeafEdges; ++i) {
+        leafedge_t& edge = data.pLeafEdges[i];
+        func(edge.vertex, &LevelData::pVertexes, &LevelData::numVertexes);
+        func(edge.seg, &LevelData::pSegs, &LevelData::numSegs);
+    }
+
+    for (int32_t i = 0; i < data.numLineRefs; ++i) {
+        func(data.pLineRefs[i], &LevelData::pLines, &LevelData::numLines);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Serializes the currently loaded level to the cache file format
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::vector<std::byte> serializeLevel(const LevelInfo& info) noexcept {
+    // Figure out the file layout and copy in the header and all the arrays
+    LevelData srcData = getCurrentLevelData(info);
+    FileHeader hdr = makeFileHeader(info);
+    setFileHeaderArraySizes(hdr, srcData);
+    hdr.skyTexIdx = (gpSkyTexture) ? (int32_t)(gpSkyTexture - gpTextures) : -1;
+    std::memcpy(hdr.startupWarning, info.startupWarning, sizeof(hdr.startupWarning));
+
+    LevelData dstData = {};
+    std::vector<std::byte> fileData(layoutFile(hdr, nullptr, dstData));
+
+    if (fileData.empty())
+        return fileData;
+
+    layoutFile(hdr, fileData.data(), dstData);
+    std::memcpy(fileData.data(), &hdr, sizeof(FileHeader));
+
+    const auto copyArray = [](auto* const pDst, const auto* const pSrc, const int32_t count) noexcept {
+        if (count > 0) {
+            std::memcpy(pDst, pSrc, (size_t) count * sizeof(*pSrc));
+        }
+    };
+
+    std::memcpy(dstData.pBlockmapLump, srcData.pBlockmapLump, (size_t) srcData.blockmapLumpSize);
+    copyArray(dstData.pVertexes, srcData.pVertexes, srcData.numVertexes);
+    copyArray(dstData.pSectors, srcData.pSectors, srcData.numSectors);
+    copyArray(dstData.pSides, srcData.pSides, srcData.numSides);
+    copyArray(dstData.pLines, srcData.pLines, srcData.numLines);
+    copyArray(dstData.pSubsectors, srcData.pSubsectors, srcData.numSubsectors);
+    copyArray(dstData.pBspNodes, srcData.pBspNodes, srcData.numBspNodes);
+    copyArray(dstData.pSegs, srcData.pSegs, srcData.numSegs);
+    copyArray(dstData.pLeafEdges, srcData.pLeafEdges, srcData.numLeafEdges);
+    copyArray(dstData.pRejectMatrix, srcData.pRejectMatrix, srcData.rejectMapSize);
+    copyArray(dstData.pLineRefs, srcData.pLineRefs, srcData.numLineRefs);
+
+    // Convert pointers to array indexes
+    forEachPointer(dstData, [&](auto*& ptr, auto pArrayMember, [[maybe_unused]] int32_t LevelData::* pCountMember) noexcept {
+        typedef std::remove_reference_t<decltype(*ptr)> elem_t;
+        ptr = (ptr) ? (elem_t*)(uintptr_t)(ptr - srcData.*pArrayMember + 1) : nullptr;
+    });
+
+    // Zero fields which are only used by the renderer or which reference map objects and thinkers (these are all null at this point anyway).
+    // The sound origin was assigned on the current game tick, so don't save that tick either - it's restored on loading.
+    for (int32_t i = 0; i < dstData.numVertexes; ++i) {
+        vertex_t& vert = dstData.pVertexes[i];
+        vert.scale = 0;
+        vert.viewx = 0;
+        vert.viewy = 0;
+        vert.screenx = 0;
+        vert.frameUpdated = 0;
+    }
+
+    for (int32_t i = 0; i < dstData.numSectors; ++i) {
+        sector_t& sec = dstData.pSectors[i];
+        sec.soundtarget = nullptr;
+        sec.thinglist = nullptr;
+        sec.specialdata = nullptr;
+        sec.soundorg.x.oldGameTic = 0;
+        sec.soundorg.y.oldGameTic = 0;
+        sec.soundorg.z.oldGameTic = 0;
+    }
+
+    for (int32_t i = 0; i < dstData.numLines; ++i) {
+        dstData.pLines[i].specialdata = nullptr;
+    }
+
+    return fileData;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the level cache is enabled
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isEnabled() noexcept {
+    return (Config::gbUseLevelCache || ProgArgs::gbVerifyLevelCache);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tries to load the cache file for the specified level into the zone heap and set up all the map data globals.
+// Returns 'false' if there is no valid cache file for the level, in which case nothing is loaded.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool load(LevelInfo& info) noexcept {
+    // Read the file and verify it is for this level and build, and that the layout matches the header
+    const std::string filePath = getCacheFilePath(info.mapHashWord1, info.mapHashWord2);
+    const FileData fileData = FileUtils::getContentsOfFile(filePath.c_str());
+
+    if ((!fileData.bytes) || (fileData.size < sizeof(FileHeader)))
+        return false;
+
+    FileHeader hdr;
+    std::memcpy(&hdr, fileData.bytes.get(), sizeof(FileHeader));
+
+    if (!isFileHeaderCompatible(hdr, makeFileHeader(info)))
+        return false;
+
+    LevelData srcData = {};
+
+    if (layoutFile(hdr, fileData.bytes.get(), srcData) != fileData.size) {
+        std::printf("Level cache: ignoring invalid cache file '%s'!\n", filePath.c_str());
+        return false;
+    }
+
+    // Verify all pointers are in range for the arrays they reference.
+    // Pointers one past the end of an array are allowed, since the line lists of sectors with no lines may point to the end of the list.
+    bool bValidPointers = (hdr.skyTexIdx >= -1) && (hdr.skyTexIdx < gNumTexLumps);
+
+    forEachPointer(srcData, [&](auto*& ptr, [[maybe_unused]] auto pArrayMember, int32_t LevelData::* pCountMember) noexcept {
+        const uintptr_t idxPlus1 = (uintptr_t) ptr;
+        bValidPointers &= (idxPlus1 <= (uintptr_t)(srcData.*pCountMember) + 1);
+    });
+
+    if (!bValidPointers) {
+        std::printf("Level cache: ignoring invalid cache file '%s'!\n", filePath.c_str());
+        return false;
+    }
+
+    // Allocate and copy in all of the level data.
+    // Note: the arrays are allocated in the same order as the 'P_Load*' functions allocate them, which keeps the zone heap layout similar to
+    // normal loading. It is not guaranteed to be identical however, since nothing else that normal loading does with the heap is replicated.
+    const auto allocAndCopy = [](const auto* const pSrc, const int32_t count) noexcept {
+        typedef std::remove_const_t<std::remove_reference_t<decltype(*pSrc)>> elem_t;
+        elem_t* const pDst = (elem_t*) Z_Malloc(*gpMainMemZone, count * (int32_t) sizeof(elem_t), PU_LEVEL, nullptr);
+
+        if (count > 0) {
+            std::memcpy(pDst, pSrc, (size_t) count * sizeof(elem_t));
+        }
+
+        return pDst;
+    };
+
+    gpBlockmapLump = (uint16_t*) Z_Malloc(*gpMainMemZone, hdr.blockmapLumpSize, PU_LEVEL, nullptr);
+    std::memcpy(gpBlockmapLump, srcData.pBlockmapLump, (size_t) hdr.blockmapLumpSize);
+    gpBlockmap = gpBlockmapLump + 4;
+    gBlockmapOriginX = d_int_to_fixed((int16_t) gpBlockmapLump[0]);
+    gBlockmapOriginY = d_int_to_fixed((int16_t) gpBlockmapLump[1]);
+    gBlockmapWidth = (int16_t) gpBlockmapLump[2];
+    gBlockmapHeight = (int16_t) gpBlockmapLump[3];
+
+    const int32_t blockLinksSize = gBlockmapWidth * gBlockmapHeight * (int32_t) sizeof(gppBlockLinks[0]);
+    gppBlockLinks = (mobj_t**) Z_Malloc(*gpMainMemZone, blockLinksSize, PU_LEVEL, nullptr);
+    D_memset(gppBlockLinks, std::byte(0), blockLinksSize);
+
+    gNumVertexes = hdr.numVertexes;
+    gpVertexes = allocAndCopy(srcData.pVertexes, gNumVertexes);
+    gNumSectors = hdr.numSectors;
+    gpSectors = allocAndCopy(srcData.pSectors, gNumSectors);
+    gNumSides = hdr.numSides;
+    gpSides = allocAndCopy(srcData.pSides, gNumSides);
+    gNumLines = hdr.numLines;
+    gpLines = allocAndCopy(srcData.pLines, gNumLines);
+    gNumSubsectors = hdr.numSubsectors;
+    gpSubsectors = allocAndCopy(srcData.pSubsectors, gNumSubsectors);
+    gNumBspNodes = hdr.numBspNodes;
+    gpBspNodes = allocAndCopy(srcData.pBspNodes, gNumBspNodes);
+    gNumSegs = hdr.numSegs;
+    gpSegs = allocAndCopy(srcData.pSegs, gNumSegs);
+    gTotalNumLeafEdges = hdr.numLeafEdges;
+    gpLeafEdges = allocAndCopy(srcData.pLeafEdges, gTotalNumLeafEdges);
+    gpRejectMatrix = allocAndCopy(srcData.pRejectMatrix, hdr.rejectMapSize);
+    line_t** const pLineRefs = allocAndCopy(srcData.pLineRefs, hdr.numLineRefs);
+
+    // Convert array indexes back to pointers
+    LevelData dstData = getCurrentLevelData(info);
+    dstData.pLineRefs = pLineRefs;
+    dstData.numLineRefs = hdr.numLineRefs;
+
+    forEachPointer(dstData, [&](auto*& ptr, auto pArrayMember, [[maybe_unused]] int32_t LevelData::* pCountMember) noexcept {
+        ptr = (ptr) ? dstData.*pArrayMember + ((uintptr_t) ptr - 1) : nullptr;
+    });
+
+    // Sector sound origins are assigned on the current game tick during normal loading
+    for (int32_t i = 0; i < gNumSectors; ++i) {
+        degenmobj_t& soundorg = gpSectors[i].soundorg;
+        soundorg.x.oldGameTic = gGameTic;
+        soundorg.y.oldGameTic = gGameTic;
+
+        #if PSYDOOM_FIX_UB
+            soundorg.z.oldGameTic = gGameTic;
+        #endif
+    }
+
+    // Restore everything else and save the lump sizes
+    gpSkyTexture = (hdr.skyTexIdx >= 0) ? &gpTextures[hdr.skyTexIdx] : nullptr;
+    info.blockmapLumpSize = hdr.blockmapLumpSize;
+    info.rejectMapSize = hdr.rejectMapSize;
+    std::memcpy(info.startupWarning, hdr.startupWarning, sizeof(info.startupWarning));
+    info.startupWarning[C_ARRAY_SIZE(info.startupWarning) - 1] = 0;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Saves the currently loaded level geometry to a cache file.
+// Should be called after 'P_GroupLines' and before any map things are spawned.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void save(const LevelInfo& info) noexcept {
+    const std::vector<std::byte> fileData = serializeLevel(info);
+    const std::string filePath = getCacheFilePath(info.mapHashWord1, info.mapHashWord2);
+
+    if (fileData.empty() || (!FileUtils::writeDataToFile(filePath.c_str(), fileData.data(), fileData.size()))) {
+        std::printf("Level cache: failed to write cache file '%s'!\n", filePath.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Checks that the currently loaded level geometry (built the normal way) is identical to what is saved in the level's cache file.
+// If there is no valid cache file for the level then one is saved, otherwise the result of the comparison is printed and returned.
+// Should be called at the same point as 'save'.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool verify(const LevelInfo& info) noexcept {
+    const std::vector<std::byte> levelData = serializeLevel(info);
+    const std::string filePath = getCacheFilePath(info.mapHashWord1, info.mapHashWord2);
+    const FileData fileData = FileUtils::getContentsOfFile(filePath.c_str());
+
+    const bool bHaveValidCacheFile = (
+        fileData.bytes &&
+        (fileData.size >= sizeof(FileHeader)) &&
+        isFileHeaderCompatible(*(const FileHeader*) fileData.bytes.get(), makeFileHeader(info))
+    );
+
+    if (!bHaveValidCacheFile) {
+        save(info);
+        std::printf("Level cache: no valid cache file to verify against, saved '%s'\n", filePath.c_str());
+        return true;
+    }
+
+    // Note: the arrays are compared byte for byte, including any struct padding and the unused byte after an odd sized blockmap.
+    // This works because 'P_SetupLevel' zero initializes all of the level arrays it saves before building them, and because serialization
+    // starts with a zeroed buffer and only copies the blockmap's actual bytes. Loading from the cache copies the saved bytes verbatim.
+    const bool bMatches = (
+        (levelData.size() == fileData.size) &&
+        (std::memcmp(levelData.data(), fileData.bytes.get(), fileData.size) == 0)
+    );
+
+    if (bMatches) {
+        std::printf("Level cache: verified '%s' matches the level as built normally\n", filePath.c_str());
+    } else {
+        std::printf("Level cache: MISMATCH between '%s' and the level as built normally!\n", filePath.c_str());
+    }
+
+    return bMatches;
+}
+
+END_NAMESPACE(LevelCache)
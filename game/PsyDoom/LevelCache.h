@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// An optional on-disk cache of the level geometry built by 'P_SetupLevel'. It holds the vertexes, sectors, sides, lines, subsectors,
+// nodes, segs, leaf edges, blockmap, reject map and the sector line lists built by 'P_GroupLines'. It is saved in a relocatable format where
+// pointers are stored as array indexes, and these are fixed up when the data is loaded back into the zone heap.
+//
+// Cache files are keyed by the map hash of the geometry lumps and also record the version of PsyDoom, the layout of the runtime structs and
+// a hash of the wall and flat texture names (since sectors and sides reference textures by index). If any of those don't match the cache
+// file is ignored and rebuilt. Map things are not cached and are always spawned from the map's 'THINGS' lump.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(LevelCache)
+
+// Details about the level being cached which are not kept in the map data globals
+struct LevelInfo {
+    uint64_t    mapHashWord1;           // Map hash of the geometry lumps: identifies the cache file
+    uint64_t    mapHashWord2;
+    bool        bFinalDoomMap;          // Whether the map is in Final Doom format (affects how textures are resolved)
+    int32_t     blockmapLumpSize;       // Size of the 'BLOCKMAP' lump in bytes: set when a cache file is loaded
+    int32_t     rejectMapSize;          // Size of the 'REJECT' lump in bytes: set when a cache file is loaded
+    char        startupWarning[64];     // Any level startup warning issued while building the geometry: set when a cache file is loaded
+};
+
+bool isEnabled() noexcept;
+bool load(LevelInfo& info) noexcept;
+void save(const LevelInfo& info) noexcept;
+bool verify(const LevelInfo& info) noexcept;
+
+END_NAMESPACE(LevelCache)
@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A pipeline which reads and decompresses map lumps in the background while the main thread parses them.
+// See the header for more details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "MapLumpPipeline.h"
+
+#include "Asserts.h"
+#include "Doom/Base/i_main.h"
+#include "ProgArgs.h"
+#include "WadFile.h"
+#include "WadUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+BEGIN_NAMESPACE(MapLumpPipeline)
+
+typedef std::chrono::steady_clock::time_point timepoint_t;
+
+// Holds the state and timings for one lump going through the pipeline
+struct PipelineLump {
+    int32_t                 lumpIdx;                // Index of the lump in the map WAD
+    char                    name[MAX_WAD_LUMPNAME + 1];
+    bool                    bCompressed;            // Whether the lump is stored compressed in the WAD
+    bool                    bReady;                 // Set once the lump is read and decompressed (if required), guarded by 'gMutex'
+    bool                    bCorrupt;               // Set if the compressed lump data turned out to be corrupt
+    int32_t                 storedSize;             // Size of the lump as stored in the WAD
+    int32_t                 uncompressedSize;       // Size of the lump after decompression
+    std::vector<std::byte>  storedData;             // The lump data as stored in the WAD
+    std::vector<std::byte>  decompressedData;       // The decompressed lump data, if the lump is compressed
+    double                  readTime;               // I/O thread: time spent reading the lump
+    double                  decompressTime;         // Worker thread: time spent decompressing the lump
+    double                  waitTime;               // Main thread: time spent blocked waiting for the lump to become ready
+    double                  parseTime;              // Main thread: time spent after the lump was handed out until the next pipeline lump was requested
+};
+
+static bool                         gbRunning;              // Is the pipeline currently running?
+static std::vector<PipelineLump>    gLumps;                 // All lumps in the pipeline, in the order they are read: not resized while running
+static std::thread                  gIoThread;              // Reads the lumps one after the other
+static std::vector<std::thread>     gDecompressThreads;     // Decompression workers: only touched by the I/O thread until it is joined
+static std::mutex                   gMutex;                 // Guards the 'bReady' flag of all lumps
+static std::condition_variable      gLumpReadyCond;         // Signalled whenever a lump becomes ready
+static timepoint_t                  gStartTime;             // When the pipeline was started
+static PipelineLump*                gpLastHandedOutLump;    // The last lump handed out to the main thread and when, for measuring parse time
+static timepoint_t                  gLastHandOutTime;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the time in seconds since the specified time point
+//------------------------------------------------------------------------------------------------------------------------------------------
+static double getSecondsSince(const timepoint_t startTime) noexcept {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Marks the specified lump as ready for the main thread to consume
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void markLumpReady(PipelineLump& lump) noexcept {
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        lump.bReady = true;
+    }
+
+    gLumpReadyCond.notify_all();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Worker thread: decompresses the specified lump
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void decompressThreadMain(PipelineLump* const pLump) noexcept {
+    PipelineLump& lump = *pLump;
+    const timepoint_t startTime = std::chrono::steady_clock::now();
+
+    lump.decompressedData.resize((size_t) lump.uncompressedSize);
+    lump.bCorrupt = (WadUtils::decompressLumpChecked(lump.storedData.data(), lump.storedSize, lump.decompressedData.data(), lump.uncompressedSize) < 0);
+    lump.decompressTime = getSecondsSince(startTime);
+
+    markLumpReady(lump);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// I/O thread: reads all of the lumps in the pipeline in order, starting decompression for each compressed lump as soon as it is read
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void ioThreadMain(WadFile* const pWadFile) noexcept {
+    for (PipelineLump& lump : gLumps) {
+        const timepoint_t startTime = std::chrono::steady_clock::now();
+        lump.storedData.resize((size_t) lump.storedSize);
+        pWadFile->readLump(lump.lumpIdx, lump.storedData.data(), false);
+        lump.readTime = getSecondsSince(startTime);
+
+        if (lump.bCompressed) {
+            gDecompressThreads.emplace_back(decompressThreadMain, &lump);
+        } else {
+            markLumpReady(lump);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Adds the main thread time since the last lump was handed out to that lump's parse time
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void endLastLumpParse() noexcept {
+    if (gpLastHandedOutLump) {
+        gpLastHandedOutLump->parseTime += getSecondsSince(gLastHandOutTime);
+        gpLastHandedOutLump = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints the timings for each lump in the pipeline as well as totals for each stage
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printTimings(const double totalTime) noexcept {
+    std::printf("Map lump pipeline timings (ms):\n");
+    std::printf("  %-8s  %8s  %8s  %8s  %8s  %8s  %8s\n", "LUMP", "SIZE", "STORED", "READ", "DECOMP", "WAIT", "PARSE");
+
+    double totalReadTime = 0;
+    double totalDecompressTime = 0;
+    double totalWaitTime = 0;
+    double totalParseTime = 0;
+
+    for (const PipelineLump& lump : gLumps) {
+        std::printf(
+            "  %-8s  %8d  %8d  %8.3f  %8.3f  %8.3f  %8.3f\n",
+            lump.name,
+            lump.uncompressedSize,
+            lump.storedSize,
+            lump.readTime * 1000.0,
+            lump.decompressTime * 1000.0,
+            lump.waitTime * 1000.0,
+            lump.parseTime * 1000.0
+        );
+
+        totalReadTime += lump.readTime;
+        totalDecompressTime += lump.decompressTime;
+        totalWaitTime += lump.waitTime;
+        totalParseTime += lump.parseTime;
+    }
+
+    std::printf(
+        "  %-8s  %8s  %8s  %8.3f  %8.3f  %8.3f  %8.3f\n",
+        "TOTAL", "", "",
+        totalReadTime * 1000.0,
+        totalDecompressTime * 1000.0,
+        totalWaitTime * 1000.0,
+        totalParseTime * 1000.0
+    );
+
+    std::printf("  Pipeline ran for %.3f ms with %d decompression workers\n", totalTime * 1000.0, (int32_t) gDecompressThreads.size());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Starts the pipeline for the specified lumps of the given WAD, which are listed in the order the map loaders will read them.
+// Negative lump indexes are ignored, as is the last lump in the WAD (which can't be read, since it's stored size is unknown).
+//------------------------------------------------------------------------------------------------------------------------------------------
+void start(WadFile& wadFile, const int32_t* const pLumpIdxs, const int32_t numLumps) noexcept {
+    // Finish up any previous run first and then setup all the lumps to be read
+    finish();
+    gLumps.reserve((size_t) numLumps);
+
+    for (int32_t i = 0; i < numLumps; ++i) {
+        const int32_t lumpIdx = pLumpIdxs[i];
+
+        if ((!wadFile.isValidLumpIdx(lumpIdx)) || (wadFile.getLumpStoredSize(lumpIdx) < 0))
+            continue;
+
+        PipelineLump& lump = gLumps.emplace_back();
+        lump.lumpIdx = lumpIdx;
+        lump.bCompressed = wadFile.isLumpCompressed(lumpIdx);
+        lump.storedSize = wadFile.getLumpStoredSize(lumpIdx);
+        lump.uncompressedSize = wadFile.getLump(lumpIdx).uncompressedSize;
+
+        const WadLumpName lumpName = wadFile.getLumpName(lumpIdx);
+        std::memcpy(lump.name, lumpName.chars, MAX_WAD_LUMPNAME);
+        lump.name[0] &= 0x7F;
+        lump.name[MAX_WAD_LUMPNAME] = 0;
+    }
+
+    // Kick off the I/O thread
+    gbRunning = true;
+    gStartTime = std::chrono::steady_clock::now();
+    gpLastHandedOutLump = nullptr;
+    gIoThread = std::thread(ioThreadMain, &wadFile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the pipeline is currently running
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isRunning() noexcept {
+    return gbRunning;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the specified map lump into the given buffer from the pipeline, waiting for it to become ready if required.
+// Behaves the same as 'WadFile::readLump' and returns 'true' if the lump is part of the pipeline, otherwise does nothing and returns 'false'.
+// Lumps can be read from the pipeline as many times as needed until it is finished.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool readLump(const int32_t lumpIdx, void* const pDest, const bool bDecompress) noexcept {
+    if (!gbRunning)
+        return false;
+
+    const auto lumpIter = std::find_if(gLumps.begin(), gLumps.end(), [=](const PipelineLump& lump) noexcept { return (lump.lumpIdx == lumpIdx); });
+
+    if (lumpIter == gLumps.end())
+        return false;
+
+    // Wait for the lump to be ready
+    endLastLumpParse();
+    PipelineLump& lump = *lumpIter;
+    const timepoint_t waitStartTime = std::chrono::steady_clock::now();
+
+    {
+        std::unique_lock<std::mutex> lock(gMutex);
+        gLumpReadyCond.wait(lock, [&]() noexcept { return lump.bReady; });
+    }
+
+    lump.waitTime += getSecondsSince(waitStartTime);
+
+    // Copy out the data, exactly the same amount that 'WadFile::readLump' would
+    if (lump.bCompressed && bDecompress) {
+        if (lump.bCorrupt) {
+            I_Error("MapLumpPipeline: lump %d has corrupt compressed data!", lumpIdx);
+        }
+
+        std::memcpy(pDest, lump.decompressedData.data(), lump.decompressedData.size());
+    } else {
+        std::memcpy(pDest, lump.storedData.data(), lump.storedData.size());
+    }
+
+    gpLastHandedOutLump = &lump;
+    gLastHandOutTime = std::chrono::steady_clock::now();
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Waits for the pipeline to finish reading all lumps: after this it is safe to read from the WAD directly again.
+// Lumps may still be decompressing after this returns.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void waitForIo() noexcept {
+    if (gIoThread.joinable()) {
+        gIoThread.join();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Waits for all pipeline threads to finish, prints timings if requested and frees up all memory used by the pipeline
+//------------------------------------------------------------------------------------------------------------------------------------------
+void finish() noexcept {
+    if (!gbRunning)
+        return;
+
+    endLastLumpParse();
+    waitForIo();
+
+    for (std::thread& thread : gDecompressThreads) {
+        thread.join();
+    }
+
+    if (ProgArgs::gbPrintLoadTimings) {
+        printTimings(getSecondsSince(gStartTime));
+    }
+
+    gDecompressThreads.clear();
+    gLumps.clear();
+    gLumps.shrink_to_fit();
+    gbRunning = false;
+}
+
+END_NAMESPACE(MapLumpPipeline)
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+class WadFile;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Overlaps the reading, decompression and parsing of map lumps during level setup.
+// Given a list of lumps in the order the map loaders will need them, a thread reads each lump's data as stored in the WAD one after the other,
+// handing compressed lumps off to worker threads for decompression as soon as they are read. Meanwhile the main thread runs the usual map
+// loaders and 'W_ReadMapLump' copies out each lump as it becomes ready, only blocking if it has not finished reading and decompressing yet.
+//
+// Since the loaders still run in the same order on the main thread, the map hash and all level data are unaffected by this.
+// While the pipeline is running it owns the map WAD's file reader, so lumps that are not part of the pipeline must not be read from the map
+// WAD until 'waitForIo' has been called (this is handled by 'W_ReadMapLump').
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(MapLumpPipeline)
+
+void start(WadFile& wadFile, const int32_t* const pLumpIdxs, const int32_t numLumps) noexcept;
+bool isRunning() noexcept;
+bool readLump(const int32_t lumpIdx, void* const pDest, const bool bDecompress) noexcept;
+void waitForIo() noexcept;
+void finish() noexcept;
+
+END_NAMESPACE(MapLumpPipeline)
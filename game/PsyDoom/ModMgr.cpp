@@ -170,7 +170,7 @@ static bool isValidOverridenFile(const PsxCd_File& file) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Get the path to an overriden file
 //------------------------------------------------------------------------------------------------------------------------------------------
-static std::string getOverridenFilePath(const CdFileId discFile) noexcept {
+std::string getOverridenFilePath(const CdFileId discFile) noexcept {
     std::string filePath;
     filePath.reserve(255);
     filePath = ProgArgs::gDataDirPath;
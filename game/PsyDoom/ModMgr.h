@@ -4,6 +4,8 @@
 #include "Macros.h"
 #include "Wess/psxcd.h"
 
+#include <string>
+
 class WadList;
 
 BEGIN_NAMESPACE(ModMgr)
@@ -14,6 +16,7 @@ void addUserWads(WadList& wadList) noexcept;
 
 // File overrides mechanism
 bool areOverridesAvailableForFile(const CdFileId discFile) noexcept;
+std::string getOverridenFilePath(const CdFileId discFile) noexcept;
 bool isFileOverriden(const PsxCd_File& file) noexcept;
 bool openOverridenFile(const CdFileId discFile, PsxCd_File& fileOut) noexcept;
 void closeOverridenFile(PsxCd_File& file) noexcept;
@@ -1,11 +1,12 @@
 #include "CDXAFileStreamer.h"
 
 #include "Asserts.h"
-#include "FileInputStream.h"
 #include "PsyDoom/DiscInfo.h"
+#include "PsyDoom/DiscReader.h"
 #include "PsyDoom/IsoFileSys.h"
 
 #include <algorithm>
+#include <cstring>
 
 BEGIN_NAMESPACE(movie)
 
@@ -13,12 +14,16 @@ BEGIN_NAMESPACE(movie)
 // Creates a CD-XA file streamer with no open file
 //------------------------------------------------------------------------------------------------------------------------------------------
 CDXAFileStreamer::CDXAFileStreamer() noexcept
-    : mFile()
+    : mDiscReader()
+    , mStartSector(0)
     , mCurSector(0)
     , mEndSector(0)
     , mSectorBuffer()
     , mUsedSectorBufferSlots()
     , mFreeSectorBufferSlots()
+    , mReadAheadBuffer()
+    , mReadAheadIdx(0)
+    , mReadAheadCount(0)
 {
 }
 
@@ -28,7 +33,7 @@ CDXAFileStreamer::~CDXAFileStreamer() noexcept = default;
 // Tells if a file is currently open for streaming
 //------------------------------------------------------------------------------------------------------------------------------------------
 bool CDXAFileStreamer::isOpen() const noexcept {
-    return (mFile != nullptr);
+    return (mDiscReader != nullptr);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -58,16 +63,17 @@ bool CDXAFileStreamer::open(
     if (!bValidDataTrack)
         return false;
 
-    // Try to open the file specified by the track and seek to the correct location for the file.
-    // If it fails then abort the opening process.
-    try {
-        mFile = std::make_unique<FileInputStream>(pTrack->sourceFilePath.c_str());
-        mFile->skipBytes(pTrack->fileOffset + pFsEntry->startLba * sizeof(CDXASector));
-    } catch (...) {
+    // Try to open the data track for reading the file's sectors.
+    // Note: this goes through a disc reader rather than reading the track's file directly so that compressed disc images work too.
+    mDiscReader = std::make_unique<DiscReader>(disc);
+
+    if (!mDiscReader->setTrackNum(1)) {
         close();
         return false;
     }
-    
+
+    mStartSector = pFsEntry->startLba;
+
     // Setup the sector buffer and buffer slot management.
     // Note: some of these fields should already be setup, hence checking these assumptions in debug.
     ASSERT(mCurSector == 0);
@@ -75,6 +81,8 @@ bool CDXAFileStreamer::open(
     ASSERT(mSectorBuffer.empty());
     ASSERT(mUsedSectorBufferSlots.empty());
     ASSERT(mFreeSectorBufferSlots.empty());
+    ASSERT(mReadAheadIdx == 0);
+    ASSERT(mReadAheadCount == 0);
 
     const uint32_t MIN_BUFFER_SIZE = 1u;
     const uint32_t realBufferSize = std::max(bufferSize, MIN_BUFFER_SIZE);  // Don't allow the buffer size to be below this!
@@ -87,6 +95,8 @@ bool CDXAFileStreamer::open(
         mFreeSectorBufferSlots.push_back(i);
     }
 
+    mReadAheadBuffer.resize(READ_AHEAD_SECTORS);
+
     // Figure out how many physical/raw CD sectors the file consumes, rounding up to the nearest whole sector.
     // This is the size of the XA file stream...
     mEndSector = (pFsEntry->size + pTrack->blockPayloadSize - 1) / pTrack->blockPayloadSize;
@@ -97,12 +107,16 @@ bool CDXAFileStreamer::open(
 // Closes up the current file being streamed
 //------------------------------------------------------------------------------------------------------------------------------------------
 void CDXAFileStreamer::close() noexcept {
-    mFile.reset();
+    mDiscReader.reset();
+    mStartSector = 0;
     mCurSector = 0;
     mEndSector = 0;
     mSectorBuffer.clear();
     mUsedSectorBufferSlots.clear();
     mFreeSectorBufferSlots.clear();
+    mReadAheadBuffer.clear();
+    mReadAheadIdx = 0;
+    mReadAheadCount = 0;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -112,24 +126,35 @@ void CDXAFileStreamer::close() noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 const CDXASector* CDXAFileStreamer::readSector() noexcept {
     // Is there a file opened for streaming or is there data ahead?
-    if (!mFile)
+    if (!mDiscReader)
         return nullptr;
 
     // Are we at the end of the stream?
     if (mCurSector >= mEndSector)
         return nullptr;
 
-    // Allocate a sector and then read it's contents from the file
-    CDXASector& sector = allocBufferSector();
+    // If there are no more sectors in the read ahead buffer then read the next run of sectors from the file in one go.
+    // Doing one large read is much cheaper than reading individual sectors, since each read has a fixed overhead.
+    if (mReadAheadIdx >= mReadAheadCount) {
+        const uint32_t numSectorsToRead = std::min(mEndSector - mCurSector, (uint32_t) mReadAheadBuffer.size());
+        const int32_t readOffset = (int32_t)((mStartSector + mCurSector) * sizeof(CDXASector));
+        const int32_t readSize = (int32_t)(numSectorsToRead * sizeof(CDXASector));
 
-    try {
-        mFile->read(sector);
-    } catch (...) {
-        close();
-        return nullptr;
+        if (!mDiscReader->readRaw(readOffset, mReadAheadBuffer.data(), readSize)) {
+            close();
+            return nullptr;
+        }
+
+        mReadAheadIdx = 0;
+        mReadAheadCount = numSectorsToRead;
     }
 
+    // Allocate a sector and then copy in it's contents from the read ahead buffer
+    CDXASector& sector = allocBufferSector();
+    std::memcpy(&sector, &mReadAheadBuffer[mReadAheadIdx], sizeof(CDXASector));
+
     // Success! Mark this sector as read and return its contents:
+    mReadAheadIdx++;
     mCurSector++;
     return &sector;
 }
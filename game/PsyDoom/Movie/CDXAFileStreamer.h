@@ -5,7 +5,7 @@
 #include <memory>
 #include <vector>
 
-class FileInputStream;
+class DiscReader;
 struct DiscInfo;
 struct IsoFileSys;
 
@@ -80,6 +80,9 @@ static_assert(sizeof(CDXASector) == 2352);
 //------------------------------------------------------------------------------------------------------------------------------------------
 class CDXAFileStreamer {
 public:
+    // How many sectors are read from the disc in one go, ahead of when they are needed
+    static constexpr uint32_t READ_AHEAD_SECTORS = 16;
+
     CDXAFileStreamer() noexcept;
     ~CDXAFileStreamer() noexcept;
 
@@ -138,12 +141,16 @@ private:
 
     CDXASector& allocBufferSector() noexcept;
 
-    std::unique_ptr<FileInputStream>    mFile;                      // The file being streamed from
+    std::unique_ptr<DiscReader>         mDiscReader;                // Reads sectors for the file being streamed from the disc
+    uint32_t                            mStartSector;               // Sector on the data track where the file starts
     uint32_t                            mCurSector;                 // Next sector to be read
     uint32_t                            mEndSector;                 // End sector in the file
     std::vector<CDXASector>             mSectorBuffer;              // Buffer of sectors that is potentially sparsely used
     std::vector<uint32_t>               mUsedSectorBufferSlots;     // Which sector buffer slots are in use (in FIFO order)
     std::vector<uint32_t>               mFreeSectorBufferSlots;     // Which sector buffer slots are free
+    std::vector<CDXASector>             mReadAheadBuffer;           // Sectors read from the disc in bulk, which are handed out by 'readSector'
+    uint32_t                            mReadAheadIdx;              // Index of the next sector to hand out from the read ahead buffer
+    uint32_t                            mReadAheadCount;            // How many sectors in the read ahead buffer are valid
 };
 
 END_NAMESPACE(movie)
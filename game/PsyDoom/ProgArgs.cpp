@@ -25,9 +25,14 @@ BEGIN_NAMESPACE(ProgArgs)
 const char* gCueFileOverride;
 
 // If true then run the game without sound or graphics.
-// Can only be used for single demo playback, the main game won't run in this mode;
+// Can only be used for demo playback (single demo or batch), the main game won't run in this mode;
 bool gbHeadlessMode = false;
 
+// If true then run headless demo playback as fast as possible, for benchmarking game logic.
+// Skips input polling, sound updates and frame timing between ticks and prints the simulation rate (in tics per second) for each demo.
+// Implies headless mode.
+bool gbMaxSpeedSim = false;
+
 // The data directory to pull file overrides for the file modding mechanism, empty string when there is none.
 // Any files placed in this directory matching original game file names will override the original game files.
 const char* gDataDirPath = "";
@@ -37,6 +42,13 @@ const char* gSaveDemoResultFilePath = "";       // Path to a json file to save t
 const char* gCheckDemoResultFilePath = "";      // Path to a json file to read the demo result from and verify a match with
 bool        gbRecordDemos;                      // True if the game should record demos for every map played
 
+// Batch demo verification: a json manifest listing pairs of demo files and expected result files to play back and check.
+// The demos are played headless using the given number of worker processes (or the number of hardware threads if '0').
+// Optionally a json report of the results can be written to the given file.
+const char* gDemoBatchFilePath = "";
+const char* gDemoBatchReportFilePath = "";
+uint32_t    gDemoBatchNumJobs = 0;
+
 bool        gbIsNetServer   = false;                // True if this peer is a server in a networked game (player 1, waits for client connection)
 bool        gbIsNetClient   = false;                // True if this peer is a client in a networked game (player 2, connects to waiting server)
 uint16_t    gServerPort     = DEFAULT_NET_PORT;     // Port that the server listens on or that the client connects to
@@ -56,6 +68,38 @@ bool gbTurboMode = false;
 int32_t gWarpMap = 0;
 skill_t gWarpSkill = sk_hard;
 
+// Sound debugging: if true print stats for SPU lock contention and the SPU command queue on exit.
+// If 'gbNoSpuCmdQueue' is set then the game thread locks the SPU and writes to it directly instead of queuing SPU commands for the audio thread.
+bool gbPrintSpuStats = false;
+bool gbNoSpuCmdQueue = false;
+
+// GPU debugging: if a file path is given then record the LIBGPU primitives and VRAM uploads for a range of frames to that file.
+// Recording begins once the given number of frames have been presented. The 'GpuReplay' tool can play back the recording.
+const char* gGpuCaptureFilePath = "";
+uint32_t    gGpuCaptureStartFrame = 0;
+uint32_t    gGpuCaptureNumFrames = 0;
+
+// Level cache debugging: if true then always build levels the normal way and check the result against the level's cache file.
+// The cache file is saved if it does not exist yet. This works regardless of whether the level cache is enabled in the game config.
+bool gbVerifyLevelCache = false;
+
+// Level loading debugging: if true print how long each map lump took to read, decompress and parse when loading a level.
+// Also prints how long it took to create all of the Vulkan pipelines on startup.
+bool gbPrintLoadTimings = false;
+
+// Zone memory debugging: if a file path is given then record all zone allocator calls made by the game to that file.
+// The 'ZoneBench' tool can replay the recording to benchmark and stress test the zone allocator.
+const char* gZoneTraceFilePath = "";
+
+// Sight check debugging: if true then build the sector PVS for each level (regardless of the game config) and print sight check statistics
+// at the end of the level. Sight checks rejected by the PVS are still done in full to verify the PVS and count the BSP traversals avoided.
+bool gbPrintSightStats = false;
+
+// Vulkan renderer debugging: if true then build the geometry for the 3D world every frame during headless demo playback, using the CPU only.
+// The geometry is built once on a single thread and once split into jobs over multiple threads, and the vertices produced are checked for
+// an exact match. The number of frames checked and any mismatches are printed at the end of each level. Only valid in headless mode.
+bool gbCheckVkDrawJobs = false;
+
 // Host that the client connects to: private so we don't expose std::string everywhere
 static std::string gServerHost;
 
@@ -87,6 +131,15 @@ static int parseArg_headless([[maybe_unused]] const int argc, const char* const*
     return 0;
 }
 
+static int parseArg_maxspeed([[maybe_unused]] const int argc, const char* const* const argv) {
+    if (std::strcmp(argv[0], "-maxspeed") == 0) {
+        gbMaxSpeedSim = true;
+        return 1;
+    }
+
+    return 0;
+}
+
 static int parseArg_datadir(const int argc, const char* const* const argv) {
     if ((argc >= 2) && (std::strcmp(argv[0], "-datadir") == 0)) {
         gDataDirPath = argv[1];
@@ -123,6 +176,33 @@ static int parseArg_checkresult(const int argc, const char* const* const argv) {
     return 0;
 }
 
+static int parseArg_demobatch(const int argc, const char* const* const argv) {
+    if ((argc >= 2) && (std::strcmp(argv[0], "-demobatch") == 0)) {
+        gDemoBatchFilePath = argv[1];
+        return 2;
+    }
+
+    return 0;
+}
+
+static int parseArg_demobatchjobs(const int argc, const char* const* const argv) {
+    if ((argc >= 2) && (std::strcmp(argv[0], "-demobatchjobs") == 0)) {
+        gDemoBatchNumJobs = (uint32_t) std::max(std::atoi(argv[1]), 0);
+        return 2;
+    }
+
+    return 0;
+}
+
+static int parseArg_demobatchreport(const int argc, const char* const* const argv) {
+    if ((argc >= 2) && (std::strcmp(argv[0], "-demobatchreport") == 0)) {
+        gDemoBatchReportFilePath = argv[1];
+        return 2;
+    }
+
+    return 0;
+}
+
 static int parseArg_record([[maybe_unused]] const int argc, const char* const* const argv) {
     if (std::strcmp(argv[0], "-record") == 0) {
         gbRecordDemos = true;
@@ -264,14 +344,92 @@ static int parseArg_skill(const int argc, const char* const* const argv) {
     return 0;
 }
 
+static int parseArg_spustats(const int argc, const char* const* const argv) {
+    if ((argc >= 1) && (std::strcmp(argv[0], "-spustats") == 0)) {
+        gbPrintSpuStats = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int parseArg_nospuqueue(const int argc, const char* const* const argv) {
+    if ((argc >= 1) && (std::strcmp(argv[0], "-nospuqueue") == 0)) {
+        gbNoSpuCmdQueue = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int parseArg_gpucapture(const int argc, const char* const* const argv) {
+    if ((argc >= 4) && (std::strcmp(argv[0], "-gpucapture") == 0)) {
+        gGpuCaptureFilePath = argv[1];
+        gGpuCaptureStartFrame = (uint32_t) std::max(std::atoi(argv[2]), 0);
+        gGpuCaptureNumFrames = (uint32_t) std::max(std::atoi(argv[3]), 1);
+        return 4;
+    }
+
+    return 0;
+}
+
+static int parseArg_verifylevelcache([[maybe_unused]] const int argc, const char* const* const argv) {
+    if (std::strcmp(argv[0], "-verifylevelcache") == 0) {
+        gbVerifyLevelCache = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int parseArg_loadtimings([[maybe_unused]] const int argc, const char* const* const argv) {
+    if (std::strcmp(argv[0], "-loadtimings") == 0) {
+        gbPrintLoadTimings = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int parseArg_zonetrace(const int argc, const char* const* const argv) {
+    if ((argc >= 2) && (std::strcmp(argv[0], "-zonetrace") == 0)) {
+        gZoneTraceFilePath = argv[1];
+        return 2;
+    }
+
+    return 0;
+}
+
+static int parseArg_sightstats([[maybe_unused]] const int argc, const char* const* const argv) {
+    if (std::strcmp(argv[0], "-sightstats") == 0) {
+        gbPrintSightStats = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int parseArg_vkdrawcheck([[maybe_unused]] const int argc, const char* const* const argv) {
+    if (std::strcmp(argv[0], "-vkdrawcheck") == 0) {
+        gbCheckVkDrawJobs = true;
+        return 1;
+    }
+
+    return 0;
+}
+
 // A list of all the argument parsing functions
 static constexpr ArgParser ARG_PARSERS[] = {
     parseArg_cue,
     parseArg_headless,
+    parseArg_maxspeed,
     parseArg_datadir,
     parseArg_playdemo,
     parseArg_saveresult,
     parseArg_checkresult,
+    parseArg_demobatch,
+    parseArg_demobatchjobs,
+    parseArg_demobatchreport,
     parseArg_record,
     parseArg_nomonsters,
     parseArg_pistolstart,
@@ -281,16 +439,65 @@ static constexpr ArgParser ARG_PARSERS[] = {
     parseArg_file,
     parseArg_nolauncher,
     parseArg_warp,
-    parseArg_skill
+    parseArg_skill,
+    parseArg_spustats,
+    parseArg_nospuqueue,
+    parseArg_gpucapture,
+    parseArg_verifylevelcache,
+    parseArg_loadtimings,
+    parseArg_zonetrace,
+    parseArg_sightstats,
+    parseArg_vkdrawcheck
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Performs additional validation and sanity checks for program arguments to fix some unsupported/invalid combos
 //------------------------------------------------------------------------------------------------------------------------------------------
 static void validateAndSanitizeArgs() noexcept {
-    if (gbHeadlessMode && (!gPlayDemoFilePath[0])) {
-        std::printf("The '-headless' switch can only be used in conjunction with '-playdemo'! Arg will be ignored...\n");
+    // Max speed simulation is only for headless demo playback
+    if (gbMaxSpeedSim) {
+        gbHeadlessMode = true;
+    }
+
+    // Batch demo playback is always headless and the demo files and results come from the batch manifest
+    if (gDemoBatchFilePath[0]) {
+        gbHeadlessMode = true;
+
+        if (gPlayDemoFilePath[0]) {
+            std::printf("Can't use '-playdemo' in conjunction with '-demobatch'! Arg will be ignored...\n");
+            gPlayDemoFilePath = "";
+        }
+
+        if (gSaveDemoResultFilePath[0]) {
+            std::printf("Can't use '-saveresult' in conjunction with '-demobatch'! Arg will be ignored...\n");
+            gSaveDemoResultFilePath = "";
+        }
+
+        if (gCheckDemoResultFilePath[0]) {
+            std::printf("Can't use '-checkresult' in conjunction with '-demobatch'! Arg will be ignored...\n");
+            gCheckDemoResultFilePath = "";
+        }
+
+        if (gbRecordDemos) {
+            std::printf("Can't use '-record' in conjunction with '-demobatch'! Arg will be ignored...\n");
+            gbRecordDemos = false;
+        }
+
+        if (gWarpMap > 0) {
+            std::printf("The '-warp' argument conflicts with '-demobatch'! Arg will be ignored...\n");
+            gWarpMap = 0;
+        }
+    }
+
+    if (gbHeadlessMode && (!gPlayDemoFilePath[0]) && (!gDemoBatchFilePath[0])) {
+        std::printf("The '-headless' and '-maxspeed' switches can only be used in conjunction with '-playdemo' or '-demobatch'! Arg will be ignored...\n");
         gbHeadlessMode = false;
+        gbMaxSpeedSim = false;
+    }
+
+    if (gbCheckVkDrawJobs && (!gbHeadlessMode)) {
+        std::printf("The '-vkdrawcheck' switch can only be used in headless mode! Arg will be ignored...\n");
+        gbCheckVkDrawJobs = false;
     }
 
     if (gbRecordDemos && gPlayDemoFilePath[0]) {
@@ -362,16 +569,30 @@ void shutdown() noexcept {
     // Reset everything back to its initial state and free any memory allocated (to help leak detection)
     gCueFileOverride = nullptr;
     gbHeadlessMode = false;
+    gbMaxSpeedSim = false;
     gDataDirPath = "";
     gPlayDemoFilePath = "";
     gSaveDemoResultFilePath = "";
     gCheckDemoResultFilePath = "";
+    gDemoBatchFilePath = "";
+    gDemoBatchReportFilePath = "";
+    gDemoBatchNumJobs = 0;
     gbIsNetServer = false;
     gbIsNetClient = false;
     gServerPort = DEFAULT_NET_PORT;
     gbNoMonsters = false;
     gbPistolStart = false;
     gbTurboMode = false;
+    gbPrintSpuStats = false;
+    gbNoSpuCmdQueue = false;
+    gGpuCaptureFilePath = "";
+    gGpuCaptureStartFrame = 0;
+    gGpuCaptureNumFrames = 0;
+    gbVerifyLevelCache = false;
+    gbPrintLoadTimings = false;
+    gZoneTraceFilePath = "";
+    gbPrintSightStats = false;
+    gbCheckVkDrawJobs = false;
     gUserWadFiles.clear();
 }
 
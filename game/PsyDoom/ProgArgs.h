@@ -10,11 +10,15 @@ BEGIN_NAMESPACE(ProgArgs)
 
 extern const char*  gCueFileOverride;
 extern bool         gbHeadlessMode;
+extern bool         gbMaxSpeedSim;
 extern const char*  gDataDirPath;
 extern const char*  gPlayDemoFilePath;
 extern const char*  gSaveDemoResultFilePath;
 extern const char*  gCheckDemoResultFilePath;
 extern bool         gbRecordDemos;
+extern const char*  gDemoBatchFilePath;
+extern const char*  gDemoBatchReportFilePath;
+extern uint32_t     gDemoBatchNumJobs;
 extern bool         gbIsNetServer;
 extern bool         gbIsNetClient;
 extern uint16_t     gServerPort;
@@ -23,6 +27,16 @@ extern bool         gbPistolStart;
 extern bool         gbTurboMode;
 extern int32_t      gWarpMap;
 extern skill_t      gWarpSkill;
+extern bool         gbPrintSpuStats;
+extern bool         gbNoSpuCmdQueue;
+extern const char*  gGpuCaptureFilePath;
+extern uint32_t     gGpuCaptureStartFrame;
+extern uint32_t     gGpuCaptureNumFrames;
+extern bool         gbVerifyLevelCache;
+extern bool         gbPrintLoadTimings;
+extern const char*  gZoneTraceFilePath;
+extern bool         gbPrintSightStats;
+extern bool         gbCheckVkDrawJobs;
 
 void init(const int argc, const char* const* const argv) noexcept;
 void shutdown() noexcept;
@@ -9,13 +9,19 @@
 #include "DiscInfo.h"
 #include "DiscReader.h"
 #include "Gpu.h"
+#include "GpuCapture.h"
 #include "Input.h"
 #include "IsoFileSys.h"
 #include "ProgArgs.h"
 #include "Spu.h"
+#include "SpuCmdQueue.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <SDL.h>
 #include <mutex>
+#include <thread>
 
 BEGIN_NAMESPACE(PsxVm)
 
@@ -27,6 +33,18 @@ Spu::Core   gSpu;
 static SDL_AudioDeviceID        gSdlAudioDeviceId;
 static std::recursive_mutex     gSpuMutex;
 
+// Stats for how long threads had to wait to acquire the SPU lock: only modified while the SPU is locked.
+// The stats are kept separately for the audio thread and for everything else (the game thread).
+struct SpuLockStats {
+    uint64_t    numLocks;           // How many times the lock was acquired
+    uint64_t    numContendedLocks;  // How many times the lock was already held by another thread
+    int64_t     maxWaitTime;        // Longest time spent waiting on the lock (nanoseconds)
+};
+
+static SpuLockStats                 gSpuLockStats[2];       // Index '0' is the game thread, index '1' is the audio thread
+static thread_local bool            gbIsAudioThread;        // Set to 'true' on the SDL audio thread
+static AudioThreadUpdateFunc        gpAudioThreadUpdateFunc;    // If set, called by the audio thread to run events which are timed against generated samples
+
 // The audio compressor is only needed if we have a floating point SPU
 #if SIMPLE_SPU_FLOAT_SPU
     static AudioCompressor::State gAudioCompState;
@@ -43,32 +61,50 @@ static void SdlAudioCallback([[maybe_unused]] void* userData, Uint8* pOutput, in
     // How many samples are to be output?
     const uint32_t numSamples = (uint32_t) outputSize / (sizeof(float) * 2);
 
-    // Lock the SPU and generate the requested number of samples
+    // Lock the SPU and generate the requested number of samples, a block at a time.
+    // Any SPU commands sent by the game thread are applied at the start of each block.
+    // If there is an audio thread update function then blocks are also split at the points where it says the next event is due.
+    gbIsAudioThread = true;
     float* pOutputF = reinterpret_cast<float*>(pOutput);
     PsxVm::LockSpu spuLock;
 
-    for (uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx) {
-        // Get this sample in floating point format
-        const Spu::StereoSample sample = Spu::stepCore(gSpu);
-
-        #if SIMPLE_SPU_FLOAT_SPU
-            float sampleL = sample.left;
-            float sampleR = sample.right;
-        #else
-            float sampleL = Spu::toFloatSample(sample.left);
-            float sampleR = Spu::toFloatSample(sample.right);
-        #endif
-
-        // If using the floating point SPU apply audio compression.
-        // When using floating point sound the audio can get EXTREMELY loud (and painful to listen to) if not capped.
-        // When using the original 16-bit SPU the sound will also clip/distort if too loud, so no point in using compression in that case.
-        #if SIMPLE_SPU_FLOAT_SPU
-            AudioCompressor::compress(gAudioCompState, sampleL, sampleR);
-        #endif
-
-        pOutputF[0] = sampleL;
-        pOutputF[1] = sampleR;
-        pOutputF += 2;
+    Spu::StereoSample samples[Spu::MAX_STEP_BLOCK_SIZE];
+
+    for (uint32_t blockStartIdx = 0; blockStartIdx < numSamples;) {
+        uint32_t blockSize = std::min(numSamples - blockStartIdx, Spu::MAX_STEP_BLOCK_SIZE);
+
+        if (gpAudioThreadUpdateFunc) {
+            blockSize = std::clamp(gpAudioThreadUpdateFunc(blockSize), 1u, blockSize);
+        }
+
+        SpuCmdQueue::applyPendingCmds();
+        Spu::stepCoreBlock(gSpu, samples, blockSize);
+
+        for (uint32_t sampleIdx = 0; sampleIdx < blockSize; ++sampleIdx) {
+            // Get this sample in floating point format
+            const Spu::StereoSample sample = samples[sampleIdx];
+
+            #if SIMPLE_SPU_FLOAT_SPU
+                float sampleL = sample.left;
+                float sampleR = sample.right;
+            #else
+                float sampleL = Spu::toFloatSample(sample.left);
+                float sampleR = Spu::toFloatSample(sample.right);
+            #endif
+
+            // If using the floating point SPU apply audio compression.
+            // When using floating point sound the audio can get EXTREMELY loud (and painful to listen to) if not capped.
+            // When using the original 16-bit SPU the sound will also clip/distort if too loud, so no point in using compression in that case.
+            #if SIMPLE_SPU_FLOAT_SPU
+                AudioCompressor::compress(gAudioCompState, sampleL, sampleR);
+            #endif
+
+            pOutputF[0] = sampleL;
+            pOutputF[1] = sampleR;
+            pOutputF += 2;
+        }
+
+        blockStartIdx += blockSize;
     }
 }
 
@@ -112,7 +148,7 @@ bool init(const char* const doomCdCuePath) noexcept {
         uint16_t vramW = {};
         uint16_t vramH = {};
         getVramSize(vramW, vramH);
-        Gpu::initCore(gGpu, vramW, vramH);
+        initGpu(vramW, vramH);
     }
 
     // Init the SPU core and use extended hardware voice counts (64 max) and an expanded RAM size (defaulted to 16 MiB) if the build is limit removing.
@@ -129,6 +165,9 @@ bool init(const char* const doomCdCuePath) noexcept {
     #endif
 
     Spu::initCore(gSpu, spuRamSize, SPU_VOICE_COUNT);
+    SpuCmdQueue::init();
+    gSpuLockStats[0] = {};
+    gSpuLockStats[1] = {};
 
     // Init the audio compressor if using the float SPU (don't need it for the 16-bit SPU)
     #if SIMPLE_SPU_FLOAT_SPU
@@ -157,7 +196,10 @@ bool init(const char* const doomCdCuePath) noexcept {
         }
     }
 
-    // Build up the ISO file system from the game disc
+    // Build up the ISO file system from the game disc.
+    // Note: disc readers memory map the disc image (if enabled) for all reads from here on in.
+    DiscReader::setUseMemoryMapping(Config::gbMemoryMapDiscImage);
+
     {
         DiscReader discReader(gDiscInfo);
 
@@ -169,10 +211,12 @@ bool init(const char* const doomCdCuePath) noexcept {
         }
     }
 
-    // Setup sound
-    SDL_InitSubSystem(SDL_INIT_AUDIO);
+    // Setup sound.
+    // Don't open an audio device in headless mode since there is no sound output, and so there are also no audio threads.
+    // The demo batch runner relies on the process being single threaded so that it can be forked safely.
+    if (!ProgArgs::gbHeadlessMode) {
+        SDL_InitSubSystem(SDL_INIT_AUDIO);
 
-    {
         // Firstly try to open an audio device sampling at 44,100 Hz stereo in floating point mode.
         // Note that if initialization succeeds then we've got our requested format, since we ask SDL not to allow any deviation.
         SDL_AudioSpec wantFmt = {};
@@ -201,6 +245,26 @@ bool init(const char* const doomCdCuePath) noexcept {
     return true;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Print statistics for SPU lock contention and the SPU command queue to standard out
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printSpuStats() noexcept {
+    const char* const THREAD_NAMES[2] = { "game", "audio" };
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        const SpuLockStats& stats = gSpuLockStats[i];
+        std::printf(
+            "SPU lock (%s thread): %llu locks, %llu contended, longest wait %.3f ms\n",
+            THREAD_NAMES[i],
+            (unsigned long long) stats.numLocks,
+            (unsigned long long) stats.numContendedLocks,
+            (double) stats.maxWaitTime / 1e6
+        );
+    }
+
+    SpuCmdQueue::printStats();
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Tear down emulated PlayStation components
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -211,16 +275,82 @@ void shutdown() noexcept {
         gSdlAudioDeviceId = 0;
     }
 
+    gpAudioThreadUpdateFunc = nullptr;
+
+    if (ProgArgs::gbPrintSpuStats) {
+        printSpuStats();
+    }
+
+    SpuCmdQueue::shutdown();
+    GpuCapture::shutdown();
     Spu::destroyCore(gSpu);     // Note: no locking of the SPU here because all threads should be done with it at this point
     Gpu::destroyCore(gGpu);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Initialize (or re-initialize) the GPU with the given VRAM size.
+// Also enables multithreaded drawing for the GPU if the user config asks for it.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void initGpu(const uint16_t vramW, const uint16_t vramH) noexcept {
+    // The contents of VRAM are lost when re-initializing so a GPU capture can't continue past this point
+    if (GpuCapture::gbIsCapturing) {
+        GpuCapture::shutdown();
+    }
+
+    Gpu::destroyCore(gGpu);
+    Gpu::initCore(gGpu, vramW, vramH);
+
+    // Note: nothing is drawn in headless mode so don't start any drawing threads in that case
+    const int32_t cfgNumThreads = Config::gClassicRendererThreads;
+    const uint32_t numThreads = (cfgNumThreads < 0) ? std::thread::hardware_concurrency() : (uint32_t) cfgNumThreads;
+
+    if ((numThreads > 1) && (!ProgArgs::gbHeadlessMode)) {
+        Gpu::enableDeferredMode(gGpu, numThreads);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Lock the SPU, recording how long the wait was if the lock was contended.
+// Once locked, any SPU commands waiting in the queue are applied so the caller sees all changes made to the SPU so far.
+//------------------------------------------------------------------------------------------------------------------------------------------
 void lockSpu() noexcept {
-    gSpuMutex.lock();
+    SpuLockStats& stats = gSpuLockStats[(gbIsAudioThread) ? 1 : 0];
+
+    if (gSpuMutex.try_lock()) {
+        stats.numLocks++;
+    } else {
+        const auto waitStartTime = std::chrono::steady_clock::now();
+        gSpuMutex.lock();
+        const auto waitTime = std::chrono::steady_clock::now() - waitStartTime;
+
+        stats.numLocks++;
+        stats.numContendedLocks++;
+        stats.maxWaitTime = std::max<int64_t>(stats.maxWaitTime, std::chrono::duration_cast<std::chrono::nanoseconds>(waitTime).count());
+    }
+
+    SpuCmdQueue::applyPendingCmds();
 }
 
 void unlockSpu() noexcept {
     gSpuMutex.unlock();
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the calling thread is the audio thread, i.e the thread which generates sound samples
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isAudioThread() noexcept {
+    return gbIsAudioThread;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sets or clears (if null) the function called by the audio thread before generating each block of samples.
+// Returns 'false' if there is no audio device generating samples, in which case the function will never be called.
+// Once this returns the previous function (if any) is guaranteed to no longer be running.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool setAudioThreadUpdateFunc(const AudioThreadUpdateFunc pFunc) noexcept {
+    LockSpu spuLock;
+    gpAudioThreadUpdateFunc = (gSdlAudioDeviceId != 0) ? pFunc : nullptr;
+    return (gSdlAudioDeviceId != 0);
+}
+
 END_NAMESPACE(PsxVm)
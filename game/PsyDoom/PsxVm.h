@@ -27,6 +27,7 @@ extern Spu::Core    gSpu;
 
 bool init(const char* const doomCdCuePath) noexcept;
 void shutdown() noexcept;
+void initGpu(const uint16_t vramW, const uint16_t vramH) noexcept;
 
 // Fire timer (root counter) related events if appropriate.
 // Note: this is implemented in LIBAPI, where timers are handled.
@@ -42,4 +43,13 @@ struct LockSpu {
     ~LockSpu() noexcept { unlockSpu(); }
 };
 
+bool isAudioThread() noexcept;
+
+// A function called by the audio thread (with the SPU locked) before generating each block of samples.
+// It receives the size of the block about to be generated and returns how many samples can be generated before it needs to be called again.
+// This allows events (such as music sequencer commands) to be timed against the audio output with sample accuracy.
+typedef uint32_t (*AudioThreadUpdateFunc)(const uint32_t maxSamples) noexcept;
+
+bool setAudioThreadUpdateFunc(const AudioThreadUpdateFunc pFunc) noexcept;
+
 END_NAMESPACE(PsxVm)
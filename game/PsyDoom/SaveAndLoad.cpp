@@ -25,6 +25,7 @@
 #include "OutputStream.h"
 #include "SaveDataTypes.h"
 #include "ScriptingEngine.h"
+#include "TagIndex.h"
 #include "Utils.h"
 
 BEGIN_NAMESPACE(SaveAndLoad)
@@ -647,8 +648,10 @@ LoadSaveResult load() noexcept {
     deserializeObjects(saveData.buttons, pButtons, hdr.numButtons);
     deserializeObjects(saveData.scheduledActions, ScriptingEngine::gScheduledActions.data(), hdr.numScheduledActions);
 
-    // Post load actions: update skill based game settings, adding map objects into the blockmap and sector lists, and associating thinkers with their sectors
+    // Post load actions: update skill based game settings, index sectors and lines by tag, adding map objects into the blockmap and sector lists
+    // and associating thinkers with their sectors.
     G_UpdateMobjInfoForSkill(gGameSkill);
+    TagIndex::build();
     addMobjsToSectors();
     associateThinkersWithSectors(gVlDoors);
     associateThinkersWithSectors(gVlCustomDoors);
@@ -29,6 +29,7 @@
 #include "Doom/Renderer/r_main.h"
 #include "Doom/UI/st_main.h"
 #include "ScriptingEngine.h"
+#include "TagIndex.h"
 
 #include <algorithm>
 #include <cstdio>
@@ -302,17 +303,8 @@ static sector_t* GetSector(const int32_t index) noexcept {
 }
 
 static sector_t* FindSectorWithTag(const int32_t tag) noexcept {
-    const int32_t numSectors = gNumSectors;
-    sector_t* const pSectors = gpSectors;
-
-    for (int32_t i = 0; i < numSectors; ++i) {
-        sector_t& sector = pSectors[i];
-
-        if (sector.tag == tag)
-            return &sector;
-    }
-
-    return nullptr;
+    const int32_t sectorIdx = TagIndex::findNextSector(tag, -1);
+    return (sectorIdx >= 0) ? gpSectors + sectorIdx : nullptr;
 }
 
 static void ForEachSector(const std::function<void (sector_t& sector)>& callback) noexcept {
@@ -331,15 +323,9 @@ static void ForEachSectorWithTag(const int32_t tag, const std::function<void (se
     if (!callback)
         return;
 
-    const int32_t numSectors = gNumSectors;
-    sector_t* const pSectors = gpSectors;
-
-    for (int32_t i = 0; i < numSectors; ++i) {
-        sector_t& sector = pSectors[i];
-
-        if (sector.tag == tag) {
-            callback(sector);
-        }
+    // Note: the callback might change sector tags, so the next sector is found after calling it
+    for (int32_t i = TagIndex::findNextSector(tag, -1); i >= 0; i = TagIndex::findNextSector(tag, i)) {
+        callback(gpSectors[i]);
     }
 }
 
@@ -449,17 +435,8 @@ static line_t* GetLine(const int32_t index) noexcept {
 }
 
 static line_t* FindLineWithTag(const int32_t tag) noexcept {
-    const int32_t numLines = gNumLines;
-    line_t* const pLines = gpLines;
-
-    for (int32_t i = 0; i < numLines; ++i) {
-        line_t& line = pLines[i];
-
-        if (line.tag == tag)
-            return &line;
-    }
-
-    return nullptr;
+    const int32_t lineIdx = TagIndex::findNextLine(tag, -1);
+    return (lineIdx >= 0) ? gpLines + lineIdx : nullptr;
 }
 
 static void ForEachLine(const std::function<void (line_t& line)>& callback) noexcept {
@@ -478,15 +455,9 @@ static void ForEachLineWithTag(const int32_t tag, const std::function<void (line
     if (!callback)
         return;
 
-    const int32_t numLines = gNumLines;
-    line_t* const pLines = gpLines;
-
-    for (int32_t i = 0; i < numLines; ++i) {
-        line_t& line = pLines[i];
-
-        if (line.tag == tag) {
-            callback(line);
-        }
+    // Note: the callback might change line tags, so the next line is found after calling it
+    for (int32_t i = TagIndex::findNextLine(tag, -1); i >= 0; i = TagIndex::findNextLine(tag, i)) {
+        callback(gpLines[i]);
     }
 }
 
@@ -801,7 +772,10 @@ static void registerType_sector_t(sol::state& lua) noexcept {
     type["colorid"] = SOL_BYTE_PROPERTY(sector_t, colorid);
     type["lightlevel"] = SOL_BYTE_PROPERTY(sector_t, lightlevel);
     type["special"] = &sector_t::special;
-    type["tag"] = &sector_t::tag;
+    type["tag"] = sol::property(
+        [](const sector_t& sector) noexcept { return sector.tag; },
+        [](sector_t& sector, const int32_t tag) noexcept { TagIndex::setSectorTag(sector, tag); }
+    );
     type["flags"] = &sector_t::flags;
     type["ceil_colorid"] = SOL_BYTE_PROPERTY(sector_t, ceilColorid);
     type["floor_tex_offset_x"] = SOL_LERPED_SECTOR_FIXED_PROPERTY_AS_FLOAT(sector_t, floorTexOffsetX);
@@ -842,7 +816,10 @@ static void registerType_line_t(sol::state& lua) noexcept {
     type["angle"] = sol::readonly_property([](const line_t& line) noexcept { return AngleToDegrees((angle_t) line.fineangle << ANGLETOFINESHIFT); });
     type["flags"] = &line_t::flags;
     type["special"] = &line_t::special;
-    type["tag"] = &line_t::tag;
+    type["tag"] = sol::property(
+        [](const line_t& line) noexcept { return line.tag; },
+        [](line_t& line, const int32_t tag) noexcept { TagIndex::setLineTag(line, tag); }
+    );
     type["frontside"] = sol::readonly_property([](const line_t& line) noexcept { return GetSide(line.sidenum[0]); });
     type["backside"] = sol::readonly_property([](const line_t& line) noexcept { return GetSide(line.sidenum[1]); });
     type["frontsector"] = sol::readonly(&line_t::frontsector);
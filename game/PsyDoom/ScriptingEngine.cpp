@@ -11,6 +11,7 @@
 #include "Doom/UI/st_main.h"
 #include "MapHash.h"
 #include "ScriptBindings.h"
+#include "SimProfiler.h"
 
 #include <cstdio>
 #include <memory>
@@ -21,6 +22,9 @@ BEGIN_NAMESPACE(ScriptingEngine)
 // The main Lua VM, managed and wrapped by the 'Sol2' library
 static std::unique_ptr<sol::state> gpLuaState;
 
+// The script for the current map, if any; read by 'readMapScript' and executed (then freed) by 'init'
+static std::unique_ptr<char[]> gpMapScript;
+
 // A table of actions registered with the scripting engine.
 // Each action has an integer identifier associated with it that is referenced by line tags.
 static std::unordered_map<int32_t, sol::protected_function> gScriptActions;
@@ -242,15 +246,24 @@ static void compactScheduledActionList() noexcept {
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the script lump for the current level (if any) ready for 'init' to execute.
+// This must be done while the map WAD is open and before the map hash is finalized, since the script contributes to the hash.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void readMapScript() noexcept {
+    gpMapScript = readCurrentMapScript();
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Initializes the scripting engine for the current level.
-// Loads and compiles the script lump for the level, if any is present.
+// Compiles and executes the script lump read by 'readMapScript', if any is present.
+// Note: the map script can use scripting bindings when it executes, so this must be done once the map is fully loaded and patched.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void init() noexcept {
     ASSERT(gNumExecutingScripts == 0);
 
-    // Read the current map script (if any)
-    std::unique_ptr<char[]> mapScript = readCurrentMapScript();
+    // Take ownership of the current map script (if any)
+    std::unique_ptr<char[]> mapScript = std::move(gpMapScript);
 
     if (!mapScript)
         return;
@@ -288,6 +301,7 @@ void shutdown() noexcept {
 // Runs all actions that are scheduled for execution
 //------------------------------------------------------------------------------------------------------------------------------------------
 void runScheduledActions() noexcept {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::Phase, (uintptr_t) SimProfiler::Phase::ScheduledActions);
     // Flag which actions are pending execution for this frame.
     // If any actions schedule any other actions then they will be delayed by 1 frame at least.
     const int32_t numActions = (int32_t) gScheduledActions.size();
@@ -345,6 +359,8 @@ bool doAction(
     const int32_t actionTag,
     const int32_t actionUserdata
 ) noexcept {
+    SIM_PROFILE_SCOPE(SimProfiler::Category::ScriptAction, (uintptr_t) actionNum);
+
     // Set context for scripts
     gNumExecutingScripts++;
 
@@ -33,6 +33,7 @@ extern int32_t                          gCurActionUserdata;
 extern bool                             gbCurActionAllowed;
 extern bool                             gbNeedMobjGC;
 
+void readMapScript() noexcept;
 void init() noexcept;
 void shutdown() noexcept;
 void runScheduledActions() noexcept;
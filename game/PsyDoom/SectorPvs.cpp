@@ -0,0 +1,927 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Builds a conservative sector PVS for the current map and uses it to tighten the reject map.
+// See the header for more details.
+//
+// How visibility is decided:
+//  (1) Every two-sided line between two different sectors is a portal. A sight line going from one sector to another must cross a chain
+//      of portals, entering each one from the sector it is leaving. Chains are found with a depth first search from each sector.
+//  (2) A sight line which crosses a portal from a particular side has the portal's left end point (relative to the direction of travel) on
+//      its left and the right end point on its right. If 'n' is the normal of the sight line (pointing to it's left) then this means that
+//      'n.l >= n.r' must hold for the left and right end points 'l' and 'r' of every portal in the chain, including pairs of end points from
+//      different portals. The set of normals satisfying all of these constraints is a convex cone and is tracked exactly (with integer math)
+//      as the chain grows. A chain is abandoned as soon as the cone becomes empty. Note that the order in which the portals are crossed is
+//      ignored, which only makes the result more conservative.
+//  (3) To allow for 'P_CheckSight' rounding the end points of the sight line (and ignoring intersections very close to the start of it),
+//      sector 'A' is treated as being able to see sector 'B' if any sector close to 'A' can see any sector close to 'B'.
+//
+// Cache file format (native endian, since the file is only ever used by the same build of PsyDoom on the same machine):
+//  (1) A 'FileHeader'.
+//  (2) The PVS reject bits: one bit for each pair of sectors, laid out exactly the same as the reject map.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "SectorPvs.h"
+
+#include "Config/Config.h"
+#include "Doom/Game/p_setup.h"
+#include "Doom/Renderer/r_local.h"
+#include "FileUtils.h"
+#include "MapHash.h"
+#include "ProgArgs.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <md5.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+BEGIN_NAMESPACE(SectorPvs)
+
+static constexpr char       FILE_MAGIC[8] = { 'P', 'S', 'Y', 'S', 'P', 'V', 'S', 0 };
+static constexpr uint32_t   FILE_VERSION = 1;
+
+// Sectors with lines this close to each other (in map units) are treated as the same sector at the ends of a sight line.
+// Sight line end points are moved by up to 1 unit when rounded and line vertexes by up to 1 unit, and intersections within 4/65536ths of
+// the length of the sight line from its start are ignored (up to ~6 units for the longest possible sight lines).
+static constexpr double NEIGHBOR_DIST = 8.0;
+
+// Size of the grid cells used to find lines that are near each other, in map units
+static constexpr int32_t NEIGHBOR_GRID_CELL_SIZE = 128;
+
+// Maximum width or height of the map that the PVS can be built for. Past this the math done by 'PS_SightCrossLine' can overflow, which
+// can let sight lines pass through walls in ways that the PVS has no way of predicting.
+static constexpr int32_t MAX_MAP_EXTENT = 23000;
+
+// Maximum number of cone clipping operations done when searching the portal chains of one sector.
+// If this is exceeded then all sectors connected to the sector by portals are treated as visible from it.
+static constexpr uint32_t MAX_SECTOR_WORK = 4 * 1024 * 1024;
+
+// Header at the start of a cache file
+struct FileHeader {
+    char        magic[8];           // Should equal 'FILE_MAGIC'
+    uint32_t    version;            // Should equal 'FILE_VERSION'
+    int32_t     numSectors;         // Number of sectors in the map
+    uint64_t    mapHashWord1;       // Map hash of the map
+    uint64_t    mapHashWord2;
+    uint64_t    inputHashWord1;     // Hash of all the map data the PVS was built from, in case something modified the map after loading
+    uint64_t    inputHashWord2;
+};
+
+// A 2D vector in whole map units
+struct Vec2 {
+    int64_t x;
+    int64_t y;
+};
+
+// A two-sided line between two different sectors
+struct Portal {
+    int32_t     frontSector;
+    int32_t     backSector;
+    Vec2        v1;
+    Vec2        v2;
+};
+
+// Describes the set of valid normals for sight lines passing through a chain of portals: a convex cone in 2D
+enum class ConeType : uint8_t {
+    Full,           // Any normal is valid
+    HalfPlane,      // Normals 'n' where 'n.a >= 0'
+    Wedge,          // Normals between 'a' and 'b' going counter clockwise from 'a', where the angle between them is less than 180 degrees
+    Line,           // Normals which are a positive or negative multiple of 'a'
+    Ray,            // Normals which are a positive multiple of 'a'
+    Empty           // No normals are valid: no sight line passes through the chain
+};
+
+struct NormalCone {
+    ConeType    type;
+    Vec2        a;
+    Vec2        b;
+};
+
+// The portals of the map and the portals connected to each sector
+struct PvsInput {
+    int32_t                 numSectors;
+    std::vector<Portal>     portals;
+    std::vector<int32_t>    sectorPortalsBeg;   // Index of the first portal in 'sectorPortals' for each sector, plus an end index
+    std::vector<int32_t>    sectorPortals;
+};
+
+// One entry in the stack of portal chains being searched
+struct ChainLink {
+    int32_t     sector;             // Sector the chain leads to
+    int32_t     nextPortalIdx;      // Next portal (index into 'sectorPortals') of the sector to try extending the chain with
+    int32_t     portal;             // The portal which lead into the sector, or '-1' if none
+    Vec2        portalL;            // The left and right end points of the portal, relative to the direction of travel
+    Vec2        portalR;
+    NormalCone  cone;               // Valid normals for sight lines through the chain up to and including this sector
+};
+
+// Working state for one thread searching portal chains
+struct SearchState {
+    std::vector<ChainLink>  chain;
+    std::vector<uint8_t>    portalsInChain;
+    std::vector<int32_t>    floodStack;
+};
+
+bool        gbCollectSightStats;    // Set when sight check statistics are being gathered for the current level
+SightStats  gSightStats;            // Sight check statistics for the current level
+
+static std::vector<uint8_t> gAddedRejectBits;   // Reject map bits which were set by the PVS rather than the map's 'REJECT' lump
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Vector helpers
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline Vec2 operator - (const Vec2 v1, const Vec2 v2) noexcept { return Vec2{ v1.x - v2.x, v1.y - v2.y }; }
+static inline Vec2 operator - (const Vec2 v) noexcept { return Vec2{ -v.x, -v.y }; }
+static inline int64_t dot(const Vec2 v1, const Vec2 v2) noexcept { return v1.x * v2.x + v1.y * v2.y; }
+static inline int64_t cross(const Vec2 v1, const Vec2 v2) noexcept { return v1.x * v2.y - v1.y * v2.x; }
+static inline Vec2 perpCcw(const Vec2 v) noexcept { return Vec2{ -v.y, v.x }; }
+
+static inline Vec2 getVertexPos(const vertex_t& vertex) noexcept {
+    // Same rounding as 'PS_SightCrossLine'
+    return Vec2{ d_fixed_to_int(vertex.x), d_fixed_to_int(vertex.y) };
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Restricts the given cone to the normals 'n' where 'n.w >= 0'.
+// Cone boundaries are always perpendicular to one of the constraint vectors, so all the math stays exact with 64-bit integers.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void clipCone(NormalCone& cone, const Vec2 w) noexcept {
+    if ((w.x == 0) && (w.y == 0))
+        return;
+
+    switch (cone.type) {
+        case ConeType::Full:
+            cone.type = ConeType::HalfPlane;
+            cone.a = w;
+            break;
+
+        case ConeType::HalfPlane: {
+            const int64_t c = cross(cone.a, w);
+
+            if (c == 0) {
+                // Parallel constraints: either the same half plane or only the line between the two opposing half planes is left
+                if (dot(cone.a, w) < 0) {
+                    cone.type = ConeType::Line;
+                    cone.a = perpCcw(cone.a);
+                }
+            } else {
+                // The two half planes intersect in a wedge bounded by normals perpendicular to both constraints
+                const Vec2 r1 = (c > 0) ? perpCcw(cone.a) : -perpCcw(cone.a);
+                const Vec2 r2 = (c < 0) ? perpCcw(w) : -perpCcw(w);
+                cone.type = ConeType::Wedge;
+                cone.a = (cross(r1, r2) > 0) ? r1 : r2;
+                cone.b = (cross(r1, r2) > 0) ? r2 : r1;
+            }
+        }   break;
+
+        case ConeType::Wedge: {
+            const int64_t da = dot(cone.a, w);
+            const int64_t db = dot(cone.b, w);
+
+            if ((da >= 0) && (db >= 0))
+                break;
+
+            if ((da < 0) && (db < 0)) {
+                cone.type = ConeType::Empty;
+                break;
+            }
+
+            // The constraint boundary passes through the wedge: find the direction along it which is inside the wedge
+            const Vec2 p = perpCcw(w);
+            const Vec2 r = ((cross(cone.a, p) >= 0) && (cross(p, cone.b) >= 0)) ? p : -p;
+
+            if (da >= 0) {
+                if (cross(cone.a, r) == 0) {
+                    cone.type = ConeType::Ray;
+                } else {
+                    cone.b = r;
+                }
+            } else {
+                if (cross(r, cone.b) == 0) {
+                    cone.type = ConeType::Ray;
+                    cone.a = cone.b;
+                } else {
+                    cone.a = r;
+                }
+            }
+        }   break;
+
+        case ConeType::Line: {
+            const int64_t d = dot(cone.a, w);
+
+            if (d != 0) {
+                cone.type = ConeType::Ray;
+                cone.a = (d > 0) ? cone.a : -cone.a;
+            }
+        }   break;
+
+        case ConeType::Ray:
+            if (dot(cone.a, w) < 0) {
+                cone.type = ConeType::Empty;
+            }
+            break;
+
+        case ConeType::Empty:
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Checks that the PVS can be safely built for the current map, returning a description of the problem if it can't or 'nullptr' if it can.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static const char* checkMapIsSupported() noexcept {
+    if (gNumSectors < 2)
+        return "not enough sectors";
+
+    // The map must be small enough that the sight check math can't overflow
+    if (gNumVertexes > 0) {
+        Vec2 minPos = getVertexPos(gpVertexes[0]);
+        Vec2 maxPos = minPos;
+
+        for (int32_t vertIdx = 1; vertIdx < gNumVertexes; ++vertIdx) {
+            const Vec2 pos = getVertexPos(gpVertexes[vertIdx]);
+            minPos = Vec2{ std::min(minPos.x, pos.x), std::min(minPos.y, pos.y) };
+            maxPos = Vec2{ std::max(maxPos.x, pos.x), std::max(maxPos.y, pos.y) };
+        }
+
+        if ((maxPos.x - minPos.x > MAX_MAP_EXTENT) || (maxPos.y - minPos.y > MAX_MAP_EXTENT))
+            return "the map is too big";
+    }
+
+    // Every subsector must contain only segs facing into it's own sector, otherwise the BSP disagrees with the line sides about where the
+    // sectors are and a sight line could move between sectors without crossing a line.
+    for (int32_t subsecIdx = 0; subsecIdx < gNumSubsectors; ++subsecIdx) {
+        const subsector_t& subsec = gpSubsectors[subsecIdx];
+
+        if ((!subsec.sector) || (subsec.firstseg < 0) || (subsec.numsegs < 0) || (subsec.firstseg + subsec.numsegs > gNumSegs))
+            return "the map has an invalid subsector";
+
+        for (int32_t segIdx = subsec.firstseg; segIdx < subsec.firstseg + subsec.numsegs; ++segIdx) {
+            if (gpSegs[segIdx].frontsector != subsec.sector)
+                return "the map has subsectors with segs from other sectors";
+        }
+    }
+
+    // Every sector must be closed: treating each line side as an edge going around the sector, each vertex must be entered as many times
+    // as it is exited. Vertexes are compared by position since some maps have duplicate vertexes.
+    std::unordered_map<uint64_t, int32_t> vertexBalances;
+    vertexBalances.reserve((size_t) gNumLines * 4);
+
+    const auto addEdge = [&](const sector_t* const pSector, const vertex_t& vertex1, const vertex_t& vertex2) noexcept {
+        const uint64_t secBits = (uint64_t)(pSector - gpSectors) << 32;
+        const Vec2 pos1 = getVertexPos(vertex1);
+        const Vec2 pos2 = getVertexPos(vertex2);
+        vertexBalances[secBits | ((uint64_t)(uint16_t) pos1.x << 16) | (uint16_t) pos1.y] += 1;
+        vertexBalances[secBits | ((uint64_t)(uint16_t) pos2.x << 16) | (uint16_t) pos2.y] -= 1;
+    };
+
+    for (int32_t lineIdx = 0; lineIdx < gNumLines; ++lineIdx) {
+        const line_t& line = gpLines[lineIdx];
+
+        if (line.frontsector) {
+            addEdge(line.frontsector, *line.vertex1, *line.vertex2);
+        }
+
+        if (line.backsector) {
+            addEdge(line.backsector, *line.vertex2, *line.vertex1);
+        }
+    }
+
+    for (const auto& [key, balance] : vertexBalances) {
+        if (balance != 0)
+            return "the map has unclosed sectors";
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Hashes all of the map data used to build the PVS
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getInputHash(uint64_t& hashWord1, uint64_t& hashWord2) noexcept {
+    MD5 md5Hasher;
+
+    const auto addInt = [&](const int32_t val) noexcept {
+        md5Hasher.add(&val, sizeof(val));
+    };
+
+    const auto addSectorIdx = [&](const sector_t* const pSector) noexcept {
+        addInt((pSector) ? (int32_t)(pSector - gpSectors) : -1);
+    };
+
+    addInt(gNumSectors);
+    addInt(gNumVertexes);
+    addInt(gNumLines);
+    addInt(gNumSubsectors);
+    addInt(gNumSegs);
+
+    for (int32_t i = 0; i < gNumVertexes; ++i) {
+        addInt(gpVertexes[i].x);
+        addInt(gpVertexes[i].y);
+    }
+
+    for (int32_t i = 0; i < gNumLines; ++i) {
+        const line_t& line = gpLines[i];
+        addInt((int32_t)(line.vertex1 - gpVertexes));
+        addInt((int32_t)(line.vertex2 - gpVertexes));
+        addSectorIdx(line.frontsector);
+        addSectorIdx(line.backsector);
+    }
+
+    for (int32_t i = 0; i < gNumSubsectors; ++i) {
+        addSectorIdx(gpSubsectors[i].sector);
+        addInt(gpSubsectors[i].firstseg);
+        addInt(gpSubsectors[i].numsegs);
+    }
+
+    for (int32_t i = 0; i < gNumSegs; ++i) {
+        addSectorIdx(gpSegs[i].frontsector);
+    }
+
+    uint8_t md5[16] = {};
+    md5Hasher.getHash(md5);
+    std::memcpy(&hashWord1, md5, sizeof(uint64_t));
+    std::memcpy(&hashWord2, md5 + sizeof(uint64_t), sizeof(uint64_t));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gathers all of the portals in the map and the portals connected to each sector
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getPvsInput(PvsInput& input) noexcept {
+    input.numSectors = gNumSectors;
+
+    for (int32_t lineIdx = 0; lineIdx < gNumLines; ++lineIdx) {
+        const line_t& line = gpLines[lineIdx];
+
+        if (line.frontsector && line.backsector && (line.frontsector != line.backsector)) {
+            Portal& portal = input.portals.emplace_back();
+            portal.frontSector = (int32_t)(line.frontsector - gpSectors);
+            portal.backSector = (int32_t)(line.backsector - gpSectors);
+            portal.v1 = getVertexPos(*line.vertex1);
+            portal.v2 = getVertexPos(*line.vertex2);
+        }
+    }
+
+    const int32_t numPortals = (int32_t) input.portals.size();
+    input.sectorPortalsBeg.assign((size_t) gNumSectors + 1, 0);
+
+    for (const Portal& portal : input.portals) {
+        input.sectorPortalsBeg[portal.frontSector + 1]++;
+        input.sectorPortalsBeg[portal.backSector + 1]++;
+    }
+
+    for (int32_t secIdx = 0; secIdx < gNumSectors; ++secIdx) {
+        input.sectorPortalsBeg[secIdx + 1] += input.sectorPortalsBeg[secIdx];
+    }
+
+    std::vector<int32_t> fillIdxs(input.sectorPortalsBeg.begin(), input.sectorPortalsBeg.end() - 1);
+    input.sectorPortals.resize((size_t) numPortals * 2);
+
+    for (int32_t portalIdx = 0; portalIdx < numPortals; ++portalIdx) {
+        const Portal& portal = input.portals[portalIdx];
+        input.sectorPortals[fillIdxs[portal.frontSector]++] = portalIdx;
+        input.sectorPortals[fillIdxs[portal.backSector]++] = portalIdx;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Marks all sectors connected to the given sector by portals as visible.
+// This is the fallback used when there are too many portal chains to search for a sector.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void markConnectedSectorsVisible(const PvsInput& input, const int32_t srcSector, SearchState& state, uint64_t* const pVisRow) noexcept {
+    // Clear out any sectors marked by an abandoned search first, otherwise the flood fill would stop at them
+    std::fill(pVisRow, pVisRow + (input.numSectors + 63) / 64, 0);
+
+    std::vector<int32_t>& stack = state.floodStack;
+    stack.clear();
+    stack.push_back(srcSector);
+    pVisRow[srcSector / 64] |= (uint64_t) 1 << (srcSector % 64);
+
+    while (!stack.empty()) {
+        const int32_t secIdx = stack.back();
+        stack.pop_back();
+
+        for (int32_t i = input.sectorPortalsBeg[secIdx]; i < input.sectorPortalsBeg[secIdx + 1]; ++i) {
+            const Portal& portal = input.portals[input.sectorPortals[i]];
+            const int32_t nextSecIdx = (portal.frontSector == secIdx) ? portal.backSector : portal.frontSector;
+            uint64_t& visWord = pVisRow[nextSecIdx / 64];
+            const uint64_t visBit = (uint64_t) 1 << (nextSecIdx % 64);
+
+            if ((visWord & visBit) == 0) {
+                visWord |= visBit;
+                stack.push_back(nextSecIdx);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finds all sectors which might be visible from the given sector by searching the portal chains leading out of it.
+// Sets the bits for the visible sectors in the given row and returns 'false' if the search had to be abandoned due to taking too long.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool findVisibleSectors(const PvsInput& input, const int32_t srcSector, SearchState& state, uint64_t* const pVisRow) noexcept {
+    std::vector<ChainLink>& chain = state.chain;
+    std::vector<uint8_t>& portalsInChain = state.portalsInChain;
+    chain.clear();
+    portalsInChain.assign(input.portals.size(), 0);
+
+    ChainLink& srcLink = chain.emplace_back();
+    srcLink.sector = srcSector;
+    srcLink.nextPortalIdx = input.sectorPortalsBeg[srcSector];
+    srcLink.portal = -1;
+    srcLink.cone.type = ConeType::Full;
+    pVisRow[srcSector / 64] |= (uint64_t) 1 << (srcSector % 64);
+
+    uint32_t work = 0;
+
+    while (!chain.empty()) {
+        // Backtrack once all portals out of the sector at the end of the chain have been tried
+        ChainLink& lastLink = chain.back();
+
+        if (lastLink.nextPortalIdx >= input.sectorPortalsBeg[lastLink.sector + 1]) {
+            if (lastLink.portal >= 0) {
+                portalsInChain[lastLink.portal] = 0;
+            }
+
+            chain.pop_back();
+            continue;
+        }
+
+        // A sight line can only cross each portal once
+        const int32_t portalIdx = input.sectorPortals[lastLink.nextPortalIdx++];
+
+        if (portalsInChain[portalIdx])
+            continue;
+
+        // Orient the portal for travel out of the current sector: line sides are on the right of the line going from vertex 1 to vertex 2
+        const Portal& portal = input.portals[portalIdx];
+        const bool bLeavingFront = (portal.frontSector == lastLink.sector);
+        const int32_t nextSector = (bLeavingFront) ? portal.backSector : portal.frontSector;
+        const Vec2 l = (bLeavingFront) ? portal.v1 : portal.v2;
+        const Vec2 r = (bLeavingFront) ? portal.v2 : portal.v1;
+
+        // Narrow down the normals of sight lines which can pass through the chain with this portal on the end
+        NormalCone cone = lastLink.cone;
+        clipCone(cone, l - r);
+
+        for (size_t linkIdx = 1; (linkIdx < chain.size()) && (cone.type != ConeType::Empty); ++linkIdx) {
+            clipCone(cone, l - chain[linkIdx].portalR);
+            clipCone(cone, chain[linkIdx].portalL - r);
+        }
+
+        work += (uint32_t) chain.size() * 2;
+
+        if (work > MAX_SECTOR_WORK) {
+            markConnectedSectorsVisible(input, srcSector, state, pVisRow);
+            return false;
+        }
+
+        if (cone.type == ConeType::Empty)
+            continue;
+
+        // The next sector might be visible: extend the chain into it
+        pVisRow[nextSector / 64] |= (uint64_t) 1 << (nextSector % 64);
+        portalsInChain[portalIdx] = 1;
+
+        ChainLink& nextLink = chain.emplace_back();
+        nextLink.sector = nextSector;
+        nextLink.nextPortalIdx = input.sectorPortalsBeg[nextSector];
+        nextLink.portal = portalIdx;
+        nextLink.portalL = l;
+        nextLink.portalR = r;
+        nextLink.cone = cone;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the shortest distance between two line segments
+//------------------------------------------------------------------------------------------------------------------------------------------
+static double getLineDistance(const Vec2 a1, const Vec2 a2, const Vec2 b1, const Vec2 b2) noexcept {
+    // Do the lines intersect?
+    const auto side = [](const Vec2 p1, const Vec2 p2, const Vec2 p) noexcept {
+        const int64_t c = cross(p2 - p1, p - p1);
+        return (c > 0) ? 1 : ((c < 0) ? -1 : 0);
+    };
+
+    if ((side(a1, a2, b1) * side(a1, a2, b2) <= 0) && (side(b1, b2, a1) * side(b1, b2, a2) <= 0)) {
+        const bool bBoxesOverlap = (
+            (std::max(a1.x, a2.x) >= std::min(b1.x, b2.x)) && (std::max(b1.x, b2.x) >= std::min(a1.x, a2.x)) &&
+            (std::max(a1.y, a2.y) >= std::min(b1.y, b2.y)) && (std::max(b1.y, b2.y) >= std::min(a1.y, a2.y))
+        );
+
+        if (bBoxesOverlap)
+            return 0.0;
+    }
+
+    // Otherwise the closest point is at the end of one of the lines
+    const auto pointDist = [](const Vec2 p, const Vec2 s1, const Vec2 s2) noexcept {
+        const double dx = (double)(s2.x - s1.x);
+        const double dy = (double)(s2.y - s1.y);
+        const double lenSq = dx * dx + dy * dy;
+        const double t = (lenSq > 0) ? std::clamp(((double)(p.x - s1.x) * dx + (double)(p.y - s1.y) * dy) / lenSq, 0.0, 1.0) : 0.0;
+        const double ox = (double) p.x - ((double) s1.x + dx * t);
+        const double oy = (double) p.y - ((double) s1.y + dy * t);
+        return std::sqrt(ox * ox + oy * oy);
+    };
+
+    return std::min({ pointDist(a1, b1, b2), pointDist(a2, b1, b2), pointDist(b1, a1, a2), pointDist(b2, a1, a2) });
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finds which sectors are close enough to each other to be treated as the same sector at the ends of a sight line.
+// Sectors are always neighbors of themselves and of the sectors on the other side of their lines.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void findNeighborSectors(std::vector<uint64_t>& neighborRows, const int32_t rowWords) noexcept {
+    neighborRows.assign((size_t) gNumSectors * rowWords, 0);
+
+    const auto markNeighbors = [&](const int32_t sec1, const int32_t sec2) noexcept {
+        neighborRows[(size_t) sec1 * rowWords + sec2 / 64] |= (uint64_t) 1 << (sec2 % 64);
+        neighborRows[(size_t) sec2 * rowWords + sec1 / 64] |= (uint64_t) 1 << (sec1 % 64);
+    };
+
+    const auto getSectorIdx = [](const sector_t* const pSector) noexcept {
+        return (pSector) ? (int32_t)(pSector - gpSectors) : -1;
+    };
+
+    for (int32_t secIdx = 0; secIdx < gNumSectors; ++secIdx) {
+        markNeighbors(secIdx, secIdx);
+    }
+
+    // Put every line which borders a sector into the cells of a grid that it's bounding box (expanded by the neighbor distance) touches
+    Vec2 gridMin = { INT32_MAX, INT32_MAX };
+    Vec2 gridMax = { INT32_MIN, INT32_MIN };
+
+    for (int32_t lineIdx = 0; lineIdx < gNumLines; ++lineIdx) {
+        const line_t& line = gpLines[lineIdx];
+
+        if (!line.frontsector)
+            continue;
+
+        for (const vertex_t* const pVertex : { line.vertex1, line.vertex2 }) {
+            const Vec2 pos = getVertexPos(*pVertex);
+            gridMin = Vec2{ std::min(gridMin.x, pos.x), std::min(gridMin.y, pos.y) };
+            gridMax = Vec2{ std::max(gridMax.x, pos.x), std::max(gridMax.y, pos.y) };
+        }
+    }
+
+    if (gridMin.x > gridMax.x)
+        return;
+
+    const int64_t margin = (int64_t) std::ceil(NEIGHBOR_DIST);
+    gridMin = Vec2{ gridMin.x - margin, gridMin.y - margin };
+    const int32_t gridW = (int32_t)((gridMax.x + margin - gridMin.x) / NEIGHBOR_GRID_CELL_SIZE) + 1;
+    const int32_t gridH = (int32_t)((gridMax.y + margin - gridMin.y) / NEIGHBOR_GRID_CELL_SIZE) + 1;
+    std::vector<std::vector<int32_t>> gridCells((size_t) gridW * gridH);
+
+    for (int32_t lineIdx = 0; lineIdx < gNumLines; ++lineIdx) {
+        const line_t& line = gpLines[lineIdx];
+
+        if (!line.frontsector)
+            continue;
+
+        const Vec2 pos1 = getVertexPos(*line.vertex1);
+        const Vec2 pos2 = getVertexPos(*line.vertex2);
+        const int32_t cellLx = (int32_t)((std::min(pos1.x, pos2.x) - margin - gridMin.x) / NEIGHBOR_GRID_CELL_SIZE);
+        const int32_t cellLy = (int32_t)((std::min(pos1.y, pos2.y) - margin - gridMin.y) / NEIGHBOR_GRID_CELL_SIZE);
+        const int32_t cellHx = (int32_t)((std::max(pos1.x, pos2.x) + margin - gridMin.x) / NEIGHBOR_GRID_CELL_SIZE);
+        const int32_t cellHy = (int32_t)((std::max(pos1.y, pos2.y) + margin - gridMin.y) / NEIGHBOR_GRID_CELL_SIZE);
+
+        for (int32_t cellY = cellLy; cellY <= cellHy; ++cellY) {
+            for (int32_t cellX = cellLx; cellX <= cellHx; ++cellX) {
+                gridCells[(size_t) cellY * gridW + cellX].push_back(lineIdx);
+            }
+        }
+
+        // The sectors on either side of the line are neighbors
+        if (line.backsector) {
+            markNeighbors(getSectorIdx(line.frontsector), getSectorIdx(line.backsector));
+        }
+    }
+
+    // Check the distance between all pairs of lines which share a cell and mark their sectors as neighbors if close enough
+    const auto areNeighbors = [&](const int32_t sec1, const int32_t sec2) noexcept {
+        return ((sec1 < 0) || (sec2 < 0) || (neighborRows[(size_t) sec1 * rowWords + sec2 / 64] & ((uint64_t) 1 << (sec2 % 64))));
+    };
+
+    for (const std::vector<int32_t>& cellLines : gridCells) {
+        for (size_t i = 0; i < cellLines.size(); ++i) {
+            const line_t& line1 = gpLines[cellLines[i]];
+            const int32_t line1Secs[2] = { getSectorIdx(line1.frontsector), getSectorIdx(line1.backsector) };
+
+            for (size_t j = i + 1; j < cellLines.size(); ++j) {
+                const line_t& line2 = gpLines[cellLines[j]];
+                const int32_t line2Secs[2] = { getSectorIdx(line2.frontsector), getSectorIdx(line2.backsector) };
+
+                const bool bAllNeighbors = (
+                    areNeighbors(line1Secs[0], line2Secs[0]) && areNeighbors(line1Secs[0], line2Secs[1]) &&
+                    areNeighbors(line1Secs[1], line2Secs[0]) && areNeighbors(line1Secs[1], line2Secs[1])
+                );
+
+                if (bAllNeighbors)
+                    continue;
+
+                const double dist = getLineDistance(
+                    getVertexPos(*line1.vertex1), getVertexPos(*line1.vertex2), getVertexPos(*line2.vertex1), getVertexPos(*line2.vertex2)
+                );
+
+                if (dist > NEIGHBOR_DIST)
+                    continue;
+
+                for (const int32_t sec1 : line1Secs) {
+                    for (const int32_t sec2 : line2Secs) {
+                        if ((sec1 >= 0) && (sec2 >= 0)) {
+                            markNeighbors(sec1, sec2);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Builds the PVS reject bits for the current map (in the same layout as the reject map) and returns them.
+// Also returns how many sectors had too many portal chains to search.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> buildPvsRejectBits(uint32_t& numThreadsUsed, int32_t& numAbandonedSectors) noexcept {
+    const int32_t numSectors = gNumSectors;
+    const int32_t rowWords = (numSectors + 63) / 64;
+
+    PvsInput input = {};
+    getPvsInput(input);
+
+    // Search the portal chains out of each sector in parallel.
+    // Each thread takes the next unsearched sector and writes only to that sector's row of the visibility matrix.
+    std::vector<uint64_t> visRows((size_t) numSectors * rowWords, 0);
+    std::atomic<int32_t> nextSector = 0;
+    std::atomic<int32_t> numAbandoned = 0;
+
+    const auto threadMain = [&]() noexcept {
+        SearchState state = {};
+
+        for (int32_t secIdx = nextSector++; secIdx < numSectors; secIdx = nextSector++) {
+            if (!findVisibleSectors(input, secIdx, state, visRows.data() + (size_t) secIdx * rowWords)) {
+                numAbandoned++;
+            }
+        }
+    };
+
+    numThreadsUsed = std::clamp<uint32_t>(std::thread::hardware_concurrency(), 1, (uint32_t) numSectors);
+    std::vector<std::thread> threads;
+
+    for (uint32_t threadIdx = 1; threadIdx < numThreadsUsed; ++threadIdx) {
+        threads.emplace_back(threadMain);
+    }
+
+    threadMain();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    numAbandonedSectors = numAbandoned;
+
+    // Allow for the rounding of sight line end points: sector 'A' might see sector 'B' if any neighbor of 'A' can see any neighbor of 'B'.
+    // First expand the visible sectors for each sector to include their neighbors, then combine the expanded sets of 'A's neighbors.
+    std::vector<uint64_t> neighborRows;
+    findNeighborSectors(neighborRows, rowWords);
+
+    const auto orRow = [&](uint64_t* const pDstRow, const uint64_t* const pSrcRow) noexcept {
+        for (int32_t i = 0; i < rowWords; ++i) {
+            pDstRow[i] |= pSrcRow[i];
+        }
+    };
+
+    const auto forEachBit = [&](const uint64_t* const pRow, const auto& func) noexcept {
+        for (int32_t secIdx = 0; secIdx < numSectors; ++secIdx) {
+            if (pRow[secIdx / 64] & ((uint64_t) 1 << (secIdx % 64))) {
+                func(secIdx);
+            }
+        }
+    };
+
+    std::vector<uint64_t> expandedRows((size_t) numSectors * rowWords, 0);
+
+    for (int32_t secIdx = 0; secIdx < numSectors; ++secIdx) {
+        uint64_t* const pExpandedRow = expandedRows.data() + (size_t) secIdx * rowWords;
+
+        forEachBit(visRows.data() + (size_t) secIdx * rowWords, [&](const int32_t visSecIdx) noexcept {
+            orRow(pExpandedRow, neighborRows.data() + (size_t) visSecIdx * rowWords);
+        });
+    }
+
+    std::fill(visRows.begin(), visRows.end(), 0);
+
+    for (int32_t secIdx = 0; secIdx < numSectors; ++secIdx) {
+        uint64_t* const pVisRow = visRows.data() + (size_t) secIdx * rowWords;
+
+        forEachBit(neighborRows.data() + (size_t) secIdx * rowWords, [&](const int32_t neighborSecIdx) noexcept {
+            orRow(pVisRow, expandedRows.data() + (size_t) neighborSecIdx * rowWords);
+        });
+    }
+
+    // Every pair which is not visible gets a reject bit
+    std::vector<uint8_t> rejectBits(((size_t) numSectors * numSectors + 7) / 8, 0);
+
+    for (int32_t secIdx1 = 0; secIdx1 < numSectors; ++secIdx1) {
+        const uint64_t* const pVisRow = visRows.data() + (size_t) secIdx1 * rowWords;
+
+        for (int32_t secIdx2 = 0; secIdx2 < numSectors; ++secIdx2) {
+            if ((pVisRow[secIdx2 / 64] & ((uint64_t) 1 << (secIdx2 % 64))) == 0) {
+                const size_t rejectEntry = (size_t) secIdx1 * numSectors + secIdx2;
+                rejectBits[rejectEntry / 8] |= (uint8_t)(1 << (rejectEntry & 7));
+            }
+        }
+    }
+
+    return rejectBits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the path to the cache file for the specified map hash
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::string getCacheFilePath(const uint64_t mapHashWord1, const uint64_t mapHashWord2) noexcept {
+    const std::string userDataFolder = Utils::getOrCreateUserDataFolder();
+    char fileName[64];
+    std::snprintf(fileName, C_ARRAY_SIZE(fileName), "SECTORPVS_%016llX%016llX.BIN", (unsigned long long) mapHashWord1, (unsigned long long) mapHashWord2);
+    return userDataFolder + fileName;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes a cache file header for the current map
+//------------------------------------------------------------------------------------------------------------------------------------------
+static FileHeader makeFileHeader() noexcept {
+    FileHeader hdr = {};
+    std::memcpy(hdr.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    hdr.version = FILE_VERSION;
+    hdr.numSectors = gNumSectors;
+    hdr.mapHashWord1 = MapHash::gWord1;
+    hdr.mapHashWord2 = MapHash::gWord2;
+    getInputHash(hdr.inputHashWord1, hdr.inputHashWord2);
+    return hdr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tries to load the PVS reject bits for the current map from it's cache file, returning 'false' if there is no valid cache file
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool loadCacheFile(const FileHeader& expectedHdr, std::vector<uint8_t>& rejectBits) noexcept {
+    const std::string filePath = getCacheFilePath(expectedHdr.mapHashWord1, expectedHdr.mapHashWord2);
+    const FileData fileData = FileUtils::getContentsOfFile(filePath.c_str());
+    const size_t numRejectBytes = ((size_t) gNumSectors * gNumSectors + 7) / 8;
+
+    if ((!fileData.bytes) || (fileData.size != sizeof(FileHeader) + numRejectBytes))
+        return false;
+
+    if (std::memcmp(fileData.bytes.get(), &expectedHdr, sizeof(FileHeader)) != 0)
+        return false;
+
+    rejectBits.resize(numRejectBytes);
+    std::memcpy(rejectBits.data(), fileData.bytes.get() + sizeof(FileHeader), numRejectBytes);
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Saves the PVS reject bits for the current map to it's cache file
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void saveCacheFile(const FileHeader& hdr, const std::vector<uint8_t>& rejectBits) noexcept {
+    std::vector<std::byte> fileData(sizeof(FileHeader) + rejectBits.size());
+    std::memcpy(fileData.data(), &hdr, sizeof(FileHeader));
+    std::memcpy(fileData.data() + sizeof(FileHeader), rejectBits.data(), rejectBits.size());
+
+    const std::string filePath = getCacheFilePath(hdr.mapHashWord1, hdr.mapHashWord2);
+
+    if (!FileUtils::writeDataToFile(filePath.c_str(), fileData.data(), fileData.size())) {
+        std::printf("Sector PVS: failed to write cache file '%s'!\n", filePath.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the sector PVS is enabled
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isEnabled() noexcept {
+    return (Config::gbUseSectorPvs || ProgArgs::gbPrintSightStats);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Builds or loads the sector PVS for the current map (if enabled) and ORs it into the reject map, which is the given number of bytes.
+// Should be called once all map geometry is loaded and patched, and after the map hash has been finalized.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void applyToRejectMap(const int32_t rejectMapSize) noexcept {
+    gbCollectSightStats = ProgArgs::gbPrintSightStats;
+    gSightStats = {};
+    gAddedRejectBits.clear();
+
+    if (!isEnabled())
+        return;
+
+    const char* const unsupportedReason = checkMapIsSupported();
+
+    if (unsupportedReason) {
+        if (gbCollectSightStats) {
+            std::printf("Sector PVS: not used for this map because %s\n", unsupportedReason);
+        }
+
+        return;
+    }
+
+    // Load the PVS from the cache file or build it if there is no valid cache file
+    const auto startTime = std::chrono::steady_clock::now();
+    const FileHeader hdr = makeFileHeader();
+    std::vector<uint8_t> rejectBits;
+    const bool bLoadedFromCache = loadCacheFile(hdr, rejectBits);
+    uint32_t numThreadsUsed = 0;
+    int32_t numAbandonedSectors = 0;
+
+    if (!bLoadedFromCache) {
+        rejectBits = buildPvsRejectBits(numThreadsUsed, numAbandonedSectors);
+        saveCacheFile(hdr, rejectBits);
+    }
+
+    // Merge into the reject map and remember which bits were added.
+    // Only the part of the PVS covered by the reject map is used, in case the 'REJECT' lump is too small for the map.
+    const size_t numMergeBytes = std::min(rejectBits.size(), (size_t) std::max(rejectMapSize, 0));
+    gAddedRejectBits.assign(numMergeBytes, 0);
+    uint64_t numLumpRejects = 0;
+    uint64_t numAddedRejects = 0;
+
+    for (size_t i = 0; i < numMergeBytes; ++i) {
+        const uint8_t lumpBits = gpRejectMatrix[i];
+        gAddedRejectBits[i] = rejectBits[i] & (~lumpBits);
+        gpRejectMatrix[i] = lumpBits | rejectBits[i];
+        numLumpRejects += std::bitset<8>(lumpBits).count();
+        numAddedRejects += std::bitset<8>(gAddedRejectBits[i]).count();
+    }
+
+    if (gbCollectSightStats) {
+        const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        if (bLoadedFromCache) {
+            std::printf("Sector PVS: loaded from cache in %.2f ms\n", totalMs);
+        } else {
+            std::printf("Sector PVS: built in %.2f ms using %u threads", totalMs, numThreadsUsed);
+            std::printf(" (%d sectors, %d with too many portal chains to search)\n", gNumSectors, numAbandonedSectors);
+        }
+
+        const uint64_t numPairs = (uint64_t) gNumSectors * gNumSectors;
+        std::printf("Sector PVS: %llu of %llu sector pairs rejected by the 'REJECT' lump,", (unsigned long long) numLumpRejects, (unsigned long long) numPairs);
+        std::printf(" %llu more rejected by the PVS\n", (unsigned long long) numAddedRejects);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the specified reject map entry was set by the sector PVS rather than the map's 'REJECT' lump
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isPvsRejectEntry(const int32_t rejectMapEntry) noexcept {
+    const size_t byteIdx = (size_t) rejectMapEntry / 8;
+    return ((byteIdx < gAddedRejectBits.size()) && (gAddedRejectBits[byteIdx] & (1 << (rejectMapEntry & 7))));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records the result of a sight check BSP traversal for the sight check statistics.
+// The traversal is either a normal one, or one done to verify a pair rejected by the PVS (which would normally have been skipped).
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordTraversal(const bool bPvsReject, const bool bCanSee) noexcept {
+    if (bPvsReject) {
+        gSightStats.numPvsRejects++;
+        gSightStats.numPvsErrors += (bCanSee) ? 1 : 0;
+    } else {
+        gSightStats.numTraversals++;
+        gSightStats.numBlockedTraversals += (bCanSee) ? 0 : 1;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints the sight check statistics for the level that just ended, if they are being gathered
+//------------------------------------------------------------------------------------------------------------------------------------------
+void onLevelEnd(const int32_t mapNum) noexcept {
+    if (!gbCollectSightStats)
+        return;
+
+    const SightStats& stats = gSightStats;
+    const double pctMul = 100.0 / (double) std::max<uint64_t>(stats.numSightChecks, 1);
+
+    std::printf("Sight checks for MAP%02d: %llu\n", mapNum, (unsigned long long) stats.numSightChecks);
+    std::printf("  Rejected by 'REJECT' lump:   %llu (%.1f%%)\n", (unsigned long long) stats.numLumpRejects, (double) stats.numLumpRejects * pctMul);
+    std::printf("  Rejected by sector PVS:      %llu (%.1f%%) - BSP traversals avoided\n", (unsigned long long) stats.numPvsRejects, (double) stats.numPvsRejects * pctMul);
+    std::printf("  BSP traversals:              %llu (%.1f%%), %llu of which were blocked\n",
+        (unsigned long long) stats.numTraversals,
+        (double) stats.numTraversals * pctMul,
+        (unsigned long long) stats.numBlockedTraversals
+    );
+
+    if (stats.numPvsErrors > 0) {
+        std::printf("  Sector PVS errors:           %llu (pairs rejected by the PVS that could see each other!)\n", (unsigned long long) stats.numPvsErrors);
+    }
+
+    gSightStats = {};
+}
+
+END_NAMESPACE(SectorPvs)
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// An optional load-time pass which computes a conservative sector to sector potentially visible set (PVS) for the current map and ORs the
+// pairs which can never see each other into the reject map. Many maps ship with an empty or weak 'REJECT' lump, which means every sight
+// check made by 'P_CheckSight' does a full BSP traversal; pairs added to the reject map by this pass skip that traversal entirely.
+//
+// The PVS treats two-sided lines between different sectors as portals and only rejects a pair of sectors if no straight line can pass
+// through any chain of portals leading from one sector to the other. Sector heights are ignored since doors and lifts can open at any time.
+// To allow for the rounding done by 'P_CheckSight' to the sight line end points, pairs of sectors which are within a few units of each
+// other are treated as being the same when deciding visibility. The result is that sight results are always identical with or without
+// the pass, and so demos stay in sync. Maps which the PVS cannot safely be computed for (unclosed sectors, a BSP which disagrees with
+// the sector sides, or map coordinates big enough to overflow the sight check math) are left alone.
+//
+// The PVS is built using all available CPU cores and saved to a cache file in the user data folder, keyed by the map hash.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(SectorPvs)
+
+// Sight check statistics gathered for the current level, when enabled via the '-sightstats' program argument
+struct SightStats {
+    uint64_t    numSightChecks;         // Number of sight checks which got as far as the reject map lookup
+    uint64_t    numLumpRejects;         // Sight checks rejected by the map's original 'REJECT' lump
+    uint64_t    numPvsRejects;          // Sight checks rejected by pairs added by the PVS: these are the BSP traversals avoided
+    uint64_t    numTraversals;          // Sight checks which needed a BSP traversal (not including verification traversals for PVS rejects)
+    uint64_t    numBlockedTraversals;   // BSP traversals which found sight to be blocked
+    uint64_t    numPvsErrors;           // PVS rejects where verification found the targets could actually see each other (should be '0')
+};
+
+extern bool         gbCollectSightStats;     // Set when sight check statistics are being gathered for the current level
+extern SightStats   gSightStats;
+
+bool isEnabled() noexcept;
+void applyToRejectMap(const int32_t rejectMapSize) noexcept;
+bool isPvsRejectEntry(const int32_t rejectMapEntry) noexcept;
+void recordTraversal(const bool bPvsReject, const bool bCanSee) noexcept;
+void onLevelEnd(const int32_t mapNum) noexcept;
+
+END_NAMESPACE(SectorPvs)
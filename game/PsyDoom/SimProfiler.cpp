@@ -0,0 +1,351 @@
+#if PSYDOOM_SIM_PROFILER
+
+#include "SimProfiler.h"
+
+#include "Asserts.h"
+#include "Doom/Game/info.h"
+#include "Doom/Game/p_base.h"
+#include "Doom/Game/p_ceiling.h"
+#include "Doom/Game/p_doors.h"
+#include "Doom/Game/p_enemy.h"
+#include "Doom/Game/p_floor.h"
+#include "Doom/Game/p_lights.h"
+#include "Doom/Game/p_mobj.h"
+#include "Doom/Game/p_plats.h"
+#include "Doom/Game/p_pspr.h"
+#include "Doom/Game/p_spec.h"
+#include "Doom/Game/sprinfo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define SIM_PROFILER_USE_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+    #define SIM_PROFILER_USE_RDTSC 1
+#else
+    #define SIM_PROFILER_USE_RDTSC 0
+#endif
+
+BEGIN_NAMESPACE(SimProfiler)
+
+static constexpr uint32_t MAX_REPORT_ENTRIES = 40;          // Maximum number of functions listed in the report
+static constexpr uint32_t MAX_REPORT_MOBJ_TYPES = 25;       // Maximum number of map object types listed in the report
+
+// Identifies a profiled piece of code
+struct EntryKey {
+    uintptr_t   id;             // Function address, phase or script action number
+    int32_t     mobjType;       // Map object type the code ran for or '-1' if not applicable
+    Category    category;
+
+    inline bool operator == (const EntryKey& other) const noexcept {
+        return ((id == other.id) && (mobjType == other.mobjType) && (category == other.category));
+    }
+
+    struct Hasher {
+        inline size_t operator()(const EntryKey& key) const noexcept {
+            return std::hash<uint64_t>()((uint64_t) key.id ^ ((uint64_t) key.mobjType << 40) ^ ((uint64_t) key.category << 56));
+        }
+    };
+};
+
+// Time spent in a profiled piece of code
+struct EntryStats {
+    uint64_t    numCalls;
+    uint64_t    totalTime;      // Time spent in the code including other profiled code it calls
+    uint64_t    selfTime;       // Time spent in the code not including other profiled code it calls
+};
+
+// An entry in the stack of profiled code currently running
+struct StackFrame {
+    EntryStats*     pStats;
+    uint64_t        startTime;
+    uint64_t        childTime;      // Time spent so far in profiled code called by this code
+};
+
+// An entry in the profiler report
+struct ReportEntry {
+    EntryKey        key;
+    EntryStats      stats;
+};
+
+static std::unordered_map<EntryKey, EntryStats, EntryKey::Hasher>   gEntries;
+static std::vector<StackFrame>                                      gStack;
+
+static uint64_t                                     gStartTimestamp;    // Timestamp counter value when profiling started
+static std::chrono::steady_clock::time_point        gStartTime;         // Real time when profiling started, for timestamp calibration
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the timestamp counter used to measure time.
+// This is the CPU timestamp counter where available, otherwise nanoseconds from the steady clock.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline uint64_t readTimestamp() noexcept {
+    #if SIM_PROFILER_USE_RDTSC
+        return __rdtsc();
+    #else
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the name of a known profiled function, or 'nullptr' if the function is not known
+//------------------------------------------------------------------------------------------------------------------------------------------
+static const char* getFunctionName(const uintptr_t id) noexcept {
+    #define SIM_PROFILER_FUNC(Func) { fnId(&Func), #Func }
+
+    static const std::unordered_map<uintptr_t, const char*> FUNCTION_NAMES = {
+        // Thinkers and late calls
+        SIM_PROFILER_FUNC(P_MobjThinker), SIM_PROFILER_FUNC(P_RemoveMobj), SIM_PROFILER_FUNC(P_ExplodeMissile),
+        SIM_PROFILER_FUNC(L_MissileHit), SIM_PROFILER_FUNC(L_SkullBash), SIM_PROFILER_FUNC(T_MoveCeiling), SIM_PROFILER_FUNC(T_CustomDoor),
+        SIM_PROFILER_FUNC(T_VerticalDoor), SIM_PROFILER_FUNC(T_MoveFloor), SIM_PROFILER_FUNC(T_FireFlicker), SIM_PROFILER_FUNC(T_Glow),
+        SIM_PROFILER_FUNC(T_LightFlash), SIM_PROFILER_FUNC(T_StrobeFlash), SIM_PROFILER_FUNC(T_PlatRaise), SIM_PROFILER_FUNC(T_DelayedAction),
+        // Map object state actions
+        SIM_PROFILER_FUNC(A_BabyMetal), SIM_PROFILER_FUNC(A_BossDeath), SIM_PROFILER_FUNC(A_BrainAwake), SIM_PROFILER_FUNC(A_BrainDie),
+        SIM_PROFILER_FUNC(A_BrainExplode), SIM_PROFILER_FUNC(A_BrainPain), SIM_PROFILER_FUNC(A_BrainScream), SIM_PROFILER_FUNC(A_BrainSpit),
+        SIM_PROFILER_FUNC(A_BruisAttack), SIM_PROFILER_FUNC(A_BspiAttack), SIM_PROFILER_FUNC(A_CPosAttack), SIM_PROFILER_FUNC(A_CPosRefire),
+        SIM_PROFILER_FUNC(A_Chase), SIM_PROFILER_FUNC(A_CyberAttack), SIM_PROFILER_FUNC(A_Explode), SIM_PROFILER_FUNC(A_FaceTarget),
+        SIM_PROFILER_FUNC(A_Fall), SIM_PROFILER_FUNC(A_FatAttack1), SIM_PROFILER_FUNC(A_FatAttack2), SIM_PROFILER_FUNC(A_FatAttack3),
+        SIM_PROFILER_FUNC(A_FatRaise), SIM_PROFILER_FUNC(A_Fire), SIM_PROFILER_FUNC(A_FireCrackle), SIM_PROFILER_FUNC(A_HeadAttack),
+        SIM_PROFILER_FUNC(A_Hoof), SIM_PROFILER_FUNC(A_KeenDie), SIM_PROFILER_FUNC(A_Look), SIM_PROFILER_FUNC(A_Metal),
+        SIM_PROFILER_FUNC(A_Pain), SIM_PROFILER_FUNC(A_PainAttack), SIM_PROFILER_FUNC(A_PainDie), SIM_PROFILER_FUNC(A_PosAttack),
+        SIM_PROFILER_FUNC(A_SPosAttack), SIM_PROFILER_FUNC(A_SargAttack), SIM_PROFILER_FUNC(A_Scream), SIM_PROFILER_FUNC(A_SkelFist),
+        SIM_PROFILER_FUNC(A_SkelMissile), SIM_PROFILER_FUNC(A_SkelWhoosh), SIM_PROFILER_FUNC(A_SkullAttack), SIM_PROFILER_FUNC(A_SpawnFly),
+        SIM_PROFILER_FUNC(A_SpawnSound), SIM_PROFILER_FUNC(A_SpidAttack), SIM_PROFILER_FUNC(A_SpidRefire), SIM_PROFILER_FUNC(A_StartFire),
+        SIM_PROFILER_FUNC(A_Tracer), SIM_PROFILER_FUNC(A_TroopAttack), SIM_PROFILER_FUNC(A_VileAttack), SIM_PROFILER_FUNC(A_VileChase),
+        SIM_PROFILER_FUNC(A_VileStart), SIM_PROFILER_FUNC(A_VileTarget), SIM_PROFILER_FUNC(A_XScream), SIM_PROFILER_FUNC(A_BFGSpray),
+        // Player sprite (weapon) state actions
+        SIM_PROFILER_FUNC(A_BFGsound), SIM_PROFILER_FUNC(A_CheckReload), SIM_PROFILER_FUNC(A_CloseShotgun2), SIM_PROFILER_FUNC(A_FireBFG),
+        SIM_PROFILER_FUNC(A_FireCGun), SIM_PROFILER_FUNC(A_FireMissile), SIM_PROFILER_FUNC(A_FirePistol), SIM_PROFILER_FUNC(A_FirePlasma),
+        SIM_PROFILER_FUNC(A_FireShotgun), SIM_PROFILER_FUNC(A_FireShotgun2), SIM_PROFILER_FUNC(A_GunFlash), SIM_PROFILER_FUNC(A_Light0),
+        SIM_PROFILER_FUNC(A_Light1), SIM_PROFILER_FUNC(A_Light2), SIM_PROFILER_FUNC(A_LoadShotgun2), SIM_PROFILER_FUNC(A_Lower),
+        SIM_PROFILER_FUNC(A_OpenShotgun2), SIM_PROFILER_FUNC(A_Punch), SIM_PROFILER_FUNC(A_Raise), SIM_PROFILER_FUNC(A_ReFire),
+        SIM_PROFILER_FUNC(A_Saw), SIM_PROFILER_FUNC(A_WeaponReady),
+    };
+
+    #undef SIM_PROFILER_FUNC
+
+    const auto nameIter = FUNCTION_NAMES.find(id);
+    return (nameIter != FUNCTION_NAMES.end()) ? nameIter->second : nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Describes the given profiled piece of code for the report
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getEntryDescription(const EntryKey& key, char (&description)[64]) noexcept {
+    static constexpr const char* const PHASE_NAMES[] = {
+        "Scheduled script actions",
+        "P_RunThinkers",
+        "P_CheckSights",
+        "P_RunMobjBase",
+        "P_RunMobjLate",
+        "P_UpdateSpecials",
+        "P_PlayerThink",
+    };
+
+    static_assert(C_ARRAY_SIZE(PHASE_NAMES) == (size_t) Phase::NUM_PHASES);
+
+    if (key.category == Category::Phase) {
+        std::snprintf(description, sizeof(description), "%s", (key.id < (uintptr_t) Phase::NUM_PHASES) ? PHASE_NAMES[key.id] : "?");
+    }
+    else if (key.category == Category::ScriptAction) {
+        std::snprintf(description, sizeof(description), "Script action #%d", (int32_t) key.id);
+    }
+    else {
+        const char* const name = getFunctionName(key.id);
+
+        if (name) {
+            std::snprintf(description, sizeof(description), "%s", name);
+        } else {
+            std::snprintf(description, sizeof(description), "Function 0x%llX", (unsigned long long) key.id);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Describes the given map object type for the report, using the sprite for its spawn state and DoomEd number to identify it
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getMobjTypeDescription(const int32_t mobjType, char (&description)[32]) noexcept {
+    if ((mobjType < 0) || (mobjType >= gNumMobjInfo)) {
+        std::snprintf(description, sizeof(description), "-");
+        return;
+    }
+
+    const mobjinfo_t& info = gMobjInfo[mobjType];
+    const int32_t sprite = gStates[info.spawnstate].sprite;
+    const char* const spriteName = ((sprite >= 0) && (sprite < gNumSprites)) ? gSprites[sprite].name.chars : "????";
+    std::snprintf(description, sizeof(description), "%d %.4s (ed %d)", mobjType, spriteName, info.doomednum);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Starts profiling a piece of code.
+// Must be paired with a call to 'endEntry', and profiled code may be nested.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void beginEntry(const Category category, const uintptr_t id, const int32_t mobjType) noexcept {
+    if (gEntries.empty() && gStack.empty()) {
+        gStartTimestamp = readTimestamp();
+        gStartTime = std::chrono::steady_clock::now();
+    }
+
+    EntryStats& stats = gEntries[EntryKey{ id, mobjType, category }];
+
+    // Note: read the timestamp last so that profiler overhead is not counted for this code
+    StackFrame& frame = gStack.emplace_back();
+    frame.pStats = &stats;
+    frame.childTime = 0;
+    frame.startTime = readTimestamp();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finishes profiling the piece of code most recently passed to 'beginEntry'
+//------------------------------------------------------------------------------------------------------------------------------------------
+void endEntry() noexcept {
+    const uint64_t endTime = readTimestamp();
+    const StackFrame frame = gStack.back();
+    gStack.pop_back();
+
+    const uint64_t elapsed = endTime - frame.startTime;
+    EntryStats& stats = *frame.pStats;
+    stats.numCalls++;
+    stats.totalTime += elapsed;
+    stats.selfTime += elapsed - std::min(frame.childTime, elapsed);
+
+    if (!gStack.empty()) {
+        gStack.back().childTime += elapsed;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Clears all profiling data gathered so far
+//------------------------------------------------------------------------------------------------------------------------------------------
+void clear() noexcept {
+    ASSERT_LOG(gStack.empty(), "Profiling data must not be cleared while code is being profiled!");
+    gEntries.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints a report of where the game simulation spent its time and clears all profiling data gathered so far
+//------------------------------------------------------------------------------------------------------------------------------------------
+void printReport(const char* const title) noexcept {
+    if (gEntries.empty())
+        return;
+
+    // Figure out how to convert timestamps to real time
+    const uint64_t elapsedTimestamp = readTimestamp() - gStartTimestamp;
+    const double elapsedSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - gStartTime).count();
+    const double msPerTimestamp = (elapsedTimestamp > 0) ? (elapsedSecs * 1000.0) / (double) elapsedTimestamp : 0.0;
+
+    // Gather all the entries and totals, then sort by time
+    std::vector<ReportEntry> phases;
+    std::vector<ReportEntry> funcs;
+    std::unordered_map<int32_t, EntryStats> mobjTypeStats;
+    uint64_t totalSimTime = 0;
+    uint64_t numTics = 0;
+
+    for (const auto& [key, stats] : gEntries) {
+        if (key.category == Category::Phase) {
+            phases.push_back(ReportEntry{ key, stats });
+            totalSimTime += stats.totalTime;
+
+            if (key.id == (uintptr_t) Phase::RunThinkers) {
+                numTics = stats.numCalls;
+            }
+        } else {
+            funcs.push_back(ReportEntry{ key, stats });
+        }
+
+        if (key.mobjType >= 0) {
+            EntryStats& typeStats = mobjTypeStats[key.mobjType];
+            typeStats.selfTime += stats.selfTime;
+
+            if (key.category == Category::MobjThink) {
+                typeStats.numCalls += stats.numCalls;
+            }
+        }
+    }
+
+    const auto compareSelfTime = [](const ReportEntry& e1, const ReportEntry& e2) noexcept {
+        return (e1.stats.selfTime > e2.stats.selfTime);
+    };
+
+    std::sort(phases.begin(), phases.end(), [](const ReportEntry& e1, const ReportEntry& e2) noexcept { return (e1.key.id < e2.key.id); });
+    std::sort(funcs.begin(), funcs.end(), compareSelfTime);
+
+    std::vector<ReportEntry> mobjTypes;
+
+    for (const auto& [mobjType, stats] : mobjTypeStats) {
+        mobjTypes.push_back(ReportEntry{ EntryKey{ 0, mobjType, Category::MobjThink }, stats });
+    }
+
+    std::sort(mobjTypes.begin(), mobjTypes.end(), compareSelfTime);
+
+    // Print the report
+    const auto getPercent = [=](const uint64_t time) noexcept {
+        return (totalSimTime > 0) ? ((double) time * 100.0) / (double) totalSimTime : 0.0;
+    };
+
+    const auto getNsPerCall = [=](const EntryStats& stats) noexcept {
+        return (stats.numCalls > 0) ? ((double) stats.selfTime * msPerTimestamp * 1e6) / (double) stats.numCalls : 0.0;
+    };
+
+    static constexpr const char* const CATEGORY_NAMES[] = {
+        "Phase", "Thinker", "MobjThink", "Sight", "LateCall", "Action", "WeaponAction", "Script"
+    };
+
+    static_assert(C_ARRAY_SIZE(CATEGORY_NAMES) == (size_t) Category::NUM_CATEGORIES);
+
+    char description[64];
+    char mobjTypeDesc[32];
+
+    std::printf("Game simulation profile for %s: %llu tics, %.3f ms profiled\n", title, (unsigned long long) numTics, totalSimTime * msPerTimestamp);
+    std::printf("  Tic phases:\n");
+
+    for (const ReportEntry& entry : phases) {
+        getEntryDescription(entry.key, description);
+        std::printf("    %-28s %10.3f ms  %5.1f%%\n", description, entry.stats.totalTime * msPerTimestamp, getPercent(entry.stats.totalTime));
+    }
+
+    std::printf("  Top functions by self time:\n");
+    std::printf("    %-28s %-12s %-22s %10s %13s %6s %10s\n", "Function", "Category", "Mobj type", "Calls", "Self", "", "ns/call");
+
+    for (uint32_t i = 0; i < std::min<size_t>(funcs.size(), MAX_REPORT_ENTRIES); ++i) {
+        const ReportEntry& entry = funcs[i];
+        getEntryDescription(entry.key, description);
+        getMobjTypeDescription(entry.key.mobjType, mobjTypeDesc);
+        std::printf(
+            "    %-28s %-12s %-22s %10llu %10.3f ms %5.1f%% %10.1f\n",
+            description,
+            CATEGORY_NAMES[(uint32_t) entry.key.category],
+            mobjTypeDesc,
+            (unsigned long long) entry.stats.numCalls,
+            entry.stats.selfTime * msPerTimestamp,
+            getPercent(entry.stats.selfTime),
+            getNsPerCall(entry.stats)
+        );
+    }
+
+    std::printf("  Top map object types by self time (thinking, sight checks, late calls and actions):\n");
+    std::printf("    %-22s %14s %13s %6s\n", "Mobj type", "Mobj tics", "Self", "");
+
+    for (uint32_t i = 0; i < std::min<size_t>(mobjTypes.size(), MAX_REPORT_MOBJ_TYPES); ++i) {
+        const ReportEntry& entry = mobjTypes[i];
+        getMobjTypeDescription(entry.key.mobjType, mobjTypeDesc);
+        std::printf(
+            "    %-22s %14llu %10.3f ms %5.1f%%\n",
+            mobjTypeDesc,
+            (unsigned long long) entry.stats.numCalls,
+            entry.stats.selfTime * msPerTimestamp,
+            getPercent(entry.stats.selfTime)
+        );
+    }
+
+    clear();
+}
+
+END_NAMESPACE(SimProfiler)
+
+#endif  // #if PSYDOOM_SIM_PROFILER
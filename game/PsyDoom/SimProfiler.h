@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Game simulation profiler: only compiled in when the 'PSYDOOM_SIM_PROFILER' CMake option is enabled, since it adds overhead.
+//
+// Attributes the time spent running the game simulation to the thinker functions, map object 'late call' functions, state action
+// functions and Lua script actions which used it, broken down by map object type where relevant. A report sorted by time is printed at
+// the end of each demo played with '-playdemo'; use '-headless -maxspeed' to get consistent results that are not tied to the frame rate.
+//
+// Times are 'self' times which do not include the time spent in other profiled code (e.g a state action invoked by a thinker), so that
+// every bit of time is only counted once. Times are measured using the CPU timestamp counter where available.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if PSYDOOM_SIM_PROFILER
+
+BEGIN_NAMESPACE(SimProfiler)
+
+// What kind of code a profiled piece of code is
+enum class Category : uint8_t {
+    Phase,              // One of the phases of a game tic, identified by a 'Phase' value
+    Thinker,            // A thinker function: identified by the function address
+    MobjThink,          // 'P_MobjThinker' for a map object: identified by the function address
+    Sight,              // A sight check by 'P_CheckSights' for a map object: identified by the function address
+    LateCall,           // A map object 'late call' function: identified by the function address
+    Action,             // A map object state action function: identified by the function address
+    WeaponAction,       // A player sprite (weapon) state action function: identified by the function address
+    ScriptAction,       // A Lua script action: identified by the action number
+    NUM_CATEGORIES
+};
+
+// The phases of a game tic that are profiled
+enum class Phase : uint8_t {
+    ScheduledActions,
+    RunThinkers,
+    CheckSights,
+    RunMobjBase,
+    RunMobjLate,
+    UpdateSpecials,
+    PlayerThink,
+    NUM_PHASES
+};
+
+void beginEntry(const Category category, const uintptr_t id, const int32_t mobjType) noexcept;
+void endEntry() noexcept;
+void clear() noexcept;
+void printReport(const char* const title) noexcept;
+
+// Gives the id to use for a profiled function
+template <class FnT>
+inline uintptr_t fnId(const FnT pFunc) noexcept {
+    return reinterpret_cast<uintptr_t>(pFunc);
+}
+
+// Profiles the code in the scope it is declared in
+struct Scope {
+    inline Scope(const Category category, const uintptr_t id, const int32_t mobjType = -1) noexcept {
+        beginEntry(category, id, mobjType);
+    }
+
+    inline ~Scope() noexcept {
+        endEntry();
+    }
+};
+
+END_NAMESPACE(SimProfiler)
+
+#define SIM_PROFILER_CONCAT_IMPL(a, b) a##b
+#define SIM_PROFILER_CONCAT(a, b) SIM_PROFILER_CONCAT_IMPL(a, b)
+
+// Profiles the rest of the current scope under the given category, id and (optionally) map object type.
+// Compiles to nothing when the profiler is disabled, so arguments must not have side effects.
+#define SIM_PROFILE_SCOPE(...)\
+    const SimProfiler::Scope SIM_PROFILER_CONCAT(simProfilerScope, __LINE__)(__VA_ARGS__)
+
+#else
+
+#define SIM_PROFILE_SCOPE(...)
+
+#endif  // #if PSYDOOM_SIM_PROFILER
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A fixed capacity lock-free queue for passing elements from exactly one producer thread to exactly one consumer thread.
+// Neither side ever blocks: pushing to a full queue or popping from an empty queue simply fails.
+// The capacity MUST be a power of two, and the usable capacity is the full amount since read and write counters are never wrapped.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class T, uint32_t Capacity>
+class SpscQueue {
+public:
+    static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two!");
+    static_assert(std::is_trivially_copyable_v<T>, "Queue elements must be trivially copyable!");
+
+    inline SpscQueue() noexcept
+        : mReadCount(0)
+        , mWriteCount(0)
+        , mElems()
+    {
+    }
+
+    // Producer only: try to push an element to the queue and return 'false' if full
+    inline bool tryPush(const T& elem) noexcept {
+        const uint32_t writeCount = mWriteCount.load(std::memory_order_relaxed);
+        const uint32_t readCount = mReadCount.load(std::memory_order_acquire);
+
+        if (writeCount - readCount >= Capacity)
+            return false;
+
+        mElems[writeCount & (Capacity - 1)] = elem;
+        mWriteCount.store(writeCount + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only: try to pop an element from the queue and return 'false' if empty
+    inline bool tryPop(T& elem) noexcept {
+        const uint32_t readCount = mReadCount.load(std::memory_order_relaxed);
+        const uint32_t writeCount = mWriteCount.load(std::memory_order_acquire);
+
+        if (readCount == writeCount)
+            return false;
+
+        elem = mElems[readCount & (Capacity - 1)];
+        mReadCount.store(readCount + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only: get a pointer to the element at the front of the queue without popping, or null if the queue is empty.
+    // The element stays valid until it is popped.
+    inline const T* peek() const noexcept {
+        const uint32_t readCount = mReadCount.load(std::memory_order_relaxed);
+        const uint32_t writeCount = mWriteCount.load(std::memory_order_acquire);
+        return (readCount != writeCount) ? &mElems[readCount & (Capacity - 1)] : nullptr;
+    }
+
+    // Consumer only: pop the element at the front of the queue, which must exist (check with 'peek' first)
+    inline void popFront() noexcept {
+        mReadCount.store(mReadCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Get the number of elements in the queue.
+    // Note: this is only a snapshot if called from a thread other than the producer or consumer.
+    inline uint32_t size() const noexcept {
+        const uint32_t readCount = mReadCount.load(std::memory_order_acquire);
+        const uint32_t writeCount = mWriteCount.load(std::memory_order_acquire);
+        return writeCount - readCount;
+    }
+
+    // Clear the queue. Only safe to call when no other threads are pushing or popping.
+    inline void clear() noexcept {
+        mReadCount.store(0, std::memory_order_relaxed);
+        mWriteCount.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr uint32_t capacity() noexcept { return Capacity; }
+
+private:
+    // Note: keep the read and write counters on separate cache lines so the two threads don't fight over them
+    alignas(64) std::atomic<uint32_t>   mReadCount;
+    alignas(64) std::atomic<uint32_t>   mWriteCount;
+    alignas(64) T                       mElems[Capacity];
+};
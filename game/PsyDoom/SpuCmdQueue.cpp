@@ -0,0 +1,231 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A queue of SPU register writes sent from the game thread to the audio thread.
+// See the header for more details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "SpuCmdQueue.h"
+
+#include "ProgArgs.h"
+#include "PsxVm.h"
+#include "SpscQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+BEGIN_NAMESPACE(SpuCmdQueue)
+
+// How many commands can be pending at once.
+// If the queue fills up (e.g no audio device is consuming commands) then the game thread falls back to locking the SPU and applying directly.
+static constexpr uint32_t MAX_PENDING_CMDS = 4096;
+
+static SpscQueue<Cmd, MAX_PENDING_CMDS>     gCmdQueue;              // The queue of commands waiting to be applied
+static bool                                 gbQueueEnabled;         // If 'false' then commands are applied immediately with the SPU locked
+static std::atomic<uint64_t>                gNumCmdsSubmitted;      // Total number of commands submitted (modified only by the game thread)
+static std::atomic<uint64_t>                gNumCmdsApplied;        // Total number of commands applied (modified only with the SPU locked)
+
+// Stats: these are only modified with the SPU locked
+static uint64_t     gNumQueueOverflows;     // How many times the queue was full and a command had to be applied directly
+static int64_t      gMaxCmdLatency;         // Longest time a command waited in the queue before being applied (nanoseconds)
+static int64_t      gTotalCmdLatency;       // Total time all commands waited in the queue before being applied (nanoseconds)
+static uint64_t     gNumQueuedCmdsApplied;  // How many commands were applied via the queue
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the current time in nanoseconds for timestamping commands
+//------------------------------------------------------------------------------------------------------------------------------------------
+static int64_t getTimestamp() noexcept {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes the changes for a single command to the SPU. The SPU must be locked when calling this.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeCmdToSpu(const Cmd& cmd) noexcept {
+    Spu::Core& spu = PsxVm::gSpu;
+    Spu::Voice& voice = spu.pVoices[std::min<uint32_t>(cmd.voiceIdx, spu.numVoices - 1)];
+
+    switch (cmd.type) {
+        case CmdType::KeyOn:                    Spu::keyOn(voice);                      break;
+        case CmdType::KeyOff:                   Spu::keyOff(voice);                     break;
+        case CmdType::SetVoiceSampleRate:       voice.sampleRate = (uint16_t) cmd.u32;  break;
+        case CmdType::SetVoiceStartAddr:        voice.adpcmStartAddr8 = cmd.u32;        break;
+        case CmdType::SetVoiceRepeatAddr:       voice.adpcmRepeatAddr8 = cmd.u32;       break;
+        case CmdType::SetVoiceEnv:              voice.env = cmd.env;                    break;
+        case CmdType::SetVoiceVolLeft:          voice.volume.left = cmd.i16;            break;
+        case CmdType::SetVoiceVolRight:         voice.volume.right = cmd.i16;           break;
+        case CmdType::SetVoiceReverb:           voice.bDoReverb = cmd.b;                break;
+        case CmdType::SetMasterVolLeft:         spu.masterVol.left = cmd.i16;           break;
+        case CmdType::SetMasterVolRight:        spu.masterVol.right = cmd.i16;          break;
+        case CmdType::SetReverbVolLeft:         spu.reverbVol.left = cmd.i16;           break;
+        case CmdType::SetReverbVolRight:        spu.reverbVol.right = cmd.i16;          break;
+        case CmdType::SetExtInputVolLeft:       spu.extInputVol.left = cmd.i16;         break;
+        case CmdType::SetExtInputVolRight:      spu.extInputVol.right = cmd.i16;        break;
+        case CmdType::SetExtEnabled:            spu.bExtEnabled = cmd.b;                break;
+        case CmdType::SetExtReverbEnabled:      spu.bExtReverbEnable = cmd.b;           break;
+        case CmdType::SetReverbWriteEnabled:    spu.bReverbWriteEnable = cmd.b;         break;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Applies a single command submitted by the game thread to the SPU. The SPU must be locked when calling this.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void applyCmd(const Cmd& cmd) noexcept {
+    writeCmdToSpu(cmd);
+    gNumCmdsApplied.store(gNumCmdsApplied.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Submit a command to be applied by the audio thread.
+// If the queue is disabled or full then the SPU is locked (which applies all pending commands) and the command applied immediately.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void submitCmd(const Cmd& cmd) noexcept {
+    // If the audio thread is issuing the command (because it is running the music sequencer) then it already has the SPU locked.
+    // Apply anything still queued by the game thread so the ordering of changes is preserved, then apply the command directly.
+    // Note: commands applied this way are deliberately not counted, since the counters are for tracking commands from the game thread.
+    if (PsxVm::isAudioThread()) {
+        applyPendingCmds();
+        writeCmdToSpu(cmd);
+        return;
+    }
+
+    // Note: only the game thread modifies the count but the audio thread reads it (via 'LIBSPU_SpuSetKey'), hence the atomic release
+    gNumCmdsSubmitted.store(gNumCmdsSubmitted.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    if (gbQueueEnabled) {
+        if (gCmdQueue.tryPush(cmd))
+            return;
+
+        PsxVm::LockSpu spuLock;
+        gNumQueueOverflows++;
+        applyCmd(cmd);
+    } else {
+        PsxVm::LockSpu spuLock;
+        applyCmd(cmd);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Initialize the command queue; should be done before any audio is generated
+//------------------------------------------------------------------------------------------------------------------------------------------
+void init() noexcept {
+    gCmdQueue.clear();
+    gbQueueEnabled = (!ProgArgs::gbNoSpuCmdQueue);
+    gNumCmdsSubmitted = 0;
+    gNumCmdsApplied = 0;
+    gNumQueueOverflows = 0;
+    gMaxCmdLatency = 0;
+    gTotalCmdLatency = 0;
+    gNumQueuedCmdsApplied = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Shutdown the command queue; should be done after the audio thread is stopped
+//------------------------------------------------------------------------------------------------------------------------------------------
+void shutdown() noexcept {
+    gCmdQueue.clear();
+    gbQueueEnabled = false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Submit a command with an integer or address value
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submit(const CmdType type, const uint8_t voiceIdx, const uint32_t value) noexcept {
+    Cmd cmd = {};
+    cmd.timestamp = getTimestamp();
+    cmd.type = type;
+    cmd.voiceIdx = voiceIdx;
+    cmd.u32 = value;
+    submitCmd(cmd);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Submit a command setting a volume level
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submitVol(const CmdType type, const uint8_t voiceIdx, const int16_t vol) noexcept {
+    Cmd cmd = {};
+    cmd.timestamp = getTimestamp();
+    cmd.type = type;
+    cmd.voiceIdx = voiceIdx;
+    cmd.i16 = vol;
+    submitCmd(cmd);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Submit a command setting an on/off flag
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submitBool(const CmdType type, const uint8_t voiceIdx, const bool bValue) noexcept {
+    Cmd cmd = {};
+    cmd.timestamp = getTimestamp();
+    cmd.type = type;
+    cmd.voiceIdx = voiceIdx;
+    cmd.b = bValue;
+    submitCmd(cmd);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Submit a command setting the entire ADSR envelope for a voice
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submitEnv(const uint8_t voiceIdx, const Spu::AdsrEnvelope& env) noexcept {
+    Cmd cmd = {};
+    cmd.timestamp = getTimestamp();
+    cmd.type = CmdType::SetVoiceEnv;
+    cmd.voiceIdx = voiceIdx;
+    cmd.env = env;
+    submitCmd(cmd);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Apply all commands which are waiting in the queue, in the order they were submitted.
+// The SPU MUST be locked when calling this; this is done automatically whenever the SPU is locked and before each block of audio.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void applyPendingCmds() noexcept {
+    const Cmd* pCmd = gCmdQueue.peek();
+
+    if (!pCmd)
+        return;
+
+    const int64_t now = getTimestamp();
+
+    for (; pCmd; pCmd = gCmdQueue.peek()) {
+        const int64_t latency = now - pCmd->timestamp;
+        gMaxCmdLatency = std::max(gMaxCmdLatency, latency);
+        gTotalCmdLatency += latency;
+        gNumQueuedCmdsApplied++;
+
+        applyCmd(*pCmd);
+        gCmdQueue.popFront();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the command with the specified number (as returned by 'getNumCmdsSubmitted' after submitting it) has yet to be applied.
+// Once this returns 'false' the effects of the command are visible to the caller.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isCmdPending(const uint64_t cmdNum) noexcept {
+    return (cmdNum > gNumCmdsApplied.load(std::memory_order_acquire));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the total number of commands submitted so far by the game thread; can be called from any thread
+//------------------------------------------------------------------------------------------------------------------------------------------
+uint64_t getNumCmdsSubmitted() noexcept {
+    return gNumCmdsSubmitted.load(std::memory_order_acquire);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Print statistics for the command queue to standard out
+//------------------------------------------------------------------------------------------------------------------------------------------
+void printStats() noexcept {
+    PsxVm::LockSpu spuLock;
+    const double avgLatencyMs = (gNumQueuedCmdsApplied > 0) ? (double) gTotalCmdLatency / (double) gNumQueuedCmdsApplied / 1e6 : 0.0;
+
+    std::printf("SPU command queue: %s\n", (gbQueueEnabled) ? "enabled" : "disabled");
+    std::printf("  Commands submitted:      %llu\n", (unsigned long long) gNumCmdsSubmitted.load(std::memory_order_acquire));
+    std::printf("  Commands queued:         %llu\n", (unsigned long long) gNumQueuedCmdsApplied);
+    std::printf("  Queue overflows:         %llu\n", (unsigned long long) gNumQueueOverflows);
+    std::printf("  Avg queued latency:      %.3f ms\n", avgLatencyMs);
+    std::printf("  Max queued latency:      %.3f ms\n", (double) gMaxCmdLatency / 1e6);
+}
+
+END_NAMESPACE(SpuCmdQueue)
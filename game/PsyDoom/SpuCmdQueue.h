@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Macros.h"
+#include "Spu.h"
+
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A queue of SPU register writes sent from the game thread to the audio thread.
+//
+// Rather than locking the SPU and modifying it directly (which can stall the game thread for the duration of an entire audio buffer),
+// LIBSPU pushes the changes it wants to make into a lock-free queue and returns immediately. The audio thread then applies all pending
+// commands in order at the start of each block of samples it generates. Anything else which locks the SPU also applies pending commands
+// first so that all changes to the SPU are always seen in the order they were made.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(SpuCmdQueue)
+
+// What type of SPU register write a command is
+enum class CmdType : uint8_t {
+    KeyOn,                  // Voice: begin the attack phase
+    KeyOff,                 // Voice: begin the release phase
+    SetVoiceSampleRate,     // Voice: set 'sampleRate' via 'u32'
+    SetVoiceStartAddr,      // Voice: set 'adpcmStartAddr8' via 'u32'
+    SetVoiceRepeatAddr,     // Voice: set 'adpcmRepeatAddr8' via 'u32'
+    SetVoiceEnv,            // Voice: set the ADSR envelope via 'env'
+    SetVoiceVolLeft,        // Voice: set the left volume via 'i16'
+    SetVoiceVolRight,       // Voice: set the right volume via 'i16'
+    SetVoiceReverb,         // Voice: set whether reverb is enabled via 'b'
+    SetMasterVolLeft,       // Core: set the left master volume via 'i16'
+    SetMasterVolRight,      // Core: set the right master volume via 'i16'
+    SetReverbVolLeft,       // Core: set the left reverb volume via 'i16'
+    SetReverbVolRight,      // Core: set the right reverb volume via 'i16'
+    SetExtInputVolLeft,     // Core: set the left external input volume via 'i16'
+    SetExtInputVolRight,    // Core: set the right external input volume via 'i16'
+    SetExtEnabled,          // Core: set whether external input is enabled via 'b'
+    SetExtReverbEnabled,    // Core: set whether external input has reverb applied via 'b'
+    SetReverbWriteEnabled,  // Core: set whether reverb writes to the reverb work area are enabled via 'b'
+};
+
+// A single timestamped SPU register write
+struct Cmd {
+    int64_t     timestamp;      // When the command was issued in steady clock ticks; used for measuring latency
+    CmdType     type;           // What sort of command this is
+    uint8_t     voiceIdx;       // Which voice the command affects (voice commands only)
+
+    union {
+        uint32_t            u32;
+        int16_t             i16;
+        bool                b;
+        Spu::AdsrEnvelope   env;
+    };
+};
+
+void init() noexcept;
+void shutdown() noexcept;
+void submit(const CmdType type, const uint8_t voiceIdx, const uint32_t value) noexcept;
+void submitVol(const CmdType type, const uint8_t voiceIdx, const int16_t vol) noexcept;
+void submitBool(const CmdType type, const uint8_t voiceIdx, const bool bValue) noexcept;
+void submitEnv(const uint8_t voiceIdx, const Spu::AdsrEnvelope& env) noexcept;
+void applyPendingCmds() noexcept;
+bool isCmdPending(const uint64_t cmdNum) noexcept;
+uint64_t getNumCmdsSubmitted() noexcept;
+void printStats() noexcept;
+
+END_NAMESPACE(SpuCmdQueue)
@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Index of map sectors and lines by tag.
+// Each index is a list of (tag, sector or line index) pairs sorted by tag and then by index, so everything with a particular tag is in a
+// contiguous run of entries which is in ascending index order. Tags rarely change during gameplay so a sorted list works well here.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "TagIndex.h"
+
+#include "Asserts.h"
+#include "Doom/Game/p_setup.h"
+#include "Doom/Renderer/r_local.h"
+
+#include <algorithm>
+#include <vector>
+
+BEGIN_NAMESPACE(TagIndex)
+
+// An entry in a tag index
+struct Entry {
+    int32_t     tag;
+    int32_t     index;      // Index of the sector or line with the tag
+
+    inline bool operator < (const Entry& other) const noexcept {
+        return (tag != other.tag) ? (tag < other.tag) : (index < other.index);
+    }
+};
+
+static std::vector<Entry>   gSectorEntries;     // Entries for all sectors in the map, sorted by tag and then by index
+static std::vector<Entry>   gLineEntries;       // Entries for all lines in the map, sorted by tag and then by index
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Builds a tag index from the given list of map objects
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class T>
+static void buildEntries(std::vector<Entry>& entries, const T* const pObjects, const int32_t numObjects) noexcept {
+    entries.clear();
+    entries.reserve((size_t) numObjects);
+
+    for (int32_t i = 0; i < numObjects; ++i) {
+        entries.push_back(Entry{ pObjects[i].tag, i });
+    }
+
+    std::sort(entries.begin(), entries.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finds the next object in the given tag index with the specified tag, starting the search at the given object index + 1.
+// Returns the index of the next matching object found, or '-1' if there was no next matching object.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static int32_t findNextEntry(const std::vector<Entry>& entries, const int32_t tag, const int32_t searchStart) noexcept {
+    const auto entryIter = std::lower_bound(entries.begin(), entries.end(), Entry{ tag, searchStart + 1 });
+    return ((entryIter != entries.end()) && (entryIter->tag == tag)) ? entryIter->index : -1;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Moves the entry for the given object index from one tag to another in the given tag index
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void changeEntryTag(std::vector<Entry>& entries, const int32_t index, const int32_t oldTag, const int32_t newTag) noexcept {
+    if (oldTag == newTag)
+        return;
+
+    const auto oldEntryIter = std::lower_bound(entries.begin(), entries.end(), Entry{ oldTag, index });
+
+    if ((oldEntryIter != entries.end()) && (oldEntryIter->tag == oldTag) && (oldEntryIter->index == index)) {
+        entries.erase(oldEntryIter);
+    }
+
+    const Entry newEntry = { newTag, index };
+    entries.insert(std::lower_bound(entries.begin(), entries.end(), newEntry), newEntry);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Builds the tag index for the sectors and lines of the current map
+//------------------------------------------------------------------------------------------------------------------------------------------
+void build() noexcept {
+    buildEntries(gSectorEntries, gpSectors, gNumSectors);
+    buildEntries(gLineEntries, gpLines, gNumLines);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Find the next sector with the specified tag, starting the search at the given sector index + 1.
+// Returns the index of the next matching sector found, or '-1' if there was no next matching sector.
+//------------------------------------------------------------------------------------------------------------------------------------------
+int32_t findNextSector(const int32_t tag, const int32_t searchStart) noexcept {
+    ASSERT_LOG(gSectorEntries.size() == (size_t) gNumSectors, "Sector tag lookup before the tag index was built for this map!");
+    return findNextEntry(gSectorEntries, tag, searchStart);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Find the next line with the specified tag, starting the search at the given line index + 1.
+// Returns the index of the next matching line found, or '-1' if there was no next matching line.
+//------------------------------------------------------------------------------------------------------------------------------------------
+int32_t findNextLine(const int32_t tag, const int32_t searchStart) noexcept {
+    ASSERT_LOG(gLineEntries.size() == (size_t) gNumLines, "Line tag lookup before the tag index was built for this map!");
+    return findNextEntry(gLineEntries, tag, searchStart);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Changes the tag of the given sector and updates the index
+//------------------------------------------------------------------------------------------------------------------------------------------
+void setSectorTag(sector_t& sector, const int32_t tag) noexcept {
+    changeEntryTag(gSectorEntries, (int32_t)(&sector - gpSectors), sector.tag, tag);
+    sector.tag = tag;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Changes the tag of the given line and updates the index
+//------------------------------------------------------------------------------------------------------------------------------------------
+void setLineTag(line_t& line, const int32_t tag) noexcept {
+    changeEntryTag(gLineEntries, (int32_t)(&line - gpLines), line.tag, tag);
+    line.tag = tag;
+}
+
+END_NAMESPACE(TagIndex)
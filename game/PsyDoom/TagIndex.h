@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+struct line_t;
+struct sector_t;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Index of the sectors and lines in the current map by tag, so that line specials and scripts can find everything with a particular tag
+// without searching through the entire map. Lookups always give results in ascending sector or line index order, which is the same order
+// that searching through the entire map would give; this matters for demo playback since specials are spawned in that order.
+//
+// The index is built after the map is loaded (or a save is loaded) and must be kept up to date by using 'setSectorTag' and 'setLineTag'
+// to change tags during gameplay.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(TagIndex)
+
+void build() noexcept;
+int32_t findNextSector(const int32_t tag, const int32_t searchStart) noexcept;
+int32_t findNextLine(const int32_t tag, const int32_t searchStart) noexcept;
+void setSectorTag(sector_t& sector, const int32_t tag) noexcept;
+void setLineTag(line_t& line, const int32_t tag) noexcept;
+
+END_NAMESPACE(TagIndex)
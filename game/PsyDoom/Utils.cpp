@@ -102,11 +102,14 @@ void doPlatformUpdates() noexcept {
         return;
 
     // Always generate timer events and update the music sequencer.
-    // Note that for PsyDoom the sequencer is now manually updated here and it now uses a delta time rather than a fixed increment
-    PsxVm::generateTimerEvents();
+    // Note that for PsyDoom the sequencer is now manually updated here and it now uses a delta time rather than a fixed increment.
+    // If the audio thread is driving the sequencer however then there is nothing to do here.
+    if (!gbWess_AudioThreadTiming) {
+        PsxVm::generateTimerEvents();
 
-    if (gbWess_SeqOn) {
-        SeqEngine();
+        if (gbWess_SeqOn) {
+            SeqEngine();
+        }
     }
 
     // Only do these updates if enough time has elapsed.
@@ -6,6 +6,7 @@
 #include "Asserts.h"
 #include "Config/Config.h"
 #include "Gpu.h"
+#include "GpuCapture.h"
 #include "ProgArgs.h"
 #include "PsxVm.h"
 #include "Utils.h"
@@ -298,6 +299,9 @@ void getClassicFramebufferWindowRect(
 // Display the currently renderered PSX GPU frame to the screen; this is used by the classic renderer
 //------------------------------------------------------------------------------------------------------------------------------------------
 void displayFramebuffer() noexcept {
+    // Let any GPU capture in progress know the frame has ended: this is done in headless mode too
+    GpuCapture::onFrameEnd();
+
     // Ignore call in headless mode otherwise handle and ensure the window is updated after we do the swap
     if (ProgArgs::gbHeadlessMode)
         return;
@@ -219,8 +219,10 @@ void VideoBackend_SDL::copyPsxToSdlFramebufferTexture() noexcept {
     // Sanity checks
     ASSERT(mpFramebufferPixels);
 
-    // Copy the framebuffer
+    // Copy the framebuffer, making sure any queued drawing is done first
     Gpu::Core& gpu = PsxVm::gGpu;
+    Gpu::flush(gpu);
+
     const Gpu::Color16* const vramPixels = reinterpret_cast<const Gpu::Color16*>(gpu.pRam);
     uint32_t* pDstPixel = mpFramebufferPixels;
 
@@ -26,6 +26,8 @@
 #include "VTypes.h"
 #include "VVertexBufferSet.h"
 
+#include <cstring>
+
 BEGIN_NAMESPACE(VDrawing)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -67,6 +69,31 @@ static std::vector<VShaderUniforms_Draw> gFrameUniforms;
 // Drawing commands for the current frame
 static std::vector<DrawCmd> gFrameDrawCmds;
 
+// The draw stream that drawing on this thread is currently being recorded to, or null if drawing goes directly to the current frame
+static thread_local DrawStream* gpCurDrawStream;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Allocates the specified number of vertices for drawing, either from the current frame or the current draw stream (if recording one).
+// Note: may invalidate previously allocated vertex pointers, be careful!
+//------------------------------------------------------------------------------------------------------------------------------------------
+static VVertex_Draw* allocDrawVerts(const uint32_t numVerts) noexcept {
+    DrawStream* const pStream = gpCurDrawStream;
+
+    if (!pStream)
+        return gVertexBuffers_Draw.allocVerts<VVertex_Draw>(numVerts);
+
+    // Recording to a stream: vertices at the start of the stream use whatever pipeline is current when the stream is submitted
+    if (pStream->runs.empty()) {
+        pStream->runs.push_back({ (VPipelineType) -1, 0 });
+    }
+
+    pStream->runs.back().numVerts += numVerts;
+
+    const size_t oldNumVerts = pStream->verts.size();
+    pStream->verts.resize(oldNumVerts + numVerts);
+    return pStream->verts.data() + oldNumVerts;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Records all drawing commands for the current frame to a Vulkan command buffer
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -215,8 +242,18 @@ void endFrame(vgl::CmdBufferRecorder& cmdRec) noexcept {
 // Set which pipeline is being used for the 'draw' subpass with lazy early out if there is no change
 //------------------------------------------------------------------------------------------------------------------------------------------
 void setDrawPipeline(const VPipelineType type) noexcept {
-    // Only switch pipelines if we need to
     ASSERT((uint32_t) type < (uint32_t) VPipelineType::NUM_TYPES);
+
+    // If recording to a draw stream then just note the pipeline switch in the stream, if there is a change
+    if (DrawStream* const pStream = gpCurDrawStream) {
+        if (pStream->runs.empty() || (pStream->runs.back().pipelineType != type)) {
+            pStream->runs.push_back({ type, 0 });
+        }
+
+        return;
+    }
+
+    // Only switch pipelines if we need to
     const VPipelineType oldPipelineType = gCurDrawPipelineType;
 
     if (oldPipelineType == type)
@@ -236,6 +273,8 @@ void setDrawPipeline(const VPipelineType type) noexcept {
 // Set uniforms used by draw shaders, including the model/view/projection transform matrix
 //------------------------------------------------------------------------------------------------------------------------------------------
 void setDrawUniforms(const VShaderUniforms_Draw& uniforms) noexcept {
+    ASSERT_LOG(!gpCurDrawStream, "Can't set uniforms while recording a draw stream!");
+
     // Record the command to set the uniforms and save them for later
     DrawCmd& drawCmd = gFrameDrawCmds.emplace_back();
     drawCmd.type = DrawCmdType::SetUniforms;
@@ -274,8 +313,11 @@ Matrix4f computeTransformMatrixFor3D(const float viewX, const float viewY, const
     // This matches the projection that the original PSX Doom used, with allowance for widescreen:
     constexpr float STATUS_BAR_H = SCREEN_H - VIEW_3D_H;
 
+    // Note: there is no framebuffer if nothing is being rendered (headless mode), in which case don't do any widescreen scaling.
     const bool bAllowWidescreen = Config::gbVulkanWidescreenEnabled;
-    const float widescreenScale = std::max((float) VRenderer::gFramebufferW / (float) VRenderer::gPsxCoordsFbW, 1.0f);
+    const float widescreenScale = (VRenderer::gPsxCoordsFbW > 0.0f) ?
+        std::max((float) VRenderer::gFramebufferW / (float) VRenderer::gPsxCoordsFbW, 1.0f) :
+        1.0f;
     const float viewLx = (bAllowWidescreen) ? -widescreenScale : -1.0f;
     const float viewRx = (bAllowWidescreen) ? +widescreenScale : +1.0f;
     const float viewTy = (HALF_VIEW_3D_H - (float) Video::gTopOverscan) / (float) HALF_SCREEN_W;
@@ -299,6 +341,8 @@ Matrix4f computeTransformMatrixFor3D(const float viewX, const float viewY, const
 // The primitives are drawn with whatever pipeline is currently bound.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void endCurrentDrawBatch() noexcept {
+    ASSERT_LOG(!gpCurDrawStream, "Can't end draw batches while recording a draw stream!");
+
     // Ignore if there are no vertices in the current batch
     if (gVertexBuffers_Draw.curBatchSize <= 0)
         return;
@@ -311,6 +355,60 @@ void endCurrentDrawBatch() noexcept {
     gVertexBuffers_Draw.endCurrentDrawBatch();
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Clears the contents of the draw stream
+//------------------------------------------------------------------------------------------------------------------------------------------
+void DrawStream::clear() noexcept {
+    verts.clear();
+    runs.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Begins recording all drawing done on the calling thread to the specified draw stream, instead of adding it to the current frame.
+// The stream is not cleared beforehand, so new drawing is appended to whatever the stream already contains.
+//
+// Streams can be nested: the stream that was being recorded to before (if any) is returned and should be passed to 'endDrawStream'.
+//------------------------------------------------------------------------------------------------------------------------------------------
+DrawStream* beginDrawStream(DrawStream& stream) noexcept {
+    ASSERT_LOG(&stream != gpCurDrawStream, "Already recording to this draw stream!");
+    DrawStream* const pPrevStream = gpCurDrawStream;
+    gpCurDrawStream = &stream;
+    return pPrevStream;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Ends recording drawing to the draw stream for the calling thread.
+// Drawing goes to the given previous stream after this (as returned by 'beginDrawStream') or to the current frame if there is none.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void endDrawStream(DrawStream* const pPrevStream) noexcept {
+    ASSERT_LOG(gpCurDrawStream, "Not recording a draw stream on this thread!");
+    gpCurDrawStream = pPrevStream;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Adds all of the drawing recorded to a draw stream to the current frame, as if the drawing functions were called directly.
+// If a draw stream is being recorded on this thread then the drawing is appended to that stream instead.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void submitDrawStream(const DrawStream& stream) noexcept {
+    ASSERT(&stream != gpCurDrawStream);
+    const VVertex_Draw* pSrcVerts = stream.verts.data();
+
+    for (const DrawStream::PipelineRun& run : stream.runs) {
+        // Note: the pipeline switch is lazy like normal and is skipped if the pipeline is already in use
+        if (run.pipelineType != (VPipelineType) -1) {
+            setDrawPipeline(run.pipelineType);
+        }
+
+        if (run.numVerts > 0) {
+            VVertex_Draw* const pDstVerts = allocDrawVerts(run.numVerts);
+            std::memcpy(pDstVerts, pSrcVerts, sizeof(VVertex_Draw) * run.numVerts);
+            pSrcVerts += run.numVerts;
+        }
+    }
+
+    ASSERT(pSrcVerts == stream.verts.data() + stream.verts.size());
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Add a 2D/UI line to the 'draw' subpass
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -324,7 +422,7 @@ void addUILine(
     const uint8_t b
 ) noexcept {
     // Fill in the vertices, starting first with common parameters
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(2);
+    VVertex_Draw* const pVerts = allocDrawVerts(2);
 
     for (uint32_t i = 0; i < 2; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -360,7 +458,7 @@ void addFlatColoredTriangle(
     const uint8_t g,
     const uint8_t b
 ) noexcept {
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(3);
+    VVertex_Draw* const pVerts = allocDrawVerts(3);
 
     for (uint32_t i = 0; i < 3; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -399,7 +497,7 @@ void addFlatColoredQuad(
     const uint8_t g,
     const uint8_t b
 ) noexcept {
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(6);
+    VVertex_Draw* const pVerts = allocDrawVerts(6);
 
     for (uint32_t i = 0; i < 6; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -443,7 +541,7 @@ void addUISprite(
     const uint16_t texWinH
 ) noexcept {
     // Fill in the vertices, starting first with common parameters
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(6);
+    VVertex_Draw* const pVerts = allocDrawVerts(6);
 
     for (uint32_t i = 0; i < 6; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -530,7 +628,7 @@ void addWorldTriangle(
     const uint8_t stMulA
 ) noexcept {
     // Fill in the vertices, starting first with common parameters
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(3);
+    VVertex_Draw* const pVerts = allocDrawVerts(3);
 
     for (uint32_t i = 0; i < 3; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -586,7 +684,7 @@ void addWorldQuad(
     const uint8_t stMulA
 ) noexcept {
     // Fill in the vertices, starting first with the parameters that are the same for all vertices
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(6);
+    VVertex_Draw* const pVerts = allocDrawVerts(6);
 
     for (uint32_t i = 0; i < 6; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -645,7 +743,7 @@ void addWorldInfiniteSkyWall(
 ) noexcept {
     // Fill in the vertices, starting first with common parameters.
     // Note: we store the sky U offset based on player rotation in the U coordinate.
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(6);
+    VVertex_Draw* const pVerts = allocDrawVerts(6);
 
     for (uint32_t i = 0; i < 6; ++i) {
         VVertex_Draw& vert = pVerts[i];
@@ -723,7 +821,7 @@ void addWorldSkyQuad(
 ) noexcept {
     // Fill in the vertices, starting first with common parameters.
     // Note: we store the sky U offset based on player rotation in the U coordinate.
-    VVertex_Draw* const pVerts = gVertexBuffers_Draw.allocVerts<VVertex_Draw>(6);
+    VVertex_Draw* const pVerts = allocDrawVerts(6);
 
     for (uint32_t i = 0; i < 6; ++i) {
         VVertex_Draw& vert = pVerts[i];
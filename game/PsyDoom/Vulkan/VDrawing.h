@@ -6,6 +6,7 @@
 #include "Matrix4.h"
 
 #include <cstdint>
+#include <vector>
 
 namespace vgl {
     class BaseRenderPass;
@@ -24,6 +25,7 @@ enum class VLightDimMode : uint8_t;
 enum class VPipelineType : uint8_t;
 enum class VPipelineType : uint8_t;
 struct VShaderUniforms_Draw;
+struct VVertex_Draw;
 
 BEGIN_NAMESPACE(VDrawing)
 
@@ -34,6 +36,25 @@ struct AddWorldQuadVert {
     uint8_t     r, g, b;
 };
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Holds vertices and pipeline switches recorded by the drawing functions while the stream is active (see 'beginDrawStream').
+// Streams can be recorded on any thread and are added to the current frame later via 'submitDrawStream', which must be done on the
+// main thread. Submitting a stream gives exactly the same result as calling the drawing functions directly.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct DrawStream {
+    // A series of vertices which are drawn after switching to the given pipeline.
+    // The pipeline is '-1' for vertices which are drawn with whatever pipeline was in use before the stream.
+    struct PipelineRun {
+        VPipelineType   pipelineType;
+        uint32_t        numVerts;
+    };
+
+    std::vector<VVertex_Draw>   verts;      // All vertices recorded, in order
+    std::vector<PipelineRun>    runs;       // Which pipeline each range of vertices in the list is drawn with
+
+    void clear() noexcept;
+};
+
 void init(vgl::LogicalDevice& device, vgl::BaseTexture& vramTex) noexcept;
 void shutdown() noexcept;
 void beginFrame(const uint32_t ringbufferIdx) noexcept;
@@ -43,6 +64,9 @@ void setDrawUniforms(const VShaderUniforms_Draw& uniforms) noexcept;
 Matrix4f computeTransformMatrixForUI(const bool bAllowWidescreen) noexcept;
 Matrix4f computeTransformMatrixFor3D(const float viewX, const float viewY, const float viewZ, const float viewAngle) noexcept;
 void endCurrentDrawBatch() noexcept;
+DrawStream* beginDrawStream(DrawStream& stream) noexcept;
+void endDrawStream(DrawStream* const pPrevStream) noexcept;
+void submitDrawStream(const DrawStream& stream) noexcept;
 
 void addUILine(
     const float x1,
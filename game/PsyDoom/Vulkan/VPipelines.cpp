@@ -7,16 +7,26 @@
 
 #include "DescriptorSetLayout.h"
 #include "FatalErrors.h"
+#include "FileUtils.h"
 #include "LogicalDevice.h"
 #include "PhysicalDevice.h"
 #include "Pipeline.h"
+#include "PipelineCache.h"
 #include "PipelineLayout.h"
 #include "PsyDoom/Config/Config.h"
+#include "PsyDoom/ProgArgs.h"
+#include "PsyDoom/Utils.h"
 #include "Sampler.h"
 #include "ShaderModule.h"
 #include "VRenderPath_Crossfade.h"
 #include "VRenderPath_Main.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
 BEGIN_NAMESPACE(VPipelines)
 
 // The raw SPIRV binary code for the shaders
@@ -36,6 +46,9 @@ BEGIN_NAMESPACE(VPipelines)
 #include "SPIRV_world_frag.bin.h"
 #include "SPIRV_world_vert.bin.h"
 
+// Name of the file in the user data folder which holds the pipeline cache contents from the previous run
+static constexpr const char* const PIPELINE_CACHE_FILE_NAME = "vulkan_pipeline_cache.bin";
+
 // Vertex binding descriptions
 const VkVertexInputBindingDescription gVertexBindingDesc_draw           = { 0, sizeof(VVertex_Draw), VK_VERTEX_INPUT_RATE_VERTEX };
 const VkVertexInputBindingDescription gVertexBindingDesc_msaaResolve    = { 0, sizeof(VVertex_MsaaResolve), VK_VERTEX_INPUT_RATE_VERTEX };
@@ -136,6 +149,56 @@ vgl::PipelineDepthStencilState gDepthState_disabled;        // No depth/stencil
 // The pipelines themselves
 vgl::Pipeline gPipelines[(size_t) VPipelineType::NUM_TYPES];
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the path to the file holding the contents of the pipeline cache
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::string getPipelineCacheFilePath() noexcept {
+    const std::string userDataFolder = Utils::getOrCreateUserDataFolder();
+    return userDataFolder + PIPELINE_CACHE_FILE_NAME;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Initializes the device's pipeline cache using the contents saved by the previous run, if there are any.
+// The pipeline cache is only an optimization, so failure to create it is not a fatal error.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void initPipelineCache(vgl::LogicalDevice& device) noexcept {
+    const std::string filePath = getPipelineCacheFilePath();
+    const FileData fileData = FileUtils::getContentsOfFile(filePath.c_str());
+
+    if (!device.getPipelineCache().init(device, fileData.bytes.get(), fileData.size)) {
+        std::printf("PsyDoom: WARNING: failed to create a Vulkan pipeline cache! Pipeline creation may be slower.\n");
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Saves the contents of the device's pipeline cache so that it can be reused on the next run.
+// The file is only rewritten if the contents have changed since they were last saved.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void savePipelineCache(vgl::LogicalDevice& device) noexcept {
+    vgl::PipelineCache& pipelineCache = device.getPipelineCache();
+
+    if (!pipelineCache.isValid())
+        return;
+
+    std::vector<std::byte> cacheData;
+
+    if (!pipelineCache.getData(cacheData))
+        return;
+
+    const std::string filePath = getPipelineCacheFilePath();
+    const FileData oldFileData = FileUtils::getContentsOfFile(filePath.c_str());
+
+    const bool bCacheChanged = (
+        (!oldFileData.bytes) ||
+        (oldFileData.size != cacheData.size()) ||
+        (std::memcmp(oldFileData.bytes.get(), cacheData.data(), cacheData.size()) != 0)
+    );
+
+    if (bCacheChanged && (!FileUtils::writeDataToFile(filePath.c_str(), cacheData.data(), cacheData.size()))) {
+        std::printf("PsyDoom: WARNING: failed to write the Vulkan pipeline cache file '%s'!\n", filePath.c_str());
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Initialize a single shader and raise a fatal error if it fails
 //-----------------------------------------------------------------------------------------------------------------------------------------
@@ -542,6 +605,7 @@ static void initDrawPipeline(
 //------------------------------------------------------------------------------------------------------------------------------------------
 void initPipelineComponents(vgl::LogicalDevice& device, const uint32_t numSamples) noexcept {
     // Create all pipeline creation inputs and states
+    initPipelineCache(device);
     initShaders(device);
     initSamplers(device);
     initDescriptorSetLayouts(device);
@@ -563,6 +627,9 @@ void initPipelines(
     VRenderPath_Crossfade& crossfadeRPath,
     const uint32_t numSamples
 ) noexcept {
+    // Time how long pipeline creation takes, if load timings are being printed
+    const auto startTime = std::chrono::steady_clock::now();
+
     // Create all of the main drawing pipelines
     initDrawPipeline(VPipelineType::Lines, mainRPath, gShaders_colored, gInputAS_lineList, gRasterState_noCull, gBlendState_noBlend, gDepthState_disabled, false, true);
     initDrawPipeline(VPipelineType::Colored, mainRPath, gShaders_colored, gInputAS_triList, gRasterState_noCull, gBlendState_noBlend, gDepthState_disabled, false, true);
@@ -631,6 +698,21 @@ void initPipelines(
         gInputAS_triList, gRasterState_noCull,
         gBlendState_noBlend, gDepthState_disabled, gMultisampleState_perSettingsEdgeOnly
     );
+
+    // Print the time taken if required and save any newly compiled pipelines for next time
+    vgl::LogicalDevice& device = *mainRPath.getRenderPass().getDevice();
+
+    if (ProgArgs::gbPrintLoadTimings) {
+        const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        std::printf(
+            "Vulkan pipeline creation took %.3f ms (%s)\n",
+            time * 1000.0,
+            (device.getPipelineCache().usedInitialData()) ? "using the saved pipeline cache" : "no saved pipeline cache"
+        );
+    }
+
+    savePipelineCache(device);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -105,7 +105,8 @@ static void initPlaqueTex(vgl::LogicalDevice& device, const texture_t& tex, cons
 
     uint32_t* const pPlaquePixels = (uint32_t*) gPlaqueTex.lock();
 
-    // Populate all of those pixels
+    // Populate all of those pixels, making sure any queued drawing to VRAM is done first
+    Gpu::flush(PsxVm::gGpu);
     const uint16_t* const pVram = PsxVm::gGpu.pRam;
     const uint32_t vramWidth = PsxVm::gGpu.ramPixelW;
     const uint16_t* const pClut = pVram + ((clutY * vramWidth) + clutX);
@@ -149,6 +149,8 @@ void VRenderPath_Psx::endFrame(vgl::Swapchain& swapchain, vgl::CmdBufferRecorder
 
     {
         Gpu::Core& gpu = PsxVm::gGpu;
+        Gpu::flush(gpu);    // Make sure any queued drawing is done first
+
         const uint16_t* pSrcPixels = gpu.pRam + (gpu.displayAreaX + (uintptr_t) gpu.displayAreaY * gpu.ramPixelW);
         const std::byte* const pDstTextureBytes = psxFbTexture.lock();
 
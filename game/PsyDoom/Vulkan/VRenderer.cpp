@@ -607,8 +607,7 @@ void init() noexcept {
             oldVramMiB
         );
 
-        Gpu::destroyCore(PsxVm::gGpu);
-        Gpu::initCore(PsxVm::gGpu, 4096, 4096);
+        PsxVm::initGpu(4096, 4096);
     }
 
     // Initialize the texture representing PSX VRAM and clear it all to black.
@@ -891,7 +890,9 @@ void pushPsxVramUpdates(const uint16_t rectLx, const uint16_t rectRx, const uint
     const uint32_t copyRectH = (uint32_t) rectBy + 1 - rectTy;
     const uint32_t copyRowSize = copyRectW * sizeof(uint16_t);
 
-    // Lock the required region of the texture and copy in the updates, row by row
+    // Lock the required region of the texture and copy in the updates, row by row.
+    // Make sure any queued drawing to VRAM is done first.
+    Gpu::flush(psxGpu);
     uint16_t* pDstBytes = (uint16_t*) gPsxVramTexture.lock(rectLx, rectTy, 0, 0, copyRectW, copyRectH, 1, 1);
     const uint16_t* pSrcBytes = psxGpu.pRam + rectLx + ((uintptr_t) rectTy * vramW);
 
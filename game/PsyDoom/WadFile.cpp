@@ -6,6 +6,7 @@
 #include "WadUtils.h"
 
 #include <cctype>
+#include <cstring>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Header for a WAD file: constains high level information about the contents of the WAD
@@ -36,6 +37,7 @@ WadFile::WadFile() noexcept
     : mNumLumps(0)
     , mLumpNames{}
     , mLumps{}
+    , mLumpIndex()
     , mFileReader()
 {
 }
@@ -47,6 +49,7 @@ WadFile::WadFile(WadFile&& other) noexcept
     : mNumLumps(other.mNumLumps)
     , mLumpNames(std::move(other.mLumpNames))
     , mLumps(std::move(other.mLumps))
+    , mLumpIndex(std::move(other.mLumpIndex))
     , mFileReader(std::move(other.mFileReader))
 {
     other.mNumLumps = 0;
@@ -66,6 +69,7 @@ void WadFile::close() noexcept {
     purgeAllLumps();
 
     mFileReader.close();
+    mLumpIndex.clear();
     mLumps.reset();
     mLumpNames.reset();
     mNumLumps = 0;
@@ -97,15 +101,7 @@ void WadFile::open(const CdFileId fileId, const RemapWadLumpNameFn lumpNameRemap
 // Note: when searching the 'compressed' flag bit in the 1st byte of candidate lump names is ignored.
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t WadFile::findLumpIdx(const WadLumpName lumpName, const int32_t searchStartIdx) const noexcept {
-    const int32_t numLumps = mNumLumps;
-    const WadLumpName* const pLumpNames = mLumpNames.get();
-
-    for (int32_t i = searchStartIdx; i < numLumps; ++i) {
-        if ((pLumpNames[i].word() & WAD_LUMPNAME_MASK) == lumpName.word())
-            return i;
-    }
-
-    return -1;
+    return mLumpIndex.findLumpIdx(lumpName.word(), searchStartIdx);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -118,8 +114,15 @@ void WadFile::purgeCachedLump(const int32_t lumpIdx) noexcept {
     void* const pCachedData = lump.pCachedData;
 
     if (pCachedData) {
-        Z_Free2(*gpMainMemZone, pCachedData);
-        ASSERT_LOG(!lump.pCachedData, "Z_Free2 should clear the pointer field pointing to the freed memory block!");
+        // PsyDoom: lumps pointing into the WAD file's memory mapping can just be dropped, there is nothing to free
+        if (lump.bIsMapped) {
+            lump.pCachedData = nullptr;
+            lump.bIsMapped = false;
+        } else {
+            Z_Free2(*gpMainMemZone, pCachedData);
+            ASSERT_LOG(!lump.pCachedData, "Z_Free2 should clear the pointer field pointing to the freed memory block!");
+        }
+
         lump.bIsUncompressed = false;
     }
 }
@@ -136,8 +139,14 @@ void WadFile::purgeAllLumps() noexcept {
         void* const pCachedData = pLumps[i].pCachedData;
 
         if (pCachedData) {
-            Z_Free2(mainMemZone, pCachedData);
-            ASSERT_LOG(!pLumps[i].pCachedData, "Z_Free2 should clear the pointer field pointing to the freed memory block!");
+            if (pLumps[i].bIsMapped) {
+                pLumps[i].pCachedData = nullptr;
+                pLumps[i].bIsMapped = false;
+            } else {
+                Z_Free2(mainMemZone, pCachedData);
+                ASSERT_LOG(!pLumps[i].pCachedData, "Z_Free2 should clear the pointer field pointing to the freed memory block!");
+            }
+
             pLumps[i].bIsUncompressed = false;
         }
     }
@@ -151,6 +160,8 @@ void WadFile::purgeAllLumps() noexcept {
 //  (1) If the lump is already cached then this call is a no-op, unless if the cached lump is compressed and decompression is required.
 //  (2) If decompression is not required then an uncompressed lump data may still be returned. This can happen if the data in the WAD file
 //      is already decompressed or if the lump was cached in a decompressed state previously.
+//  (3) PsyDoom: if decompression is not required and the WAD file is memory mapped then the returned data points directly into the mapping
+//      and must not be modified. If decompression is required then the data is always copied to zone memory, since callers may modify it.
 //------------------------------------------------------------------------------------------------------------------------------------------
 const WadLump& WadFile::cacheLump(const int32_t lumpIdx, const int16_t allocTag, const bool bDecompress) noexcept {
     ASSERT(isValidLumpIdx(lumpIdx));
@@ -170,12 +181,28 @@ const WadLump& WadFile::cacheLump(const int32_t lumpIdx, const int16_t allocTag,
         // Handle the situation where the caller wanted the data uncompressed when it's already loaded and compressed.
         // In this scenario decompress the currently loaded lump and have it replace the previously compressed version of the lump.
         // The original game did not trigger this case but now with PsyDoom it's possible, so we must fix.
-        if (bDecompress && (!lump.bIsUncompressed)) {
+        if (bDecompress && lump.bIsMapped) {
+            // PsyDoom: if the lump is currently pointing into the WAD's memory mapping then copy or decompress it to zone memory instead.
+            // The caller may modify the lump data, which the mapping does not allow.
+            const void* const pMappedLump = lump.pCachedData;
+            lump.pCachedData = nullptr;
+            lump.bIsMapped = false;
+            Z_Malloc(*gpMainMemZone, lump.uncompressedSize, allocTag, &lump.pCachedData);
+
+            if (lump.bIsUncompressed) {
+                std::memcpy(lump.pCachedData, pMappedLump, (size_t) lump.uncompressedSize);
+            } else {
+                decompressLumpData(lumpIdx, pMappedLump, lump.pCachedData);
+            }
+
+            lump.bIsUncompressed = true;
+        }
+        else if (bDecompress && (!lump.bIsUncompressed)) {
             void* const pCompressedLump = lump.pCachedData;
             
             Z_SetUser(pCompressedLump, nullptr); // N.B: Doing this to avoid wiping the cache entry on 'Z_Free'
             Z_Malloc(*gpMainMemZone, lump.uncompressedSize, allocTag, &lump.pCachedData);
-            WadUtils::decompressLump(pCompressedLump, lump.pCachedData);
+            decompressLumpData(lumpIdx, pCompressedLump, lump.pCachedData);
             Z_Free2(*gpMainMemZone, pCompressedLump);
 
             lump.bIsUncompressed = true;
@@ -198,13 +225,26 @@ const WadLump& WadFile::cacheLump(const int32_t lumpIdx, const int16_t allocTag,
         sizeToRead = lumpCompressedSize;
     }
 
+    // PsyDoom: if the WAD is memory mapped and decompression is not required then just point to the lump data in the mapping.
+    // This avoids using any zone memory for the lump, and there is nothing to free when it is dropped from the cache.
+    const bool bIsLumpCompressed = ((uint8_t) mLumpNames[lumpIdx].chars[0] & 0x80);
+
+    if (!bDecompress) {
+        if (const std::byte* const pMappedData = getMappedLumpData(lumpIdx, sizeToRead)) {
+            lump.pCachedData = (void*) pMappedData;
+            lump.bIsMapped = true;
+            lump.bIsUncompressed = (!bIsLumpCompressed);
+            return lump;
+        }
+    }
+
     // Alloc RAM for the lump and read it
     Z_Malloc(*gpMainMemZone, sizeToRead, allocTag, &lump.pCachedData);
     readLump(lumpIdx, lump.pCachedData, bDecompress);
 
     // Save whether the lump is compressed or not.
     // If the lump is compressed then the highest bit of the first character in the name will be set:
-    if ((uint8_t) mLumpNames[lumpIdx].chars[0] & 0x80) {
+    if (bIsLumpCompressed) {
         lump.bIsUncompressed = bDecompress;
     } else {
         lump.bIsUncompressed = true;
@@ -237,14 +277,24 @@ void WadFile::readLump(const int32_t lumpIdx, void* const pDest, const bool bDec
     const uint32_t sizeToRead = nextLump.wadFileOffset - lump.wadFileOffset;
     const bool bIsLumpCompressed = ((uint8_t) lumpName.chars[0] & 0x80u);
 
+    // PsyDoom: if the WAD is memory mapped then copy or decompress the lump directly from the mapping
+    if (const std::byte* const pMappedData = getMappedLumpData(lumpIdx, (int32_t) sizeToRead)) {
+        if (bDecompress && bIsLumpCompressed) {
+            decompressLumpData(lumpIdx, pMappedData, pDest);
+        } else {
+            std::memcpy(pDest, pMappedData, sizeToRead);
+        }
+
+        return;
+    }
+
     if (bDecompress && bIsLumpCompressed) {
         // Decompression needed, must alloc a temp buffer for the compressed data before reading and decompressing!
         void* const pTmpBuffer = Z_EndMalloc(*gpMainMemZone, sizeToRead, PU_STATIC, nullptr);
 
         mFileReader.seekAbsolute(lump.wadFileOffset);
         mFileReader.read(pTmpBuffer, sizeToRead);
-        ASSERT(WadUtils::getDecompressedLumpSize(pTmpBuffer) == lump.uncompressedSize);   // Sanity check the WAD data in debug mode
-        WadUtils::decompressLump(pTmpBuffer, pDest);
+        decompressLumpData(lumpIdx, pTmpBuffer, pDest);
 
         Z_Free2(*gpMainMemZone, pTmpBuffer);
     } else {
@@ -254,11 +304,54 @@ void WadFile::readLump(const int32_t lumpIdx, void* const pDest, const bool bDec
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decompresses the given compressed data for the specified lump into a buffer sized to the lump's uncompressed size.
+// PsyDoom: the decompression is bounds checked against the lump's stored and uncompressed sizes, so corrupt data in user WADs can't cause
+// reads or writes outside of the buffers. Such data is treated as a fatal error.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void WadFile::decompressLumpData(const int32_t lumpIdx, const void* const pSrc, void* const pDst) const noexcept {
+    const int32_t uncompressedSize = mLumps[lumpIdx].uncompressedSize;
+    const int32_t decompressedSize = WadUtils::decompressLumpChecked(pSrc, getLumpStoredSize(lumpIdx), pDst, uncompressedSize);
+
+    if (decompressedSize < 0) {
+        I_Error("WadFile: lump %d has corrupt compressed data!", lumpIdx);
+    }
+
+    ASSERT(decompressedSize == uncompressedSize);   // Sanity check the WAD data in debug mode
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// If the WAD file is memory mapped, returns a pointer to the data for the specified lump within the mapping, otherwise returns 'nullptr'.
+// The given amount of data at the lump's location must be within the file, otherwise this is treated as a fatal IO error.
+//------------------------------------------------------------------------------------------------------------------------------------------
+const std::byte* WadFile::getMappedLumpData(const int32_t lumpIdx, const int32_t size) const noexcept {
+    const std::byte* const pMappedData = mFileReader.getMappedData();
+
+    if (!pMappedData)
+        return nullptr;
+
+    const WadLump& lump = mLumps[lumpIdx];
+    const size_t mappedSize = mFileReader.getMappedSize();
+
+    if ((lump.wadFileOffset < 0) || (size < 0) || ((size_t) lump.wadFileOffset + (size_t) size > mappedSize)) {
+        I_Error("WadFile::getMappedLumpData: lump %d is outside the file - IO error!", lumpIdx);
+    }
+
+    return pMappedData + lump.wadFileOffset;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Performs WAD initialization after the file has been opened
 //------------------------------------------------------------------------------------------------------------------------------------------
 void WadFile::initAfterOpen(const RemapWadLumpNameFn lumpNameRemapFn) noexcept {
     readLumpInfo(lumpNameRemapFn);
+
+    // PsyDoom: index the lump names for fast lookup, ignoring the 'compressed' flag bit
+    mLumpIndex.init(mNumLumps);
+
+    for (int32_t lumpIdx = 0; lumpIdx < mNumLumps; ++lumpIdx) {
+        mLumpIndex.addLump(mLumpNames[lumpIdx].word() & WAD_LUMPNAME_MASK, lumpIdx);
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
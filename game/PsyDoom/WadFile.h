@@ -4,6 +4,7 @@
 #include "Endian.h"
 #include "GameFileReader.h"
 #include "SmallString.h"
+#include "WadLumpIndex.h"
 
 #include <memory>
 
@@ -13,6 +14,7 @@
 struct WadLump {
     void*       pCachedData;            // The data for the lump cached into memory, if 'nullptr' then the lump has not been loaded yet.
     bool        bIsUncompressed;        // Only has meaning if the lump is cached. If 'true' then the cached data is uncompressed, otherwise it is compressed.
+    bool        bIsMapped;              // Only has meaning if the lump is cached. If 'true' then the cached data points into the WAD file's (read-only) memory mapping rather than zone memory.
     int32_t     wadFileOffset;          // Offset of the lump in the WAD file.
     int32_t     uncompressedSize;       // Original size of the lump in bytes, before any compression.
 };
@@ -68,6 +70,19 @@ public:
         return mNumLumps;
     }
 
+    // Tells if the specified lump is stored compressed in the WAD: the highest bit of the first character in the name is set if so
+    inline bool isLumpCompressed(const int32_t lumpIdx) const noexcept {
+        ASSERT(isValidLumpIdx(lumpIdx));
+        return ((uint8_t) mLumpNames[lumpIdx].chars[0] & 0x80u);
+    }
+
+    // Gives the size of the specified lump as stored in the WAD (i.e the compressed size, if compressed) or '-1' if unknown.
+    // The size can only be determined if there is a lump following this one, since the lump header only has the uncompressed size.
+    inline int32_t getLumpStoredSize(const int32_t lumpIdx) const noexcept {
+        ASSERT(isValidLumpIdx(lumpIdx));
+        return (lumpIdx + 1 < mNumLumps) ? mLumps[lumpIdx + 1].wadFileOffset - mLumps[lumpIdx].wadFileOffset : -1;
+    }
+
     int32_t findLumpIdx(const WadLumpName lumpName, const int32_t searchStartIdx = 0) const noexcept;
 
     void purgeCachedLump(const int32_t lumpIdx) noexcept;
@@ -80,11 +95,14 @@ private:
     WadFile& operator = (const WadFile& other) = delete;
     WadFile& operator = (WadFile&& other) = delete;
 
+    void decompressLumpData(const int32_t lumpIdx, const void* const pSrc, void* const pDst) const noexcept;
+    const std::byte* getMappedLumpData(const int32_t lumpIdx, const int32_t size) const noexcept;
     void initAfterOpen(const RemapWadLumpNameFn lumpNameRemapFn) noexcept;
     void readLumpInfo(const RemapWadLumpNameFn lumpNameRemapFn) noexcept;
 
     int32_t                         mNumLumps;          // The number of lumps in the WAD
     std::unique_ptr<WadLumpName[]>  mLumpNames;         // Store names in their own list for cache-friendly search
     std::unique_ptr<WadLump[]>      mLumps;             // The details and data for each lump
+    WadLumpIndex                    mLumpIndex;         // PsyDoom: hash index of the lump names for fast lookup
     GameFileReader                  mFileReader;        // Responsible for reading from the WAD file
 };
@@ -6,6 +6,7 @@
 WadList::WadList() noexcept
     : mWadFiles()
     , mLumpHandles()
+    , mLumpIndex()
 {
 }
 
@@ -48,8 +49,10 @@ void WadList::finalize() noexcept {
     }
 
     mLumpHandles.reserve(totalLumps);
+    mLumpIndex.init(totalLumps);
 
-    // Create all of the lump handles
+    // Create all of the lump handles and index them by name.
+    // Note: handles are indexed in order so that searches still find lumps in earlier WADs first, allowing them to override later WADs.
     for (int32_t wadFileIndex = 0; wadFileIndex < (int32_t) mWadFiles.size(); ++wadFileIndex) {
         WadFile& wadFile = mWadFiles[wadFileIndex];
         const int32_t numWadLumps = wadFile.getNumLumps();
@@ -57,6 +60,7 @@ void WadList::finalize() noexcept {
         for (int32_t lumpIdx = 0; lumpIdx < numWadLumps; ++lumpIdx) {
             const WadLumpName lumpName = wadFile.getLumpName(lumpIdx);
             mLumpHandles.push_back({ wadFileIndex, lumpIdx, lumpName.word() & WAD_LUMPNAME_MASK });     // Note: remove the special 'compressed' flag bit to make later search a bit faster
+            mLumpIndex.addLump(mLumpHandles.back().name.word(), (int32_t) mLumpHandles.size() - 1);
         }
     }
 }
@@ -65,6 +69,7 @@ void WadList::finalize() noexcept {
 // Clears the WAD list and unloads all WADs
 //------------------------------------------------------------------------------------------------------------------------------------------
 void WadList::clear() noexcept {
+    mLumpIndex.clear();
     mLumpHandles.clear();
     mWadFiles.clear();
 }
@@ -75,15 +80,7 @@ void WadList::clear() noexcept {
 // Note: when searching the 'compressed' flag bit in the 1st byte of candidate lump names is ignored.
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t WadList::findLumpIdx(const WadLumpName lumpName, const int32_t searchStartIdx) const noexcept {
-    const int32_t numLumps = (int32_t) mLumpHandles.size();
-    const LumpHandle* const pLumpHandles = mLumpHandles.data();
-
-    for (int32_t i = searchStartIdx; i < numLumps; ++i) {
-        if (pLumpHandles[i].name.word() == lumpName.word())
-            return i;
-    }
-
-    return -1;
+    return mLumpIndex.findLumpIdx(lumpName.word(), searchStartIdx);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "WadFile.h"
+#include "WadLumpIndex.h"
 
 #include <vector>
 
@@ -44,4 +45,5 @@ private:
 
     std::vector<WadFile>        mWadFiles;
     std::vector<LumpHandle>     mLumpHandles;
+    WadLumpIndex                mLumpIndex;         // PsyDoom: hash index of the lump handle names for fast lookup
 };
@@ -0,0 +1,120 @@
+#include "WadLumpIndex.h"
+
+#include "Asserts.h"
+#include "WadFile.h"
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Creates an empty lump index
+//------------------------------------------------------------------------------------------------------------------------------------------
+WadLumpIndex::WadLumpIndex() noexcept
+    : mSlots()
+    , mNextLumpIdxs()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Move a lump index from one object to another
+//------------------------------------------------------------------------------------------------------------------------------------------
+WadLumpIndex::WadLumpIndex(WadLumpIndex&& other) noexcept
+    : mSlots(std::move(other.mSlots))
+    , mNextLumpIdxs(std::move(other.mNextLumpIdxs))
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Frees up the lump index
+//------------------------------------------------------------------------------------------------------------------------------------------
+WadLumpIndex::~WadLumpIndex() noexcept {
+    clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Removes all lumps from the index and frees up the memory used
+//------------------------------------------------------------------------------------------------------------------------------------------
+void WadLumpIndex::clear() noexcept {
+    mSlots.clear();
+    mSlots.shrink_to_fit();
+    mNextLumpIdxs.clear();
+    mNextLumpIdxs.shrink_to_fit();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prepares the index to hold the specified number of lumps, removing any lumps previously added.
+// The lumps must then be added in order with 'addLump()'.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void WadLumpIndex::init(const int32_t numLumps) noexcept {
+    ASSERT(numLumps >= 0);
+
+    // Keep the table at most half full so probe sequences stay short
+    uint32_t numSlots = 16;
+
+    while (numSlots < (uint32_t) numLumps * 2) {
+        numSlots *= 2;
+    }
+
+    mSlots.assign(numSlots, Slot{ 0, -1, -1 });
+    mNextLumpIdxs.assign((size_t) numLumps, -1);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Adds the specified lump to the index.
+// Lumps must be added in increasing lump index order and the 'compressed' flag bit must be removed from the name.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void WadLumpIndex::addLump(const uint64_t lumpNameWord, const int32_t lumpIdx) noexcept {
+    ASSERT((lumpIdx >= 0) && (lumpIdx < (int32_t) mNextLumpIdxs.size()));
+    ASSERT((lumpNameWord & WAD_LUMPNAME_MASK) == lumpNameWord);
+
+    Slot& slot = mSlots[getSlotIdx(lumpNameWord)];
+
+    if (slot.firstLumpIdx < 0) {
+        slot.name = lumpNameWord;
+        slot.firstLumpIdx = lumpIdx;
+    } else {
+        ASSERT(slot.lastLumpIdx < lumpIdx);
+        mNextLumpIdxs[slot.lastLumpIdx] = lumpIdx;
+    }
+
+    slot.lastLumpIdx = lumpIdx;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns the index of the first lump with the specified name at or after the given lump index, or '-1' if there is no such lump.
+// The name should not have the 'compressed' flag bit set.
+//------------------------------------------------------------------------------------------------------------------------------------------
+int32_t WadLumpIndex::findLumpIdx(const uint64_t lumpNameWord, const int32_t searchStartIdx) const noexcept {
+    if (mSlots.empty())
+        return -1;
+
+    const Slot& slot = mSlots[getSlotIdx(lumpNameWord)];
+
+    // Walk the chain of lumps with this name to the first one at or after the start index
+    if ((slot.firstLumpIdx < 0) || (searchStartIdx > slot.lastLumpIdx))
+        return -1;
+
+    int32_t lumpIdx = slot.firstLumpIdx;
+
+    while (lumpIdx < searchStartIdx) {
+        lumpIdx = mNextLumpIdxs[lumpIdx];
+    }
+
+    return lumpIdx;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns the index of the hash table slot for the specified lump name word: either the slot holding the name or the empty slot it would go in
+//------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t WadLumpIndex::getSlotIdx(const uint64_t lumpNameWord) const noexcept {
+    // Fibonacci hashing: mixes the characters of the name into the high bits, which are then folded down
+    const uint64_t hash = lumpNameWord * 0x9E3779B97F4A7C15ull;
+    const uint32_t slotMask = (uint32_t) mSlots.size() - 1;
+    uint32_t slotIdx = (uint32_t)(hash ^ (hash >> 32)) & slotMask;
+
+    while (true) {
+        const Slot& slot = mSlots[slotIdx];
+
+        if ((slot.firstLumpIdx < 0) || (slot.name == lumpNameWord))
+            return slotIdx;
+
+        slotIdx = (slotIdx + 1) & slotMask;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A hash index over a list of WAD lump names, for fast lookup of lump indexes by name.
+// Uses open addressing with linear probing on the 64-bit lump name words (see 'WadLumpName').
+// Each distinct name maps to the first lump with that name, and lumps with repeated names are chained together in lump index order.
+// This means that a search starting from any lump index gives the same result as a linear scan from that index.
+//------------------------------------------------------------------------------------------------------------------------------------------
+class WadLumpIndex {
+public:
+    WadLumpIndex() noexcept;
+    WadLumpIndex(WadLumpIndex&& other) noexcept;
+    ~WadLumpIndex() noexcept;
+
+    void clear() noexcept;
+    void init(const int32_t numLumps) noexcept;
+    void addLump(const uint64_t lumpNameWord, const int32_t lumpIdx) noexcept;
+    int32_t findLumpIdx(const uint64_t lumpNameWord, const int32_t searchStartIdx = 0) const noexcept;
+
+private:
+    WadLumpIndex(const WadLumpIndex& other) = delete;
+    WadLumpIndex& operator = (const WadLumpIndex& other) = delete;
+    WadLumpIndex& operator = (WadLumpIndex&& other) = delete;
+
+    // An entry in the hash table for a distinct lump name
+    struct Slot {
+        uint64_t    name;               // The lump name word, without the 'compressed' flag bit
+        int32_t     firstLumpIdx;       // Index of the first lump with this name or '-1' if the slot is unused
+        int32_t     lastLumpIdx;        // Index of the last lump with this name
+    };
+
+    uint32_t getSlotIdx(const uint64_t lumpNameWord) const noexcept;
+
+    std::vector<Slot>       mSlots;             // The hash table: always a power of two in size and never more than half full
+    std::vector<int32_t>    mNextLumpIdxs;      // For each lump, the index of the next lump with the same name or '-1' if none
+};
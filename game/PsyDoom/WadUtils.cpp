@@ -3,59 +3,169 @@
 //------------------------------------------------------------------------------------------------------------------------------------------
 #include "WadUtils.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 BEGIN_NAMESPACE(WadUtils)
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Format notes for the compression algorithm used, which is a form of LZSS:
+//
+//  (1) The data is a series of 'id' bytes, each followed by up to 8 items. Bit 0 of the id byte describes the 1st item, bit 1 the 2nd etc.
+//  (2) If the bit for an item is '0' then the item is a single literal byte which is copied to the output.
+//  (3) If the bit for an item is '1' then the item is a 2 byte match, referencing previously output data. The first 12-bits give the
+//      distance back in the output (minus 1) to copy from and the remaining 4-bits give the number of bytes to copy (minus 1).
+//      The source and destination may overlap, in which case the copy repeats recently output bytes.
+//  (4) A match with a length of '1' (stored as '0') marks the end of the compressed stream.
+//
+// PsyDoom: the original decoder processed one bit of the id byte at a time. The decoders here handle a whole id byte per iteration, with
+// a fast path for 8 literals in a row, and copy non-overlapping matches using wide loads and stores. Note that the wide copies never write
+// past the end of the match, so output buffers sized exactly to the decompressed size are still fine.
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Copies a match of the given length (1-16 bytes) from earlier in the output.
+// Non-overlapping matches are copied with 4 or 8 byte loads and stores, overlapping ones a byte at a time.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void copyMatch(uint8_t* const pDst, const uint8_t* const pSrc, const uint32_t length, const uint32_t distance) noexcept {
+    if (distance >= length) {
+        if (length >= 8) {
+            // Two possibly overlapping 8 byte copies cover 8-16 bytes exactly
+            uint64_t word1, word2;
+            std::memcpy(&word1, pSrc, 8);
+            std::memcpy(&word2, pSrc + length - 8, 8);
+            std::memcpy(pDst, &word1, 8);
+            std::memcpy(pDst + length - 8, &word2, 8);
+            return;
+        }
+
+        if (length >= 4) {
+            // Two possibly overlapping 4 byte copies cover 4-8 bytes exactly
+            uint32_t word1, word2;
+            std::memcpy(&word1, pSrc, 4);
+            std::memcpy(&word2, pSrc + length - 4, 4);
+            std::memcpy(pDst, &word1, 4);
+            std::memcpy(pDst + length - 4, &word2, 4);
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < length; ++i) {
+        pDst[i] = pSrc[i];
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Decompresses the given compressed lump data into the given output buffer.
-// The compression algorithm used is a form of LZSS.
-// Assumes the output buffer is sized big enough to hold all of the decompressed data.
+// Assumes the compressed data is valid and the output buffer is sized big enough to hold all of the decompressed data.
+// For untrusted data use 'decompressLumpChecked' instead.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void decompressLump(const void* const pSrc, void* const pDst) noexcept {
     const uint8_t* pSrcByte = (const uint8_t*) pSrc;
     uint8_t* pDstByte = (uint8_t*) pDst;
 
-    uint32_t idByte = 0;        // Controls whether there is compressed or uncompressed data ahead
-    uint32_t haveIdByte = 0;    // Controls when to read an id byte, when '0' we need to read another one
-
     while (true) {
-        // Read the id byte if required.
-        // We need 1 id byte for every 8 bytes of uncompressed output, or every 8 runs of compressed data.
-        if (haveIdByte == 0) {
-            idByte = *pSrcByte;
-            ++pSrcByte;
+        uint32_t idByte = *pSrcByte;
+        ++pSrcByte;
+
+        // Fast path: 8 literal bytes in a row
+        if (idByte == 0) {
+            std::memcpy(pDstByte, pSrcByte, 8);
+            pSrcByte += 8;
+            pDstByte += 8;
+            continue;
         }
 
-        haveIdByte = (haveIdByte + 1) & 7;
-
-        if (idByte & 1) {
-            // Compressed data ahead: the first 12-bits tells where to take repeated data from.
-            // The remaining 4-bits tell how many bytes of repeated data to take.
-            const uint32_t srcByte1 = pSrcByte[0];
-            const uint32_t srcByte2 = pSrcByte[1];
-            pSrcByte += 2;
-
-            const int32_t srcOffset = ((srcByte1 << 4) | (srcByte2 >> 4)) + 1;
-            const int32_t numRepeatedBytes = (srcByte2 & 0xF) + 1;
+        for (uint32_t itemIdx = 0; itemIdx < 8; ++itemIdx, idByte >>= 1) {
+            if (idByte & 1) {
+                const uint32_t srcByte1 = pSrcByte[0];
+                const uint32_t srcByte2 = pSrcByte[1];
+                pSrcByte += 2;
 
-            // A value of '1' is a special value and means we have reached the end of the compressed stream
-            if (numRepeatedBytes == 1)
-                break;
+                const uint32_t distance = ((srcByte1 << 4) | (srcByte2 >> 4)) + 1;
+                const uint32_t length = (srcByte2 & 0xF) + 1;
 
-            const uint8_t* const pRepeatedBytes = pDstByte - srcOffset;
+                if (length == 1)
+                    return;
 
-            for (int32_t i = 0; i < numRepeatedBytes; ++i) {
-                *pDstByte = pRepeatedBytes[i];
+                copyMatch(pDstByte, pDstByte - distance, length, distance);
+                pDstByte += length;
+            } else {
+                *pDstByte = *pSrcByte;
+                ++pSrcByte;
                 ++pDstByte;
             }
-        } else {
-            // Uncompressed data: just copy the input byte
-            *pDstByte = *pSrcByte;
-            ++pSrcByte;
-            ++pDstByte;
         }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decompresses the given compressed lump data, verifying that no reads or writes go outside of the given input and output buffers.
+// If the output buffer is null then nothing is written and just the decompressed size is computed.
+// Returns the decompressed size of the data or '-1' if the data is corrupt or does not fit in the output buffer.
+//------------------------------------------------------------------------------------------------------------------------------------------
+int32_t decompressLumpChecked(const void* const pSrc, const int32_t srcSize, void* const pDst, const int32_t dstSize) noexcept {
+    const uint8_t* pSrcByte = (const uint8_t*) pSrc;
+    const uint8_t* const pSrcEnd = pSrcByte + std::max(srcSize, 0);
+    uint8_t* const pDstBeg = (uint8_t*) pDst;
+    const int32_t dstCapacity = (pDst) ? std::max(dstSize, 0) : INT32_MAX;
+    int32_t outSize = 0;
+
+    while (pSrcByte < pSrcEnd) {
+        uint32_t idByte = *pSrcByte;
+        ++pSrcByte;
+
+        // Fast path: 8 literal bytes in a row, with room for all of them
+        if ((idByte == 0) && (pSrcEnd - pSrcByte >= 8) && (dstCapacity - outSize >= 8)) {
+            if (pDstBeg) {
+                std::memcpy(pDstBeg + outSize, pSrcByte, 8);
+            }
+
+            pSrcByte += 8;
+            outSize += 8;
+            continue;
+        }
+
+        for (uint32_t itemIdx = 0; itemIdx < 8; ++itemIdx, idByte >>= 1) {
+            if (idByte & 1) {
+                if (pSrcEnd - pSrcByte < 2)
+                    return -1;
+
+                const uint32_t srcByte1 = pSrcByte[0];
+                const uint32_t srcByte2 = pSrcByte[1];
+                pSrcByte += 2;
+
+                const int32_t distance = (int32_t)((srcByte1 << 4) | (srcByte2 >> 4)) + 1;
+                const int32_t length = (int32_t)(srcByte2 & 0xF) + 1;
+
+                if (length == 1)
+                    return outSize;
+
+                if ((distance > outSize) || (length > dstCapacity - outSize))
+                    return -1;
+
+                if (pDstBeg) {
+                    copyMatch(pDstBeg + outSize, pDstBeg + outSize - distance, (uint32_t) length, (uint32_t) distance);
+                }
+
+                outSize += length;
+            } else {
+                if ((pSrcByte >= pSrcEnd) || (outSize >= dstCapacity))
+                    return -1;
 
-        idByte >>= 1;
+                if (pDstBeg) {
+                    pDstBeg[outSize] = *pSrcByte;
+                }
+
+                ++pSrcByte;
+                ++outSize;
+            }
+        }
     }
+
+    // Ran out of input before the end of stream marker
+    return -1;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -63,42 +173,36 @@ void decompressLump(const void* const pSrc, void* const pDst) noexcept {
 // Instead this function returns the decompressed size of the lump data, given just the data itself.
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t getDecompressedLumpSize(const void* const pSrc) noexcept {
-    // This code is pretty much a replica of 'decompressLump()' - see that function for more details/comments.
-    // The only difference here is that we don't save the decompressed data and just count the number of output bytes instead.
-    const uint8_t* pSrcByte = (uint8_t*) pSrc;
+    // This is the same as 'decompressLump()' except we just count the number of output bytes - see that function for more details
+    const uint8_t* pSrcByte = (const uint8_t*) pSrc;
     int32_t size = 0;
 
-    uint32_t idByte = 0;
-    uint32_t haveIdByte = 0;
-
     while (true) {
-        if (haveIdByte == 0) {
-            idByte = *pSrcByte;
-            ++pSrcByte;
-        }
+        uint32_t idByte = *pSrcByte;
+        ++pSrcByte;
 
-        haveIdByte = (haveIdByte + 1) & 7;
+        if (idByte == 0) {
+            pSrcByte += 8;
+            size += 8;
+            continue;
+        }
 
-        if (idByte & 1) {
-            // Note: not bothering to read the byte containing only positional information for the replicated data.
-            // We are only interested in the byte count for this function.
-            const uint32_t srcByte2 = pSrcByte[1];
-            pSrcByte += 2;
-            const uint32_t numRepeatedBytes = (srcByte2 & 0xF) + 1;
+        for (uint32_t itemIdx = 0; itemIdx < 8; ++itemIdx, idByte >>= 1) {
+            if (idByte & 1) {
+                // Note: not bothering to read the byte containing only positional information for the replicated data
+                const int32_t length = (pSrcByte[1] & 0xF) + 1;
+                pSrcByte += 2;
 
-            if (numRepeatedBytes == 1)
-                break;
+                if (length == 1)
+                    return size;
 
-            size += numRepeatedBytes;
-        } else {
-            ++size;
-            ++pSrcByte;
+                size += length;
+            } else {
+                ++pSrcByte;
+                ++size;
+            }
         }
-
-        idByte >>= 1;
     }
-
-    return size;
 }
 
 END_NAMESPACE(WadUtils)
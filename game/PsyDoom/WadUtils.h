@@ -5,6 +5,7 @@
 BEGIN_NAMESPACE(WadUtils)
 
 void decompressLump(const void* const pSrc, void* const pDst) noexcept;
+int32_t decompressLumpChecked(const void* const pSrc, const int32_t srcSize, void* const pDst, const int32_t dstSize) noexcept;
 int32_t getDecompressedLumpSize(const void* const pSrc) noexcept;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
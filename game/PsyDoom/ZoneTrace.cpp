@@ -0,0 +1,341 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Zone memory telemetry: records the zone memory allocator calls made by the game to a binary file and summarizes heap usage per level.
+// See the header for more details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "ZoneTrace.h"
+
+#include "Doom/Base/z_zone.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+BEGIN_NAMESPACE(ZoneTrace)
+
+// Allocation totals for a call site
+struct CallSiteStats {
+    uint32_t    numAllocs;
+    int64_t     allocBytes;
+};
+
+// Heap usage statistics for the current level
+struct LevelStats {
+    int32_t     numTics;                                            // How many game tics were sampled
+    int32_t     peakUsedBytes[(uint32_t) StatTag::NUM_TAGS];        // Peak memory used by each tag
+    int32_t     peakTotalUsedBytes;                                 // Peak memory used by all tags combined
+    int32_t     minFreeBytes;                                       // Lowest amount of free memory seen
+    int32_t     minLargestFreeBytes;                                // Smallest 'largest free block' seen
+    double      maxFragmentation;                                   // Highest fragmentation ratio seen: 1 - (largest free block / free memory)
+    uint32_t    numAllocs;                                          // Number of allocations, frees and purges and the bytes involved
+    int64_t     allocBytes;
+    uint32_t    numFrees;
+    uint32_t    numPurges;
+    int64_t     purgedBytes;
+};
+
+// Names of each of the tags that stats are gathered for
+static constexpr const char* STAT_TAG_NAMES[(uint32_t) StatTag::NUM_TAGS] = {
+    "PU_STATIC",
+    "PU_LEVEL",
+    "PU_LEVSPEC",
+    "PU_ANIMATION",
+    "PU_CACHE",
+    "Other",
+};
+
+// How many of the top call sites (by bytes allocated) to list in the level summary
+static constexpr uint32_t NUM_SUMMARY_CALL_SITES = 8;
+
+bool gbIsTracing = false;
+
+static std::FILE*                                   gpTraceFile;        // The file being written to, or null if not tracing
+static std::string                                  gTraceFilePath;     // Path to the file being written to
+static std::unordered_map<const void*, uint32_t>    gBlockIds;          // Block ids for all blocks allocated while tracing, by address
+static uint32_t                                     gNextBlockId;       // Id to assign to the next block allocated
+static uint64_t                                     gNumEvents;         // How many events have been recorded
+static LevelStats                                   gLevelStats;        // Heap usage statistics for the current level
+static std::unordered_map<uint64_t, CallSiteStats>  gLevelCallSites;    // Allocation totals for each call site for the current level
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Write an event to the trace file
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeEvent(
+    const EventType type,
+    const uint32_t blockId,
+    const int16_t tag,
+    const int32_t size,
+    const bool bHasUser,
+    const uint64_t callSite
+) noexcept {
+    Event event = {};
+    event.type = type;
+    event.bHasUser = (bHasUser) ? 1 : 0;
+    event.tag = tag;
+    event.blockId = blockId;
+    event.size = size;
+    event.callSite = callSite;
+
+    std::fwrite(&event, sizeof(event), 1, gpTraceFile);
+    gNumEvents++;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the id of the block for the specified memory allocated by the zone allocator, or '0' if unknown
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t getBlockId(const void* const ptr) noexcept {
+    const auto blockIter = gBlockIds.find(ptr);
+    return (blockIter != gBlockIds.end()) ? blockIter->second : 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Clears the heap usage statistics for the current level
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void resetLevelStats() noexcept {
+    gLevelStats = {};
+    gLevelStats.minFreeBytes = INT32_MAX;
+    gLevelStats.minLargestFreeBytes = INT32_MAX;
+    gLevelCallSites.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells which of the tags that stats are gathered for the specified block tag counts towards
+//------------------------------------------------------------------------------------------------------------------------------------------
+static StatTag getStatTag(const int16_t tag) noexcept {
+    switch (tag) {
+        case PU_STATIC:     return StatTag::Static;
+        case PU_LEVEL:      return StatTag::Level;
+        case PU_LEVSPEC:    return StatTag::LevSpec;
+        case PU_ANIMATION:  return StatTag::Animation;
+        case PU_CACHE:      return StatTag::Cache;
+        default:            return StatTag::Other;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Walks the main zone heap and gathers statistics on its current state
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getHeapStats(TicStats& stats) noexcept {
+    int32_t curFreeRun = 0;
+
+    for (const memblock_t* pBlock = &gpMainMemZone->blocklist; pBlock; pBlock = pBlock->next) {
+        stats.numBlocks++;
+
+        if (pBlock->user) {
+            stats.usedBytes[(uint32_t) getStatTag(pBlock->tag)] += pBlock->size;
+            curFreeRun = 0;
+        } else {
+            stats.numFreeBlocks++;
+            stats.freeBytes += pBlock->size;
+            curFreeRun += pBlock->size;
+            stats.largestFreeBytes = std::max(stats.largestFreeBytes, curFreeRun);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints a summary of heap usage for the level which just ended
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printLevelSummary(const int32_t mapNum) noexcept {
+    const LevelStats& stats = gLevelStats;
+    const int32_t heapSize = gpMainMemZone->size;
+
+    std::printf("Zone heap summary for map %02d (%d tics, heap size %d bytes):\n", mapNum, stats.numTics, heapSize);
+
+    for (uint32_t tagIdx = 0; tagIdx < (uint32_t) StatTag::NUM_TAGS; ++tagIdx) {
+        std::printf("  Peak %-14s %10d bytes\n", STAT_TAG_NAMES[tagIdx], stats.peakUsedBytes[tagIdx]);
+    }
+
+    std::printf(
+        "  Peak total used:    %10d bytes (%.1f%% of heap)\n",
+        stats.peakTotalUsedBytes,
+        (double) stats.peakTotalUsedBytes * 100.0 / (double) heapSize
+    );
+
+    std::printf("  Min free:           %10d bytes\n", stats.minFreeBytes);
+    std::printf("  Min largest free:   %10d bytes\n", stats.minLargestFreeBytes);
+    std::printf("  Max fragmentation:  %10.1f%%\n", stats.maxFragmentation * 100.0);
+    std::printf("  Allocations:        %10u (%lld bytes)\n", stats.numAllocs, (long long) stats.allocBytes);
+    std::printf("  Frees:              %10u\n", stats.numFrees);
+    std::printf("  Purges:             %10u (%lld bytes)\n", stats.numPurges, (long long) stats.purgedBytes);
+
+    // List the call sites which allocated the most memory
+    std::vector<std::pair<uint64_t, CallSiteStats>> callSites(gLevelCallSites.begin(), gLevelCallSites.end());
+
+    std::sort(callSites.begin(), callSites.end(), [](const auto& site1, const auto& site2) noexcept {
+        return (site1.second.allocBytes > site2.second.allocBytes);
+    });
+
+    const uint64_t zMallocAddress = (uint64_t)(uintptr_t) &Z_Malloc;
+    std::printf("  Top call sites by bytes allocated (address relative to 'Z_Malloc'):\n");
+
+    for (uint32_t i = 0; i < std::min<size_t>(callSites.size(), NUM_SUMMARY_CALL_SITES); ++i) {
+        const auto& [callSite, siteStats] = callSites[i];
+
+        std::printf(
+            "    Z_Malloc%+-12lld %8u allocs %12lld bytes\n",
+            (long long)(callSite - zMallocAddress),
+            siteStats.numAllocs,
+            (long long) siteStats.allocBytes
+        );
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Begins recording zone allocator calls to the specified file, if a path is given and the file can be opened.
+// The zone heap size is recorded so the trace can be replayed with the same amount of memory.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void init(const char* const filePath, const int32_t heapSize) noexcept {
+    shutdown();
+
+    if ((!filePath) || (!filePath[0]))
+        return;
+
+    gpTraceFile = std::fopen(filePath, "wb");
+
+    if (!gpTraceFile) {
+        std::printf("Zone trace: failed to open '%s' for writing! Nothing will be traced.\n", filePath);
+        return;
+    }
+
+    // Use a large buffer since there are many small writes
+    std::setvbuf(gpTraceFile, nullptr, _IOFBF, 1024 * 1024);
+
+    gbIsTracing = true;
+    gTraceFilePath = filePath;
+    gNextBlockId = 1;
+    gNumEvents = 0;
+    resetLevelStats();
+
+    // Write the file header
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.heapSize = heapSize;
+    header.bLimitRemoving = (PSYDOOM_LIMIT_REMOVING) ? 1 : 0;
+    header.zMallocAddress = (uint64_t)(uintptr_t) &Z_Malloc;
+    std::fwrite(&header, sizeof(header), 1, gpTraceFile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Ends the trace in progress, if any, and closes the trace file
+//------------------------------------------------------------------------------------------------------------------------------------------
+void shutdown() noexcept {
+    if (gpTraceFile) {
+        std::fclose(gpTraceFile);
+        gpTraceFile = nullptr;
+        std::printf("Zone trace: recorded %llu event(s) to '%s'\n", (unsigned long long) gNumEvents, gTraceFilePath.c_str());
+    }
+
+    gbIsTracing = false;
+    gTraceFilePath.clear();
+    gBlockIds.clear();
+    gLevelCallSites.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a call to 'Z_Malloc' or 'Z_EndMalloc' which returned the specified memory
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordMalloc(
+    const void* const ptr,
+    const int32_t size,
+    const int16_t tag,
+    const bool bHasUser,
+    const bool bEndMalloc,
+    const uint64_t callSite
+) noexcept {
+    // Note: if this address was used by a block that was purged or freed via tags then this replaces the stale id for that block
+    const uint32_t blockId = gNextBlockId++;
+    gBlockIds[ptr] = blockId;
+    writeEvent((bEndMalloc) ? EventType::EndMalloc : EventType::Malloc, blockId, tag, size, bHasUser, callSite);
+
+    gLevelStats.numAllocs++;
+    gLevelStats.allocBytes += size;
+
+    CallSiteStats& siteStats = gLevelCallSites[callSite];
+    siteStats.numAllocs++;
+    siteStats.allocBytes += size;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a call to 'Z_Free2' for the specified memory
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordFree(const void* const ptr, const int32_t blockSize, const int16_t tag, const uint64_t callSite) noexcept {
+    writeEvent(EventType::Free, getBlockId(ptr), tag, blockSize, false, callSite);
+    gBlockIds.erase(ptr);
+    gLevelStats.numFrees++;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a call to 'Z_FreeTags' for the specified tag bits
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordFreeTags(const int16_t tagBits, const uint64_t callSite) noexcept {
+    writeEvent(EventType::FreeTags, 0, tagBits, 0, false, callSite);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a call to 'Z_ChangeTag' for the specified memory
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordChangeTag(const void* const ptr, const int16_t tag, const uint64_t callSite) noexcept {
+    writeEvent(EventType::ChangeTag, getBlockId(ptr), tag, 0, false, callSite);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a call to 'Z_SetUser' for the specified memory
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordSetUser(const void* const ptr, const bool bHasUser, const uint64_t callSite) noexcept {
+    writeEvent(EventType::SetUser, getBlockId(ptr), 0, 0, bHasUser, callSite);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records the allocator purging the specified block to make room for an allocation made from the given call site
+//------------------------------------------------------------------------------------------------------------------------------------------
+void recordPurge(const void* const ptr, const int32_t blockSize, const int16_t tag, const uint64_t callSite) noexcept {
+    writeEvent(EventType::Purge, getBlockId(ptr), tag, blockSize, false, callSite);
+    gBlockIds.erase(ptr);
+    gLevelStats.numPurges++;
+    gLevelStats.purgedBytes += blockSize;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Called at the end of each game tic: samples the state of the heap, records it and updates the statistics for the level
+//------------------------------------------------------------------------------------------------------------------------------------------
+void onGameTic(const int32_t gameTic) noexcept {
+    TicStats ticStats = {};
+    ticStats.gameTic = gameTic;
+    getHeapStats(ticStats);
+
+    writeEvent(EventType::TicStats, 0, 0, (int32_t) sizeof(ticStats), false, 0);
+    std::fwrite(&ticStats, sizeof(ticStats), 1, gpTraceFile);
+
+    LevelStats& stats = gLevelStats;
+    int32_t totalUsedBytes = 0;
+
+    for (uint32_t tagIdx = 0; tagIdx < (uint32_t) StatTag::NUM_TAGS; ++tagIdx) {
+        stats.peakUsedBytes[tagIdx] = std::max(stats.peakUsedBytes[tagIdx], ticStats.usedBytes[tagIdx]);
+        totalUsedBytes += ticStats.usedBytes[tagIdx];
+    }
+
+    const double fragmentation = (ticStats.freeBytes > 0) ? 1.0 - (double) ticStats.largestFreeBytes / (double) ticStats.freeBytes : 0.0;
+
+    stats.numTics++;
+    stats.peakTotalUsedBytes = std::max(stats.peakTotalUsedBytes, totalUsedBytes);
+    stats.minFreeBytes = std::min(stats.minFreeBytes, ticStats.freeBytes);
+    stats.minLargestFreeBytes = std::min(stats.minLargestFreeBytes, ticStats.largestFreeBytes);
+    stats.maxFragmentation = std::max(stats.maxFragmentation, fragmentation);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Called when a level ends: prints a summary of heap usage for the level and resets the statistics for the next one
+//------------------------------------------------------------------------------------------------------------------------------------------
+void onLevelEnd(const int32_t mapNum) noexcept {
+    if (gLevelStats.numTics > 0) {
+        printLevelSummary(mapNum);
+    }
+
+    resetLevelStats();
+}
+
+END_NAMESPACE(ZoneTrace)
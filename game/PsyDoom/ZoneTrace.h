@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstdint>
+
+#if _MSC_VER
+    #include <intrin.h>
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Zone memory telemetry: records the zone memory allocator calls made by the game (e.g while playing back a demo) to a binary file.
+// The state of the heap is also sampled every game tic, and a summary of heap usage is printed at the end of each level.
+// The summary gives the peak memory used by each tag, which is useful for deciding how big the heap needs to be for a mod.
+// The 'ZoneBench' tool can replay the file against the zone allocator to benchmark and stress test it with a real allocation pattern.
+//
+// File format (all values little endian):
+//  (1) A 'FileHeader'.
+//  (2) A sequence of 'Event' records, one for each zone allocator call made by the game, purge done by the allocator or game tic.
+//      'TicStats' events are followed by a 'TicStats' struct.
+//
+// Notes:
+//  (1) Allocated blocks are identified by a block id (starting at '1') which is assigned when the block is allocated.
+//      A block id of '0' means the block is unknown to the trace; events for such blocks should be ignored.
+//  (2) Blocks purged by the allocator to make room for new allocations are recorded with 'Purge' events rather than 'Free' events.
+//      Replays should ignore these since the replaying allocator decides for itself what needs to be purged.
+//  (3) Call sites are the return addresses of the zone allocator calls. To find them in the executable subtract the 'Z_Malloc' address
+//      given in the header and add the address of 'Z_Malloc' in the executable's symbol table.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(ZoneTrace)
+
+static constexpr char       FILE_MAGIC[8] = { 'P', 'S', 'Y', 'Z', 'T', 'R', 'C', 0 };
+static constexpr uint32_t   FILE_VERSION = 2;
+
+// What type of zone allocator call (or other occurrence) an event is for
+enum class EventType : uint8_t {
+    Malloc,         // 'Z_Malloc': 'blockId' is the new block, 'size' is the requested size
+    EndMalloc,      // 'Z_EndMalloc': 'blockId' is the new block, 'size' is the requested size
+    Free,           // 'Z_Free2': 'blockId' is the block freed, 'size' and 'tag' are the block size and tag
+    FreeTags,       // 'Z_FreeTags': 'tag' holds the tag bits of the blocks freed
+    ChangeTag,      // 'Z_ChangeTag': 'blockId' is the block modified and 'tag' is the new tag
+    SetUser,        // 'Z_SetUser': 'blockId' is the block modified and 'bHasUser' tells if it was given an owner or had it cleared
+    Purge,          // A block was purged to make room for an allocation: 'size' and 'tag' are the block size and tag
+    TicStats,       // A game tic ended: followed by a 'TicStats' struct, which is 'size' bytes
+    NUM_TYPES
+};
+
+// The tags that heap usage is broken down by: all other tags are counted together
+enum class StatTag : uint8_t {
+    Static,
+    Level,
+    LevSpec,
+    Animation,
+    Cache,
+    Other,
+    NUM_TAGS
+};
+
+// Header at the start of a trace file
+struct FileHeader {
+    char        magic[8];           // Should equal 'FILE_MAGIC'
+    uint32_t    version;            // Should equal 'FILE_VERSION'
+    int32_t     heapSize;           // Size of the zone heap of the game which made the trace
+    uint8_t     bLimitRemoving;     // Whether the trace was made by a limit removing build
+    uint8_t     pad[7];
+    uint64_t    zMallocAddress;     // Address of 'Z_Malloc' in the game which made the trace, for locating call sites
+};
+
+// A single zone allocator call or other occurrence
+struct Event {
+    EventType   type;
+    uint8_t     bHasUser;           // Allocation and 'SetUser' events: whether the block has an owning pointer
+    int16_t     tag;                // The tag or tag bits for the event, if applicable
+    uint32_t    blockId;            // The block that the event is for, if applicable
+    int32_t     size;               // The size for the event, if applicable
+    uint32_t    pad;
+    uint64_t    callSite;           // Where the zone allocator was called from, if applicable
+};
+
+// The state of the heap at the end of a game tic
+struct TicStats {
+    int32_t     gameTic;                                        // Which game tic this is for
+    int32_t     numBlocks;                                      // How many blocks there are in the heap in total
+    int32_t     numFreeBlocks;                                  // How many free blocks there are in the heap
+    int32_t     freeBytes;                                      // Total amount of free memory
+    int32_t     largestFreeBytes;                               // Size of the largest free block, treating adjacent free blocks as merged
+    int32_t     usedBytes[(uint32_t) StatTag::NUM_TAGS];        // Amount of memory used by blocks of each tag, including block headers
+};
+
+static_assert(sizeof(Event) == 24);
+
+// True while zone allocator calls are being recorded; recording functions must only be called when this is set
+extern bool gbIsTracing;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the return address of the function this is used in, for recording call sites
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if _MSC_VER
+    #define ZONE_TRACE_CALL_SITE() ((uint64_t)(uintptr_t) _ReturnAddress())
+#else
+    #define ZONE_TRACE_CALL_SITE() ((uint64_t)(uintptr_t) __builtin_return_address(0))
+#endif
+
+void init(const char* const filePath, const int32_t heapSize) noexcept;
+void shutdown() noexcept;
+void recordMalloc(const void* const ptr, const int32_t size, const int16_t tag, const bool bHasUser, const bool bEndMalloc, const uint64_t callSite) noexcept;
+void recordFree(const void* const ptr, const int32_t blockSize, const int16_t tag, const uint64_t callSite) noexcept;
+void recordFreeTags(const int16_t tagBits, const uint64_t callSite) noexcept;
+void recordChangeTag(const void* const ptr, const int16_t tag, const uint64_t callSite) noexcept;
+void recordSetUser(const void* const ptr, const bool bHasUser, const uint64_t callSite) noexcept;
+void recordPurge(const void* const ptr, const int32_t blockSize, const int16_t tag, const uint64_t callSite) noexcept;
+void onGameTic(const int32_t gameTic) noexcept;
+void onLevelEnd(const int32_t mapNum) noexcept;
+
+END_NAMESPACE(ZoneTrace)
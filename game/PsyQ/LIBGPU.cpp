@@ -8,6 +8,7 @@
 #include "Gpu.h"
 #include "LIBETC.h"
 #include "PsyDoom/BitShift.h"
+#include "PsyDoom/GpuCapture.h"
 #include "PsyDoom/LIBGPU_CmdDispatch.h"
 #include "PsyDoom/PsxVm.h"
 #include "PsyDoom/Video.h"
@@ -61,15 +62,15 @@ static void clearDrawingArea(const uint8_t r, const uint8_t g, const uint8_t b)
     clearColor.comp.b = b;
 
     Gpu::Core& gpu = PsxVm::gGpu;
+    const Gpu::Color16 clearColor16 = Gpu::color24FTo16<Gpu::DrawMode::Colored>(clearColor);
+    const uint16_t clearW = (gpu.drawAreaRx - gpu.drawAreaLx) + 1;
+    const uint16_t clearH = (gpu.drawAreaBy - gpu.drawAreaTy) + 1;
 
-    Gpu::clearRect(
-        gpu,
-        Gpu::color24FTo16<Gpu::DrawMode::Colored>(clearColor),
-        gpu.drawAreaLx,
-        gpu.drawAreaTy,
-        (gpu.drawAreaRx - gpu.drawAreaLx) + 1,
-        (gpu.drawAreaBy - gpu.drawAreaTy) + 1
-    );
+    if (GpuCapture::gbIsCapturing) {
+        GpuCapture::recordClearRect(clearColor16, gpu.drawAreaLx, gpu.drawAreaTy, clearW, clearH);
+    }
+
+    Gpu::clearRect(gpu, clearColor16, gpu.drawAreaLx, gpu.drawAreaTy, clearW, clearH);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -168,8 +169,9 @@ void LIBGPU_SetDispMask([[maybe_unused]] const int32_t mask) noexcept {
 //  1 = Return the number of drawing operations currently in progress.
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t LIBGPU_DrawSync([[maybe_unused]] const int32_t mode) noexcept {
-    // This function doesn't need to do anything in this emulated environment.
-    // When we submit something to the 'gpu' it is handled immediately, in a blocking fashion.
+    // When we submit something to the 'gpu' it is normally handled immediately, in a blocking fashion.
+    // If multithreaded drawing is enabled however then wait for all queued drawing to be done, regardless of mode.
+    Gpu::flush(PsxVm::gGpu);
     return 0;
 }
 
@@ -187,6 +189,14 @@ void LIBGPU_LoadImage(const SRECT& dstRect, const uint16_t* const pImageData) no
     ASSERT(dstRect.w <= gpu.ramPixelW);
     ASSERT(dstRect.h <= gpu.ramPixelH);
 
+    // Record the upload if capturing GPU commands
+    if (GpuCapture::gbIsCapturing) {
+        GpuCapture::recordLoadImage(dstRect, pImageData);
+    }
+
+    // Make sure any queued drawing is done before modifying VRAM directly
+    Gpu::flush(gpu);
+
     // Determine the destination bounds and row size for the copy.
     // Note that we must wrap horizontal coordinates (see comments below).
     const uint16_t rowW = dstRect.w;
@@ -307,6 +317,14 @@ int32_t LIBGPU_MoveImage(const SRECT& srcRect, const int32_t dstX, const int32_t
     ASSERT(dstX + srcRect.w <= gpu.ramPixelW);
     ASSERT(dstY + srcRect.y <= gpu.ramPixelH);
 
+    // Record the copy if capturing GPU commands
+    if (GpuCapture::gbIsCapturing) {
+        GpuCapture::recordMoveImage(srcRect, dstX, dstY);
+    }
+
+    // Make sure any queued drawing is done before accessing VRAM directly
+    Gpu::flush(gpu);
+
     // Copy each row
     const uint32_t numRows = srcRect.h;
     const uint32_t rowSize = srcRect.w * sizeof(uint16_t);
@@ -365,6 +383,11 @@ DRAWENV& LIBGPU_PutDrawEnv(DRAWENV& env) noexcept {
     // Those features are no longer supported however by PsyDoom's simplified PSX Gpu emulation.
     LIBGPU_CmdDispatch::setGpuTexPageId(env.tpage);
 
+    // Record the new draw state if capturing GPU commands
+    if (GpuCapture::gbIsCapturing) {
+        GpuCapture::recordGpuState();
+    }
+
     // Clear the screen if specified by the DRAWENV.
     // Fill the draw area with the specified background color.
     if (env.isbg) {
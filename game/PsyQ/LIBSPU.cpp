@@ -6,6 +6,7 @@
 
 #include "Asserts.h"
 #include "PsyDoom/PsxVm.h"
+#include "PsyDoom/SpuCmdQueue.h"
 #include "Spu.h"
 
 #include <cmath>
@@ -57,6 +58,17 @@ static uint32_t gTransferStartAddr;
 // See the implementation of 'LIBSPU__spu_note2pitch' for more details on that.
 static uint16_t gVoiceBaseNotes[SPU_NUM_VOICES] = {};
 
+// PsyDoom: the ADSR envelope for each voice and which voices have reverb enabled.
+// Since SPU register writes are now queued for the audio thread to apply, this state is tracked here so it can be read and partially
+// modified without having to lock the SPU.
+static Spu::AdsrEnvelope    gVoiceEnvs[SPU_NUM_VOICES] = {};
+static SpuVoiceMask         gReverbVoiceBits = 0;
+
+// PsyDoom: the number of the last key on/off command queued for each voice, and whether it was a 'key on'.
+// Used to report the correct status for voices whose key on/off has not yet been applied by the audio thread.
+static uint64_t     gVoiceKeyCmdNums[SPU_NUM_VOICES] = {};
+static bool         gbVoiceKeyCmdIsOn[SPU_NUM_VOICES] = {};
+
 // Internal LIBSPU function: convert a note to a pitch.
 // See definition for details.
 uint16_t LIBSPU__spu_note2pitch(
@@ -115,22 +127,26 @@ void LIBSPU_SpuSetVoiceAttr(const SpuVoiceAttr& attribs) noexcept {
     const bool bSetVolR         = (bSetAllAttribs || (attribMask & SPU_VOICE_VOLR));
     const bool bSetVolModeR     = (bSetAllAttribs || (attribMask & SPU_VOICE_VOLMODER));
 
-    // Set the required attributes for all specified voices
-    Spu::Core& spu = PsxVm::gSpu;
-    PsxVm::LockSpu spuLock;
+    const bool bSetEnv = (
+        bSetAttackRate || bSetDecayRate || bSetSustainLevel || bSetSustainRate || bSetReleaseRate || bSetAdsrPart1 || bSetAdsrPart2
+    );
 
+    // Set the required attributes for all specified voices.
+    // PsyDoom: rather than locking the SPU and modifying it directly, queue up the register writes for the audio thread to apply.
+    // The envelope for each voice is tracked here so that individual envelope fields can be modified without reading back from the SPU.
     const SpuVoiceMask voiceBits = attribs.voice_bits;
+    const uint32_t numVoices = std::min(SPU_NUM_VOICES, PsxVm::gSpu.numVoices);
 
-    for (uint32_t voiceIdx = 0; voiceIdx < spu.numVoices; ++voiceIdx) {
+    for (uint32_t voiceIdx = 0; voiceIdx < numVoices; ++voiceIdx) {
         // Skip this voice if we're not setting its attributes
         if ((voiceBits & (SpuVoiceMask(1) << voiceIdx)) == 0)
             continue;
 
         // Set: voice 'pitch' or sample rate. Note that '4,096' = '44,100 Hz'.
-        Spu::Voice& voice = spu.pVoices[voiceIdx];
+        const uint8_t voiceIdx8 = (uint8_t) voiceIdx;
 
         if (bSetPitch) {
-            voice.sampleRate = attribs.pitch;
+            SpuCmdQueue::submit(SpuCmdQueue::CmdType::SetVoiceSampleRate, voiceIdx8, attribs.pitch);
         }
 
         // Set: voice 'base' note at which the sample rate is regarded to be '44,100 Hz'
@@ -144,46 +160,48 @@ void LIBSPU_SpuSetVoiceAttr(const SpuVoiceAttr& attribs) noexcept {
             const uint16_t baseNote = gVoiceBaseNotes[voiceIdx];
             const uint16_t note = attribs.note;
             const uint16_t sampleRate = LIBSPU__spu_note2pitch(baseNote >> 8, baseNote & 0xFF, note >> 8, note & 0xFF);
-            voice.sampleRate = sampleRate;
+            SpuCmdQueue::submit(SpuCmdQueue::CmdType::SetVoiceSampleRate, voiceIdx8, sampleRate);
         }
 
         // Set: the start address (64-bit word index) for the voice wave data.
         // If the given address is not 64-bit aligned then it is aligned up to the next 64-bit boundary.
         if (bSetWaveAddr) {
             const uint32_t addr = (attribs.addr + 7) / 8;
-            voice.adpcmStartAddr8 = addr;
+            SpuCmdQueue::submit(SpuCmdQueue::CmdType::SetVoiceStartAddr, voiceIdx8, addr);
         }
 
-        // Set: attack rate
+        // Set: attack rate. Note that all envelope changes are made to the tracked envelope for the voice, then sent to the SPU.
+        Spu::AdsrEnvelope& env = gVoiceEnvs[voiceIdx];
+
         if (bSetAttackRate) {
             const uint32_t attackRate = (attribs.ar < 0x7F) ? attribs.ar : 0x7F;
-            voice.env.attackStep = (attackRate & 0b0000'0011);
-            voice.env.releaseShift = (attackRate & 0b0111'1100) >> 2;
+            env.attackStep = (attackRate & 0b0000'0011);
+            env.releaseShift = (attackRate & 0b0111'1100) >> 2;
 
             // Set: attack rate mode (exponential or not).
             // If not specified then default to 'linear' increase mode.
             if (bSetAttackMode) {
-                voice.env.bAttackExp = (attribs.a_mode == SPU_VOICE_EXPIncN) ? 1 : 0;
+                env.bAttackExp = (attribs.a_mode == SPU_VOICE_EXPIncN) ? 1 : 0;
             } else {
-                voice.env.bAttackExp = 0;
+                env.bAttackExp = 0;
             }
         }
 
         // Set: decay rate
         if (bSetDecayRate) {
-            voice.env.decayShift = (attribs.dr < 0xF) ? attribs.dr : 0xF;
+            env.decayShift = (attribs.dr < 0xF) ? attribs.dr : 0xF;
         }
 
         // Set: sustain level
         if (bSetSustainLevel) {
-            voice.env.sustainLevel = (attribs.sl < 0xF) ? attribs.sl : 0xF;
+            env.sustainLevel = (attribs.sl < 0xF) ? attribs.sl : 0xF;
         }
 
         // Set: sustain rate
         if (bSetSustainRate) {
             const uint32_t sustainRate = (attribs.sr < 0x7F) ? attribs.sr : 0x7F;
-            voice.env.sustainStep = (sustainRate & 0b0000'0011);
-            voice.env.sustainShift = (sustainRate & 0b0111'1100) >> 2;
+            env.sustainStep = (sustainRate & 0b0000'0011);
+            env.sustainShift = (sustainRate & 0b0111'1100) >> 2;
 
             // Set: sustain rate mode (increase and exponential or not).
             // If not specified then default to 'increase' and NOT 'exponential' mode.
@@ -205,26 +223,26 @@ void LIBSPU_SpuSetVoiceAttr(const SpuVoiceAttr& attribs) noexcept {
                     default: break;
                 }
 
-                voice.env.bSustainDec = dir;
-                voice.env.bSustainExp = mode;
+                env.bSustainDec = dir;
+                env.bSustainExp = mode;
             } else {
-                voice.env.bSustainDec = 0;
-                voice.env.bSustainExp = 0;
+                env.bSustainDec = 0;
+                env.bSustainExp = 0;
             }
         }
 
         // Set: release rate
         if (bSetReleaseRate) {
             const uint32_t releaseRate = (attribs.rr < 0x1F) ? attribs.rr : 0x1F;
-            voice.env.releaseShift = releaseRate;
+            env.releaseShift = releaseRate;
 
             // Set: release rate mode (exponential or not).
             // If not specified then default to 'linear' mode.
-            voice.env.bReleaseExp = 0;
+            env.bReleaseExp = 0;
 
             if (bSetReleaseMode) {
                 if (attribs.r_mode == SPU_VOICE_EXPDec) {
-                    voice.env.bReleaseExp = 1;
+                    env.bReleaseExp = 1;
                 }
             }
         }
@@ -234,57 +252,69 @@ void LIBSPU_SpuSetVoiceAttr(const SpuVoiceAttr& attribs) noexcept {
             // Note: the original PSX code set the low 16-bits of the ADSR envelope directly using 'attribs.adsr1'.
             // We can't rely on that method however because a particular bitfield order is not guaranteed in C++.
             // Instead decode all fields individually in a portable manner:
-            voice.env.sustainLevel = attribs.adsr1 & 0xF;
-            voice.env.decayShift = (attribs.adsr1 >> 4) & 0xF;
-            voice.env.attackStep = (attribs.adsr1 >> 8) & 0x3;
-            voice.env.attackShift = (attribs.adsr1 >> 10) & 0x1F;
-            voice.env.bAttackExp = (attribs.adsr1 >> 15);
+            env.sustainLevel = attribs.adsr1 & 0xF;
+            env.decayShift = (attribs.adsr1 >> 4) & 0xF;
+            env.attackStep = (attribs.adsr1 >> 8) & 0x3;
+            env.attackShift = (attribs.adsr1 >> 10) & 0x1F;
+            env.bAttackExp = (attribs.adsr1 >> 15);
         }
 
         if (bSetAdsrPart2) {
             // Note: the original PSX code set the high 16-bits of the ADSR envelope directly using 'attribs.adsr2'.
             // We can't rely on that method however because a particular bitfield order is not guaranteed in C++.
             // Instead decode all fields individually in a portable manner:
-            voice.env.releaseShift = attribs.adsr2 & 0x1F;
-            voice.env.bReleaseExp = (attribs.adsr2 >> 5) & 0x1;
-            voice.env.sustainStep = (attribs.adsr2 >> 6) & 0x3;
-            voice.env.sustainShift = (attribs.adsr2 >> 8) & 0x1F;
-            voice.env._unused = (attribs.adsr2 >> 13) & 0x1;
-            voice.env.bSustainDec = (attribs.adsr2 >> 14) & 0x1;
-            voice.env.bSustainExp = attribs.adsr2 >> 15;
+            env.releaseShift = attribs.adsr2 & 0x1F;
+            env.bReleaseExp = (attribs.adsr2 >> 5) & 0x1;
+            env.sustainStep = (attribs.adsr2 >> 6) & 0x3;
+            env.sustainShift = (attribs.adsr2 >> 8) & 0x1F;
+            env._unused = (attribs.adsr2 >> 13) & 0x1;
+            env.bSustainDec = (attribs.adsr2 >> 14) & 0x1;
+            env.bSustainExp = attribs.adsr2 >> 15;
+        }
+
+        if (bSetEnv) {
+            SpuCmdQueue::submitEnv(voiceIdx8, env);
         }
 
         // Set: wave loop address (64-bit word index).
         // If the given address is not 64-bit aligned then it is aligned up to the next 64-bit boundary.
         if (bSetWaveLoopAddr) {
             const uint32_t addr = (attribs.loop_addr + 7) / 8;
-            voice.adpcmRepeatAddr8 = addr;
+            SpuCmdQueue::submit(SpuCmdQueue::CmdType::SetVoiceRepeatAddr, voiceIdx8, addr);
         }
 
         // Set: left volume and mode
         if (bSetVolL) {
             const uint16_t mode = (bSetVolModeL) ? attribs.volmode.left : 0;
 
+            int16_t vol = {};
+
             if (mode == 0) {
-                voice.volume.left = attribs.volume.left & 0x7FFF;
+                vol = attribs.volume.left & 0x7FFF;
             } else {
                 const uint16_t volBits = (attribs.volume.left < 0x7F) ? attribs.volume.left : 0x7F;
                 const uint16_t modeBits = 0x8000 | ((mode - 1) << 12);
-                voice.volume.left = modeBits | volBits;
+                vol = (int16_t)(modeBits | volBits);
             }
+
+            SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetVoiceVolLeft, voiceIdx8, vol);
         }
 
         // Set: right volume and mode
         if (bSetVolR) {
             const uint16_t mode = (bSetVolModeR) ? attribs.volmode.right : 0;
 
+            int16_t vol = {};
+
             if (mode == 0) {
-                voice.volume.right = attribs.volume.right & 0x7FFF;
+                vol = attribs.volume.right & 0x7FFF;
             } else {
                 const uint16_t volBits = (attribs.volume.right < 0x7F) ? attribs.volume.right : 0x7F;
                 const uint16_t modeBits = 0x8000 | ((mode - 1) << 12);
-                voice.volume.right = modeBits | volBits;
+                vol = (int16_t)(modeBits | volBits);
             }
+
+            SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetVoiceVolRight, voiceIdx8, vol);
         }
     }
 }
@@ -522,33 +552,37 @@ void LIBSPU_SpuSetCommonAttr(const SpuCommonAttr& attribs) noexcept {
         const bool bSetExtMix       = (bSetAllAttribs || (attribMask & SPU_COMMON_EXTMIX));
     #endif
 
-    // Set: master volume and mode (left)
-    Spu::Core& spu = PsxVm::gSpu;
-    PsxVm::LockSpu spuLock;
-
+    // Set: master volume and mode (left).
+    // PsyDoom: rather than locking the SPU and modifying it directly, queue up the register writes for the audio thread to apply.
     if (bSetMVolL) {
         const uint16_t mode = (bSetMVolModeL) ? attribs.mvolmode.left : 0;
+        int16_t vol = {};
 
         if (mode == 0) {
-            spu.masterVol.left = attribs.mvol.left & 0x7FFF;
+            vol = attribs.mvol.left & 0x7FFF;
         } else {
             const uint16_t volBits = std::max(std::min(attribs.mvol.left, (int16_t) 0x7F), (int16_t) 0);
             const uint16_t modeBits = 0x8000 | ((mode - 1) << 12);
-            spu.masterVol.left = modeBits | volBits;
+            vol = (int16_t)(modeBits | volBits);
         }
+
+        SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetMasterVolLeft, 0, vol);
     }
 
     // Set: master volume and mode (right)
     if (bSetMVolR) {
         const uint16_t mode = (bSetMVolModeR) ? attribs.mvolmode.right : 0;
+        int16_t vol = {};
 
         if (mode == 0) {
-            spu.masterVol.right = attribs.mvol.right & 0x7FFF;
+            vol = attribs.mvol.right & 0x7FFF;
         } else {
             const uint16_t volBits = std::max(std::min(attribs.mvol.right, (int16_t) 0x7F), (int16_t) 0);
             const uint16_t modeBits = 0x8000 | ((mode - 1) << 12);
-            spu.masterVol.right = modeBits | volBits;
+            vol = (int16_t)(modeBits | volBits);
         }
+
+        SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetMasterVolRight, 0, vol);
     }
 
     // Note: PsyDoom's new SPU implemention only supports a single external input, which is used to supply CD audio.
@@ -558,20 +592,20 @@ void LIBSPU_SpuSetCommonAttr(const SpuCommonAttr& attribs) noexcept {
 
     // Set: cd volume left and right
     if (bSetCdVolL) {
-        spu.extInputVol.left = attribs.cd.volume.left;
+        SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetExtInputVolLeft, 0, attribs.cd.volume.left);
     }
 
     if (bSetCdVolR) {
-        spu.extInputVol.right = attribs.cd.volume.right;
+        SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetExtInputVolRight, 0, attribs.cd.volume.right);
     }
 
     // Set: cd reverb and mix enabled
     if (bSetCdReverb) {
-        spu.bExtReverbEnable = (attribs.cd.reverb != 0);
+        SpuCmdQueue::submitBool(SpuCmdQueue::CmdType::SetExtReverbEnabled, 0, (attribs.cd.reverb != 0));
     }
 
     if (bSetCdMix) {
-        spu.bExtEnabled = (attribs.cd.mix != 0);
+        SpuCmdQueue::submitBool(SpuCmdQueue::CmdType::SetExtEnabled, 0, (attribs.cd.mix != 0));
     }
 
     // Attributes relating to PlayStation external inputs are ignored for PsyDoom (see comments above)
@@ -644,15 +678,12 @@ void LIBSPU_SpuStart() noexcept {
 // By default both left and right channels are set, but you can set independently using 'SPU_REV_DEPTHL' and 'SPU_REV_DEPTHR' mask flags.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void LIBSPU_SpuSetReverbDepth(const SpuReverbAttr& reverb) noexcept {
-    Spu::Core& spu = PsxVm::gSpu;
-    PsxVm::LockSpu spuLock;
-
     if ((reverb.mask == 0) || (reverb.mask & SPU_REV_DEPTHL)) {
-        spu.reverbVol.left = reverb.depth.left;
+        SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetReverbVolLeft, 0, reverb.depth.left);
     }
 
     if ((reverb.mask == 0) || (reverb.mask & SPU_REV_DEPTHR)) {
-        spu.reverbVol.right = reverb.depth.right;
+        SpuCmdQueue::submitVol(SpuCmdQueue::CmdType::SetReverbVolRight, 0, reverb.depth.right);
     }
 }
 
@@ -667,33 +698,30 @@ void LIBSPU_SpuSetReverbDepth(const SpuReverbAttr& reverb) noexcept {
 //            If the bit is set then reverb is enabled.
 //------------------------------------------------------------------------------------------------------------------------------------------
 SpuVoiceMask LIBSPU_SpuSetReverbVoice(const int32_t onOff, const SpuVoiceMask voiceBits) noexcept {
-    // Enabling/disabling reverb for every single voice with the bit mask?
-    Spu::Core& spu = PsxVm::gSpu;
-    PsxVm::LockSpu spuLock;
+    // Figure out which voices will have reverb enabled after this call.
+    // Either reverb is being enabled/disabled for every single voice with the bit mask, or just for specific voices.
+    SpuVoiceMask enabledVoiceBits = 0;
 
     if (onOff == SPU_BIT) {
-        for (uint32_t voiceIdx = 0; voiceIdx < SPU_NUM_VOICES; ++voiceIdx) {
-            Spu::Voice& voice = spu.pVoices[voiceIdx];
-            voice.bDoReverb = (voiceBits & (SpuVoiceMask(1) << voiceIdx));
-        }
-
-        return voiceBits;
+        enabledVoiceBits = voiceBits;
+    } else if (onOff != SPU_OFF) {
+        enabledVoiceBits = gReverbVoiceBits | voiceBits;
+    } else {
+        enabledVoiceBits = gReverbVoiceBits & (~voiceBits);
     }
 
-    // Enable or disable reverb for specific voices and return the reverb status of all voices after
-    const bool bEnableReverb = (onOff != SPU_OFF);
-    SpuVoiceMask enabledVoiceBits = 0;
+    // PsyDoom: queue up the register writes for the audio thread to apply, but only for voices where the reverb status has changed
+    const SpuVoiceMask changedVoiceBits = gReverbVoiceBits ^ enabledVoiceBits;
 
     for (uint32_t voiceIdx = 0; voiceIdx < SPU_NUM_VOICES; ++voiceIdx) {
-        Spu::Voice& voice = spu.pVoices[voiceIdx];
+        const SpuVoiceMask voiceBit = SpuVoiceMask(1) << voiceIdx;
 
-        if (voiceBits & (SpuVoiceMask(1) << voiceIdx)) {
-            voice.bDoReverb = bEnableReverb;
+        if (changedVoiceBits & voiceBit) {
+            SpuCmdQueue::submitBool(SpuCmdQueue::CmdType::SetVoiceReverb, (uint8_t) voiceIdx, (enabledVoiceBits & voiceBit));
         }
-
-        enabledVoiceBits |= (voice.bDoReverb) ? (SpuVoiceMask(1) << voiceIdx) : 0;
     }
 
+    gReverbVoiceBits = enabledVoiceBits;
     return enabledVoiceBits;
 }
 
@@ -721,8 +749,17 @@ void LIBSPU_SpuInit() noexcept {
         voice.sampleRate = 0x00FF;
         voice.adpcmStartAddr8 = 0;
         voice.env = {};
+        voice.bDoReverb = false;
+    }
+
+    // PsyDoom: reset the tracked voice state to match.
+    // Note: reverb must be cleared on the voices too, since 'LIBSPU_SpuSetReverbVoice' only writes the voices whose reverb bit changes.
+    for (Spu::AdsrEnvelope& env : gVoiceEnvs) {
+        env = {};
     }
 
+    gReverbVoiceBits = 0;
+
     spu.bUnmute = true;
     LIBSPU_SpuStart();
 
@@ -745,10 +782,7 @@ void LIBSPU_SpuInit() noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 int32_t LIBSPU_SpuSetReverb(const int32_t onOff) noexcept {
     const bool bEnable = (onOff != SPU_OFF);
-
-    Spu::Core& spu = PsxVm::gSpu;
-    PsxVm::LockSpu spuLock;
-    spu.bReverbWriteEnable = bEnable;
+    SpuCmdQueue::submitBool(SpuCmdQueue::CmdType::SetReverbWriteEnabled, 0, bEnable);
     return (bEnable) ? SPU_ON : SPU_OFF;
 }
 
@@ -838,25 +872,19 @@ void LIBSPU_SpuSetKeyOnWithAttr(const SpuVoiceAttr& attribs) noexcept {
 // The on/off action to perform must be either 'SPU_OFF' or 'SPU_ON'
 //------------------------------------------------------------------------------------------------------------------------------------------
 void LIBSPU_SpuSetKey(const int32_t onOff, const SpuVoiceMask voiceBits) noexcept {
-    Spu::Core& spu = PsxVm::gSpu;
-    PsxVm::LockSpu spuLock;
+    if ((onOff != SPU_OFF) && (onOff != SPU_ON))
+        return;
 
-    const uint32_t numVoicesToSet = std::min(SPU_NUM_VOICES, spu.numVoices);
+    // PsyDoom: queue up the key on/off for the audio thread to apply, and remember the command so the status can be reported while pending
+    const uint32_t numVoicesToSet = std::min(SPU_NUM_VOICES, PsxVm::gSpu.numVoices);
+    const bool bKeyOn = (onOff == SPU_ON);
+    const SpuCmdQueue::CmdType cmdType = (bKeyOn) ? SpuCmdQueue::CmdType::KeyOn : SpuCmdQueue::CmdType::KeyOff;
 
-    if (onOff == SPU_OFF) {
-        for (uint32_t voiceIdx = 0; voiceIdx < numVoicesToSet; ++voiceIdx) {
-            if (voiceBits & (SpuVoiceMask(1) << voiceIdx)) {
-                Spu::Voice& voice = spu.pVoices[voiceIdx];
-                Spu::keyOff(voice);
-            }
-        }
-    }
-    else if (onOff == SPU_ON) {
-        for (uint32_t voiceIdx = 0; voiceIdx < numVoicesToSet; ++voiceIdx) {
-            if (voiceBits & (SpuVoiceMask(1) << voiceIdx)) {
-                Spu::Voice& voice = spu.pVoices[voiceIdx];
-                Spu::keyOn(voice);
-            }
+    for (uint32_t voiceIdx = 0; voiceIdx < numVoicesToSet; ++voiceIdx) {
+        if (voiceBits & (SpuVoiceMask(1) << voiceIdx)) {
+            SpuCmdQueue::submit(cmdType, (uint8_t) voiceIdx, 0);
+            gVoiceKeyCmdNums[voiceIdx] = SpuCmdQueue::getNumCmdsSubmitted();
+            gbVoiceKeyCmdIsOn[voiceIdx] = bKeyOn;
         }
     }
 }
@@ -875,6 +903,12 @@ void LIBSPU_SpuGetAllKeysStatus(uint8_t statuses[SPU_NUM_VOICES]) noexcept {
     const uint32_t numVoicesToGet = std::min(SPU_NUM_VOICES, spu.numVoices);
 
     for (uint32_t voiceIdx = 0; voiceIdx < numVoicesToGet; ++voiceIdx) {
+        // PsyDoom: if a key on/off for the voice is still waiting to be applied by the audio thread then report the status it will have
+        if (SpuCmdQueue::isCmdPending(gVoiceKeyCmdNums[voiceIdx])) {
+            statuses[voiceIdx] = (gbVoiceKeyCmdIsOn[voiceIdx]) ? SPU_ON : SPU_OFF_ENV_ON;
+            continue;
+        }
+
         const Spu::EnvPhase envPhase = spu.pVoices[voiceIdx].envPhase;
 
         switch (envPhase) {
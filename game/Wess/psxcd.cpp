@@ -15,11 +15,17 @@
 #include "PsyDoom/ModMgr.h"
 #include "PsyDoom/ProgArgs.h"
 #include "PsyDoom/PsxVm.h"
+#include "PsyDoom/SpscQueue.h"
 #include "PsyDoom/Utils.h"
 #include "Spu.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
 #include <mutex>
+#include <thread>
 
 // PsyDoom: raise the open file limit
 #if PSYDOOM_MODS
@@ -31,6 +37,11 @@
 static constexpr int32_t FADE_TIME_MS       = 250;      // Time it takes to fade out CD audio (milliseconds)
 static constexpr int32_t CDDA_SECTOR_SIZE   = 2352;     // Size of of a CD digital audio sector
 
+// How many sectors of CD audio the reader thread tries to keep buffered ahead of playback (~13.3 ms of audio per sector).
+// The ring holding the sectors is larger than this so that new playback can be buffered while sectors from old playback are discarded.
+static constexpr uint32_t CDDA_READ_AHEAD_SECTORS   = 32;
+static constexpr uint32_t CDDA_SECTOR_RING_SIZE     = 64;
+
 // If true then the 'psxcd' module has been initialized
 static bool gbPSXCD_IsCdInit;
 
@@ -38,22 +49,23 @@ static bool gbPSXCD_IsCdInit;
 static PsxCd_File gPSXCD_cdfile;
 
 // CD audio playback related state.
-// Access to all of this is controlled by the CD player mutex.
+// Access to all of this (except where noted) is controlled by the CD player mutex, which the audio thread never takes.
 static struct {
-    DiscReader  discReader          = { PsxVm::gDiscInfo };     // The disc reader used to stream the audio
-    bool        bPlay               = false;                    // If 'false' then playback is either paused or stopped (stopped if the disc reader doesn't have a track)
-    bool        bLoop               = false;                    // If 'true' then playback is looped upon reaching the end
-    int32_t     bufferOffset        = 0;                        // Where we are in the audio buffer
-    int32_t     loopTrack           = 0;                        // The track to play when looping
-    int32_t     loopSectorOffset    = 0;                        // Offset (in sectors) to start at in the track when looping
-
-    // The CD audio buffer: we read CD audio in chunks
-    int16_t buffer[CDDA_SECTOR_SIZE / sizeof(int16_t)];
+    DiscReader          discReader          = { PsxVm::gDiscInfo };     // The disc reader used to stream the audio: used by the CD reader thread
+    std::atomic<bool>   bPlay               = false;                    // If 'false' then playback is either paused or stopped (stopped if the disc reader doesn't have a track). Can be cleared by the audio thread.
+    bool                bLoop               = false;                    // If 'true' then playback is looped upon reaching the end
+    int32_t             loopTrack           = 0;                        // The track to play when looping
+    int32_t             loopSectorOffset    = 0;                        // Offset (in sectors) to start at in the track when looping
+    int32_t             startTrack          = 0;                        // The track that playback started on
+    int32_t             startSectorOffset   = 0;                        // Offset (in sectors) that playback started at in the start track
+    uint32_t            readPlayGen         = 0;                        // CD reader thread: which playback request (generation) the reader is buffering sectors for
+    uint32_t            numPlayGenSectors   = 0;                        // CD reader thread: how many sectors have been buffered for the current playback request
+    bool                bReadReachedEnd     = false;                    // CD reader thread: true if there is nothing more to read for the current playback request
 } gCdPlayer;
 
 // The lock for the CD player and a helper to lock/unlock via RAII.
 // N.B: this *CANNOT* be held the same time as the SPU lock, otherwise deadlock MIGHT occur!
-// The SPU can request audio from the CD and thus needs access to the cd player lock also.
+// The SPU lock is held by the audio thread, so holding both could stall audio.
 static std::recursive_mutex gCdPlayerMutex;
 
 struct LockCdPlayer {
@@ -61,6 +73,46 @@ struct LockCdPlayer {
     ~LockCdPlayer() noexcept { gCdPlayerMutex.unlock(); }
 };
 
+// A sector of CD audio read ahead of time by the CD reader thread, waiting to be played by the audio thread
+struct CdAudioSector {
+    int16_t     samples[CDDA_SECTOR_SIZE / sizeof(int16_t)];    // The 16-bit stereo samples for the sector
+    uint32_t    playGen;                                        // Which playback request (generation) the sector was read for
+    int32_t     trackNum;                                       // Which track the sector is from
+    int32_t     elapsedSectors;                                 // What 'psxcd_elapsed_sectors' reports once this sector begins playing
+    bool        bEndOfPlayback;                                 // If set then this is not audio but a marker saying playback has ended (no looping)
+};
+
+// Sectors of CD audio which have been read ahead of playback: pushed by the CD reader thread and popped by the audio thread.
+// The playback request (generation) counter is incremented every time playback is started or stopped, so that any sectors left over from
+// previous playback can be discarded by the audio thread. It is only modified while the CD player is locked.
+static SpscQueue<CdAudioSector, CDDA_SECTOR_RING_SIZE>  gCdSectorRing;
+static std::atomic<uint32_t>                            gCdPlayGen;
+
+// Audio thread state: where we are in the sector at the front of the ring and whether the current playback request has had audio played yet
+static uint32_t     gCdSectorSampleIdx;
+static uint32_t     gCdLastAudioPlayGen;
+static bool         gbCdAudioStarved;
+
+// The current playback position, set by the audio thread as it begins playing each sector.
+// Bits 0-31 hold the elapsed sector count, bits 32-47 the track number and bits 48-63 the low 16-bits of the playback request number.
+static std::atomic<uint64_t> gCdPlayPos;
+
+// Stats: how many times playback ran out of buffered CD audio, and the total number of samples of silence output as a result
+static std::atomic<uint32_t> gNumCdUnderruns;
+static std::atomic<uint32_t> gNumCdUnderrunSamples;
+
+// The thread which reads CD audio ahead of playback, a condition variable used to wake it up and a flag telling it to quit.
+// Note: this is declared after the CD player state so that it is destroyed (and the thread stopped) first at program exit.
+static std::condition_variable_any  gCdReaderWakeCond;
+static std::atomic<bool>            gbCdReaderQuit;
+
+static void stopCdReaderThread() noexcept;
+
+static struct CdReaderThread {
+    std::thread thread;
+    ~CdReaderThread() noexcept { stopCdReaderThread(); }
+} gCdReaderThread;
+
 // Disc readers used for each open file
 static DiscReader gFileDiscReaders[MAX_OPEN_FILES] = {
     PsxVm::gDiscInfo, PsxVm::gDiscInfo, PsxVm::gDiscInfo, PsxVm::gDiscInfo,
@@ -70,44 +122,77 @@ static DiscReader gFileDiscReaders[MAX_OPEN_FILES] = {
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// A callback invoked by the SPU when it wants audio from the CD player - returns a single sample.
+// Packs up the playback position published by the audio thread
 //------------------------------------------------------------------------------------------------------------------------------------------
-static Spu::StereoSample SpuAudioCallback([[maybe_unused]] void* pUserData) noexcept {
-    // Lock the CD player while we are doing this.
-    // Note that this thread also has the SPU lock at this point too.
-    // Therefore the main thread must NOT lock both the CD player and the SPU at the same time, or otherwise a deadlock might occur.
-    LockCdPlayer cdPlayerLock;
+static uint64_t makeCdPlayPos(const uint32_t playGen, const int32_t trackNum, const int32_t elapsedSectors) noexcept {
+    return (
+        ((uint64_t)(playGen & 0xFFFF) << 48) |
+        ((uint64_t)(trackNum & 0xFFFF) << 32) |
+        (uint64_t)(uint32_t) elapsedSectors
+    );
+}
 
-    // If the CD player is not currently active then return silence
-    if ((!gCdPlayer.bPlay) || (!gCdPlayer.discReader.isTrackOpen()))
-        return Spu::StereoSample{};
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Starts a new CD playback request (or stops playback) by incrementing the request counter.
+// Any sectors buffered for previous requests will be skipped by the audio thread. The CD player must be locked when calling this.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void beginNewCdPlayGen() noexcept {
+    gCdPlayGen.store(gCdPlayGen.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    gCdReaderWakeCond.notify_one();
+}
 
-    // Check if we have any data left in the buffer firstly
-    constexpr int16_t SAMPLE_SIZE = sizeof(int16_t);
-    constexpr int32_t NUM_BUFFER_SAMPLES = sizeof(gCdPlayer.buffer) / SAMPLE_SIZE;
-    static_assert(NUM_BUFFER_SAMPLES % 2 == 0);
+//------------------------------------------------------------------------------------------------------------------------------------------
+// CD reader thread: reads the next sector of CD audio ahead of playback and adds it to the sector ring, if there is room for it.
+// Handles looping back around to the loop track and loop sector offset when the end of the current track is reached.
+// The CD player must be locked when calling this. Returns 'true' if a sector was read.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readAheadCdAudioSector() noexcept {
+    // If a new playback request has been made then start buffering for that
+    const uint32_t playGen = gCdPlayGen.load(std::memory_order_relaxed);
+
+    if (gCdPlayer.readPlayGen != playGen) {
+        gCdPlayer.readPlayGen = playGen;
+        gCdPlayer.numPlayGenSectors = 0;
+        gCdPlayer.bReadReachedEnd = false;
+    }
 
     DiscReader& disc = gCdPlayer.discReader;
 
-    if (gCdPlayer.bufferOffset + 1 >= NUM_BUFFER_SAMPLES) {
-        // Get the size of the track and where we are at in it
-        const DiscTrack* pTrack = disc.getOpenTrack();
-        int32_t trackSize = pTrack->trackPayloadSize;
-        int32_t trackOffset = disc.tell();
-
-        // See if there is any data left in the track to read
-        if (trackOffset >= trackSize) {
-            // We reached the end, do we loop back around again?
-            if (gCdPlayer.bLoop) {
-                // Looping: rewind back to the start plus any additional offset.
-                // Change tracks also if we need to.
-                if (disc.getTrackNum() != gCdPlayer.loopTrack) {
-                    disc.setTrackNum(gCdPlayer.loopTrack);
-
-                    // Need to re-fetch this info when changing tracks
-                    pTrack = disc.getOpenTrack();
-                    trackSize = pTrack->trackPayloadSize;
-                }
+    if (gCdPlayer.bReadReachedEnd || (!disc.isTrackOpen()))
+        return false;
+
+    // Is there room for another sector? Note that the ring might also contain sectors from previous playback, which don't count.
+    const uint32_t ringSize = gCdSectorRing.size();
+    const uint32_t numSectorsBuffered = std::min(ringSize, gCdPlayer.numPlayGenSectors);
+
+    if ((numSectorsBuffered >= CDDA_READ_AHEAD_SECTORS) || (ringSize >= CDDA_SECTOR_RING_SIZE))
+        return false;
+
+    // Get the size of the track and where we are at in it
+    CdAudioSector sector;
+    sector.playGen = playGen;
+    sector.bEndOfPlayback = false;
+
+    const DiscTrack* pTrack = disc.getOpenTrack();
+    int32_t trackSize = pTrack->trackPayloadSize;
+    int32_t trackOffset = disc.tell();
+
+    // See if there is any data left in the track to read
+    if (trackOffset >= trackSize) {
+        // We reached the end, do we loop back around again?
+        bool bLoopOk = gCdPlayer.bLoop;
+
+        if (bLoopOk) {
+            // Looping: rewind back to the start plus any additional offset.
+            // Change tracks also if we need to.
+            if (disc.getTrackNum() != gCdPlayer.loopTrack) {
+                bLoopOk = disc.setTrackNum(gCdPlayer.loopTrack);
+            }
+
+            if (bLoopOk) {
+                // Need to re-fetch this info in case the track changed
+                pTrack = disc.getOpenTrack();
+                trackSize = pTrack->trackPayloadSize;
 
                 if (gCdPlayer.loopSectorOffset > 0) {
                     disc.trackSeekAbs(CDDA_SECTOR_SIZE * gCdPlayer.loopSectorOffset);
@@ -116,31 +201,149 @@ static Spu::StereoSample SpuAudioCallback([[maybe_unused]] void* pUserData) noex
                 }
 
                 trackOffset = disc.tell();
+                bLoopOk = (trackOffset < trackSize);
             }
-            else {
-                // No looping, mark the CD player as no longer playing and return an empty sample
-                gCdPlayer.bPlay = false;
-                return Spu::StereoSample{};
-            }
         }
 
-        // Read what we can and zero anything we can't (in case the last sector is short for some reason)
-        const int32_t samplesToRead = std::min<int32_t>((trackSize - trackOffset) / SAMPLE_SIZE, NUM_BUFFER_SAMPLES);
-        const int32_t samplesToZero = NUM_BUFFER_SAMPLES - samplesToRead;
-        disc.read(gCdPlayer.buffer, samplesToRead * SAMPLE_SIZE);
+        // No looping (or the loop track is bad): add a marker telling the audio thread that playback has ended
+        if (!bLoopOk) {
+            std::memset(sector.samples, 0, sizeof(sector.samples));
+            sector.trackNum = pTrack->trackNum;
+            sector.elapsedSectors = trackOffset / CDDA_SECTOR_SIZE;
+            sector.bEndOfPlayback = true;
+            gCdSectorRing.tryPush(sector);
+            gCdPlayer.bReadReachedEnd = true;
+            return true;
+        }
+    }
+
+    // Read what we can and zero anything we can't (in case the last sector is short for some reason)
+    constexpr int32_t SAMPLE_SIZE = sizeof(int16_t);
+    constexpr int32_t NUM_SECTOR_SAMPLES = CDDA_SECTOR_SIZE / SAMPLE_SIZE;
+
+    const int32_t samplesToRead = std::min<int32_t>((trackSize - trackOffset) / SAMPLE_SIZE, NUM_SECTOR_SAMPLES);
+    const int32_t samplesToZero = NUM_SECTOR_SAMPLES - samplesToRead;
+
+    if (!disc.read(sector.samples, samplesToRead * SAMPLE_SIZE)) {
+        std::memset(sector.samples, 0, (size_t) samplesToRead * SAMPLE_SIZE);
+    }
+
+    if (samplesToZero > 0) {
+        std::memset(sector.samples + samplesToRead, 0, (size_t) samplesToZero * SAMPLE_SIZE);
+    }
+
+    // Save where we are in the disc after this sector and queue it up
+    sector.trackNum = pTrack->trackNum;
+    sector.elapsedSectors = disc.tell() / CDDA_SECTOR_SIZE;
+    gCdSectorRing.tryPush(sector);
+    gCdPlayer.numPlayGenSectors++;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Entry point for the CD reader thread: keeps CD audio buffered ahead of playback until told to quit
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void cdReaderThreadMain() noexcept {
+    while (!gbCdReaderQuit.load(std::memory_order_relaxed)) {
+        // Note: the lock is released between sectors so the main thread doesn't have to wait long to change playback.
+        // If there is nothing to read then wait a little, or until woken. The audio thread doesn't wake this thread since it must never block,
+        // so the timeout needs to be short enough to keep the buffer topped up while playing.
+        std::unique_lock<std::recursive_mutex> cdPlayerLock(gCdPlayerMutex);
+
+        if (!readAheadCdAudioSector()) {
+            gCdReaderWakeCond.wait_for(cdPlayerLock, std::chrono::milliseconds(4));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Starts up the CD reader thread if it is not already running
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void startCdReaderThread() noexcept {
+    if (gCdReaderThread.thread.joinable())
+        return;
+
+    gbCdReaderQuit = false;
+    gCdReaderThread.thread = std::thread(cdReaderThreadMain);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Stops the CD reader thread if it is running
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void stopCdReaderThread() noexcept {
+    if (!gCdReaderThread.thread.joinable())
+        return;
+
+    {
+        LockCdPlayer cdPlayerLock;
+        gbCdReaderQuit = true;
+        gCdReaderWakeCond.notify_one();
+    }
 
-        if (samplesToZero > 0) {
-            std::memset(gCdPlayer.buffer + samplesToRead * SAMPLE_SIZE, 0, (size_t) samplesToZero * SAMPLE_SIZE);
+    gCdReaderThread.thread.join();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A callback invoked by the SPU when it wants audio from the CD player - returns a single sample.
+// This runs on the audio thread and is wait-free: it only takes sectors which have been read ahead of time by the CD reader thread.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static Spu::StereoSample SpuAudioCallback([[maybe_unused]] void* pUserData) noexcept {
+    // Skip past any sectors left over from previous playback requests
+    constexpr uint32_t NUM_SECTOR_SAMPLES = CDDA_SECTOR_SIZE / sizeof(int16_t);
+    static_assert(NUM_SECTOR_SAMPLES % 2 == 0);
+
+    const uint32_t playGen = gCdPlayGen.load(std::memory_order_acquire);
+    const CdAudioSector* pSector = gCdSectorRing.peek();
+
+    while (pSector && (pSector->playGen != playGen)) {
+        gCdSectorRing.popFront();
+        gCdSectorSampleIdx = 0;
+        pSector = gCdSectorRing.peek();
+    }
+
+    // If the CD player is not currently active then return silence
+    if (!gCdPlayer.bPlay.load(std::memory_order_relaxed))
+        return Spu::StereoSample{};
+
+    // If there is no audio buffered then we've underrun: count the number of times it happens, once playback for the request has begun
+    if (!pSector) {
+        if (gCdLastAudioPlayGen == playGen) {
+            if (!gbCdAudioStarved) {
+                gNumCdUnderruns.fetch_add(1, std::memory_order_relaxed);
+                gbCdAudioStarved = true;
+            }
+
+            gNumCdUnderrunSamples.fetch_add(1, std::memory_order_relaxed);
         }
 
-        gCdPlayer.bufferOffset = 0;
+        return Spu::StereoSample{};
     }
 
-    // Should have samples in the buffer at this point, return the requested samples
-    ASSERT(gCdPlayer.bufferOffset + 2 <= NUM_BUFFER_SAMPLES);
+    // Reached the end of playback? If so mark the CD player as no longer playing and return an empty sample.
+    // Note: the end marker is left in the ring so that trying to resume playback will also just end again.
+    if (pSector->bEndOfPlayback) {
+        gCdPlayer.bPlay = false;
+        return Spu::StereoSample{};
+    }
+
+    // Beginning a new sector? If so then update the playback position.
+    if (gCdSectorSampleIdx == 0) {
+        gCdPlayPos.store(makeCdPlayPos(playGen, pSector->trackNum, pSector->elapsedSectors), std::memory_order_relaxed);
+    }
+
+    gCdLastAudioPlayGen = playGen;
+    gbCdAudioStarved = false;
+
+    // Return the next sample and move onto the next sector if this one is done
+    ASSERT(gCdSectorSampleIdx + 2 <= NUM_SECTOR_SAMPLES);
+    const Spu::StereoSample sample = { pSector->samples[gCdSectorSampleIdx], pSector->samples[gCdSectorSampleIdx + 1] };
+    gCdSectorSampleIdx += 2;
+
+    if (gCdSectorSampleIdx >= NUM_SECTOR_SAMPLES) {
+        gCdSectorRing.popFront();
+        gCdSectorSampleIdx = 0;
+    }
 
-    Spu::StereoSample sample = { gCdPlayer.buffer[gCdPlayer.bufferOffset], gCdPlayer.buffer[gCdPlayer.bufferOffset + 1] };
-    gCdPlayer.bufferOffset += 2;
     return sample;
 }
 
@@ -162,6 +365,11 @@ void psxcd_init() noexcept {
         PsxVm::gSpu.pExtInputCallback = SpuAudioCallback;
         PsxVm::gSpu.pExtInputUserData = nullptr;
     }
+
+    // PsyDoom: start reading CD audio in the background (not needed in headless mode since CD audio is never played)
+    if (!ProgArgs::gbHeadlessMode) {
+        startCdReaderThread();
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -174,6 +382,19 @@ void psxcd_exit() noexcept {
         PsxVm::gSpu.pExtInputCallback = nullptr;
         PsxVm::gSpu.pExtInputUserData = nullptr;
     }
+
+    // PsyDoom: stop reading CD audio in the background and print stats if requested
+    stopCdReaderThread();
+
+    if (ProgArgs::gbPrintSpuStats) {
+        std::printf(
+            "CD audio: %u underruns, %u samples of silence output due to underruns\n",
+            psxcd_get_num_underruns(),
+            gNumCdUnderrunSamples.load()
+        );
+    }
+
+    gbPSXCD_IsCdInit = false;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -381,21 +602,22 @@ static void psxcd_play_internal(
         psxspu_start_cd_fade(fadeUpTime, vol);
     }
 
-    // Skip the requested number of sectors
+    // Skip the requested number of sectors.
+    // PsyDoom: always seek, since the CD reader thread may have read from the track (for the previous playback request) in the meantime.
     {
         // N.B: don't hold this lock in the main thread at the same time as the SPU lock - otherwise deadlock might occur!
         LockCdPlayer cdPlayerLock;
+        gCdPlayer.discReader.trackSeekAbs(CDDA_SECTOR_SIZE * std::max(sectorOffset, 0));
 
-        if (sectorOffset > 0) {
-            gCdPlayer.discReader.trackSeekAbs(CDDA_SECTOR_SIZE * sectorOffset);
-        }
-
-        // Mark the player as playing and save loop parameters
+        // Mark the player as playing and save loop parameters.
+        // PsyDoom: also start a new playback request so the CD reader thread begins buffering the new audio.
         gCdPlayer.bPlay = true;
-        gCdPlayer.bufferOffset = CDDA_SECTOR_SIZE / sizeof(int16_t);    // Need to read a sector
         gCdPlayer.bLoop = bLoop;
         gCdPlayer.loopTrack = loopTrack;
         gCdPlayer.loopSectorOffset = loopSectorOffset;
+        gCdPlayer.startTrack = track;
+        gCdPlayer.startSectorOffset = gCdPlayer.discReader.tell() / CDDA_SECTOR_SIZE;
+        beginNewCdPlayGen();
     }
 }
 
@@ -476,8 +698,10 @@ void psxcd_stop() noexcept {
         gCdPlayer.discReader.closeTrack();
         gCdPlayer.bPlay = false;
         gCdPlayer.bLoop = false;
-        gCdPlayer.bufferOffset = 0;
         gCdPlayer.loopSectorOffset = 0;
+        gCdPlayer.startTrack = 0;
+        gCdPlayer.startSectorOffset = 0;
+        beginNewCdPlayGen();
     }
 }
 
@@ -525,6 +749,7 @@ void psxcd_restart(const int32_t vol) noexcept {
 
         // Begin playing again
         gCdPlayer.bPlay = true;
+        gCdReaderWakeCond.notify_one();
     }
 
     // Set the audio volume
@@ -537,7 +762,15 @@ void psxcd_restart(const int32_t vol) noexcept {
 int32_t psxcd_elapsed_sectors() noexcept {
     // N.B: don't hold this lock in the main thread at the same time as the SPU lock - otherwise deadlock might occur!
     LockCdPlayer cdPlayerLock;
-    return (gCdPlayer.discReader.isTrackOpen()) ? gCdPlayer.discReader.tell() / CDDA_SECTOR_SIZE : 0;
+
+    if (!gCdPlayer.discReader.isTrackOpen())
+        return 0;
+
+    // PsyDoom: the disc reader is ahead of playback, so use the position of the sector being played by the audio thread.
+    // If nothing has been played yet for the current playback request then use where playback started.
+    const uint64_t playPos = gCdPlayPos.load(std::memory_order_relaxed);
+    const bool bIsPlayPosValid = ((playPos >> 48) == (gCdPlayGen.load(std::memory_order_relaxed) & 0xFFFF));
+    return (bIsPlayPosValid) ? (int32_t)(uint32_t) playPos : gCdPlayer.startSectorOffset;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -553,6 +786,20 @@ int32_t psxcd_get_file_size(const CdFileId discFile) noexcept {
 
 int32_t psxcd_get_playing_track() noexcept {
     LockCdPlayer cdPlayerLock;
-    const DiscTrack* const pTrack = gCdPlayer.discReader.getOpenTrack();
-    return (pTrack) ? pTrack->trackNum : -1;
+
+    if (!gCdPlayer.discReader.isTrackOpen())
+        return -1;
+
+    // PsyDoom: the disc reader might have already moved onto the loop track, so use the track of the sector being played by the audio thread.
+    // If nothing has been played yet for the current playback request then use the track that playback started on.
+    const uint64_t playPos = gCdPlayPos.load(std::memory_order_relaxed);
+    const bool bIsPlayPosValid = ((playPos >> 48) == (gCdPlayGen.load(std::memory_order_relaxed) & 0xFFFF));
+    return (bIsPlayPosValid) ? (int32_t)((playPos >> 32) & 0xFFFF) : gCdPlayer.startTrack;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom addition: returns how many times CD audio playback has run out of buffered audio, due to the disc being read too slowly
+//------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t psxcd_get_num_underruns() noexcept {
+    return gNumCdUnderruns.load(std::memory_order_relaxed);
 }
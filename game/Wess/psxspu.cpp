@@ -78,6 +78,7 @@ void psxspu_init_reverb(
     const int32_t delay,
     const int32_t feedback
 ) noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     gPsxSpu_rev_attr.mask = SPU_REV_MODE | SPU_REV_DEPTHL | SPU_REV_DEPTHR | SPU_REV_DELAYTIME | SPU_REV_FEEDBACK;
@@ -121,6 +122,7 @@ void psxspu_init_reverb(
 // Set the reverb strength for the left and right channels
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_set_reverb_depth(const int16_t depthLeft, const int16_t depthRight) noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     gPsxSpu_rev_attr.depth.left = depthLeft;
@@ -137,6 +139,7 @@ void psxspu_init() noexcept {
     if (gbPsxSpu_initialized)
         return;
 
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     LIBSPU_SpuInit();
@@ -200,6 +203,7 @@ static void psxspu_set_cd_volume(const int32_t vol) noexcept {
 // Enable mixing of cd audio into the sound output
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_setcdmixon() noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     SpuCommonAttr attribs;
@@ -214,6 +218,7 @@ void psxspu_setcdmixon() noexcept {
 // Disable mixing of cd audio into the sound output
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_setcdmixoff() noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     SpuCommonAttr attribs;
@@ -267,6 +272,7 @@ void psxspu_fadeengine() noexcept {
 // Set the current cd audio volume and disable any fades on cd volume that are active
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_set_cd_vol(const int32_t vol) noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     gPsxSpu_cd_vol = vol;
@@ -294,6 +300,7 @@ void psxspu_start_cd_fade(const int32_t fadeTimeMs, const int32_t destVol) noexc
             return;
     #endif
 
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     if (gbWess_WessTimerActive) {
@@ -313,6 +320,7 @@ void psxspu_start_cd_fade(const int32_t fadeTimeMs, const int32_t destVol) noexc
 // Stop doing a fade of cd music
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_stop_cd_fade() noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
     gPsxSpu_cd_fade_ticks_left = 0;
     gbPsxSpu_timer_callback_enabled = true;
@@ -329,6 +337,7 @@ bool psxspu_get_cd_fade_status() noexcept {
 // Sets the master volume level
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_set_master_vol(const int32_t vol) noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = 0;
 
     gPsxSpu_master_vol = vol;
@@ -350,6 +359,7 @@ int32_t psxspu_get_master_vol() noexcept {
 // Begin doing a fade of master volume to the specified volume in the specified amount of time
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_start_master_fade(const int32_t fadeTimeMs, const int32_t destVol) noexcept {
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
 
     if (gbWess_WessTimerActive) {
@@ -370,6 +380,7 @@ void psxspu_start_master_fade(const int32_t fadeTimeMs, const int32_t destVol) n
 //------------------------------------------------------------------------------------------------------------------------------------------
 void psxspu_stop_master_fade() noexcept {
     // Note: disabling callback processing before setting the tick count - in case an interrupt happens
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might be running the fade engine, so lock it out too
     gbPsxSpu_timer_callback_enabled = false;
     gPsxSpu_master_fade_ticks_left = 0;
     gbPsxSpu_timer_callback_enabled = true;
@@ -121,6 +121,7 @@ bool wess_init() noexcept {
         return false;
 
     // Ensure the sequencer is initially disabled
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Install the timing handler/callback, init hardware specific stuff and mark the module as initialized
@@ -141,6 +142,8 @@ void wess_exit(bool bForceRestoreTimerHandler) noexcept {
     if ((!Is_System_Active()) || (!gbWess_sysinit))
         return;
 
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
+
     // Unload the current module and do hardware specific shutdown
     if (gbWess_module_loaded) {
         wess_unload_module();
@@ -194,6 +197,7 @@ void wess_unload_module() noexcept {
         return;
 
     // Shutdown the sequencer engine
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     wess_seq_stopall();
     gbWess_SeqOn = false;
 
@@ -756,6 +760,7 @@ int32_t wess_load_module(
     }
 
     // The module is now loaded and the sequencer is enabled
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_module_loaded = true;
     gbWess_SeqOn = true;
 
@@ -891,6 +896,7 @@ int32_t wess_seq_structrig(
         return 0;
 
     // Disable sequencer ticking temporarily (to avoid hardware timer interrupts) while we setup all this
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     master_status_structure& mstat = *gpWess_pm_stat;
@@ -1052,6 +1058,7 @@ void wess_seq_stop(const int32_t seqIdx) noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Run through all of the sequences searching for the one we are interested in
@@ -1113,6 +1120,7 @@ void wess_seq_stopall() noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Grab some basic info from the master status
@@ -40,6 +40,7 @@ void wess_master_mus_vol_set(const uint8_t musicVol) noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Update the master volume global
@@ -49,6 +49,7 @@ void wess_seq_pause(const int32_t seqIdx, const bool bMute) noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Grab some basic info from the master status
@@ -117,6 +118,7 @@ void wess_seq_restart(const int32_t seqIdx) noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Grab some basic info from the master status
@@ -180,6 +182,7 @@ void wess_seq_pauseall(const bool bMute, SavedVoiceList* const pSavedVoices) noe
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // If muting temporarily, then save the state of all voices to the given state struct (if given).
@@ -258,6 +261,7 @@ void wess_seq_restartall(SavedVoiceList* const pSavedVoices) noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Grab some basic info from the master status
@@ -148,6 +148,7 @@ void wess_seq_update_type_special(const uintptr_t seqType, const TriggerPlayAttr
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Grab some basic info from the master status
@@ -213,6 +214,7 @@ void wess_seq_stoptype(const uintptr_t seqType) noexcept {
 
     // Temporarily disable the sequencer while we do this.
     // It was originally fired by hardware timer interrupts, so this step was required.
+    WessSeqLock seqLock;    // PsyDoom: the audio thread might also be running the sequencer, so lock it out too
     gbWess_SeqOn = false;
 
     // Grab some basic info from the master status
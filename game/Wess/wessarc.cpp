@@ -5,11 +5,18 @@
 
 #include "psxcmd.h"
 #include "psxspu.h"
+#include "PsyDoom/Config/Config.h"
+#include "PsyDoom/ProgArgs.h"
+#include "PsyDoom/PsxVm.h"
 #include "PsyQ/LIBAPI.h"
 #include "PsyQ/LIBSPU.h"
 #include "SmallString.h"
 #include "wessseq.h"
 
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
 const WessDriverFunc* const gWess_CmdFuncArr[10] = {
     gWess_DrvFunctions,
     gWess_drv_cmds,
@@ -44,6 +51,18 @@ static PsxCd_File   gWess_module_fileref;       // Holds the current file open b
 static PsxCd_File   gWess_data_fileref;         // Holds the current file open by the data loader
 static bool         gbWess_ReadChunk1;          // If true we can read data to sector buffer 1
 static bool         gbWess_ReadChunk2;          // If true we can read data to sector buffer 2
+static std::recursive_mutex gWess_SeqMutex;     // PsyDoom: guards sequencer state against concurrent updates from the audio thread (see 'WessSeqLock')
+
+#if PSYDOOM_MODS
+    // PsyDoom: true if the timer interrupt handler and sequencer are being driven by the audio thread rather than by 'Utils::doPlatformUpdates'
+    bool gbWess_AudioThreadTiming;
+
+    // PsyDoom: the sample rate of the audio thread and state for driving the sequencer from it
+    static constexpr uint32_t AUDIO_SAMPLE_RATE = 44100;
+
+    static uint32_t     gWess_AudioSamplesToAdvance;    // Samples generated by the audio thread which the sequencer has not yet been advanced by
+    static uint32_t     gWess_AudioTimerPhase;          // Progress towards the next timer interrupt in units of '1 / GetIntsPerSec()' samples
+#endif
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Gives the number of ticks or interrupts per second the music system uses.
@@ -96,7 +115,7 @@ int32_t WessInterruptHandler() noexcept {
     // Execute the sequencer engine if it is enabled.
     //
     // PsyDoom: this is now invoked by 'Utils::doPlatformUpdates' as frequently as possible and with a variable delta time.
-    // This helps keep the music timing as stable as possible.
+    // This helps keep the music timing as stable as possible. Alternatively it can be driven by the audio thread with sample accurate timing.
     #if !PSYDOOM_MODS
         if (gbWess_SeqOn) {
             SeqEngine();
@@ -108,6 +127,94 @@ int32_t WessInterruptHandler() noexcept {
     return 0;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: lock or unlock the sequencer so the audio thread won't step it (if it is doing that)
+//------------------------------------------------------------------------------------------------------------------------------------------
+void Wess_LockSeq() noexcept {
+    gWess_SeqMutex.lock();
+}
+
+void Wess_UnlockSeq() noexcept {
+    gWess_SeqMutex.unlock();
+}
+
+#if PSYDOOM_MODS
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: returns how many samples the audio thread can generate before the next timer interrupt or sequencer command is due.
+// Always returns at least '1' sample.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t Wess_GetAudioSamplesTillNextEvent() noexcept {
+    const uint32_t intsPerSec = GetIntsPerSec();
+    const uint32_t samplesTillTimer = (AUDIO_SAMPLE_RATE - gWess_AudioTimerPhase + intsPerSec - 1) / intsPerSec;
+    uint32_t samplesTillEvent = samplesTillTimer;
+
+    if (gbWess_SeqOn) {
+        const double ticksTillCmd = SeqEngineGetTicksTillNextCmd();
+
+        if (ticksTillCmd >= 0.0) {
+            const double samplesTillCmd = std::ceil(ticksTillCmd * (double) AUDIO_SAMPLE_RATE / (double) intsPerSec);
+
+            if (samplesTillCmd < (double) samplesTillEvent) {
+                samplesTillEvent = (uint32_t) samplesTillCmd;
+            }
+        }
+    }
+
+    return std::max(samplesTillEvent, 1u);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: advance the sequencer and the timer by the given number of audio samples, calling the timer interrupt handler when it is due.
+// The given amount of time should not go past the next interrupt or sequencer command (see 'Wess_GetAudioSamplesTillNextEvent').
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void Wess_AdvanceAudioTime(const uint32_t numSamples) noexcept {
+    const uint32_t intsPerSec = GetIntsPerSec();
+
+    if (gbWess_SeqOn) {
+        SeqEngineAdvance((double) numSamples * (double) intsPerSec / (double) AUDIO_SAMPLE_RATE);
+    }
+
+    gWess_AudioTimerPhase += numSamples * intsPerSec;
+
+    while (gWess_AudioTimerPhase >= AUDIO_SAMPLE_RATE) {
+        gWess_AudioTimerPhase -= AUDIO_SAMPLE_RATE;
+        WessInterruptHandler();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: called by the audio thread before it generates each block of samples, when the sequencer is being driven by the audio thread.
+// Catches up the sequencer and timer on samples generated so far, then returns how many samples can be generated until the next event.
+// This means that sequencer commands are executed at the exact sample they are due at, regardless of how the game loop is paced.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t Wess_AudioThreadUpdate(const uint32_t maxSamples) noexcept {
+    // Don't wait on the game thread if it is modifying the sequencer, just keep generating audio and catch up on the next call.
+    // This will delay some sequencer commands slightly but the overall timing won't drift.
+    if (!gWess_SeqMutex.try_lock()) {
+        gWess_AudioSamplesToAdvance += maxSamples;
+        return maxSamples;
+    }
+
+    // Advance time by the samples generated since the last update, stopping at each event along the way to preserve precision
+    while (gWess_AudioSamplesToAdvance > 0) {
+        const uint32_t numSamples = std::min(gWess_AudioSamplesToAdvance, Wess_GetAudioSamplesTillNextEvent());
+        Wess_AdvanceAudioTime(numSamples);
+        gWess_AudioSamplesToAdvance -= numSamples;
+    }
+
+    // Execute any sequencer commands due right now, such as the first commands for newly triggered tracks
+    if (gbWess_SeqOn && (SeqEngineGetTicksTillNextCmd() == 0.0)) {
+        SeqEngineAdvance(0.0);
+    }
+
+    // Figure out how many samples can be generated before the next event and remember to advance by that much next time
+    const uint32_t numSamplesToGen = std::min(Wess_GetAudioSamplesTillNextEvent(), maxSamples);
+    gWess_AudioSamplesToAdvance = numSamplesToGen;
+    gWess_SeqMutex.unlock();
+    return numSamplesToGen;
+}
+#endif
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Sets up timer interrupts and the timer interrupt handler which drive the entire music and sound sequencer
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -138,12 +245,30 @@ void init_WessTimer() noexcept {
     // The timer handler is now installed, and we can re-enable interrupts
     gbWess_WessTimerActive = true;
     LIBAPI_ExitCriticalSection();
+
+    // PsyDoom: if enabled then have the audio thread drive the timer and sequencer based on the number of samples generated.
+    // If there is no audio device then fallback to having the game loop drive everything.
+    #if PSYDOOM_MODS
+        if (Config::gbAudioThreadMusicTiming && (!ProgArgs::gbHeadlessMode)) {
+            gWess_AudioSamplesToAdvance = 0;
+            gWess_AudioTimerPhase = 0;
+            gbWess_AudioThreadTiming = PsxVm::setAudioThreadUpdateFunc(Wess_AudioThreadUpdate);
+        }
+    #endif
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Shut down the timer interrupts powering the sequencer system
 //------------------------------------------------------------------------------------------------------------------------------------------
 void exit_WessTimer() noexcept {
+    // PsyDoom: stop the audio thread from driving the timer and sequencer, if it was doing that
+    #if PSYDOOM_MODS
+        if (gbWess_AudioThreadTiming) {
+            PsxVm::setAudioThreadUpdateFunc(nullptr);
+            gbWess_AudioThreadTiming = false;
+        }
+    #endif
+
     // Make sure volume levels are actually what we think they are
     const int32_t masterVol = psxspu_get_master_vol();
     psxspu_set_master_vol(masterVol);
@@ -364,6 +364,21 @@ extern uint8_t      gWess_sectorBuffer1[CDROM_SECTOR_SIZE];
 extern uint8_t      gWess_sectorBuffer2[CDROM_SECTOR_SIZE];
 extern bool         gbWess_SeqOn;
 
+#if PSYDOOM_MODS
+    extern bool     gbWess_AudioThreadTiming;
+#endif
+
+// PsyDoom: a lock which must be held by the game thread while it modifies sequencer, track or volume fade state.
+// This takes the place of the original 'gbWess_SeqOn' interrupt guards when the sequencer is being stepped by the audio thread.
+// The audio thread never blocks on this lock: if it can't get it then sequencer updates are postponed until the next block of audio.
+void Wess_LockSeq() noexcept;
+void Wess_UnlockSeq() noexcept;
+
+struct WessSeqLock {
+    WessSeqLock() noexcept { Wess_LockSeq(); }
+    ~WessSeqLock() noexcept { Wess_UnlockSeq(); }
+};
+
 // Type for a driver or sequencer command function.
 // The format of the function depends on the particular command function invoked.
 struct WessDriverFunc {
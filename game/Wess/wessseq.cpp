@@ -823,8 +823,18 @@ void SeqEngine() noexcept {
         const double deltaTime = std::clamp(std::chrono::duration<double>(now - gLastSequencerUpdateTime).count(), 0.0, 0.5);
         const double deltaTime120HzTicks = std::min(deltaTime * 120.0, 8.0);
         gLastSequencerUpdateTime = now;
+        SeqEngineAdvance(deltaTime120HzTicks);
+    #else
+        SeqEngineAdvance(1.0);
     #endif
+}
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: advances the sequencer by the given (fractional) number of 120 Hz ticks and executes any sequencer commands which become due.
+// This is the body of the original 'SeqEngine', split out so that the sequencer can also be stepped by an exact amount of time.
+// For the original code the amount of time is always 1 tick (and is ignored).
+//------------------------------------------------------------------------------------------------------------------------------------------
+void SeqEngineAdvance([[maybe_unused]] const double deltaTime120HzTicks) noexcept {
     // Some helper variables for the loop
     master_status_structure& mstat = *gpWess_eng_mstat;
     track_status* const pTrackStats = gpWess_eng_trackStats;
@@ -919,3 +929,51 @@ void SeqEngine() noexcept {
     track_status& firstTrack = pTrackStats[0];
     gWess_CmdFuncArr[firstTrack.driver_id][DriverEntry1]();
 }
+
+#if PSYDOOM_MODS
+//------------------------------------------------------------------------------------------------------------------------------------------
+// PsyDoom: returns how many (fractional) 120 Hz ticks must elapse before the sequencer next has a command to execute or a timed track to end.
+// Returns a negative value if there is nothing scheduled, i.e if no tracks are playing.
+// This allows the sequencer to be advanced exactly up to the point where the next command is due.
+//------------------------------------------------------------------------------------------------------------------------------------------
+double SeqEngineGetTicksTillNextCmd() noexcept {
+    const master_status_structure& mstat = *gpWess_eng_mstat;
+    const track_status* const pTrackStats = gpWess_eng_trackStats;
+    const uint8_t maxTracks = gWess_eng_maxActiveTracks;
+
+    double minTicks = -1.0;
+    uint8_t numActiveTracksToVisit = mstat.num_active_tracks;
+
+    for (uint8_t trackIdx = 0; (trackIdx < maxTracks) && (numActiveTracksToVisit > 0); ++trackIdx) {
+        const track_status& trackStat = pTrackStats[trackIdx];
+
+        if (!trackStat.active)
+            continue;
+
+        numActiveTracksToVisit--;
+
+        // Paused tracks and tracks with no tempo never advance, so they have nothing scheduled
+        if (trackStat.stopped || (trackStat.tempo_ppi_frac == 0))
+            continue;
+
+        // How many fractional quarter note parts (16.16 format) until the next command and until the track ends (if timed)?
+        const double curQnpFrac = (double) trackStat.deltatime_qnp * 65536.0 + (double) trackStat.deltatime_qnp_frac;
+        double qnpFracTillEvent = std::max((double) trackStat.qnp_till_next_cmd * 65536.0 - curQnpFrac, 0.0);
+
+        if (trackStat.timed) {
+            const double curAbsQnpFrac = (double) trackStat.abstime_qnp * 65536.0 + (double) trackStat.deltatime_qnp_frac;
+            const double qnpFracTillEnd = std::max((double) trackStat.end_abstime_qnp * 65536.0 - curAbsQnpFrac, 0.0);
+            qnpFracTillEvent = std::min(qnpFracTillEvent, qnpFracTillEnd);
+        }
+
+        // Convert to ticks and see if this is the soonest event
+        const double ticksTillEvent = qnpFracTillEvent / (double) trackStat.tempo_ppi_frac;
+
+        if ((minTicks < 0.0) || (ticksTillEvent < minTicks)) {
+            minTicks = ticksTillEvent;
+        }
+    }
+
+    return minTicks;
+}
+#endif
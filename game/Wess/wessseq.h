@@ -61,3 +61,8 @@ void Eng_TrkRet(track_status& trackStat) noexcept;
 void Eng_TrkEnd(track_status& trackStat) noexcept;
 void Eng_NullEvent(track_status& trackStat) noexcept;
 void SeqEngine() noexcept;
+void SeqEngineAdvance(const double deltaTime120HzTicks) noexcept;
+
+#if PSYDOOM_MODS
+    double SeqEngineGetTicksTillNextCmd() noexcept;
+#endif
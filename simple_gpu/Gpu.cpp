@@ -1,12 +1,91 @@
 #include "Gpu.h"
 
 #include "Asserts.h"
+#include "GpuSimd.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 BEGIN_NAMESPACE(Gpu)
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// An inclusive rectangular area of VRAM pixels.
+// Used to restrict drawing to a single tile in deferred mode and for tracking the areas of VRAM affected by draw primitives.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct PixelBounds {
+    int32_t lx;
+    int32_t rx;
+    int32_t ty;
+    int32_t by;
+
+    inline bool isEmpty() const noexcept {
+        return ((lx > rx) || (ty > by));
+    }
+
+    inline bool intersects(const PixelBounds& other) const noexcept {
+        return ((lx <= other.rx) && (rx >= other.lx) && (ty <= other.by) && (by >= other.ty));
+    }
+};
+
+// Clipping bounds used when drawing immediately: these are larger than the biggest VRAM size, so they never restrict drawing
+static constexpr PixelBounds NO_CLIP = { 0, INT16_MAX, 0, INT16_MAX };
+
+// Deferred mode: add a draw primitive to the queue of primitives to be rasterized
+template <class PrimT>
+static void deferDraw(Core& core, const PrimT& prim, const DrawMode drawMode) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the range of VRAM coordinates (on one axis) that texture lookups can read from, given the texture window and page settings.
+// This mirrors the coordinate wrapping done by 'readTexel' and falls back to the full page or VRAM range if wrapping can happen.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getTexReadRange(
+    const uint32_t winPos,
+    const uint32_t winMask,
+    const uint32_t texelsPerPixel,
+    const uint32_t pagePos,
+    const uint32_t pageMask,
+    const uint32_t ramMask,
+    int32_t& lo,
+    int32_t& hi
+) noexcept {
+    uint32_t pageLo = winPos / texelsPerPixel;
+    uint32_t pageHi = (winPos + winMask) / texelsPerPixel;
+
+    if ((pageHi > pageMask) || ((pageMask & (pageMask + 1)) != 0)) {
+        pageLo = 0;
+        pageHi = pageMask;
+    }
+
+    const uint32_t vramLo = pagePos + pageLo;
+    const uint32_t vramHi = pagePos + pageHi;
+
+    if ((vramHi > ramMask) || ((ramMask & (ramMask + 1)) != 0)) {
+        lo = 0;
+        hi = (int32_t) ramMask;
+    } else {
+        lo = (int32_t) vramLo;
+        hi = (int32_t) vramHi;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the area of VRAM that texture lookups can read from with the current GPU settings and the given texture format
+//------------------------------------------------------------------------------------------------------------------------------------------
+static PixelBounds getTexReadBounds(const Core& core, const TexFmt texFmt) noexcept {
+    const uint32_t texelsPerPixel = (texFmt == TexFmt::Bpp4) ? 4 : ((texFmt == TexFmt::Bpp8) ? 2 : 1);
+
+    PixelBounds bounds;
+    getTexReadRange(core.texWinX, core.texWinXMask, texelsPerPixel, core.texPageX, core.texPageXMask, core.ramXMask, bounds.lx, bounds.rx);
+    getTexReadRange(core.texWinY, core.texWinYMask, 1, core.texPageY, core.texPageYMask, core.ramYMask, bounds.ty, bounds.by);
+    return bounds;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Rounds the given number up to the next power of two if it's not a power of two
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -70,13 +149,23 @@ void initCore(Core& core, const uint16_t ramPixelW, const uint16_t ramPixelH) no
     core.clutCacheY = UINT16_MAX;
     core.clutCacheFmt = {};
     std::memset(core.clutCache, 0, sizeof(core.clutCache));
+
+    core.bUseSimd = isSimdSupported();
 }
 
 void destroyCore(Core& core) noexcept {
+    disableDeferredMode(core);
     delete[] core.pRam;
     core = {};
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if SIMD span shading is supported on this platform; if so then it is enabled by default for new cores
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isSimdSupported() noexcept {
+    return SIMPLE_GPU_SIMD;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Sanity checks GPU state in debug to make sure it is good for drawing
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -229,6 +318,9 @@ bool isPixelInDrawArea(const Core& core, const uint16_t x, const uint16_t y) noe
 // Clears a region of VRAM to the specified color
 //------------------------------------------------------------------------------------------------------------------------------------------
 void clearRect(Core& core, const Color16 color, const uint16_t x, const uint16_t y, const uint16_t w, const uint16_t h) noexcept {
+    // Make sure all pending drawing is done first if deferred mode is enabled
+    flush(core);
+
     // Caching GPU state
     uint16_t* const pRam = core.pRam;
     const uint16_t ramPixelW = core.ramPixelW;
@@ -334,7 +426,7 @@ Color16 colorBlend(const Color16 bg, const Color16 fg, const BlendMode mode) noe
 // Drawing a rectangle - internal implementation tailored to each texture format
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode, TexFmt TexFmt>
-static void draw(Core& core, const DrawRect& rect) noexcept {
+static void draw(Core& core, const DrawRect& rect, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // According to the NO$PSX specs rectangle sizes cannot exceed 1023 x 511
@@ -368,8 +460,19 @@ static void draw(Core& core, const DrawRect& rect) noexcept {
         begY = core.drawAreaTy;
     }
 
-    const int16_t endX = std::min(rectTx + (int16_t) rect.w, (int16_t) core.drawAreaRx + 1);
-    const int16_t endY = std::min(rectTy + (int16_t) rect.h, (int16_t) core.drawAreaBy + 1);
+    // Also clip to the tile being drawn in deferred mode (no-op when drawing immediately)
+    if (begX < clip.lx) {
+        topLeftU += (uint16_t)(clip.lx - begX);
+        begX = (int16_t) clip.lx;
+    }
+
+    if (begY < clip.ty) {
+        topLeftV += (uint16_t)(clip.ty - begY);
+        begY = (int16_t) clip.ty;
+    }
+
+    const int16_t endX = (int16_t) std::min(std::min(rectTx + (int16_t) rect.w, (int16_t) core.drawAreaRx + 1), clip.rx + 1);
+    const int16_t endY = (int16_t) std::min(std::min(rectTy + (int16_t) rect.h, (int16_t) core.drawAreaBy + 1), clip.by + 1);
 
     // If we are in flat colored mode then decide the foreground color for every pixel in the rectangle
     const Color24F rectColor = rect.color;
@@ -411,17 +514,29 @@ static void draw(Core& core, const DrawRect& rect) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Drawing a rectangle - external interface
+// Drawing a rectangle - dispatch to the implementation for the current texture format, restricting drawing to the given area
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawRect& rect) noexcept {
+static void drawClipped(Core& core, const DrawRect& rect, const PixelBounds& clip) noexcept {
     if (core.texFmt == TexFmt::Bpp4) {
-        draw<DrawMode, TexFmt::Bpp4>(core, rect);
+        draw<DrawMode, TexFmt::Bpp4>(core, rect, clip);
     } else if (core.texFmt == TexFmt::Bpp8) {
-        draw<DrawMode, TexFmt::Bpp8>(core, rect);
+        draw<DrawMode, TexFmt::Bpp8>(core, rect, clip);
     } else {
         ASSERT(core.texFmt == TexFmt::Bpp16);
-        draw<DrawMode, TexFmt::Bpp16>(core, rect);
+        draw<DrawMode, TexFmt::Bpp16>(core, rect, clip);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Drawing a rectangle - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawRect& rect) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, rect, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, rect, NO_CLIP);
     }
 }
 
@@ -432,10 +547,10 @@ template void draw<DrawMode::Textured>(Core& core, const DrawRect& rect) noexcep
 template void draw<DrawMode::TexturedBlended>(Core& core, const DrawRect& rect) noexcept;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Drawing a line
+// Drawing a line - internal implementation, restricting drawing to the given area
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawLine& line) noexcept {
+static void drawClipped(Core& core, const DrawLine& line, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // Translate the line by the drawing offset
@@ -504,7 +619,9 @@ void draw(Core& core, const DrawLine& line) noexcept {
         const int32_t x = (bLineIsSteep) ? b : a;
         const int32_t y = (bLineIsSteep) ? a : b;
 
-        if (isPixelInDrawArea(core, x, y)) {
+        const bool bInClipArea = ((x >= clip.lx) && (x <= clip.rx) && (y >= clip.ty) && (y <= clip.by));
+
+        if (isPixelInDrawArea(core, x, y) && bInClipArea) {
             const Color16 color = (bBlend) ? colorBlend(vramReadU16(core, x, y), lineColor, blendMode) : lineColor;
             vramWriteU16(core, x, y, color);
         }
@@ -519,6 +636,18 @@ void draw(Core& core, const DrawLine& line) noexcept {
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Drawing a line - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawLine& line) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, line, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, line, NO_CLIP);
+    }
+}
+
 // Instantiate the variants of this function
 template void draw<DrawMode::Colored>(Core& core, const DrawLine& line) noexcept;
 template void draw<DrawMode::ColoredBlended>(Core& core, const DrawLine& line) noexcept;
@@ -532,7 +661,7 @@ template void draw<DrawMode::ColoredBlended>(Core& core, const DrawLine& line) n
 //  https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode, TexFmt TexFmt>
-static void draw(Core& core, const DrawTriangle& triangle) noexcept {
+static void draw(Core& core, const DrawTriangle& triangle, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // Apply the draw offset to the triangle points
@@ -554,10 +683,10 @@ static void draw(Core& core, const DrawTriangle& triangle) noexcept {
     const int32_t maxY = std::max(std::max(p1y, p2y), p3y);
     const int32_t xrange = maxX - minX;
     const int32_t yrange = maxY - minY;
-    const int32_t lx = std::max((int32_t) core.drawAreaLx, minX);
-    const int32_t rx = std::min((int32_t) core.drawAreaRx, maxX - 1);
-    const int32_t ty = std::max((int32_t) core.drawAreaTy, minY);
-    const int32_t by = std::min((int32_t) core.drawAreaBy, maxY - 1);
+    const int32_t lx = std::max(std::max((int32_t) core.drawAreaLx, minX), clip.lx);
+    const int32_t rx = std::min(std::min((int32_t) core.drawAreaRx, maxX - 1), clip.rx);
+    const int32_t ty = std::max(std::max((int32_t) core.drawAreaTy, minY), clip.ty);
+    const int32_t by = std::min(std::min((int32_t) core.drawAreaBy, maxY - 1), clip.by);
 
     if ((xrange >= 1024) || (yrange >= 512))
         return;
@@ -675,17 +804,29 @@ static void draw(Core& core, const DrawTriangle& triangle) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Drawing a triangle - external interface
+// Drawing a triangle - dispatch to the implementation for the current texture format, restricting drawing to the given area
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawTriangle& triangle) noexcept {
+static void drawClipped(Core& core, const DrawTriangle& triangle, const PixelBounds& clip) noexcept {
     if (core.texFmt == TexFmt::Bpp4) {
-        draw<DrawMode, TexFmt::Bpp4>(core, triangle);
+        draw<DrawMode, TexFmt::Bpp4>(core, triangle, clip);
     } else if (core.texFmt == TexFmt::Bpp8) {
-        draw<DrawMode, TexFmt::Bpp8>(core, triangle);
+        draw<DrawMode, TexFmt::Bpp8>(core, triangle, clip);
     } else {
         ASSERT(core.texFmt == TexFmt::Bpp16);
-        draw<DrawMode, TexFmt::Bpp16>(core, triangle);
+        draw<DrawMode, TexFmt::Bpp16>(core, triangle, clip);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Drawing a triangle - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawTriangle& triangle) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, triangle, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, triangle, NO_CLIP);
     }
 }
 
@@ -706,7 +847,7 @@ template void draw<DrawMode::TexturedBlended>(Core& core, const DrawTriangle& tr
 //  https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode, TexFmt TexFmt>
-static void draw(Core& core, const DrawTriangleGouraud& triangle) noexcept {
+static void draw(Core& core, const DrawTriangleGouraud& triangle, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // Apply the draw offset to the triangle points
@@ -728,10 +869,10 @@ static void draw(Core& core, const DrawTriangleGouraud& triangle) noexcept {
     const int32_t maxY = std::max(std::max(p1y, p2y), p3y);
     const int32_t xrange = maxX - minX;
     const int32_t yrange = maxY - minY;
-    const int32_t lx = std::max((int32_t) core.drawAreaLx, minX);
-    const int32_t rx = std::min((int32_t) core.drawAreaRx, maxX - 1);
-    const int32_t ty = std::max((int32_t) core.drawAreaTy, minY);
-    const int32_t by = std::min((int32_t) core.drawAreaBy, maxY - 1);
+    const int32_t lx = std::max(std::max((int32_t) core.drawAreaLx, minX), clip.lx);
+    const int32_t rx = std::min(std::min((int32_t) core.drawAreaRx, maxX - 1), clip.rx);
+    const int32_t ty = std::max(std::max((int32_t) core.drawAreaTy, minY), clip.ty);
+    const int32_t by = std::min(std::min((int32_t) core.drawAreaBy, maxY - 1), clip.by);
 
     if ((xrange >= 1024) || (yrange >= 512))
         return;
@@ -869,17 +1010,29 @@ static void draw(Core& core, const DrawTriangleGouraud& triangle) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Drawing a gouraud shaded triangle - external interface
+// Drawing a gouraud shaded triangle - dispatch to the implementation for the current texture format, restricting drawing to the given area
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawTriangleGouraud& triangle) noexcept {
+static void drawClipped(Core& core, const DrawTriangleGouraud& triangle, const PixelBounds& clip) noexcept {
     if (core.texFmt == TexFmt::Bpp4) {
-        draw<DrawMode, TexFmt::Bpp4>(core, triangle);
+        draw<DrawMode, TexFmt::Bpp4>(core, triangle, clip);
     } else if (core.texFmt == TexFmt::Bpp8) {
-        draw<DrawMode, TexFmt::Bpp8>(core, triangle);
+        draw<DrawMode, TexFmt::Bpp8>(core, triangle, clip);
     } else {
         ASSERT(core.texFmt == TexFmt::Bpp16);
-        draw<DrawMode, TexFmt::Bpp16>(core, triangle);
+        draw<DrawMode, TexFmt::Bpp16>(core, triangle, clip);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Drawing a gouraud shaded triangle - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawTriangleGouraud& triangle) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, triangle, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, triangle, NO_CLIP);
     }
 }
 
@@ -892,9 +1045,10 @@ template void draw<DrawMode::TexturedBlended>(Core& core, const DrawTriangleGour
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draws a single row of Doom floor pixels; texture format is assumed to be 8bpp.
 // This is a new primitive added to help accelerate the classic renderer for PsyDoom.
+// This is the internal implementation, which restricts drawing to the given area.
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawFloorRow& row) noexcept {
+static void drawClipped(Core& core, const DrawFloorRow& row, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // Apply the draw offset to the row coordinates
@@ -927,8 +1081,8 @@ void draw(Core& core, const DrawFloorRow& row) noexcept {
     const float tStep = 1.0f / (float) xrange;
 
     // Also similar to triangles, skip the row if the distances between the vertices exceed 1023 on the x dimension.
-    // Also skip if the row itself is outside the draw area.
-    if ((xrange >= 1024) || (py < core.drawAreaTy) || (py > core.drawAreaBy))
+    // Also skip if the row itself is outside the draw area or the clipping area.
+    if ((xrange >= 1024) || (py < core.drawAreaTy) || (py > core.drawAreaBy) || (py < clip.ty) || (py > clip.by))
         return;
 
     // If we're going to draw textured and with a CLUT make sure it is up to date
@@ -957,7 +1111,47 @@ void draw(Core& core, const DrawFloorRow& row) noexcept {
     uint16_t* pDstPixelRow = pVram + py * vramPixelW;
     const bool bEnableMasking = (!core.bDisableMasking);
 
-    for (int32_t x = lx; x <= rx; ++x) {
+    // Skip any pixels before the clipping area.
+    // Note: 't' must be stepped exactly like it would be if the pixels were drawn, so that the results are identical.
+    const int32_t clipLx = std::max(lx, clip.lx);
+    const int32_t clipRx = std::min(rx, clip.rx);
+
+    for (int32_t x = lx; x < clipLx; ++x) {
+        t += tStep;
+        tinv -= tStep;
+    }
+
+    // Use SIMD to shade the row if possible.
+    // This can't be done if the row might sample from pixels it draws to, since all texels for a batch are fetched before writing.
+    #if SIMPLE_GPU_SIMD
+        if constexpr ((DrawMode == DrawMode::Textured) || (DrawMode == DrawMode::TexturedBlended)) {
+            const PixelBounds rowBounds = { clipLx, clipRx, py, py };
+
+            if (core.bUseSimd && (!getTexReadBounds(core, TexFmt::Bpp8).intersects(rowBounds))) {
+                Simd::SpanBatch batch = {};
+                std::fill_n(batch.r, Simd::BATCH_SIZE, rowColor.comp.r);
+                std::fill_n(batch.g, Simd::BATCH_SIZE, rowColor.comp.g);
+                std::fill_n(batch.b, Simd::BATCH_SIZE, rowColor.comp.b);
+
+                for (int32_t x = clipLx; x <= clipRx; x += Simd::BATCH_SIZE) {
+                    const uint32_t numPixels = std::min<uint32_t>(clipRx - x + 1, Simd::BATCH_SIZE);
+
+                    for (uint32_t i = 0; i < numPixels; ++i) {
+                        batch.u[i] = (uint16_t)(u1 * tinv + u2 * t);
+                        batch.v[i] = (uint16_t)(v1 * tinv + v2 * t);
+                        t += tStep;
+                        tinv -= tStep;
+                    }
+
+                    Simd::shadeSpanBatch<DrawMode>(core, batch, numPixels, pDstPixelRow + x, 1);
+                }
+
+                return;
+            }
+        }
+    #endif
+
+    for (int32_t x = clipLx; x <= clipRx; ++x) {
         // Compute the texture coordinate to use
         const uint16_t u = (uint16_t)(u1 * tinv + u2 * t);
         const uint16_t v = (uint16_t)(v1 * tinv + v2 * t);
@@ -1004,6 +1198,18 @@ void draw(Core& core, const DrawFloorRow& row) noexcept {
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a single row of Doom floor pixels - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawFloorRow& row) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, row, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, row, NO_CLIP);
+    }
+}
+
 // Instantiate the variants of this function
 template void draw<DrawMode::Colored>(Core& core, const DrawFloorRow& row) noexcept;
 template void draw<DrawMode::ColoredBlended>(Core& core, const DrawFloorRow& row) noexcept;
@@ -1013,9 +1219,10 @@ template void draw<DrawMode::TexturedBlended>(Core& core, const DrawFloorRow& ro
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draws a single column of Doom wall pixels; texture format is assumed to be 8bpp.
 // This is a new primitive added to help accelerate the classic renderer for PsyDoom.
+// This is the internal implementation, which restricts drawing to the given area.
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawWallCol& col) noexcept {
+static void drawClipped(Core& core, const DrawWallCol& col, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // Apply the draw offset to the column coordinates
@@ -1046,8 +1253,8 @@ void draw(Core& core, const DrawWallCol& col) noexcept {
     const float tStep = 1.0f / (float) yrange;
 
     // Also similar to triangles, skip the column if the distances between the vertices exceed 511 on the y dimension.
-    // Also skip if the column itself is outside the draw area.
-    if ((yrange >= 512) || (px < core.drawAreaLx) || (px > core.drawAreaRx))
+    // Also skip if the column itself is outside the draw area or the clipping area.
+    if ((yrange >= 512) || (px < core.drawAreaLx) || (px > core.drawAreaRx) || (px < clip.lx) || (px > clip.rx))
         return;
 
     // If we're going to draw textured and with a CLUT make sure it is up to date
@@ -1087,7 +1294,47 @@ void draw(Core& core, const DrawWallCol& col) noexcept {
     uint16_t* pDstPixelCol = core.pRam + px;
     const bool bEnableMasking = (!core.bDisableMasking);
 
-    for (int32_t y = ty; y <= by; ++y) {
+    // Skip any pixels before the clipping area.
+    // Note: 't' must be stepped exactly like it would be if the pixels were drawn, so that the results are identical.
+    const int32_t clipTy = std::max(ty, clip.ty);
+    const int32_t clipBy = std::min(by, clip.by);
+
+    for (int32_t y = ty; y < clipTy; ++y) {
+        t += tStep;
+        tinv -= tStep;
+    }
+
+    // Use SIMD to shade the column if possible.
+    // This can't be done if the column might sample from pixels it draws to, since all texels for a batch are fetched before writing.
+    #if SIMPLE_GPU_SIMD
+        if constexpr ((DrawMode == DrawMode::Textured) || (DrawMode == DrawMode::TexturedBlended)) {
+            const PixelBounds colBounds = { px, px, clipTy, clipBy };
+
+            if (core.bUseSimd && (!getTexReadBounds(core, TexFmt::Bpp8).intersects(colBounds))) {
+                Simd::SpanBatch batch = {};
+                std::fill_n(batch.u, Simd::BATCH_SIZE, (uint16_t) u);
+                std::fill_n(batch.r, Simd::BATCH_SIZE, colColor.comp.r);
+                std::fill_n(batch.g, Simd::BATCH_SIZE, colColor.comp.g);
+                std::fill_n(batch.b, Simd::BATCH_SIZE, colColor.comp.b);
+
+                for (int32_t y = clipTy; y <= clipBy; y += Simd::BATCH_SIZE) {
+                    const uint32_t numPixels = std::min<uint32_t>(clipBy - y + 1, Simd::BATCH_SIZE);
+
+                    for (uint32_t i = 0; i < numPixels; ++i) {
+                        batch.v[i] = (uint16_t)(v1 * tinv + v2 * t);
+                        t += tStep;
+                        tinv -= tStep;
+                    }
+
+                    Simd::shadeSpanBatch<DrawMode>(core, batch, numPixels, pDstPixelCol + y * vramPixelW, vramPixelW);
+                }
+
+                return;
+            }
+        }
+    #endif
+
+    for (int32_t y = clipTy; y <= clipBy; ++y) {
         // Compute the 'v' texture coordinate to use
         const uint16_t v = (uint16_t)(v1 * tinv + v2 * t);
 
@@ -1129,6 +1376,18 @@ void draw(Core& core, const DrawWallCol& col) noexcept {
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a single column of Doom wall pixels - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawWallCol& col) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, col, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, col, NO_CLIP);
+    }
+}
+
 // Instantiate the variants of this function
 template void draw<DrawMode::Colored>(Core& core, const DrawWallCol& col) noexcept;
 template void draw<DrawMode::ColoredBlended>(Core& core, const DrawWallCol& col) noexcept;
@@ -1138,9 +1397,10 @@ template void draw<DrawMode::TexturedBlended>(Core& core, const DrawWallCol& col
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draws a single gouraud shaded column of Doom wall pixels; texture format is assumed to be 8bpp.
 // This is a new primitive added to help accelerate the classic renderer for PsyDoom.
+// This is the internal implementation, which restricts drawing to the given area.
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawMode DrawMode>
-void draw(Core& core, const DrawWallColGouraud& col) noexcept {
+static void drawClipped(Core& core, const DrawWallColGouraud& col, const PixelBounds& clip) noexcept {
     sanityCheckGpuDrawState(core);
 
     // Apply the draw offset to the column coordinates
@@ -1180,8 +1440,8 @@ void draw(Core& core, const DrawWallColGouraud& col) noexcept {
     const float tStep = 1.0f / (float) yrange;
 
     // Also similar to triangles, skip the column if the distances between the vertices exceed 511 on the y dimension.
-    // Also skip if the column itself is outside the draw area.
-    if ((yrange >= 512) || (px < core.drawAreaLx) || (px > core.drawAreaRx))
+    // Also skip if the column itself is outside the draw area or the clipping area.
+    if ((yrange >= 512) || (px < core.drawAreaLx) || (px > core.drawAreaRx) || (px < clip.lx) || (px > clip.rx))
         return;
 
     // If we're going to draw textured and with a CLUT make sure it is up to date
@@ -1213,7 +1473,47 @@ void draw(Core& core, const DrawWallColGouraud& col) noexcept {
     uint16_t* pDstPixelCol = core.pRam + px;
     const bool bEnableMasking = (!core.bDisableMasking);
 
-    for (int32_t y = ty; y <= by; ++y) {
+    // Skip any pixels before the clipping area.
+    // Note: 't' must be stepped exactly like it would be if the pixels were drawn, so that the results are identical.
+    const int32_t clipTy = std::max(ty, clip.ty);
+    const int32_t clipBy = std::min(by, clip.by);
+
+    for (int32_t y = ty; y < clipTy; ++y) {
+        t += tStep;
+        tInv -= tStep;
+    }
+
+    // Use SIMD to shade the column if possible.
+    // This can't be done if the column might sample from pixels it draws to, since all texels for a batch are fetched before writing.
+    // Note: unlike the other Doom specific primitives the color is recomputed for every pixel, so colored blending is fine to do too.
+    #if SIMPLE_GPU_SIMD
+        constexpr bool bIsTextured = ((DrawMode == DrawMode::Textured) || (DrawMode == DrawMode::TexturedBlended));
+        const PixelBounds colBounds = { px, px, clipTy, clipBy };
+
+        if (core.bUseSimd && ((!bIsTextured) || (!getTexReadBounds(core, TexFmt::Bpp8).intersects(colBounds)))) {
+            Simd::SpanBatch batch = {};
+            std::fill_n(batch.u, Simd::BATCH_SIZE, (uint16_t) u);
+
+            for (int32_t y = clipTy; y <= clipBy; y += Simd::BATCH_SIZE) {
+                const uint32_t numPixels = std::min<uint32_t>(clipBy - y + 1, Simd::BATCH_SIZE);
+
+                for (uint32_t i = 0; i < numPixels; ++i) {
+                    batch.v[i] = (uint16_t)(v1 * tInv + v2 * t);
+                    batch.r[i] = (uint8_t)(r1 * tInv + r2 * t + 0.5f);
+                    batch.g[i] = (uint8_t)(g1 * tInv + g2 * t + 0.5f);
+                    batch.b[i] = (uint8_t)(b1 * tInv + b2 * t + 0.5f);
+                    t += tStep;
+                    tInv -= tStep;
+                }
+
+                Simd::shadeSpanBatch<DrawMode>(core, batch, numPixels, pDstPixelCol + y * vramPixelW, vramPixelW);
+            }
+
+            return;
+        }
+    #endif
+
+    for (int32_t y = clipTy; y <= clipBy; ++y) {
         // Compute the 'v' texture coordinate to use
         const uint16_t v = (uint16_t)(v1 * tInv + v2 * t);
 
@@ -1272,10 +1572,665 @@ void draw(Core& core, const DrawWallColGouraud& col) noexcept {
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a single gouraud shaded column of Doom wall pixels - external interface
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+void draw(Core& core, const DrawWallColGouraud& col) noexcept {
+    if (core.pDeferred) {
+        deferDraw(core, col, DrawMode);
+    } else {
+        drawClipped<DrawMode>(core, col, NO_CLIP);
+    }
+}
+
 // Instantiate the variants of this function
 template void draw<DrawMode::Colored>(Core& core, const DrawWallColGouraud& col) noexcept;
 template void draw<DrawMode::ColoredBlended>(Core& core, const DrawWallColGouraud& col) noexcept;
 template void draw<DrawMode::Textured>(Core& core, const DrawWallColGouraud& col) noexcept;
 template void draw<DrawMode::TexturedBlended>(Core& core, const DrawWallColGouraud& col) noexcept;
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Deferred rendering mode: types and constants
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+// Size of the square tiles that VRAM is divided into for deferred rendering: 32x32 pixels
+static constexpr uint32_t TILE_SIZE_SHIFT = 5;
+static constexpr int32_t TILE_SIZE = 1 << TILE_SIZE_SHIFT;
+
+// Bounds that do not contain or intersect anything, used as the starting point for a union of bounds
+static constexpr PixelBounds EMPTY_BOUNDS = { INT32_MAX, INT32_MIN, INT32_MAX, INT32_MIN };
+
+// Used to indicate that a queued primitive does not use the CLUT cache
+static constexpr uint32_t NO_CLUT_SNAPSHOT = UINT32_MAX;
+
+// What type of primitive a queued draw command is for
+enum class PrimType : uint8_t {
+    Rect,
+    Line,
+    Triangle,
+    TriangleGouraud,
+    FloorRow,
+    WallCol,
+    WallColGouraud,
+};
+
+// A snapshot of all the GPU state which affects how a primitive is drawn
+struct DrawState {
+    int16_t     drawOffsetX;
+    int16_t     drawOffsetY;
+    uint16_t    drawAreaLx;
+    uint16_t    drawAreaRx;
+    uint16_t    drawAreaTy;
+    uint16_t    drawAreaBy;
+    uint16_t    texPageX;
+    uint16_t    texPageY;
+    uint16_t    texPageXMask;
+    uint16_t    texPageYMask;
+    uint16_t    texWinX;
+    uint16_t    texWinY;
+    uint16_t    texWinXMask;
+    uint16_t    texWinYMask;
+    BlendMode   blendMode;
+    TexFmt      texFmt;
+    uint16_t    clutX;
+    uint16_t    clutY;
+    bool        bDisableMasking;
+};
+
+// A saved copy of the CLUT cache, as it was when a primitive was queued.
+// Queued primitives use these instead of loading CLUTs from VRAM, so they see the exact same CLUT as they would in immediate mode.
+struct ClutSnapshot {
+    TexFmt      fmt;
+    uint16_t    x;
+    uint16_t    y;
+    Color16     colors[256];
+};
+
+// A draw primitive waiting to be rasterized, along with the GPU state it was submitted with
+struct DeferredCmd {
+    DrawState   state;
+    PrimType    primType;
+    DrawMode    drawMode;
+    uint32_t    clutSnapshotIdx;    // Which CLUT snapshot the primitive uses or 'NO_CLUT_SNAPSHOT' if none
+
+    union PrimData {
+        DrawRect                rect;
+        DrawLine                line;
+        DrawTriangle            triangle;
+        DrawTriangleGouraud     triangleGouraud;
+        DrawFloorRow            floorRow;
+        DrawWallCol             wallCol;
+        DrawWallColGouraud      wallColGouraud;
+
+        inline PrimData() noexcept : rect() {}
+    } prim;
+};
+
+// State for the deferred rendering mode
+struct DeferredRenderer {
+    std::vector<DeferredCmd>                cmds;                   // All queued draw primitives, in submission order
+    std::vector<ClutSnapshot>               clutSnapshots;          // CLUT snapshots used by the queued primitives
+    uint32_t                                curClutSnapshotIdx;     // Snapshot which holds the current contents of the GPU's CLUT cache or 'NO_CLUT_SNAPSHOT' if none
+    std::vector<std::vector<uint32_t>>      tileCmds;               // For each tile, the indexes of all queued primitives touching the tile (in submission order)
+    std::vector<uint32_t>                   activeTiles;            // Indexes of all tiles which have queued primitives
+    uint32_t                                numTilesX;              // How many tiles there are horizontally in VRAM
+    uint32_t                                numTilesY;              // How many tiles there are vertically in VRAM
+    PixelBounds                             pendingWrites;          // Union of the areas that queued primitives draw to
+    PixelBounds                             pendingReads;           // Union of the areas that queued primitives sample textures from
+
+    // Worker thread pool and the synchronization for it
+    std::vector<std::thread>                workers;
+    std::mutex                              mutex;
+    std::condition_variable                 jobStartCV;             // Signalled when there is a new batch of tiles to rasterize (or when quitting)
+    std::condition_variable                 jobDoneCV;              // Signalled when the last busy worker finishes rasterizing
+    uint64_t                                jobId;                  // Incremented for each new batch of tiles to rasterize
+    uint32_t                                numWorkersBusy;         // How many workers are still rasterizing the current batch
+    bool                                    bQuit;                  // Set when the workers should exit
+    const Core*                             pJobCore;               // The core that the current batch of tiles is being drawn for
+    std::atomic<uint32_t>                   nextActiveTileIdx;      // Index into 'activeTiles' of the next tile for a thread to rasterize
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Expand the given bounds so that they include the other bounds
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void addToBounds(PixelBounds& bounds, const PixelBounds& other) noexcept {
+    bounds.lx = std::min(bounds.lx, other.lx);
+    bounds.rx = std::max(bounds.rx, other.rx);
+    bounds.ty = std::min(bounds.ty, other.ty);
+    bounds.by = std::max(bounds.by, other.by);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Save and restore the GPU state which affects how primitives are drawn
+//------------------------------------------------------------------------------------------------------------------------------------------
+static DrawState getDrawState(const Core& core) noexcept {
+    DrawState state;
+    state.drawOffsetX = core.drawOffsetX;
+    state.drawOffsetY = core.drawOffsetY;
+    state.drawAreaLx = core.drawAreaLx;
+    state.drawAreaRx = core.drawAreaRx;
+    state.drawAreaTy = core.drawAreaTy;
+    state.drawAreaBy = core.drawAreaBy;
+    state.texPageX = core.texPageX;
+    state.texPageY = core.texPageY;
+    state.texPageXMask = core.texPageXMask;
+    state.texPageYMask = core.texPageYMask;
+    state.texWinX = core.texWinX;
+    state.texWinY = core.texWinY;
+    state.texWinXMask = core.texWinXMask;
+    state.texWinYMask = core.texWinYMask;
+    state.blendMode = core.blendMode;
+    state.texFmt = core.texFmt;
+    state.clutX = core.clutX;
+    state.clutY = core.clutY;
+    state.bDisableMasking = core.bDisableMasking;
+    return state;
+}
+
+static void setDrawState(Core& core, const DrawState& state) noexcept {
+    core.drawOffsetX = state.drawOffsetX;
+    core.drawOffsetY = state.drawOffsetY;
+    core.drawAreaLx = state.drawAreaLx;
+    core.drawAreaRx = state.drawAreaRx;
+    core.drawAreaTy = state.drawAreaTy;
+    core.drawAreaBy = state.drawAreaBy;
+    core.texPageX = state.texPageX;
+    core.texPageY = state.texPageY;
+    core.texPageXMask = state.texPageXMask;
+    core.texPageYMask = state.texPageYMask;
+    core.texWinX = state.texWinX;
+    core.texWinY = state.texWinY;
+    core.texWinXMask = state.texWinXMask;
+    core.texWinYMask = state.texWinYMask;
+    core.blendMode = state.blendMode;
+    core.texFmt = state.texFmt;
+    core.clutX = state.clutX;
+    core.clutY = state.clutY;
+    core.bDisableMasking = state.bDisableMasking;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the area of VRAM that a primitive draws to with the current GPU settings.
+// Returns 'false' if the primitive is rejected entirely before drawing starts, following the same rules as the draw functions.
+// The returned bounds may be empty if the primitive is not rejected but is outside of the draw area.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool getPrimBounds(const Core& core, const DrawRect& rect, PixelBounds& bounds) noexcept {
+    if ((rect.w >= 1024) || (rect.h >= 512))
+        return false;
+
+    const int16_t rectTx = rect.x + core.drawOffsetX;
+    const int16_t rectTy = rect.y + core.drawOffsetY;
+    bounds.lx = std::max(rectTx, (int16_t) core.drawAreaLx);
+    bounds.ty = std::max(rectTy, (int16_t) core.drawAreaTy);
+    bounds.rx = (int16_t) std::min(rectTx + (int16_t) rect.w, (int16_t) core.drawAreaRx + 1) - 1;
+    bounds.by = (int16_t) std::min(rectTy + (int16_t) rect.h, (int16_t) core.drawAreaBy + 1) - 1;
+    return true;
+}
+
+static bool getPrimBounds(const Core& core, const DrawLine& line, PixelBounds& bounds) noexcept {
+    const int32_t lineX1 = line.x1 + core.drawOffsetX;
+    const int32_t lineY1 = line.y1 + core.drawOffsetY;
+    const int32_t lineX2 = line.x2 + core.drawOffsetX;
+    const int32_t lineY2 = line.y2 + core.drawOffsetY;
+
+    if ((std::abs(lineX2 - lineX1) >= 1024) || (std::abs(lineY2 - lineY1) >= 512))
+        return false;
+
+    bounds.lx = std::max(std::min(lineX1, lineX2), (int32_t) core.drawAreaLx);
+    bounds.rx = std::min(std::max(lineX1, lineX2), (int32_t) core.drawAreaRx);
+    bounds.ty = std::max(std::min(lineY1, lineY2), (int32_t) core.drawAreaTy);
+    bounds.by = std::min(std::max(lineY1, lineY2), (int32_t) core.drawAreaBy);
+    return true;
+}
+
+template <class TriT>
+static bool getTrianglePrimBounds(const Core& core, const TriT& triangle, PixelBounds& bounds) noexcept {
+    const int32_t p1x = triangle.x1 + core.drawOffsetX;
+    const int32_t p1y = triangle.y1 + core.drawOffsetY;
+    const int32_t p2x = triangle.x2 + core.drawOffsetX;
+    const int32_t p2y = triangle.y2 + core.drawOffsetY;
+    const int32_t p3x = triangle.x3 + core.drawOffsetX;
+    const int32_t p3y = triangle.y3 + core.drawOffsetY;
+
+    const int32_t minX = std::min(std::min(p1x, p2x), p3x);
+    const int32_t minY = std::min(std::min(p1y, p2y), p3y);
+    const int32_t maxX = std::max(std::max(p1x, p2x), p3x);
+    const int32_t maxY = std::max(std::max(p1y, p2y), p3y);
+
+    if ((maxX - minX >= 1024) || (maxY - minY >= 512))
+        return false;
+
+    bounds.lx = std::max((int32_t) core.drawAreaLx, minX);
+    bounds.rx = std::min((int32_t) core.drawAreaRx, maxX - 1);
+    bounds.ty = std::max((int32_t) core.drawAreaTy, minY);
+    bounds.by = std::min((int32_t) core.drawAreaBy, maxY - 1);
+    return true;
+}
+
+static bool getPrimBounds(const Core& core, const DrawFloorRow& row, PixelBounds& bounds) noexcept {
+    const int32_t p1x = row.x1 + core.drawOffsetX;
+    const int32_t p2x = row.x2 + core.drawOffsetX;
+    const int32_t py = row.y + core.drawOffsetY;
+    const int32_t minX = std::min(p1x, p2x);
+    const int32_t maxX = std::max(p1x, p2x);
+
+    if ((maxX - minX >= 1024) || (py < core.drawAreaTy) || (py > core.drawAreaBy))
+        return false;
+
+    bounds.lx = std::max((int32_t) core.drawAreaLx, minX);
+    bounds.rx = std::min((int32_t) core.drawAreaRx, maxX - 1);
+    bounds.ty = py;
+    bounds.by = py;
+    return true;
+}
+
+template <class ColT>
+static bool getColPrimBounds(const Core& core, const ColT& col, PixelBounds& bounds) noexcept {
+    const int32_t px = col.x + core.drawOffsetX;
+    const int32_t p1y = col.y1 + core.drawOffsetY;
+    const int32_t p2y = col.y2 + core.drawOffsetY;
+    const int32_t minY = std::min(p1y, p2y);
+    const int32_t maxY = std::max(p1y, p2y);
+
+    if ((maxY - minY >= 512) || (px < core.drawAreaLx) || (px > core.drawAreaRx))
+        return false;
+
+    bounds.lx = px;
+    bounds.rx = px;
+    bounds.ty = std::max((int32_t) core.drawAreaTy, minY);
+    bounds.by = std::min((int32_t) core.drawAreaBy, maxY - 1);
+    return true;
+}
+
+static bool getPrimBounds(const Core& core, const DeferredCmd& cmd, PixelBounds& bounds) noexcept {
+    switch (cmd.primType) {
+        case PrimType::Rect:                return getPrimBounds(core, cmd.prim.rect, bounds);
+        case PrimType::Line:                return getPrimBounds(core, cmd.prim.line, bounds);
+        case PrimType::Triangle:            return getTrianglePrimBounds(core, cmd.prim.triangle, bounds);
+        case PrimType::TriangleGouraud:     return getTrianglePrimBounds(core, cmd.prim.triangleGouraud, bounds);
+        case PrimType::FloorRow:            return getPrimBounds(core, cmd.prim.floorRow, bounds);
+        case PrimType::WallCol:             return getColPrimBounds(core, cmd.prim.wallCol, bounds);
+        case PrimType::WallColGouraud:      return getColPrimBounds(core, cmd.prim.wallColGouraud, bounds);
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draw a queued primitive using the GPU state currently set on the given core, restricting drawing to the given area
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+static void drawCmd(Core& core, const DeferredCmd& cmd, const PixelBounds& clip) noexcept {
+    switch (cmd.primType) {
+        case PrimType::Rect:                drawClipped<DrawMode>(core, cmd.prim.rect, clip);               break;
+        case PrimType::Triangle:            drawClipped<DrawMode>(core, cmd.prim.triangle, clip);           break;
+        case PrimType::TriangleGouraud:     drawClipped<DrawMode>(core, cmd.prim.triangleGouraud, clip);    break;
+        case PrimType::FloorRow:            drawClipped<DrawMode>(core, cmd.prim.floorRow, clip);           break;
+        case PrimType::WallCol:             drawClipped<DrawMode>(core, cmd.prim.wallCol, clip);            break;
+        case PrimType::WallColGouraud:      drawClipped<DrawMode>(core, cmd.prim.wallColGouraud, clip);     break;
+
+        // Note: lines cannot be textured
+        case PrimType::Line:
+            if constexpr ((DrawMode == DrawMode::Colored) || (DrawMode == DrawMode::ColoredBlended)) {
+                drawClipped<DrawMode>(core, cmd.prim.line, clip);
+            }
+            break;
+    }
+}
+
+static void drawCmd(Core& core, const DeferredCmd& cmd, const PixelBounds& clip) noexcept {
+    switch (cmd.drawMode) {
+        case DrawMode::Colored:             drawCmd<DrawMode::Colored>(core, cmd, clip);            break;
+        case DrawMode::ColoredBlended:      drawCmd<DrawMode::ColoredBlended>(core, cmd, clip);     break;
+        case DrawMode::Textured:            drawCmd<DrawMode::Textured>(core, cmd, clip);           break;
+        case DrawMode::TexturedBlended:     drawCmd<DrawMode::TexturedBlended>(core, cmd, clip);    break;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if 'updateClutCache' would reload the CLUT cache for the current GPU settings
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool clutCacheNeedsUpdate(const Core& core) noexcept {
+    return (
+        (core.clutCacheX != core.clutX) ||
+        (core.clutCacheY != core.clutY) ||
+        (core.clutCacheFmt != core.texFmt)
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Rasterize queued primitives for tiles until there are no more tiles left to claim.
+// This is called by the worker threads and also the thread doing the flush.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void rasterizeTiles(DeferredRenderer& dr, const Core& core) noexcept {
+    // Each thread uses its own core to draw with, which shares VRAM with the real one but has its own state and CLUT cache
+    Core tileCore = {};
+    tileCore.pRam = core.pRam;
+    tileCore.ramPixelW = core.ramPixelW;
+    tileCore.ramPixelH = core.ramPixelH;
+    tileCore.ramXMask = core.ramXMask;
+    tileCore.ramYMask = core.ramYMask;
+    tileCore.clutCacheX = UINT16_MAX;
+    tileCore.clutCacheY = UINT16_MAX;
+    tileCore.bUseSimd = core.bUseSimd;
+
+    uint32_t curClutSnapshotIdx = NO_CLUT_SNAPSHOT;
+    const uint32_t numActiveTiles = (uint32_t) dr.activeTiles.size();
+
+    while (true) {
+        // Claim the next tile to rasterize, if there are any left
+        const uint32_t activeTileIdx = dr.nextActiveTileIdx.fetch_add(1, std::memory_order_relaxed);
+
+        if (activeTileIdx >= numActiveTiles)
+            break;
+
+        const uint32_t tileIdx = dr.activeTiles[activeTileIdx];
+        const int32_t tileX = (int32_t)(tileIdx % dr.numTilesX) * TILE_SIZE;
+        const int32_t tileY = (int32_t)(tileIdx / dr.numTilesX) * TILE_SIZE;
+        const PixelBounds tileBounds = { tileX, tileX + TILE_SIZE - 1, tileY, tileY + TILE_SIZE - 1 };
+
+        // Draw all primitives touching the tile in the order they were submitted
+        for (const uint32_t cmdIdx : dr.tileCmds[tileIdx]) {
+            const DeferredCmd& cmd = dr.cmds[cmdIdx];
+            setDrawState(tileCore, cmd.state);
+
+            if ((cmd.clutSnapshotIdx != NO_CLUT_SNAPSHOT) && (cmd.clutSnapshotIdx != curClutSnapshotIdx)) {
+                const ClutSnapshot& clut = dr.clutSnapshots[cmd.clutSnapshotIdx];
+                tileCore.clutCacheFmt = clut.fmt;
+                tileCore.clutCacheX = clut.x;
+                tileCore.clutCacheY = clut.y;
+                std::memcpy(tileCore.clutCache, clut.colors, sizeof(clut.colors));
+                curClutSnapshotIdx = cmd.clutSnapshotIdx;
+            }
+
+            drawCmd(tileCore, cmd, tileBounds);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Entry point for deferred rendering worker threads: waits for batches of tiles to rasterize until told to quit
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void workerThreadMain(DeferredRenderer& dr) noexcept {
+    uint64_t lastJobId = 0;
+    std::unique_lock<std::mutex> lock(dr.mutex);
+
+    while (true) {
+        dr.jobStartCV.wait(lock, [&]() noexcept { return (dr.bQuit || (dr.jobId != lastJobId)); });
+
+        if (dr.bQuit)
+            break;
+
+        lastJobId = dr.jobId;
+        const Core& core = *dr.pJobCore;
+
+        lock.unlock();
+        rasterizeTiles(dr, core);
+        lock.lock();
+
+        dr.numWorkersBusy--;
+
+        if (dr.numWorkersBusy == 0) {
+            dr.jobDoneCV.notify_one();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Queue up a draw primitive for deferred rendering, binning it into all the tiles it touches.
+// If the primitive has a dependency on pending drawing (via texturing) then flush beforehand, so the results are the same as immediate mode.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void submitDeferredCmd(Core& core, const DeferredCmd& cmd) noexcept {
+    sanityCheckGpuDrawState(core);
+    DeferredRenderer& dr = *core.pDeferred;
+
+    // Get the area the primitive draws to and ignore if rejected entirely by the GPU
+    PixelBounds dstBounds;
+
+    if (!getPrimBounds(core, cmd, dstBounds))
+        return;
+
+    // Textured primitives: these use the CLUT cache (unless 16bpp) and have dependencies on the VRAM they read from.
+    // Note: the Doom specific primitives always update the CLUT cache and always read textures as 8bpp.
+    const bool bTextured = ((cmd.drawMode == DrawMode::Textured) || (cmd.drawMode == DrawMode::TexturedBlended));
+    const bool bIsDoomPrim = ((cmd.primType == PrimType::FloorRow) || (cmd.primType == PrimType::WallCol) || (cmd.primType == PrimType::WallColGouraud));
+    const bool bUsesClut = (bTextured && (bIsDoomPrim || (core.texFmt != TexFmt::Bpp16)));
+
+    if (bUsesClut && clutCacheNeedsUpdate(core)) {
+        // Update the CLUT cache at the same point the immediate mode would, making sure any drawing to the CLUT is done first
+        if (core.texFmt != TexFmt::Bpp16) {
+            const int32_t clutW = (core.texFmt == TexFmt::Bpp4) ? 16 : 256;
+            const PixelBounds clutBounds = { core.clutX, core.clutX + clutW - 1, core.clutY, core.clutY };
+
+            if (clutBounds.intersects(dr.pendingWrites)) {
+                flush(core);
+            }
+        }
+
+        updateClutCache(core);
+        dr.curClutSnapshotIdx = NO_CLUT_SNAPSHOT;
+    }
+
+    if (dstBounds.isEmpty())
+        return;
+
+    // Some primitives give results which depend on the order pixels are drawn in, so they cannot be split into tiles.
+    // These must be drawn immediately after flushing, in the order they were submitted:
+    //  (1) Flat colored blended primitives (other than lines) feed the blended color for each pixel into the blend for the next pixel.
+    //  (2) Textured primitives which sample from the area of VRAM they draw to.
+    const bool bCarriesBlendedColor = (
+        (cmd.drawMode == DrawMode::ColoredBlended) &&
+        (cmd.primType != PrimType::Line) &&
+        (cmd.primType != PrimType::TriangleGouraud) &&
+        (cmd.primType != PrimType::WallColGouraud)
+    );
+
+    PixelBounds texBounds = EMPTY_BOUNDS;
+
+    if (bTextured) {
+        texBounds = getTexReadBounds(core, (bIsDoomPrim) ? TexFmt::Bpp8 : core.texFmt);
+    }
+
+    if (bCarriesBlendedColor || texBounds.intersects(dstBounds)) {
+        flush(core);
+        drawCmd(core, cmd, NO_CLIP);
+        return;
+    }
+
+    // Check for dependencies between this primitive and pending drawing via texturing, and flush if there are any
+
+    if (texBounds.intersects(dr.pendingWrites) || dstBounds.intersects(dr.pendingReads)) {
+        flush(core);
+    }
+
+    // Save the CLUT cache contents if required, then queue up the primitive
+    DeferredCmd& queuedCmd = dr.cmds.emplace_back(cmd);
+
+    if (bUsesClut) {
+        if (dr.curClutSnapshotIdx == NO_CLUT_SNAPSHOT) {
+            ClutSnapshot& clut = dr.clutSnapshots.emplace_back();
+            clut.fmt = core.clutCacheFmt;
+            clut.x = core.clutCacheX;
+            clut.y = core.clutCacheY;
+            std::memcpy(clut.colors, core.clutCache, sizeof(clut.colors));
+            dr.curClutSnapshotIdx = (uint32_t) dr.clutSnapshots.size() - 1;
+        }
+
+        queuedCmd.clutSnapshotIdx = dr.curClutSnapshotIdx;
+    }
+
+    addToBounds(dr.pendingWrites, dstBounds);
+
+    if (bTextured) {
+        addToBounds(dr.pendingReads, texBounds);
+    }
+
+    // Bin the primitive into all the tiles it touches
+    const uint32_t cmdIdx = (uint32_t) dr.cmds.size() - 1;
+    const uint32_t tileLx = (uint32_t) std::max(dstBounds.lx, 0) >> TILE_SIZE_SHIFT;
+    const uint32_t tileRx = std::min((uint32_t) dstBounds.rx >> TILE_SIZE_SHIFT, dr.numTilesX - 1);
+    const uint32_t tileTy = (uint32_t) std::max(dstBounds.ty, 0) >> TILE_SIZE_SHIFT;
+    const uint32_t tileBy = std::min((uint32_t) dstBounds.by >> TILE_SIZE_SHIFT, dr.numTilesY - 1);
+
+    for (uint32_t tileY = tileTy; tileY <= tileBy; ++tileY) {
+        for (uint32_t tileX = tileLx; tileX <= tileRx; ++tileX) {
+            const uint32_t tileIdx = tileY * dr.numTilesX + tileX;
+            std::vector<uint32_t>& tileCmds = dr.tileCmds[tileIdx];
+
+            if (tileCmds.empty()) {
+                dr.activeTiles.push_back(tileIdx);
+            }
+
+            tileCmds.push_back(cmdIdx);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Deferred mode: make a queued draw command for the given primitive and submit it
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class PrimT>
+static void deferDraw(Core& core, const PrimT& prim, const DrawMode drawMode) noexcept {
+    DeferredCmd cmd;
+    cmd.state = getDrawState(core);
+    cmd.drawMode = drawMode;
+    cmd.clutSnapshotIdx = NO_CLUT_SNAPSHOT;
+
+    if constexpr (std::is_same_v<PrimT, DrawRect>) {
+        cmd.primType = PrimType::Rect;
+        cmd.prim.rect = prim;
+    } else if constexpr (std::is_same_v<PrimT, DrawLine>) {
+        cmd.primType = PrimType::Line;
+        cmd.prim.line = prim;
+    } else if constexpr (std::is_same_v<PrimT, DrawTriangle>) {
+        cmd.primType = PrimType::Triangle;
+        cmd.prim.triangle = prim;
+    } else if constexpr (std::is_same_v<PrimT, DrawTriangleGouraud>) {
+        cmd.primType = PrimType::TriangleGouraud;
+        cmd.prim.triangleGouraud = prim;
+    } else if constexpr (std::is_same_v<PrimT, DrawFloorRow>) {
+        cmd.primType = PrimType::FloorRow;
+        cmd.prim.floorRow = prim;
+    } else if constexpr (std::is_same_v<PrimT, DrawWallCol>) {
+        cmd.primType = PrimType::WallCol;
+        cmd.prim.wallCol = prim;
+    } else {
+        static_assert(std::is_same_v<PrimT, DrawWallColGouraud>);
+        cmd.primType = PrimType::WallColGouraud;
+        cmd.prim.wallColGouraud = prim;
+    }
+
+    submitDeferredCmd(core, cmd);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Enable deferred rendering mode for the core using the specified number of threads in total for rasterization.
+// The thread calling 'flush' is counted as one of these threads and helps out with rasterization.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void enableDeferredMode(Core& core, const uint32_t numThreads) noexcept {
+    disableDeferredMode(core);
+
+    DeferredRenderer* const pDeferred = new DeferredRenderer();
+    DeferredRenderer& dr = *pDeferred;
+    dr.curClutSnapshotIdx = NO_CLUT_SNAPSHOT;
+    dr.numTilesX = std::max<uint32_t>((uint32_t) core.ramPixelW >> TILE_SIZE_SHIFT, 1);
+    dr.numTilesY = std::max<uint32_t>((uint32_t) core.ramPixelH >> TILE_SIZE_SHIFT, 1);
+    dr.tileCmds.resize((size_t) dr.numTilesX * dr.numTilesY);
+    dr.pendingWrites = EMPTY_BOUNDS;
+    dr.pendingReads = EMPTY_BOUNDS;
+    dr.jobId = 0;
+    dr.numWorkersBusy = 0;
+    dr.bQuit = false;
+    dr.pJobCore = nullptr;
+    dr.nextActiveTileIdx = 0;
+
+    const uint32_t numWorkers = (numThreads > 1) ? numThreads - 1 : 0;
+    dr.workers.reserve(numWorkers);
+
+    for (uint32_t i = 0; i < numWorkers; ++i) {
+        dr.workers.emplace_back(workerThreadMain, std::ref(dr));
+    }
+
+    core.pDeferred = pDeferred;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Disable deferred rendering mode for the core, if enabled; draws everything that is pending and shuts down the worker threads
+//------------------------------------------------------------------------------------------------------------------------------------------
+void disableDeferredMode(Core& core) noexcept {
+    if (!core.pDeferred)
+        return;
+
+    flush(core);
+    DeferredRenderer& dr = *core.pDeferred;
+
+    {
+        std::lock_guard<std::mutex> lock(dr.mutex);
+        dr.bQuit = true;
+    }
+
+    dr.jobStartCV.notify_all();
+
+    for (std::thread& worker : dr.workers) {
+        worker.join();
+    }
+
+    delete core.pDeferred;
+    core.pDeferred = nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if deferred rendering mode is enabled for the core
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool isDeferredModeEnabled(const Core& core) noexcept {
+    return (core.pDeferred != nullptr);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Deferred mode: rasterize all queued primitives in parallel and wait for that to finish.
+// Does nothing if deferred mode is not enabled.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void flush(Core& core) noexcept {
+    if (!core.pDeferred)
+        return;
+
+    DeferredRenderer& dr = *core.pDeferred;
+
+    if (dr.cmds.empty())
+        return;
+
+    // Kick off the workers (if any) and help out with rasterizing on this thread, then wait for everything to finish
+    dr.nextActiveTileIdx.store(0, std::memory_order_relaxed);
+
+    if (!dr.workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(dr.mutex);
+            dr.pJobCore = &core;
+            dr.jobId++;
+            dr.numWorkersBusy = (uint32_t) dr.workers.size();
+        }
+
+        dr.jobStartCV.notify_all();
+        rasterizeTiles(dr, core);
+
+        std::unique_lock<std::mutex> lock(dr.mutex);
+        dr.jobDoneCV.wait(lock, [&]() noexcept { return (dr.numWorkersBusy == 0); });
+    } else {
+        rasterizeTiles(dr, core);
+    }
+
+    // Clear out everything that was queued
+    for (const uint32_t tileIdx : dr.activeTiles) {
+        dr.tileCmds[tileIdx].clear();
+    }
+
+    dr.activeTiles.clear();
+    dr.cmds.clear();
+    dr.clutSnapshots.clear();
+    dr.curClutSnapshotIdx = NO_CLUT_SNAPSHOT;
+    dr.pendingWrites = EMPTY_BOUNDS;
+    dr.pendingReads = EMPTY_BOUNDS;
+}
+
 END_NAMESPACE(Gpu)
@@ -19,6 +19,7 @@
 //  (7) The GPU 'mask bit' for masking pixels is not supported, Doom did not use this.
 //  (8) X and Y flipping textures is not supported; original PS1 models did not have this anyway so games could not use it.
 //  (9) All rendering/command primitives are fed directly to the GPU and handled immediately - command buffers are not supported.
+//      The one exception to this is the optional 'deferred' mode, where primitives are binned into tiles and rasterized in parallel.
 //  (10) Only rectangles, lines, triangles, and a few (newly added) Doom specific primitives are supported.
 //       Quads must be decomposed externally into triangles.
 //  (11) The full range of draw primitives exposed by the original LIBGPU is NOT provided, only the ones that Doom uses.
@@ -222,6 +223,9 @@ struct DrawWallColGouraud {
     Color24F    color2;     // Column point 2: color
 };
 
+// Opaque state for the deferred (tiled and multithreaded) rendering mode
+struct DeferredRenderer;
+
 //----------------------------------------------------------------------------------------------------------------------
 // The GPU core/device itself
 //----------------------------------------------------------------------------------------------------------------------
@@ -260,11 +264,19 @@ struct Core {
     uint16_t        clutCacheX;
     uint16_t        clutCacheY;
     Color16         clutCache[256];
+
+    // Use SIMD for shading wall columns and floor rows? Output is identical either way. Defaults to 'true' if supported.
+    bool            bUseSimd;
+
+    // If not null then deferred rendering is enabled, and draw primitives are queued up rather than being rasterized immediately.
+    // See 'enableDeferredMode' for more details.
+    DeferredRenderer*   pDeferred;
 };
 
 // Initializing and shutting down a core
 void initCore(Core& core, const uint16_t ramPixelW, const uint16_t ramPixelH) noexcept;
 void destroyCore(Core& core) noexcept;
+bool isSimdSupported() noexcept;
 
 // VRAM reading
 uint16_t vramReadU16(const Core& core, const uint16_t x, const uint16_t y) noexcept;
@@ -276,6 +288,20 @@ void updateClutCache(Core& core) noexcept;
 bool isPixelInDrawArea(const Core& core, const uint16_t x, const uint16_t y) noexcept;
 void clearRect(Core& core, const Color16 color, const uint16_t x, const uint16_t y, const uint16_t w, const uint16_t h) noexcept;
 
+// Deferred rendering mode.
+//
+// When enabled, all draw primitives are binned into tiles of VRAM along with a snapshot of the GPU state they were submitted with.
+// When 'flush' is called a pool of threads rasterizes the tiles in parallel, with each tile processing its primitives in submission order.
+// Since every pixel belongs to exactly one tile, blending and masking give exactly the same results as the immediate mode.
+// Primitives which sample from areas of VRAM that have pending draws, or which draw over areas that pending primitives sample from,
+// cause an automatic flush beforehand so that texturing is also unaffected.
+//
+// IMPORTANT: 'flush' MUST be called before VRAM is accessed directly via 'pRam' (to read or write) while this mode is enabled!
+void enableDeferredMode(Core& core, const uint32_t numThreads) noexcept;
+void disableDeferredMode(Core& core) noexcept;
+bool isDeferredModeEnabled(const Core& core) noexcept;
+void flush(Core& core) noexcept;
+
 // Color manipulation and conversion
 template <DrawMode DrawMode>
 Color16 color24FTo16(const Color24F colorIn) noexcept;
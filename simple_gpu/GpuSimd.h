@@ -0,0 +1,272 @@
+#pragma once
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// SIMD span shading for the Doom specific wall column and floor row primitives, which make up most of the pixels in a classic frame.
+// These are internal to the GPU implementation and are only used when 'Core::bUseSimd' is set.
+//
+// Notes:
+//  (1) All of these routines must produce output which is bit-identical to the scalar routines in 'Gpu.cpp'.
+//      Texture coordinates and gouraud colors are interpolated by accumulating floating point steps from pixel to pixel, so that part
+//      is still done by scalar code in exactly the same order; the results are handed to 'shadeSpanBatch' in batches of 8 pixels.
+//  (2) Only 128-bit vectors are used (SSE2 or NEON), each holding 8 16-bit pixels.
+//      Both instruction sets are a guaranteed part of the 64-bit x86 and ARM architectures, so no CPU feature detection is needed.
+//  (3) Neither SSE2 nor NEON have a gather instruction, so the VRAM and CLUT lookups for each texel are done one at a time.
+//      Texture window/page wrapping, masking, color modulation and blending are all done 8 pixels at a time however.
+//  (4) All texels for a batch are fetched before any pixels are written, so these routines must NOT be used if a primitive can read
+//      texels from the same area of VRAM that it draws to.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "Gpu.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define SIMPLE_GPU_SIMD_SSE2 1
+    #define SIMPLE_GPU_SIMD_NEON 0
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+    #define SIMPLE_GPU_SIMD_SSE2 0
+    #define SIMPLE_GPU_SIMD_NEON 1
+    #include <arm_neon.h>
+#else
+    #define SIMPLE_GPU_SIMD_SSE2 0
+    #define SIMPLE_GPU_SIMD_NEON 0
+#endif
+
+#define SIMPLE_GPU_SIMD (SIMPLE_GPU_SIMD_SSE2 || SIMPLE_GPU_SIMD_NEON)
+
+#if SIMPLE_GPU_SIMD
+
+BEGIN_NAMESPACE(Gpu)
+BEGIN_NAMESPACE(Simd)
+
+// The number of pixels processed at a time
+static constexpr uint32_t BATCH_SIZE = 8;
+
+// A vector of 8 16-bit pixels or values
+#if SIMPLE_GPU_SIMD_SSE2
+    typedef __m128i Vec16;
+#else
+    typedef uint16x8_t Vec16;
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Basic operations on vectors of 8 unsigned 16-bit values.
+// Note: 'vmin' is only valid for values less than 0x8000 since SSE2 only has a signed 16-bit minimum.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if SIMPLE_GPU_SIMD_SSE2
+    inline Vec16 vload(const uint16_t* const pSrc) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc)); }
+    inline void vstore(uint16_t* const pDst, const Vec16 a) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst), a); }
+    inline Vec16 vsplat(const uint16_t value) noexcept { return _mm_set1_epi16((int16_t) value); }
+    inline Vec16 vand(const Vec16 a, const Vec16 b) noexcept { return _mm_and_si128(a, b); }
+    inline Vec16 vor(const Vec16 a, const Vec16 b) noexcept { return _mm_or_si128(a, b); }
+    inline Vec16 vadd(const Vec16 a, const Vec16 b) noexcept { return _mm_add_epi16(a, b); }
+    inline Vec16 vsubSat(const Vec16 a, const Vec16 b) noexcept { return _mm_subs_epu16(a, b); }
+    inline Vec16 vmul(const Vec16 a, const Vec16 b) noexcept { return _mm_mullo_epi16(a, b); }
+    inline Vec16 vmin(const Vec16 a, const Vec16 b) noexcept { return _mm_min_epi16(a, b); }
+    inline Vec16 vcmpEq(const Vec16 a, const Vec16 b) noexcept { return _mm_cmpeq_epi16(a, b); }
+    inline Vec16 vselect(const Vec16 mask, const Vec16 a, const Vec16 b) noexcept { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+    template <int N> inline Vec16 vshr(const Vec16 a) noexcept { return _mm_srli_epi16(a, N); }
+    template <int N> inline Vec16 vshl(const Vec16 a) noexcept { return _mm_slli_epi16(a, N); }
+#else
+    inline Vec16 vload(const uint16_t* const pSrc) noexcept { return vld1q_u16(pSrc); }
+    inline void vstore(uint16_t* const pDst, const Vec16 a) noexcept { vst1q_u16(pDst, a); }
+    inline Vec16 vsplat(const uint16_t value) noexcept { return vdupq_n_u16(value); }
+    inline Vec16 vand(const Vec16 a, const Vec16 b) noexcept { return vandq_u16(a, b); }
+    inline Vec16 vor(const Vec16 a, const Vec16 b) noexcept { return vorrq_u16(a, b); }
+    inline Vec16 vadd(const Vec16 a, const Vec16 b) noexcept { return vaddq_u16(a, b); }
+    inline Vec16 vsubSat(const Vec16 a, const Vec16 b) noexcept { return vqsubq_u16(a, b); }
+    inline Vec16 vmul(const Vec16 a, const Vec16 b) noexcept { return vmulq_u16(a, b); }
+    inline Vec16 vmin(const Vec16 a, const Vec16 b) noexcept { return vminq_u16(a, b); }
+    inline Vec16 vcmpEq(const Vec16 a, const Vec16 b) noexcept { return vceqq_u16(a, b); }
+    inline Vec16 vselect(const Vec16 mask, const Vec16 a, const Vec16 b) noexcept { return vbslq_u16(mask, a, b); }
+    template <int N> inline Vec16 vshr(const Vec16 a) noexcept { return vshrq_n_u16(a, N); }
+    template <int N> inline Vec16 vshl(const Vec16 a) noexcept { return vshlq_n_u16(a, N); }
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Same as 'Gpu::colorMul' for 8 colors at once.
+// The multipliers for each color are given as separate vectors of red, green and blue components (in 1.7 fixed point format).
+//------------------------------------------------------------------------------------------------------------------------------------------
+inline Vec16 colorMul(const Vec16 colors, const Vec16 mulR, const Vec16 mulG, const Vec16 mulB) noexcept {
+    const Vec16 compMask = vsplat(0x1F);
+    const Vec16 compMax = vsplat(31);
+
+    // Note: the max product here is 31 * 255 which easily fits in 16-bits
+    const Vec16 r = vmin(vshr<7>(vmul(vand(colors, compMask), mulR)), compMax);
+    const Vec16 g = vmin(vshr<7>(vmul(vand(vshr<5>(colors), compMask), mulG)), compMax);
+    const Vec16 b = vmin(vshr<7>(vmul(vand(vshr<10>(colors), compMask), mulB)), compMax);
+    const Vec16 t = vand(colors, vsplat(0x8000));
+    return vor(vor(r, vshl<5>(g)), vor(vshl<10>(b), t));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Same as 'Gpu::colorBlend' for 8 colors at once
+//------------------------------------------------------------------------------------------------------------------------------------------
+inline Vec16 colorBlend(const Vec16 bg, const Vec16 fg, const BlendMode mode) noexcept {
+    const Vec16 compMask = vsplat(0x1F);
+    const Vec16 compMax = vsplat(31);
+
+    const Vec16 bgR = vand(bg, compMask);
+    const Vec16 bgG = vand(vshr<5>(bg), compMask);
+    const Vec16 bgB = vand(vshr<10>(bg), compMask);
+    const Vec16 fgR = vand(fg, compMask);
+    const Vec16 fgG = vand(vshr<5>(fg), compMask);
+    const Vec16 fgB = vand(vshr<10>(fg), compMask);
+
+    Vec16 r, g, b;
+
+    switch (mode) {
+        case BlendMode::Alpha50:
+            r = vshr<1>(vadd(bgR, fgR));
+            g = vshr<1>(vadd(bgG, fgG));
+            b = vshr<1>(vadd(bgB, fgB));
+            break;
+
+        case BlendMode::Add:
+            r = vmin(vadd(bgR, fgR), compMax);
+            g = vmin(vadd(bgG, fgG), compMax);
+            b = vmin(vadd(bgB, fgB), compMax);
+            break;
+
+        case BlendMode::Subtract:
+            r = vsubSat(bgR, fgR);
+            g = vsubSat(bgG, fgG);
+            b = vsubSat(bgB, fgB);
+            break;
+
+        case BlendMode::Add25:
+        default:
+            r = vmin(vadd(bgR, vshr<2>(fgR)), compMax);
+            g = vmin(vadd(bgG, vshr<2>(fgG)), compMax);
+            b = vmin(vadd(bgB, vshr<2>(fgB)), compMax);
+            break;
+    }
+
+    // Note: like the scalar version the semi-transparency bit comes from the foreground color
+    const Vec16 t = vand(fg, vsplat(0x8000));
+    return vor(vor(r, vshl<5>(g)), vor(vshl<10>(b), t));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Converts 8 untextured gouraud shaded colors (8-bits per component) to 16-bit, like the scalar gouraud wall column code does
+//------------------------------------------------------------------------------------------------------------------------------------------
+inline Vec16 gouraudColorTo16(const Vec16 r8, const Vec16 g8, const Vec16 b8) noexcept {
+    const Vec16 round = vsplat(4);
+    const Vec16 compMax = vsplat(31);
+
+    const Vec16 r = vmin(vshr<3>(vadd(r8, round)), compMax);
+    const Vec16 g = vmin(vshr<3>(vadd(g8, round)), compMax);
+    const Vec16 b = vmin(vshr<3>(vadd(b8, round)), compMax);
+    return vor(r, vor(vshl<5>(g), vshl<10>(b)));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Inputs for shading a batch of up to 8 pixels in a wall column or floor row.
+// The pixels in the batch are consecutive pixels in the column or row.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SpanBatch {
+    alignas(16) uint16_t u[BATCH_SIZE];     // Texture coordinate for each pixel (8bpp texels): unused if not texturing
+    alignas(16) uint16_t v[BATCH_SIZE];     // Texture coordinate for each pixel (8bpp texels): unused if not texturing
+    alignas(16) uint16_t r[BATCH_SIZE];     // Color for each pixel: a 1.7 fixed point multiplier if texturing, otherwise a 0-255 value
+    alignas(16) uint16_t g[BATCH_SIZE];     // Color for each pixel: a 1.7 fixed point multiplier if texturing, otherwise a 0-255 value
+    alignas(16) uint16_t b[BATCH_SIZE];     // Color for each pixel: a 1.7 fixed point multiplier if texturing, otherwise a 0-255 value
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Shades and writes a batch of up to 8 wall column or floor row pixels, using the current GPU state.
+// If texturing then the texture format is assumed to be 8bpp and the CLUT cache is assumed to be up to date.
+// If not texturing then the colors in the batch are assumed to be gouraud shaded colors which need conversion to 16-bit.
+// The pixels are written starting at 'pDst' and 'dstStride' pixels apart.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawMode DrawMode>
+inline void shadeSpanBatch(
+    const Core& core,
+    const SpanBatch& batch,
+    const uint32_t numPixels,
+    uint16_t* const pDst,
+    const uint32_t dstStride
+) noexcept {
+    constexpr bool bTextured = ((DrawMode == DrawMode::Textured) || (DrawMode == DrawMode::TexturedBlended));
+    constexpr bool bBlended = ((DrawMode == DrawMode::ColoredBlended) || (DrawMode == DrawMode::TexturedBlended));
+
+    ASSERT((numPixels > 0) && (numPixels <= BATCH_SIZE));
+    const bool bFullContiguousBatch = ((dstStride == 1) && (numPixels == BATCH_SIZE));
+
+    // Read the existing pixels: these are needed for blending and also to leave masked pixels unchanged
+    alignas(16) uint16_t pixels[BATCH_SIZE] = {};
+    Vec16 bgColors;
+
+    if (bFullContiguousBatch) {
+        bgColors = vload(pDst);
+    } else {
+        for (uint32_t i = 0; i < numPixels; ++i) {
+            pixels[i] = pDst[i * dstStride];
+        }
+
+        bgColors = vload(pixels);
+    }
+
+    // Figure out the foreground color for each pixel and which pixels are to be skipped (if masked)
+    Vec16 fgColors;
+    Vec16 bSkipPixel = vsplat(0);
+
+    if constexpr (bTextured) {
+        // Wrap the texture coordinates to the texture window and page, and then VRAM; this mirrors 'readTexel<TexFmt::Bpp8>'
+        const Vec16 u = vload(batch.u);
+        const Vec16 v = vload(batch.v);
+
+        Vec16 vramX = vadd(vand(u, vsplat(core.texWinXMask)), vsplat(core.texWinX));
+        Vec16 vramY = vadd(vand(v, vsplat(core.texWinYMask)), vsplat(core.texWinY));
+        vramX = vadd(vand(vshr<1>(vramX), vsplat(core.texPageXMask)), vsplat(core.texPageX));
+        vramY = vadd(vand(vramY, vsplat(core.texPageYMask)), vsplat(core.texPageY));
+        vramX = vand(vramX, vsplat(core.ramXMask));
+        vramY = vand(vramY, vsplat(core.ramYMask));
+
+        alignas(16) uint16_t vramXs[BATCH_SIZE];
+        alignas(16) uint16_t vramYs[BATCH_SIZE];
+        vstore(vramXs, vramX);
+        vstore(vramYs, vramY);
+
+        // Fetch the CLUT indexes and then the texels one at a time (no gather instructions available).
+        // Note: lanes beyond the end of the batch are fetched also, which is safe since the coordinates have been wrapped to VRAM.
+        const uint16_t* const pVram = core.pRam;
+        const uint32_t vramPixelW = core.ramPixelW;
+        alignas(16) uint16_t texels[BATCH_SIZE];
+
+        for (uint32_t i = 0; i < BATCH_SIZE; ++i) {
+            const uint16_t vramPixel = pVram[(uint32_t) vramYs[i] * vramPixelW + vramXs[i]];
+            const uint16_t clutIdx = (vramPixel >> ((batch.u[i] & 1) * 8)) & 0xFF;
+            texels[i] = core.clutCache[clutIdx];
+        }
+
+        const Vec16 texelColors = vload(texels);
+
+        if (!core.bDisableMasking) {
+            bSkipPixel = vcmpEq(texelColors, vsplat(0));
+        }
+
+        fgColors = colorMul(texelColors, vload(batch.r), vload(batch.g), vload(batch.b));
+    } else {
+        fgColors = gouraudColorTo16(vload(batch.r), vload(batch.g), vload(batch.b));
+    }
+
+    // Do blending with the background if that is enabled and save the output pixels
+    if constexpr (bBlended) {
+        fgColors = colorBlend(bgColors, fgColors, core.blendMode);
+    }
+
+    const Vec16 outColors = vselect(bSkipPixel, bgColors, fgColors);
+
+    if (bFullContiguousBatch) {
+        vstore(pDst, outColors);
+    } else {
+        vstore(pixels, outColors);
+
+        for (uint32_t i = 0; i < numPixels; ++i) {
+            pDst[i * dstStride] = pixels[i];
+        }
+    }
+}
+
+END_NAMESPACE(Simd)
+END_NAMESPACE(Gpu)
+
+#endif  // #if SIMPLE_GPU_SIMD
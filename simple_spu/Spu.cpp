@@ -1,6 +1,7 @@
 #include "Spu.h"
 
 #include "Asserts.h"
+#include "SpuSimd.h"
 
 #include <algorithm>
 #include <cstring>
@@ -44,6 +45,42 @@ static constexpr int32_t INTERP_GAUSS_TABLE[512] = {
     0x593A, 0x5949, 0x5958, 0x5965, 0x5971, 0x597C, 0x5986, 0x598F, 0x5997, 0x599E, 0x59A4, 0x59A9, 0x59AD, 0x59B0, 0x59B2, 0x59B3,
 };
 
+#if SIMPLE_SPU_SIMD
+//------------------------------------------------------------------------------------------------------------------------------------------
+// The gaussian interpolation table rearranged for SIMD: for each of the 256 gauss indexes this holds the 4 factors to multiply the
+// 4 most recent samples with (oldest first), so that they can be loaded with a single vector load.
+// For the floating point SPU the factors are pre-converted to floating point.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct GaussTaps {
+    alignas(16) Simd::SampleValue taps[4];
+};
+
+static constexpr auto INTERP_GAUSS_TAPS = []() noexcept {
+    struct {
+        GaussTaps entries[256];
+    } table = {};
+
+    for (int32_t gaussTableIdx = 0; gaussTableIdx < 256; ++gaussTableIdx) {
+        const int32_t factors[4] = {
+            INTERP_GAUSS_TABLE[(255 - gaussTableIdx) & 0x1FF],
+            INTERP_GAUSS_TABLE[(511 - gaussTableIdx) & 0x1FF],
+            INTERP_GAUSS_TABLE[(256 + gaussTableIdx) & 0x1FF],
+            INTERP_GAUSS_TABLE[(      gaussTableIdx) & 0x1FF],
+        };
+
+        for (int32_t i = 0; i < 4; ++i) {
+            #if SIMPLE_SPU_FLOAT_SPU
+                table.entries[gaussTableIdx].taps[i] = toFloatSample((int16_t) factors[i]);
+            #else
+                table.entries[gaussTableIdx].taps[i] = (int16_t) factors[i];
+            #endif
+        }
+    }
+
+    return table;
+}();
+#endif  // #if SIMPLE_SPU_SIMD
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Read from sound memory with bounds checking.
 // Any portion read beyond the end of sound memory will be zeroed.
@@ -64,9 +101,9 @@ static void sramRead(
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Decode an ADPCM block for the given voice
+// Decode an ADPCM block for the given voice, optionally using the SIMD decoder
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void decodeAdpcmBlock(Voice& voice, std::byte adpcmBlock[ADPCM_BLOCK_SIZE]) noexcept {
+static void decodeAdpcmBlock(Voice& voice, std::byte adpcmBlock[ADPCM_BLOCK_SIZE], [[maybe_unused]] const bool bUseSimd) noexcept {
     // Hold the last 2 ADPCM samples we decoded here with the newest first.
     // They are required for the adaptive decoding throughout and carry across ADPCM blocks.
     Sample prevSamples[2] = {
@@ -111,6 +148,24 @@ static void decodeAdpcmBlock(Voice& voice, std::byte adpcmBlock[ADPCM_BLOCK_SIZE
         const int32_t filterCoefNeg = FILTER_COEF_NEG[adpcmFilter];
     #endif
 
+    // Use the SIMD decoder if enabled: it produces exactly the same output as the code below
+    #if SIMPLE_SPU_SIMD
+        if (bUseSimd) {
+            Simd::decodeAdpcmSamples(
+                adpcmBlock,
+                sampleShift,
+                adpcmFilter,
+                filterCoefPos,
+                filterCoefNeg,
+                prevSamples[0].value,
+                prevSamples[1].value,
+                voice.samples + Voice::NUM_PREV_SAMPLES
+            );
+
+            return;
+        }
+    #endif
+
     // Decode all of the samples
     for (int32_t sampleIdx = 0; sampleIdx < ADPCM_BLOCK_NUM_SAMPLES; sampleIdx++) {
         // Read this samples 4-bit data
@@ -288,13 +343,19 @@ static Sample getVoiceSample(const Voice& voice, const uint32_t index) noexcept
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Get the current (interpolated) sample for the given voice
+// Get the current (interpolated) sample for the given voice, optionally using SIMD to do the interpolation
 //------------------------------------------------------------------------------------------------------------------------------------------
-static Sample getInterpolatedVoiceSample(const Voice& voice) noexcept {
+static Sample getInterpolatedVoiceSample(const Voice& voice, [[maybe_unused]] const bool bUseSimd) noexcept {
     // What sample and interpolation index should we use?
     const int32_t curSampleIdx  = (int32_t) voice.adpcmBlockPos.fields.sampleIdx;
     const int32_t gaussTableIdx = (int32_t)(uint8_t) voice.adpcmBlockPos.fields.gaussIdx;
 
+    // Use SIMD if enabled, provided the 4 samples are loaded and within the sample buffer (which should always be the case)
+    #if SIMPLE_SPU_SIMD
+        if (bUseSimd && voice.bSamplesLoaded && (curSampleIdx < ADPCM_BLOCK_NUM_SAMPLES))
+            return Simd::interpolateSamples(voice.samples + curSampleIdx, INTERP_GAUSS_TAPS.entries[gaussTableIdx].taps);
+    #endif
+
     // Get the most recent sample and previous 3 samples
     const Sample samp1 = getVoiceSample(voice, Voice::NUM_PREV_SAMPLES + curSampleIdx - 3);
     const Sample samp2 = getVoiceSample(voice, Voice::NUM_PREV_SAMPLES + curSampleIdx - 2);
@@ -334,56 +395,52 @@ static Sample getInterpolatedVoiceSample(const Voice& voice) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Process/update a single voice and return it's output and output to be reverberated
+// Read and decode the next ADPCM block for the voice if it is time to do so.
+// Returns 'true' if a new block was read, in which case the ADPCM flags for the block are also returned.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void stepVoice(
+static inline bool loadVoiceSamples(
     Voice& voice,
-    const std::byte* pRam,
+    const std::byte* const pRam,
     const uint32_t ramSize,
-    StereoSample& output,
-    StereoSample& outputToReverb
+    const bool bUseSimd,
+    uint8_t& adpcmFlags
 ) noexcept {
-    // Nothing to do if the voice is switched off
-    if (voice.envPhase == EnvPhase::Off)
-        return;
+    if (voice.bSamplesLoaded)
+        return false;
 
-    // Read and decode the next ADPCM block if it is time.
-    // Note that if we read in a new block then we'll have to handle the ADPCM flags at the end.
     std::byte adpcmBlock[ADPCM_BLOCK_SIZE];
-    bool bHandleAdpcmFlags = false;
-
-    if (!voice.bSamplesLoaded) {
-        const uint32_t samplesAddr = voice.adpcmCurAddr8 * 8;
-        sramRead(pRam, ramSize, samplesAddr, ADPCM_BLOCK_SIZE, adpcmBlock);
-        decodeAdpcmBlock(voice, adpcmBlock);
-        voice.bSamplesLoaded = true;
-        bHandleAdpcmFlags = true;
-    }
-
-    // Process the ADSR envelope for the voice
-    stepVoiceEnvelope(voice);
-
-    // Get the interpolated sample for the voice, attenuate by the volume envelope and voice volume, and add to the output.
-    // Only bother doing this however if the voice is actually turned on.
-    if (!voice.bDisabled) {
-        const Sample rawSample = getInterpolatedVoiceSample(voice);
-        const Sample sampleEnvScaled = rawSample * voice.envLevel;
-        const int16_t realVoiceVolL = (int16_t) std::clamp((int32_t) voice.volume.left * 2, INT16_MIN, +INT16_MAX);     // N.B: voice volume was divided by 2
-        const int16_t realVoiceVolR = (int16_t) std::clamp((int32_t) voice.volume.right * 2, INT16_MIN, +INT16_MAX);
-
-        const StereoSample sampleVolScaled = {
-            sampleEnvScaled * realVoiceVolL,
-            sampleEnvScaled * realVoiceVolR
-        };
+    const uint32_t samplesAddr = voice.adpcmCurAddr8 * 8;
+    sramRead(pRam, ramSize, samplesAddr, ADPCM_BLOCK_SIZE, adpcmBlock);
+    decodeAdpcmBlock(voice, adpcmBlock, bUseSimd);
+    voice.bSamplesLoaded = true;
+
+    // The ADPCM flags are in the 2nd byte of the ADPCM block
+    adpcmFlags = (uint8_t) adpcmBlock[1];
+    return true;
+}
 
-        output += sampleVolScaled;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the interpolated sample for the voice, attenuated by the volume envelope
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline Sample getEnvScaledVoiceSample(const Voice& voice, const bool bUseSimd) noexcept {
+    const Sample rawSample = getInterpolatedVoiceSample(voice, bUseSimd);
+    return rawSample * voice.envLevel;
+}
 
-        // Only include in the output to reverberate if reverb is enabled for the voice
-        if (voice.bDoReverb) {
-            outputToReverb += sampleVolScaled;
-        }
-    }
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the real left and right volume levels for a voice; the volume stored in the voice is divided by 2
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline Volume getRealVoiceVolume(const Voice& voice) noexcept {
+    return Volume {
+        (int16_t) std::clamp((int32_t) voice.volume.left * 2, INT16_MIN, +INT16_MAX),
+        (int16_t) std::clamp((int32_t) voice.volume.right * 2, INT16_MIN, +INT16_MAX)
+    };
+}
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Advance the voice to the next sample after it has been output, and handle the flags for any ADPCM block that was just read
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void advanceVoice(Voice& voice, const bool bHandleAdpcmFlags, const uint8_t adpcmFlags) noexcept {
     // Advance the position of the voice within the current sample block.
     // Note that the original PSX SPU wouldn't allow frequencies of more than 176,400 Hz (0x4000), hence we clamp the frequency here.
     // Certain pieces of music in Doom need this clamping to be done in order to sound correct.
@@ -404,9 +461,6 @@ static void stepVoice(
 
     // Handle processing flags for the current ADPCM block we just read (if we read one)
     if (bHandleAdpcmFlags) {
-        // The ADPCM flags are in the 2nd byte of the ADPCM block
-        const uint8_t adpcmFlags = (uint8_t) adpcmBlock[1];
-
         // Is this where we jump to restart a loop?
         if (adpcmFlags & ADPCM_FLAG_LOOP_START) {
             voice.adpcmRepeatAddr8 = voice.adpcmCurAddr8;
@@ -426,6 +480,98 @@ static void stepVoice(
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Process/update a single voice and return it's output and output to be reverberated
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void stepVoice(
+    Voice& voice,
+    const std::byte* pRam,
+    const uint32_t ramSize,
+    const bool bUseSimd,
+    StereoSample& output,
+    StereoSample& outputToReverb
+) noexcept {
+    // Nothing to do if the voice is switched off
+    if (voice.envPhase == EnvPhase::Off)
+        return;
+
+    // Read and decode the next ADPCM block if it is time.
+    // Note that if we read in a new block then we'll have to handle the ADPCM flags at the end.
+    uint8_t adpcmFlags = 0;
+    const bool bHandleAdpcmFlags = loadVoiceSamples(voice, pRam, ramSize, bUseSimd, adpcmFlags);
+
+    // Process the ADSR envelope for the voice
+    stepVoiceEnvelope(voice);
+
+    // Get the interpolated sample for the voice, attenuate by the volume envelope and voice volume, and add to the output.
+    // Only bother doing this however if the voice is actually turned on.
+    if (!voice.bDisabled) {
+        const Sample sampleEnvScaled = getEnvScaledVoiceSample(voice, bUseSimd);
+        const Volume realVoiceVol = getRealVoiceVolume(voice);
+
+        const StereoSample sampleVolScaled = {
+            sampleEnvScaled * realVoiceVol.left,
+            sampleEnvScaled * realVoiceVol.right
+        };
+
+        output += sampleVolScaled;
+
+        // Only include in the output to reverberate if reverb is enabled for the voice
+        if (voice.bDoReverb) {
+            outputToReverb += sampleVolScaled;
+        }
+    }
+
+    advanceVoice(voice, bHandleAdpcmFlags, adpcmFlags);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Process/update a single voice for a block of samples and add it's output to the given output and reverb input buffers.
+// Produces exactly the same result as calling 'stepVoice' once for each sample in the block, but hoists the per-voice state that
+// cannot change during the block out of the loop and stops early once the voice has switched off.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void stepVoiceBlock(
+    Voice& voice,
+    const std::byte* pRam,
+    const uint32_t ramSize,
+    const bool bUseSimd,
+    StereoSample* const pOutput,
+    StereoSample* const pOutputToReverb,
+    const uint32_t numSamples
+) noexcept {
+    // Voice volume and enabled/reverb flags can only be changed from outside of the SPU, so they are fixed for the whole block
+    const Volume realVoiceVol = getRealVoiceVolume(voice);
+    const bool bOutputSamples = (!voice.bDisabled);
+    const bool bDoReverb = voice.bDoReverb;
+
+    for (uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx) {
+        // Once the voice is switched off it stays off until the next 'key on', which can only happen outside of the SPU
+        if (voice.envPhase == EnvPhase::Off)
+            break;
+
+        uint8_t adpcmFlags = 0;
+        const bool bHandleAdpcmFlags = loadVoiceSamples(voice, pRam, ramSize, bUseSimd, adpcmFlags);
+        stepVoiceEnvelope(voice);
+
+        if (bOutputSamples) {
+            const Sample sampleEnvScaled = getEnvScaledVoiceSample(voice, bUseSimd);
+
+            const StereoSample sampleVolScaled = {
+                sampleEnvScaled * realVoiceVol.left,
+                sampleEnvScaled * realVoiceVol.right
+            };
+
+            pOutput[sampleIdx] += sampleVolScaled;
+
+            if (bDoReverb) {
+                pOutputToReverb[sampleIdx] += sampleVolScaled;
+            }
+        }
+
+        advanceVoice(voice, bHandleAdpcmFlags, adpcmFlags);
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Process/update all voices and get 1 sample of output from them
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -434,13 +580,35 @@ static void stepVoices(
     const int32_t numVoices,
     const std::byte* pRam,
     const uint32_t ramSize,
+    const bool bUseSimd,
     StereoSample& output,
     StereoSample& outputToReverb
 ) noexcept {
     ASSERT(pVoices || (numVoices == 0));
 
     for (int32_t voiceIdx = 0; voiceIdx < numVoices; ++voiceIdx) {
-        stepVoice(pVoices[voiceIdx], pRam, ramSize, output, outputToReverb);
+        stepVoice(pVoices[voiceIdx], pRam, ramSize, bUseSimd, output, outputToReverb);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Process/update all voices for a block of samples and get the output from them.
+// Voices are mixed into the output in the same order as 'stepVoices', so the result is identical to stepping sample by sample.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void stepVoicesBlock(
+    Voice* const pVoices,
+    const int32_t numVoices,
+    const std::byte* pRam,
+    const uint32_t ramSize,
+    const bool bUseSimd,
+    StereoSample* const pOutput,
+    StereoSample* const pOutputToReverb,
+    const uint32_t numSamples
+) noexcept {
+    ASSERT(pVoices || (numVoices == 0));
+
+    for (int32_t voiceIdx = 0; voiceIdx < numVoices; ++voiceIdx) {
+        stepVoiceBlock(pVoices[voiceIdx], pRam, ramSize, bUseSimd, pOutput, pOutputToReverb, numSamples);
     }
 }
 
@@ -680,8 +848,9 @@ void doMasterMix(
     void Spu::initCore(Core& core, const uint32_t ramSize, const uint32_t voiceCount) noexcept
 #endif
 {
-    // Zero init everything by default
+    // Zero init everything by default and use the SIMD sample decoding and interpolation routines where available
     core = {};
+    core.bUseSimd = isSimdSupported();
 
     // Zero voices is a valid use-case, if for example you wanted to use this as a PS1 reverb DSP
     if (voiceCount > 0) {
@@ -722,19 +891,10 @@ void Spu::destroyCore(Core& core) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Start playing the given voice
+// Mixes in external input, does reverb and the final master mix for one SPU cycle, given the output from all voices for the cycle.
+// Also advances the cycle counter for the SPU.
 //------------------------------------------------------------------------------------------------------------------------------------------
-StereoSample Spu::stepCore(Core& core) noexcept {
-    // Process all voices firstly and silence the output if we are not unmuted
-    StereoSample output = {};
-    StereoSample outputToReverb = {};
-    stepVoices(core.pVoices, core.numVoices, core.pRam, core.ramSize, output, outputToReverb);
-
-    if (!core.bUnmute) {
-        output = {};
-        outputToReverb = {};
-    }
-
+static StereoSample finishCoreStep(Core& core, StereoSample output, StereoSample outputToReverb) noexcept {
     // Mix any external input
     if (core.bExtEnabled) {
         mixExternalInput(
@@ -773,6 +933,61 @@ StereoSample Spu::stepCore(Core& core) noexcept {
     return output;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if SIMD versions of the ADPCM decoding and sample interpolation routines are available on this platform
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool Spu::isSimdSupported() noexcept {
+    return SIMPLE_SPU_SIMD;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Step the SPU core for a single cycle and return the sample output
+//------------------------------------------------------------------------------------------------------------------------------------------
+StereoSample Spu::stepCore(Core& core) noexcept {
+    // Process all voices firstly and silence the output if we are not unmuted
+    StereoSample output = {};
+    StereoSample outputToReverb = {};
+    stepVoices(core.pVoices, core.numVoices, core.pRam, core.ramSize, core.bUseSimd, output, outputToReverb);
+
+    if (!core.bUnmute) {
+        output = {};
+        outputToReverb = {};
+    }
+
+    return finishCoreStep(core, output, outputToReverb);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Step the SPU core for the specified number of cycles and save the sample output to the given buffer.
+// The output is identical to calling 'stepCore' once for each sample, but voices are processed a block at a time.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void Spu::stepCoreBlock(Core& core, StereoSample* const pOutput, const uint32_t numSamples) noexcept {
+    ASSERT(pOutput || (numSamples == 0));
+
+    // Voice output to be reverberated for the current sub-block (the voice output itself goes directly to the output buffer)
+    StereoSample outputToReverb[MAX_STEP_BLOCK_SIZE];
+
+    for (uint32_t blockStartIdx = 0; blockStartIdx < numSamples; blockStartIdx += MAX_STEP_BLOCK_SIZE) {
+        const uint32_t blockSize = std::min(numSamples - blockStartIdx, MAX_STEP_BLOCK_SIZE);
+        StereoSample* const pBlockOutput = pOutput + blockStartIdx;
+
+        // Process all voices for the block firstly and silence the output if we are not unmuted
+        std::fill_n(pBlockOutput, blockSize, StereoSample{});
+        std::fill_n(outputToReverb, blockSize, StereoSample{});
+        stepVoicesBlock(core.pVoices, core.numVoices, core.pRam, core.ramSize, core.bUseSimd, pBlockOutput, outputToReverb, blockSize);
+
+        if (!core.bUnmute) {
+            std::fill_n(pBlockOutput, blockSize, StereoSample{});
+            std::fill_n(outputToReverb, blockSize, StereoSample{});
+        }
+
+        // Do external input, reverb and the master mix for each sample in the block
+        for (uint32_t sampleIdx = 0; sampleIdx < blockSize; ++sampleIdx) {
+            pBlockOutput[sampleIdx] = finishCoreStep(core, pBlockOutput[sampleIdx], outputToReverb[sampleIdx]);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Start playing the given voice
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -29,6 +29,7 @@ static constexpr int16_t    MIN_MASTER_VOLUME       = -0x3FFF;      // Minimum m
 static constexpr int16_t    MAX_MASTER_VOLUME       = +0x3FFF;      // Maximum master volume level (divided by 2)
 static constexpr int16_t    MIN_ENV_LEVEL           = 0;            // Minimum allowed envelope level
 static constexpr int16_t    MAX_ENV_LEVEL           = 0x7FFF;       // Maximum allowed envelope level
+static constexpr uint32_t   MAX_STEP_BLOCK_SIZE     = 256;          // Maximum number of samples processed at once by 'stepCoreBlock' (larger requests are split up)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Flags read from the 2nd byte of a PSX ADPCM block.
@@ -417,6 +418,7 @@ struct Core {
     bool                bReverbWriteEnable;     // Whether reverb can write output to the reverb work area
     bool                bExtEnabled;            // Whether to mix input from the external input source
     bool                bExtReverbEnable;       // Whether to apply reverb on the input from the external source
+    bool                bUseSimd;               // Use SIMD for ADPCM decoding and sample interpolation? Output is identical either way. Defaults to 'true' if supported.
     ExtInputCallback    pExtInputCallback;      // Callback used to source external input: if null no external input is mixed with SPU voices
     void*               pExtInputUserData;      // User data passed to the external input callback
     uint32_t            cycleCount;             // How many cycles has the SPU done (44,100 == 1 second of audio): each cycle is generating a 16-bit left & right audio sample
@@ -448,8 +450,13 @@ struct Core {
 
 void destroyCore(Core& core) noexcept;
 
-// Step the given SPU core
+// Tells if SIMD versions of the ADPCM decoding and sample interpolation routines are available on this platform
+bool isSimdSupported() noexcept;
+
+// Step the given SPU core for a single sample, or for a whole block of samples.
+// Stepping in blocks produces identical output to stepping sample by sample, but is much faster.
 StereoSample stepCore(Core& core) noexcept;
+void stepCoreBlock(Core& core, StereoSample* const pOutput, const uint32_t numSamples) noexcept;
 
 // Key on or off the given SPU voice
 void keyOn(Voice& voice) noexcept;
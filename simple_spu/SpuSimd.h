@@ -0,0 +1,224 @@
+#pragma once
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// SIMD versions of the hot per-voice SPU routines: ADPCM block decoding and 4-tap gaussian interpolation.
+// These are internal to the SPU implementation and are only used when 'Core::bUseSimd' is set.
+//
+// Notes:
+//  (1) All of these routines must produce output which is bit-identical to the scalar routines in 'Spu.cpp'.
+//      For floating point this means that sums are done in exactly the same order as the scalar code.
+//  (2) Only 128-bit vectors are used (SSE2 or NEON), since the data being operated on is at most 28 samples wide.
+//      Both instruction sets are a guaranteed part of the 64-bit x86 and ARM architectures, so no CPU feature detection is needed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "Spu.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define SIMPLE_SPU_SIMD_SSE2 1
+    #define SIMPLE_SPU_SIMD_NEON 0
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+    #define SIMPLE_SPU_SIMD_SSE2 0
+    #define SIMPLE_SPU_SIMD_NEON 1
+    #include <arm_neon.h>
+#else
+    #define SIMPLE_SPU_SIMD_SSE2 0
+    #define SIMPLE_SPU_SIMD_NEON 0
+#endif
+
+#define SIMPLE_SPU_SIMD (SIMPLE_SPU_SIMD_SSE2 || SIMPLE_SPU_SIMD_NEON)
+
+#if SIMPLE_SPU_SIMD
+
+BEGIN_NAMESPACE(Spu)
+BEGIN_NAMESPACE(Simd)
+
+#if SIMPLE_SPU_FLOAT_SPU
+    static_assert(sizeof(Sample) == sizeof(float));
+    typedef float SampleValue;
+#else
+    static_assert(sizeof(Sample) == sizeof(int16_t));
+    typedef int16_t SampleValue;
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Expands the 28 4-bit samples in a PSX ADPCM block to 16-bit and applies the block's sample shift.
+// The output is the same as '((int16_t)(nibble << 12)) >> sampleShift' for each sample.
+// Note: the output buffer must have room for 32 samples; the last 4 samples written are garbage.
+//------------------------------------------------------------------------------------------------------------------------------------------
+inline void expandAdpcmNibbles(const std::byte adpcmBlock[ADPCM_BLOCK_SIZE], const uint32_t sampleShift, int16_t nibbleSamples[32]) noexcept {
+    #if SIMPLE_SPU_SIMD_SSE2
+        // Get the 14 bytes of sample data and split into low and high nibbles, then interleave so that the low nibble comes first
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(adpcmBlock));
+        const __m128i data = _mm_srli_si128(block, 2);
+        const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+        const __m128i loNibbles = _mm_and_si128(data, nibbleMask);
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi16(data, 4), nibbleMask);
+        const __m128i nibbles1 = _mm_unpacklo_epi8(loNibbles, hiNibbles);
+        const __m128i nibbles2 = _mm_unpackhi_epi8(loNibbles, hiNibbles);
+
+        // Widen to 16-bits with the nibble in the uppermost 4 bits, then do an arithmetic shift to sign extend and scale
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i shift = _mm_cvtsi32_si128((int) sampleShift);
+        __m128i* const pOut = reinterpret_cast<__m128i*>(nibbleSamples);
+        _mm_storeu_si128(pOut + 0, _mm_sra_epi16(_mm_slli_epi16(_mm_unpacklo_epi8(zero, nibbles1), 4), shift));
+        _mm_storeu_si128(pOut + 1, _mm_sra_epi16(_mm_slli_epi16(_mm_unpackhi_epi8(zero, nibbles1), 4), shift));
+        _mm_storeu_si128(pOut + 2, _mm_sra_epi16(_mm_slli_epi16(_mm_unpacklo_epi8(zero, nibbles2), 4), shift));
+        _mm_storeu_si128(pOut + 3, _mm_sra_epi16(_mm_slli_epi16(_mm_unpackhi_epi8(zero, nibbles2), 4), shift));
+    #else
+        // Same approach as SSE2, but NEON can shift right via a negative left shift amount
+        const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(adpcmBlock));
+        const uint8x16_t data = vextq_u8(block, vdupq_n_u8(0), 2);
+        const uint8x16_t loNibbles = vandq_u8(data, vdupq_n_u8(0x0F));
+        const uint8x16_t hiNibbles = vshrq_n_u8(data, 4);
+        const uint8x16x2_t nibbles = vzipq_u8(loNibbles, hiNibbles);
+
+        const int16x8_t shift = vdupq_n_s16((int16_t) -(int32_t) sampleShift);
+        const auto expand = [=](const uint8x8_t nibbles8) noexcept {
+            const int16x8_t samples = vreinterpretq_s16_u16(vshll_n_u8(nibbles8, 8));
+            return vshlq_s16(vshlq_n_s16(samples, 4), shift);
+        };
+
+        vst1q_s16(nibbleSamples + 0,  expand(vget_low_u8(nibbles.val[0])));
+        vst1q_s16(nibbleSamples + 8,  expand(vget_high_u8(nibbles.val[0])));
+        vst1q_s16(nibbleSamples + 16, expand(vget_low_u8(nibbles.val[1])));
+        vst1q_s16(nibbleSamples + 24, expand(vget_high_u8(nibbles.val[1])));
+    #endif
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Converts 28 samples from 16-bit to floating point; the same as calling 'toFloatSample' on each.
+// Note: the input and output buffers must have room for 32 samples.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if SIMPLE_SPU_FLOAT_SPU
+inline void convertAdpcmSamplesToFloat(const int16_t samplesIn[32], float samplesOut[32]) noexcept {
+    for (int32_t i = 0; i < 32; i += 8) {
+        #if SIMPLE_SPU_SIMD_SSE2
+            const __m128i samplesI16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samplesIn + i));
+            const __m128i samplesLoI32 = _mm_srai_epi32(_mm_unpacklo_epi16(samplesI16, samplesI16), 16);
+            const __m128i samplesHiI32 = _mm_srai_epi32(_mm_unpackhi_epi16(samplesI16, samplesI16), 16);
+            const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+            _mm_storeu_ps(samplesOut + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(samplesLoI32), scale));
+            _mm_storeu_ps(samplesOut + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(samplesHiI32), scale));
+        #else
+            const int16x8_t samplesI16 = vld1q_s16(samplesIn + i);
+            const float32x4_t samplesLo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(samplesI16)));
+            const float32x4_t samplesHi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(samplesI16)));
+            vst1q_f32(samplesOut + i + 0, vmulq_n_f32(samplesLo, 1.0f / 32768.0f));
+            vst1q_f32(samplesOut + i + 4, vmulq_n_f32(samplesHi, 1.0f / 32768.0f));
+        #endif
+    }
+}
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decode the 28 samples of a PSX ADPCM block.
+// The adaptive filter is inherently serial (each sample depends on the previous 2) so only the nibble expansion is vectorized,
+// except for filter '0' which has no prediction and can be done entirely with SIMD.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if SIMPLE_SPU_FLOAT_SPU
+inline void decodeAdpcmSamples(
+    const std::byte adpcmBlock[ADPCM_BLOCK_SIZE],
+    const uint32_t sampleShift,
+    const uint32_t adpcmFilter,
+    const float filterCoefPos,
+    const float filterCoefNeg,
+    float prevSample1,
+    float prevSample2,
+    Sample* const pSamplesOut
+) noexcept {
+    alignas(16) int16_t nibbleSamples[32];
+    alignas(16) float floatSamples[32];
+    expandAdpcmNibbles(adpcmBlock, sampleShift, nibbleSamples);
+    convertAdpcmSamplesToFloat(nibbleSamples, floatSamples);
+
+    if (adpcmFilter == 0) {
+        // No prediction: samples need no further processing since they are already within the -1 to +1 range
+        std::memcpy(pSamplesOut, floatSamples, sizeof(float) * ADPCM_BLOCK_NUM_SAMPLES);
+    } else {
+        for (int32_t sampleIdx = 0; sampleIdx < ADPCM_BLOCK_NUM_SAMPLES; sampleIdx++) {
+            float sample = floatSamples[sampleIdx];
+            sample += prevSample1 * filterCoefPos + prevSample2 * filterCoefNeg;
+            sample = std::clamp(sample, -1.0f, 1.0f);
+            pSamplesOut[sampleIdx] = sample;
+            prevSample2 = prevSample1;
+            prevSample1 = sample;
+        }
+    }
+}
+#else
+inline void decodeAdpcmSamples(
+    const std::byte adpcmBlock[ADPCM_BLOCK_SIZE],
+    const uint32_t sampleShift,
+    const uint32_t adpcmFilter,
+    const int32_t filterCoefPos,
+    const int32_t filterCoefNeg,
+    int32_t prevSample1,
+    int32_t prevSample2,
+    Sample* const pSamplesOut
+) noexcept {
+    alignas(16) int16_t nibbleSamples[32];
+    expandAdpcmNibbles(adpcmBlock, sampleShift, nibbleSamples);
+
+    if (adpcmFilter == 0) {
+        // No prediction: the rounding term of '+32 / 64' adds nothing and samples are already within 16-bit range
+        std::memcpy(pSamplesOut, nibbleSamples, sizeof(int16_t) * ADPCM_BLOCK_NUM_SAMPLES);
+    } else {
+        for (int32_t sampleIdx = 0; sampleIdx < ADPCM_BLOCK_NUM_SAMPLES; sampleIdx++) {
+            int32_t sample = nibbleSamples[sampleIdx];
+            sample += (prevSample1 * filterCoefPos + prevSample2 * filterCoefNeg + 32) / 64;
+            sample = std::clamp<int32_t>(sample, INT16_MIN, INT16_MAX);
+            pSamplesOut[sampleIdx] = (int16_t) sample;
+            prevSample2 = prevSample1;
+            prevSample1 = sample;
+        }
+    }
+}
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Do 4-tap gaussian interpolation of the given 4 samples (oldest first) using the given 4 filter taps.
+// The result is the same as the scalar code: each sample is multiplied by it's tap and then the products are summed in order.
+//------------------------------------------------------------------------------------------------------------------------------------------
+inline Sample interpolateSamples(const Sample samples[4], const SampleValue taps[4]) noexcept {
+    const SampleValue* const pSamples = reinterpret_cast<const SampleValue*>(samples);
+
+    #if SIMPLE_SPU_FLOAT_SPU
+        #if SIMPLE_SPU_SIMD_SSE2
+            const __m128 products = _mm_mul_ps(_mm_loadu_ps(pSamples), _mm_loadu_ps(taps));
+            __m128 sum = _mm_add_ss(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+            sum = _mm_add_ss(sum, _mm_movehl_ps(products, products));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(3, 3, 3, 3)));
+            return _mm_cvtss_f32(sum);
+        #else
+            const float32x4_t products = vmulq_f32(vld1q_f32(pSamples), vld1q_f32(taps));
+            float sum = vgetq_lane_f32(products, 0) + vgetq_lane_f32(products, 1);
+            sum += vgetq_lane_f32(products, 2);
+            sum += vgetq_lane_f32(products, 3);
+            return sum;
+        #endif
+    #else
+        // Each product is shifted down individually (rather than the sum) to match the scalar code
+        #if SIMPLE_SPU_SIMD_SSE2
+            const __m128i samples16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSamples));
+            const __m128i taps16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(taps));
+            const __m128i productsLo = _mm_mullo_epi16(samples16, taps16);
+            const __m128i productsHi = _mm_mulhi_epi16(samples16, taps16);
+            __m128i products = _mm_srai_epi32(_mm_unpacklo_epi16(productsLo, productsHi), 15);
+            products = _mm_add_epi32(products, _mm_shuffle_epi32(products, _MM_SHUFFLE(1, 0, 3, 2)));
+            products = _mm_add_epi32(products, _mm_shuffle_epi32(products, _MM_SHUFFLE(2, 3, 0, 1)));
+            return (int16_t) _mm_cvtsi128_si32(products);
+        #else
+            const int32x4_t products = vshrq_n_s32(vmull_s16(vld1_s16(pSamples), vld1_s16(taps)), 15);
+            int32x2_t sum = vadd_s32(vget_low_s32(products), vget_high_s32(products));
+            sum = vpadd_s32(sum, sum);
+            return (int16_t) vget_lane_s32(sum, 0);
+        #endif
+    #endif
+}
+
+END_NAMESPACE(Simd)
+END_NAMESPACE(Spu)
+
+#endif  // #if SIMPLE_SPU_SIMD
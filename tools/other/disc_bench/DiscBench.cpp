@@ -0,0 +1,246 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// DiscBench:
+//      Benchmark for reading files from a game disc image via the game's 'DiscReader'.
+//      Reads a file (PSXDOOM.WAD by default) from the data track of the given disc image repeatedly and reports the throughput in MB/s.
+//      The file is read in 2,048 byte (single sector) chunks and also all at once, using both regular file I/O and memory mapping.
+//      If the data track has raw 2,352 byte sectors then the same tests are also done against a temporary 2,048 byte sector ISO copy of
+//      the track, for comparison. The data read in every test is checked to make sure it is identical.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "PsyDoom/DiscInfo.h"
+#include "PsyDoom/DiscReader.h"
+#include "PsyDoom/IsoFileSys.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+static constexpr uint32_t   DEFAULT_NUM_ITERATIONS  = 20;                           // Default number of times to read the file for each test
+static constexpr const char DEFAULT_FILE_PATH[]     = "PSXDOOM/ABIN/PSXDOOM.WAD";   // Default file to read from the disc
+static constexpr int32_t    SECTOR_PAYLOAD_SIZE     = 2048;                         // Size of a CD-ROM data sector's payload
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the specified file from the data track of the disc, either one sector at a time or all at once.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readDiscFile(
+    DiscReader& discReader,
+    const IsoFileSysEntry& fileEntry,
+    std::byte* const pDstBytes,
+    const bool bSectorAtATime
+) noexcept {
+    if (!discReader.setTrackNum(1))
+        return false;
+
+    if (!discReader.trackSeekAbs((int32_t) fileEntry.startLba * SECTOR_PAYLOAD_SIZE))
+        return false;
+
+    const int32_t fileSize = (int32_t) fileEntry.size;
+
+    if (!bSectorAtATime)
+        return discReader.read(pDstBytes, fileSize);
+
+    for (int32_t offset = 0; offset < fileSize; offset += SECTOR_PAYLOAD_SIZE) {
+        if (!discReader.read(pDstBytes + offset, std::min(fileSize - offset, SECTOR_PAYLOAD_SIZE)))
+            return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Times reading the specified file from the disc for the given number of iterations and prints the throughput.
+// Also checks that the data read matches the given expected data, if that is specified.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool runTest(
+    const char* const testName,
+    const DiscInfo& discInfo,
+    const IsoFileSysEntry& fileEntry,
+    const bool bUseMemoryMapping,
+    const bool bSectorAtATime,
+    const uint32_t numIterations,
+    std::byte* const pReadBytes,
+    const std::byte* const pExpectedBytes
+) noexcept {
+    DiscReader::setUseMemoryMapping(bUseMemoryMapping);
+    double totalTime = 0;
+    double bestTime = 0;
+
+    for (uint32_t iterIdx = 0; iterIdx < numIterations; ++iterIdx) {
+        // Note: use a new disc reader each time so that opening the file (and mapping it) is included in the timings
+        std::memset(pReadBytes, 0, fileEntry.size);
+        const auto startTime = std::chrono::steady_clock::now();
+        bool bReadOk;
+
+        {
+            DiscReader discReader(discInfo);
+            bReadOk = readDiscFile(discReader, fileEntry, pReadBytes, bSectorAtATime);
+        }
+
+        const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        if (!bReadOk) {
+            std::printf("  %-40s read failed!\n", testName);
+            return false;
+        }
+
+        if (pExpectedBytes && (std::memcmp(pReadBytes, pExpectedBytes, fileEntry.size) != 0)) {
+            std::printf("  %-40s data read does not match other tests!\n", testName);
+            return false;
+        }
+
+        totalTime += time;
+        bestTime = (iterIdx == 0) ? time : std::min(bestTime, time);
+    }
+
+    const double megabytes = (double) fileEntry.size / (1024.0 * 1024.0);
+    const double avgTime = totalTime / numIterations;
+    std::printf("  %-40s %9.1f MB/s average %9.1f MB/s best\n", testName, megabytes / avgTime, megabytes / bestTime);
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Runs all the read tests for the specified disc image.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool runAllTests(
+    const char* const discName,
+    const DiscInfo& discInfo,
+    const IsoFileSysEntry& fileEntry,
+    const uint32_t numIterations,
+    std::byte* const pReadBytes,
+    const std::byte* const pExpectedBytes
+) noexcept {
+    const DiscTrack& track = discInfo.tracks[0];
+    std::printf("%s (%d byte sectors, %u iterations):\n", discName, track.blockSize, numIterations);
+
+    return (
+        runTest("File I/O, one sector per read", discInfo, fileEntry, false, true, numIterations, pReadBytes, pExpectedBytes) &&
+        runTest("File I/O, whole file in one read", discInfo, fileEntry, false, false, numIterations, pReadBytes, pExpectedBytes) &&
+        runTest("Memory mapped, one sector per read", discInfo, fileEntry, true, true, numIterations, pReadBytes, pExpectedBytes) &&
+        runTest("Memory mapped, whole file in one read", discInfo, fileEntry, true, false, numIterations, pReadBytes, pExpectedBytes)
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes the payload of every sector in the data track of the given disc to a 2,048 byte sector ISO file.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool writeDataTrackIso(const DiscInfo& discInfo, const char* const isoFilePath) noexcept {
+    DiscReader::setUseMemoryMapping(false);
+    DiscReader discReader(discInfo);
+
+    if (!discReader.setTrackNum(1))
+        return false;
+
+    const int32_t trackSize = discReader.getOpenTrack()->trackPayloadSize;
+    std::unique_ptr<std::byte[]> trackBytes(new std::byte[trackSize]);
+
+    if (!discReader.read(trackBytes.get(), trackSize))
+        return false;
+
+    std::FILE* const pFile = std::fopen(isoFilePath, "wb");
+
+    if (!pFile)
+        return false;
+
+    const bool bWriteOk = (std::fwrite(trackBytes.get(), (size_t) trackSize, 1, pFile) == 1);
+    return ((std::fclose(pFile) == 0) && bWriteOk);
+}
+
+int main(int argc, const char* const argv[]) noexcept {
+    // Parse the command line
+    uint32_t numIterations = DEFAULT_NUM_ITERATIONS;
+    const char* discFilePath = DEFAULT_FILE_PATH;
+    const char* cueFilePath = nullptr;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+        if ((std::strcmp(argv[argIdx], "-iterations") == 0) && (argIdx + 1 < argc)) {
+            numIterations = (uint32_t) std::max(std::atoi(argv[argIdx + 1]), 1);
+            ++argIdx;
+        }
+        else if ((std::strcmp(argv[argIdx], "-file") == 0) && (argIdx + 1 < argc)) {
+            discFilePath = argv[argIdx + 1];
+            ++argIdx;
+        }
+        else {
+            cueFilePath = argv[argIdx];
+        }
+    }
+
+    if (!cueFilePath) {
+        std::printf("Usage: DiscBench [-iterations <NUM ITERATIONS>] [-file <PATH ON DISC>] <CUE FILE>\n");
+        std::printf("Reads '%s' from the disc by default.\n", DEFAULT_FILE_PATH);
+        return 1;
+    }
+
+    // Read the disc info and find the file to read
+    DiscInfo discInfo;
+    std::string errorMsg;
+
+    if (!discInfo.parseFromCueFile(cueFilePath, errorMsg)) {
+        std::printf("Failed to parse the .cue file '%s'! Error message: %s\n", cueFilePath, errorMsg.c_str());
+        return 1;
+    }
+
+    IsoFileSys isoFileSys;
+
+    {
+        DiscReader discReader(discInfo);
+
+        if (!isoFileSys.build(discReader)) {
+            std::printf("Failed to read the ISO 9660 filesystem from the disc!\n");
+            return 1;
+        }
+    }
+
+    const IsoFileSysEntry* const pFileEntry = isoFileSys.getEntry(discFilePath);
+
+    if ((!pFileEntry) || pFileEntry->bIsDirectory) {
+        std::printf("File '%s' was not found on the disc!\n", discFilePath);
+        return 1;
+    }
+
+    std::printf("Reading '%s' (%u bytes)\n", discFilePath, pFileEntry->size);
+
+    // Read the file once to get the expected data and to warm up the OS file cache
+    std::unique_ptr<std::byte[]> expectedBytes(new std::byte[pFileEntry->size]);
+    std::unique_ptr<std::byte[]> readBytes(new std::byte[pFileEntry->size]);
+
+    if (!runTest("Warm up", discInfo, *pFileEntry, false, false, 1, expectedBytes.get(), nullptr))
+        return 1;
+
+    // Run the tests for the original disc image
+    if (!runAllTests(cueFilePath, discInfo, *pFileEntry, numIterations, readBytes.get(), expectedBytes.get()))
+        return 1;
+
+    // If the disc image has sector framing then make a 2,048 byte sector ISO from the data track and run the tests for that too
+    if (discInfo.tracks[0].blockSize == SECTOR_PAYLOAD_SIZE)
+        return 0;
+
+    std::error_code fsError;
+    const std::string isoFilePath = (std::filesystem::temp_directory_path(fsError) / "DiscBench_DataTrack.iso").string();
+
+    if (fsError || (!writeDataTrackIso(discInfo, isoFilePath.c_str()))) {
+        std::printf("Failed to write a temporary ISO file for the data track!\n");
+        return 1;
+    }
+
+    const std::string isoCueStr = "FILE \"" + isoFilePath + "\" BINARY\nTRACK 01 MODE1/2048\nINDEX 01 00:00:00\n";
+    DiscInfo isoDiscInfo;
+    bool bIsoTestsOk = false;
+
+    if (isoDiscInfo.parseFromCueStr(isoCueStr.c_str(), "", errorMsg)) {
+        bIsoTestsOk = runAllTests("Data track as ISO", isoDiscInfo, *pFileEntry, numIterations, readBytes.get(), expectedBytes.get());
+    } else {
+        std::printf("Failed to parse the .cue for the temporary ISO file! Error message: %s\n", errorMsg.c_str());
+    }
+
+    std::filesystem::remove(isoFilePath, fsError);
+    return (bIsoTestsOk) ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// DiscCompress:
+//      Converts a game disc image in .cue/.bin format into a compressed disc image ('.pdz' file) which PsyDoom can use instead.
+//      The compressed image holds the data for every track on the disc, including raw sector framing, so nothing used by PsyDoom is lost.
+//      After conversion the compressed image is read back and checked against the original disc, unless '-noverify' is specified.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "FileUtils.h"
+#include "PsyDoom/CompressedDiscImage.h"
+#include "PsyDoom/DiscInfo.h"
+#include "PsyDoom/DiscReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+static constexpr int32_t VERIFY_CHUNK_SIZE = 2352 * 64;     // How much data to compare at a time when verifying
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Checks that every track in the compressed disc image matches the original disc.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool verifyImage(const DiscInfo& srcDisc, const DiscInfo& imageDisc) noexcept {
+    if (srcDisc.tracks.size() != imageDisc.tracks.size()) {
+        std::printf("Verify failed: the compressed disc image has a different number of tracks!\n");
+        return false;
+    }
+
+    DiscReader srcReader(srcDisc);
+    DiscReader imageReader(imageDisc);
+    std::unique_ptr<std::byte[]> srcBytes(new std::byte[VERIFY_CHUNK_SIZE]);
+    std::unique_ptr<std::byte[]> imageBytes(new std::byte[VERIFY_CHUNK_SIZE]);
+
+    for (size_t trackIdx = 0; trackIdx < srcDisc.tracks.size(); ++trackIdx) {
+        const DiscTrack& srcTrack = srcDisc.tracks[trackIdx];
+        const DiscTrack& imageTrack = imageDisc.tracks[trackIdx];
+
+        const bool bSameTrackInfo = (
+            (srcTrack.trackNum == imageTrack.trackNum) &&
+            (srcTrack.blockSize == imageTrack.blockSize) &&
+            (srcTrack.blockCount == imageTrack.blockCount) &&
+            (srcTrack.blockPayloadOffset == imageTrack.blockPayloadOffset) &&
+            (srcTrack.blockPayloadSize == imageTrack.blockPayloadSize) &&
+            (srcTrack.bIsData == imageTrack.bIsData)
+        );
+
+        if (!bSameTrackInfo) {
+            std::printf("Verify failed: the details for track %d are different in the compressed disc image!\n", srcTrack.trackNum);
+            return false;
+        }
+
+        if ((!srcReader.setTrackNum(srcTrack.trackNum)) || (!imageReader.setTrackNum(imageTrack.trackNum))) {
+            std::printf("Verify failed: couldn't open track %d for reading!\n", srcTrack.trackNum);
+            return false;
+        }
+
+        for (int32_t offset = 0; offset < srcTrack.trackPhysicalSize; offset += VERIFY_CHUNK_SIZE) {
+            const int32_t readSize = std::min(srcTrack.trackPhysicalSize - offset, VERIFY_CHUNK_SIZE);
+
+            const bool bDataMatches = (
+                srcReader.readRaw(offset, srcBytes.get(), readSize) &&
+                imageReader.readRaw(offset, imageBytes.get(), readSize) &&
+                (std::memcmp(srcBytes.get(), imageBytes.get(), (size_t) readSize) == 0)
+            );
+
+            if (!bDataMatches) {
+                std::printf("Verify failed: the data for track %d is different in the compressed disc image!\n", srcTrack.trackNum);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, const char* const argv[]) noexcept {
+    // Parse the command line
+    int32_t groupSectors = CompressedDiscImage::DEFAULT_GROUP_SECTORS;
+    bool bVerify = true;
+    const char* cueFilePath = nullptr;
+    const char* outputFilePath = nullptr;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+        if ((std::strcmp(argv[argIdx], "-groupsectors") == 0) && (argIdx + 1 < argc)) {
+            groupSectors = std::max(std::atoi(argv[argIdx + 1]), 1);
+            ++argIdx;
+        }
+        else if (std::strcmp(argv[argIdx], "-noverify") == 0) {
+            bVerify = false;
+        }
+        else if (!cueFilePath) {
+            cueFilePath = argv[argIdx];
+        }
+        else {
+            outputFilePath = argv[argIdx];
+        }
+    }
+
+    if ((!cueFilePath) || (!outputFilePath)) {
+        std::printf("Usage: DiscCompress [-groupsectors <NUM SECTORS>] [-noverify] <INPUT CUE FILE> <OUTPUT PDZ FILE>\n");
+        std::printf("Use '-groupsectors' to set how many raw sectors are compressed together (default %d).\n", CompressedDiscImage::DEFAULT_GROUP_SECTORS);
+        std::printf("Larger groups compress better but make random access reads slower.\n");
+        return 1;
+    }
+
+    // Read the source disc and figure out how much data it has
+    DiscInfo srcDisc;
+    std::string errorMsg;
+
+    if (!srcDisc.parseFromCueFile(cueFilePath, errorMsg)) {
+        std::printf("Failed to parse the .cue file '%s'! Error message: %s\n", cueFilePath, errorMsg.c_str());
+        return 1;
+    }
+
+    int64_t srcSize = 0;
+    int64_t trackDataSize = 0;
+
+    for (size_t trackIdx = 0; trackIdx < srcDisc.tracks.size(); ++trackIdx) {
+        const DiscTrack& track = srcDisc.tracks[trackIdx];
+        trackDataSize += track.trackPhysicalSize;
+
+        // Only count the size of each source file once
+        const bool bFirstTrackInFile = std::none_of(
+            srcDisc.tracks.begin(),
+            srcDisc.tracks.begin() + trackIdx,
+            [&](const DiscTrack& otherTrack) noexcept { return (otherTrack.sourceFilePath == track.sourceFilePath); }
+        );
+
+        if (bFirstTrackInFile) {
+            srcSize += track.sourceFileTotalSize;
+        }
+    }
+
+    std::printf("Compressing '%s': %zu tracks, %lld bytes of track data\n", cueFilePath, srcDisc.tracks.size(), (long long) trackDataSize);
+
+    // Create the compressed image
+    const auto startTime = std::chrono::steady_clock::now();
+
+    if (!CompressedDiscImage::create(srcDisc, outputFilePath, groupSectors, errorMsg)) {
+        std::printf("Failed to create the compressed disc image! Error message: %s\n", errorMsg.c_str());
+        return 1;
+    }
+
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const int64_t outputSize = FileUtils::getFileSize(outputFilePath);
+
+    std::printf("Wrote '%s' in %.1f seconds\n", outputFilePath, time);
+    std::printf("  Source files size:   %lld bytes\n", (long long) srcSize);
+    std::printf("  Compressed size:     %lld bytes (%.1f%% of the source files)\n", (long long) outputSize, (100.0 * outputSize) / std::max<int64_t>(srcSize, 1));
+
+    // Verify the image if required
+    if (!bVerify)
+        return 0;
+
+    DiscInfo imageDisc;
+
+    if (!imageDisc.parseFromCueFile(outputFilePath, errorMsg)) {
+        std::printf("Verify failed: couldn't read the compressed disc image! Error message: %s\n", errorMsg.c_str());
+        return 1;
+    }
+
+    if (!verifyImage(srcDisc, imageDisc))
+        return 1;
+
+    std::printf("Verified the compressed disc image against the original disc\n");
+    return 0;
+}
@@ -0,0 +1,613 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// GpuBench:
+//      Microbenchmark and golden output test for the 'simple_gpu' PlayStation GPU emulation.
+//      Draws a synthetic but representative workload (frames made from wall columns, floor rows, sprites, rectangles and lines using
+//      all the draw modes and blend modes) using the immediate drawing mode and the deferred (tiled and multithreaded) drawing mode
+//      with various thread counts. Verifies that VRAM after every frame is byte-for-byte identical to the immediate mode output (the
+//      golden output, compared via a hash of VRAM after each frame and the full contents of VRAM at the end) and reports the
+//      throughput of each mode in frames per second.
+//
+//      Also captures a stream of wall columns and floor rows (the bulk of the pixels in a classic renderer frame) and replays it using
+//      the scalar and SIMD span shading code, reporting the throughput of each in megapixels per second and checking the output matches.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "Gpu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static constexpr uint16_t VRAM_W                = 1024;     // Width of VRAM for the test cores
+static constexpr uint16_t VRAM_H                = 512;      // Height of VRAM for the test cores
+static constexpr uint16_t FB_W                  = 256;      // Width of the framebuffer being drawn to
+static constexpr uint16_t FB_H                  = 240;      // Height of the framebuffer being drawn to
+static constexpr uint16_t TEX_AREA_X            = 512;      // Where textures are placed in VRAM (x)
+static constexpr uint16_t TEX_AREA_Y            = 0;        // Where textures are placed in VRAM (y)
+static constexpr uint16_t CLUT_AREA_Y           = 480;      // Where CLUTs are placed in VRAM (y)
+static constexpr uint32_t NUM_CLUTS             = 16;       // Number of different 8bpp CLUTs
+static constexpr uint32_t DEFAULT_NUM_FRAMES    = 300;      // Default number of frames to draw
+static constexpr uint32_t NUM_CAPTURED_SPANS    = 200000;   // Number of wall columns and floor rows in the captured span stream
+static constexpr uint32_t NUM_SPAN_REPLAYS      = 10;       // How many times to replay the captured span stream when benchmarking
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Simple deterministic random number generator, so that every test core gets exactly the same input
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Rng {
+    uint32_t state;
+
+    uint32_t next() noexcept {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    int32_t range(const int32_t min, const int32_t max) noexcept {
+        return min + (int32_t)(next() % (uint32_t)(max - min + 1));
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Computes a 64-bit FNV-1a hash of all of VRAM
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t hashVram(const Gpu::Core& core) noexcept {
+    const uint8_t* const pBytes = reinterpret_cast<const uint8_t*>(core.pRam);
+    const size_t numBytes = (size_t) VRAM_W * VRAM_H * sizeof(uint16_t);
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < numBytes; ++i) {
+        hash ^= pBytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Fills the texture and CLUT areas of VRAM with random data
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeTestTextures(Gpu::Core& core) noexcept {
+    Rng rng = { 777 };
+
+    for (uint16_t y = TEX_AREA_Y; y < TEX_AREA_Y + 256; ++y) {
+        for (uint16_t x = TEX_AREA_X; x < VRAM_W; ++x) {
+            Gpu::vramWriteU16(core, x, y, (uint16_t) rng.next());
+        }
+    }
+
+    // Note: make CLUT entry '0' transparent so that masking gets tested
+    for (uint16_t clutIdx = 0; clutIdx < NUM_CLUTS; ++clutIdx) {
+        for (uint16_t i = 0; i < 256; ++i) {
+            const uint16_t color = (i == 0) ? 0 : (uint16_t) rng.next();
+            Gpu::vramWriteU16(core, i, CLUT_AREA_Y + clutIdx, color);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Set random texturing and blending state, using a 64x64 or 128x128 texture window in the texture area
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void setRandomTexState(Gpu::Core& core, Rng& rng, const Gpu::TexFmt texFmt) noexcept {
+    const uint16_t texSize = (rng.next() & 1) ? 64 : 128;
+    const uint16_t texelsPerPixel = (texFmt == Gpu::TexFmt::Bpp4) ? 4 : ((texFmt == Gpu::TexFmt::Bpp8) ? 2 : 1);
+
+    core.texFmt = texFmt;
+    core.texPageX = TEX_AREA_X;
+    core.texPageY = TEX_AREA_Y;
+    core.texPageXMask = 0x3FF;
+    core.texPageYMask = 0x1FF;
+    core.texWinX = (uint16_t)(rng.range(0, (256 - texSize / texelsPerPixel) / 2) * 2 * texelsPerPixel);
+    core.texWinY = (uint16_t)(rng.range(0, (256 - texSize) / 4) * 4);
+    core.texWinXMask = texSize - 1;
+    core.texWinYMask = texSize - 1;
+    core.clutX = 0;
+    core.clutY = (uint16_t)(CLUT_AREA_Y + rng.range(0, NUM_CLUTS - 1));
+    core.blendMode = (Gpu::BlendMode) rng.range(0, 3);
+    core.bDisableMasking = ((rng.next() % 8) == 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Helpers to draw using a randomly chosen draw mode
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class PrimT>
+static void drawWithRandomMode(Gpu::Core& core, Rng& rng, const PrimT& prim) noexcept {
+    switch (rng.next() % 4) {
+        case 0:     Gpu::draw<Gpu::DrawMode::Colored>(core, prim);              break;
+        case 1:     Gpu::draw<Gpu::DrawMode::ColoredBlended>(core, prim);       break;
+        case 2:     Gpu::draw<Gpu::DrawMode::Textured>(core, prim);             break;
+        default:    Gpu::draw<Gpu::DrawMode::TexturedBlended>(core, prim);      break;
+    }
+}
+
+static void drawWithRandomTexturedMode(Gpu::Core& core, Rng& rng, const Gpu::DrawWallCol& col) noexcept {
+    if ((rng.next() % 4) == 0) {
+        Gpu::draw<Gpu::DrawMode::TexturedBlended>(core, col);
+    } else {
+        Gpu::draw<Gpu::DrawMode::Textured>(core, col);
+    }
+}
+
+static Gpu::Color24F randomColor(Rng& rng) noexcept {
+    return Gpu::Color24F((uint8_t) rng.range(0, 255), (uint8_t) rng.range(0, 255), (uint8_t) rng.range(0, 255));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a single test frame to the framebuffer, which is similar in makeup to a frame drawn by the classic renderer
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void drawTestFrame(Gpu::Core& core, const uint32_t frameIdx) noexcept {
+    Rng rng = { 1000 + frameIdx };
+
+    // Alternate between two framebuffers like the game does
+    const uint16_t fbX = (frameIdx & 1) ? FB_W : 0;
+    core.drawOffsetX = (int16_t) fbX;
+    core.drawOffsetY = 0;
+    core.drawAreaLx = fbX;
+    core.drawAreaRx = fbX + FB_W - 1;
+    core.drawAreaTy = 0;
+    core.drawAreaBy = FB_H - 1;
+    Gpu::clearRect(core, Gpu::Color16(0), fbX, 0, FB_W, FB_H);
+
+    // Walls: a few columns for every screen column
+    for (int32_t x = 0; x < FB_W; ++x) {
+        for (int32_t colIdx = 0; colIdx < 3; ++colIdx) {
+            setRandomTexState(core, rng, Gpu::TexFmt::Bpp8);
+            const int16_t y1 = (int16_t) rng.range(-40, FB_H / 2);
+            const int16_t y2 = (int16_t) rng.range(FB_H / 2, FB_H + 40);
+
+            if ((rng.next() % 3) == 0) {
+                Gpu::DrawWallColGouraud col = {};
+                col.x = (int16_t) x;
+                col.u = (int16_t) rng.range(0, 255);
+                col.y1 = y1;
+                col.y2 = y2;
+                col.v1 = (int16_t) rng.range(0, 127);
+                col.v2 = (int16_t) rng.range(0, 255);
+                col.color1 = randomColor(rng);
+                col.color2 = randomColor(rng);
+                drawWithRandomMode(core, rng, col);
+            } else {
+                Gpu::DrawWallCol col = {};
+                col.x = (int16_t) x;
+                col.u = (int16_t) rng.range(0, 255);
+                col.y1 = y1;
+                col.y2 = y2;
+                col.v1 = (int16_t) rng.range(0, 127);
+                col.v2 = (int16_t) rng.range(0, 255);
+                col.color = randomColor(rng);
+                drawWithRandomTexturedMode(core, rng, col);
+            }
+        }
+    }
+
+    // Floors and ceilings: a row for every screen row
+    for (int32_t y = 0; y < FB_H; ++y) {
+        setRandomTexState(core, rng, Gpu::TexFmt::Bpp8);
+
+        Gpu::DrawFloorRow row = {};
+        row.y = (int16_t) y;
+        row.x1 = (int16_t) rng.range(-20, FB_W / 2);
+        row.x2 = (int16_t) rng.range(FB_W / 2, FB_W + 20);
+        row.u1 = (int16_t) rng.range(0, 1023);
+        row.v1 = (int16_t) rng.range(0, 1023);
+        row.u2 = (int16_t) rng.range(0, 1023);
+        row.v2 = (int16_t) rng.range(0, 1023);
+        row.color = randomColor(rng);
+        drawWithRandomMode(core, rng, row);
+    }
+
+    // Sprites and other triangles, in all texture formats
+    for (int32_t triIdx = 0; triIdx < 64; ++triIdx) {
+        setRandomTexState(core, rng, (Gpu::TexFmt) rng.range(0, 2));
+        const int16_t x = (int16_t) rng.range(-32, FB_W);
+        const int16_t y = (int16_t) rng.range(-32, FB_H);
+        const int16_t w = (int16_t) rng.range(1, 96);
+        const int16_t h = (int16_t) rng.range(1, 96);
+
+        if ((rng.next() % 2) == 0) {
+            Gpu::DrawTriangle tri = {};
+            tri.x1 = x;                     tri.y1 = y;
+            tri.x2 = x + w;                 tri.y2 = y + (int16_t) rng.range(0, h);
+            tri.x3 = x + (int16_t) rng.range(0, w);    tri.y3 = y + h;
+            tri.u1 = (int16_t) rng.range(0, 63);    tri.v1 = (int16_t) rng.range(0, 63);
+            tri.u2 = (int16_t) rng.range(0, 63);    tri.v2 = (int16_t) rng.range(0, 63);
+            tri.u3 = (int16_t) rng.range(0, 63);    tri.v3 = (int16_t) rng.range(0, 63);
+            tri.color = randomColor(rng);
+            drawWithRandomMode(core, rng, tri);
+        } else {
+            Gpu::DrawTriangleGouraud tri = {};
+            tri.x1 = x;                     tri.y1 = y + (int16_t) rng.range(0, h);
+            tri.x2 = x + w;                 tri.y2 = y;
+            tri.x3 = x + (int16_t) rng.range(0, w);    tri.y3 = y + h;
+            tri.u1 = (int16_t) rng.range(0, 63);    tri.v1 = (int16_t) rng.range(0, 63);
+            tri.u2 = (int16_t) rng.range(0, 63);    tri.v2 = (int16_t) rng.range(0, 63);
+            tri.u3 = (int16_t) rng.range(0, 63);    tri.v3 = (int16_t) rng.range(0, 63);
+            tri.color1 = randomColor(rng);
+            tri.color2 = randomColor(rng);
+            tri.color3 = randomColor(rng);
+            drawWithRandomMode(core, rng, tri);
+        }
+    }
+
+    // UI elements and a few lines (like the automap)
+    for (int32_t rectIdx = 0; rectIdx < 16; ++rectIdx) {
+        setRandomTexState(core, rng, (Gpu::TexFmt) rng.range(0, 2));
+
+        Gpu::DrawRect rect = {};
+        rect.x = (int16_t) rng.range(-16, FB_W);
+        rect.y = (int16_t) rng.range(-16, FB_H);
+        rect.w = (uint16_t) rng.range(1, 64);
+        rect.h = (uint16_t) rng.range(1, 64);
+        rect.u = (uint16_t) rng.range(0, 63);
+        rect.v = (uint16_t) rng.range(0, 63);
+        rect.color = randomColor(rng);
+        drawWithRandomMode(core, rng, rect);
+    }
+
+    for (int32_t lineIdx = 0; lineIdx < 32; ++lineIdx) {
+        core.blendMode = (Gpu::BlendMode) rng.range(0, 3);
+
+        Gpu::DrawLine line = {};
+        line.x1 = (int16_t) rng.range(-16, FB_W + 16);
+        line.y1 = (int16_t) rng.range(-16, FB_H + 16);
+        line.x2 = (int16_t) rng.range(-16, FB_W + 16);
+        line.y2 = (int16_t) rng.range(-16, FB_H + 16);
+        line.color = randomColor(rng);
+
+        if (rng.next() & 1) {
+            Gpu::draw<Gpu::DrawMode::ColoredBlended>(core, line);
+        } else {
+            Gpu::draw<Gpu::DrawMode::Colored>(core, line);
+        }
+    }
+
+    // Finally do some drawing which samples from VRAM that is being drawn to, to test the dependency tracking used by the deferred mode:
+    //  (1) Copy part of the previous frame into this one with a textured rectangle.
+    //  (2) Then draw over the area of the previous frame that was copied, which must happen after the copy.
+    //  (3) Then copy part of this frame over itself, which depends on the order pixels are drawn in.
+    core.texFmt = Gpu::TexFmt::Bpp16;
+    core.texPageX = FB_W - fbX;
+    core.texPageY = 0;
+    core.texPageXMask = 0xFF;
+    core.texPageYMask = 0xFF;
+    core.texWinX = 0;
+    core.texWinY = 0;
+    core.texWinXMask = 0x3F;
+    core.texWinYMask = 0x3F;
+    core.bDisableMasking = false;
+
+    Gpu::DrawRect rect = {};
+    rect.x = 8;
+    rect.y = 8;
+    rect.w = 48;
+    rect.h = 32;
+    rect.color = Gpu::Color24F(128, 128, 128);
+    Gpu::draw<Gpu::DrawMode::Textured>(core, rect);
+
+    core.drawOffsetX = (int16_t)(FB_W - fbX);
+    core.drawAreaLx = FB_W - fbX;
+    core.drawAreaRx = core.drawAreaLx + FB_W - 1;
+    rect.color = randomColor(rng);
+    Gpu::draw<Gpu::DrawMode::Colored>(core, rect);
+
+    core.drawOffsetX = (int16_t) fbX;
+    core.drawAreaLx = fbX;
+    core.drawAreaRx = fbX + FB_W - 1;
+    core.texPageX = fbX;
+    core.texWinXMask = 0xFF;
+    core.texWinYMask = 0xFF;
+    rect.x = 16;
+    rect.y = 100;
+    rect.w = 200;
+    rect.h = 64;
+    rect.color = Gpu::Color24F(128, 128, 128);
+    Gpu::draw<Gpu::DrawMode::TexturedBlended>(core, rect);
+
+    // Done with the frame: make sure VRAM is up to date for display
+    Gpu::flush(core);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A captured wall column or floor row, along with the draw mode and GPU state it was drawn with
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct CapturedSpan {
+    enum class Type : uint8_t {
+        FloorRow,
+        WallCol,
+        WallColGouraud,
+    };
+
+    Type                        type;
+    Gpu::DrawMode               drawMode;
+    Gpu::BlendMode              blendMode;
+    bool                        bDisableMasking;
+    uint16_t                    texWinX;
+    uint16_t                    texWinY;
+    uint16_t                    texWinXMask;
+    uint16_t                    texWinYMask;
+    uint16_t                    clutY;
+    Gpu::DrawFloorRow           row;
+    Gpu::DrawWallCol            col;
+    Gpu::DrawWallColGouraud     gouraudCol;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the number of pixels covered by a span on one axis, within the framebuffer; the last pixel is not drawn
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t getNumSpanPixels(const int32_t p1, const int32_t p2, const int32_t fbSize) noexcept {
+    const int32_t lo = std::max(std::min(p1, p2), 0);
+    const int32_t hi = std::min(std::max(p1, p2) - 1, fbSize - 1);
+    return (uint32_t) std::max(hi - lo + 1, 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Captures a stream of wall columns and floor rows with random textures, colors and draw modes.
+// Returns the total number of pixels drawn by the stream.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t captureSpans(Gpu::Core& core, std::vector<CapturedSpan>& spans) noexcept {
+    Rng rng = { 4242 };
+    uint64_t numPixels = 0;
+    spans.clear();
+    spans.reserve(NUM_CAPTURED_SPANS);
+
+    for (uint32_t spanIdx = 0; spanIdx < NUM_CAPTURED_SPANS; ++spanIdx) {
+        setRandomTexState(core, rng, Gpu::TexFmt::Bpp8);
+
+        CapturedSpan span = {};
+        span.blendMode = core.blendMode;
+        span.bDisableMasking = core.bDisableMasking;
+        span.texWinX = core.texWinX;
+        span.texWinY = core.texWinY;
+        span.texWinXMask = core.texWinXMask;
+        span.texWinYMask = core.texWinYMask;
+        span.clutY = core.clutY;
+
+        // Mostly textured draw modes, like the classic renderer
+        const uint32_t modeRand = rng.next() % 8;
+        span.drawMode = (modeRand < 5) ? Gpu::DrawMode::Textured : ((modeRand < 7) ? Gpu::DrawMode::TexturedBlended : (Gpu::DrawMode)(modeRand % 2));
+
+        switch (rng.next() % 3) {
+            case 0: {
+                span.type = CapturedSpan::Type::FloorRow;
+                span.row.y = (int16_t) rng.range(0, FB_H - 1);
+                span.row.x1 = (int16_t) rng.range(-20, FB_W / 2);
+                span.row.x2 = (int16_t) rng.range(FB_W / 2, FB_W + 20);
+                span.row.u1 = (int16_t) rng.range(0, 1023);
+                span.row.v1 = (int16_t) rng.range(0, 1023);
+                span.row.u2 = (int16_t) rng.range(0, 1023);
+                span.row.v2 = (int16_t) rng.range(0, 1023);
+                span.row.color = randomColor(rng);
+                numPixels += getNumSpanPixels(span.row.x1, span.row.x2, FB_W);
+            }   break;
+
+            case 1: {
+                span.type = CapturedSpan::Type::WallCol;
+                span.col.x = (int16_t) rng.range(0, FB_W - 1);
+                span.col.u = (int16_t) rng.range(0, 255);
+                span.col.y1 = (int16_t) rng.range(-40, FB_H / 2);
+                span.col.y2 = (int16_t) rng.range(FB_H / 2, FB_H + 40);
+                span.col.v1 = (int16_t) rng.range(0, 127);
+                span.col.v2 = (int16_t) rng.range(0, 255);
+                span.col.color = randomColor(rng);
+                numPixels += getNumSpanPixels(span.col.y1, span.col.y2, FB_H);
+            }   break;
+
+            default: {
+                span.type = CapturedSpan::Type::WallColGouraud;
+                span.gouraudCol.x = (int16_t) rng.range(0, FB_W - 1);
+                span.gouraudCol.u = (int16_t) rng.range(0, 255);
+                span.gouraudCol.y1 = (int16_t) rng.range(-40, FB_H / 2);
+                span.gouraudCol.y2 = (int16_t) rng.range(FB_H / 2, FB_H + 40);
+                span.gouraudCol.v1 = (int16_t) rng.range(0, 127);
+                span.gouraudCol.v2 = (int16_t) rng.range(0, 255);
+                span.gouraudCol.color1 = randomColor(rng);
+                span.gouraudCol.color2 = randomColor(rng);
+                numPixels += getNumSpanPixels(span.gouraudCol.y1, span.gouraudCol.y2, FB_H);
+            }   break;
+        }
+
+        spans.push_back(span);
+    }
+
+    return numPixels;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a primitive with the specified draw mode
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class PrimT>
+static void drawWithMode(Gpu::Core& core, const Gpu::DrawMode drawMode, const PrimT& prim) noexcept {
+    switch (drawMode) {
+        case Gpu::DrawMode::Colored:            Gpu::draw<Gpu::DrawMode::Colored>(core, prim);              break;
+        case Gpu::DrawMode::ColoredBlended:     Gpu::draw<Gpu::DrawMode::ColoredBlended>(core, prim);       break;
+        case Gpu::DrawMode::Textured:           Gpu::draw<Gpu::DrawMode::Textured>(core, prim);             break;
+        case Gpu::DrawMode::TexturedBlended:    Gpu::draw<Gpu::DrawMode::TexturedBlended>(core, prim);      break;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Replays the captured span stream using either the scalar or SIMD span shading code and reports the throughput in megapixels/s.
+// Saves the contents of VRAM afterwards to the given output.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void runSpanBenchmark(
+    const bool bUseSimd,
+    const std::vector<CapturedSpan>& spans,
+    const uint64_t numSpanPixels,
+    std::vector<uint16_t>& vramOut
+) noexcept {
+    Gpu::Core core = {};
+    Gpu::initCore(core, VRAM_W, VRAM_H);
+    writeTestTextures(core);
+
+    core.bUseSimd = bUseSimd;
+    core.drawOffsetX = 0;
+    core.drawOffsetY = 0;
+    core.drawAreaLx = 0;
+    core.drawAreaRx = FB_W - 1;
+    core.drawAreaTy = 0;
+    core.drawAreaBy = FB_H - 1;
+    core.texFmt = Gpu::TexFmt::Bpp8;
+    core.texPageX = TEX_AREA_X;
+    core.texPageY = TEX_AREA_Y;
+    core.texPageXMask = 0x3FF;
+    core.texPageYMask = 0x1FF;
+    core.clutX = 0;
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t replayIdx = 0; replayIdx < NUM_SPAN_REPLAYS; ++replayIdx) {
+        for (const CapturedSpan& span : spans) {
+            core.blendMode = span.blendMode;
+            core.bDisableMasking = span.bDisableMasking;
+            core.texWinX = span.texWinX;
+            core.texWinY = span.texWinY;
+            core.texWinXMask = span.texWinXMask;
+            core.texWinYMask = span.texWinYMask;
+            core.clutY = span.clutY;
+
+            switch (span.type) {
+                case CapturedSpan::Type::FloorRow:          drawWithMode(core, span.drawMode, span.row);            break;
+                case CapturedSpan::Type::WallCol:           drawWithMode(core, span.drawMode, span.col);            break;
+                case CapturedSpan::Type::WallColGouraud:    drawWithMode(core, span.drawMode, span.gouraudCol);     break;
+            }
+        }
+    }
+
+    const auto endTime = std::chrono::high_resolution_clock::now();
+    const double totalTime = std::chrono::duration<double>(endTime - startTime).count();
+    const double numPixels = (double) numSpanPixels * NUM_SPAN_REPLAYS;
+
+    vramOut.assign(core.pRam, core.pRam + (size_t) VRAM_W * VRAM_H);
+    Gpu::destroyCore(core);
+
+    std::printf("%-24s %10.1f Mpixels/s\n", (bUseSimd) ? "spans (SIMD)" : "spans (scalar)", numPixels / totalTime / 1e6);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// The output of a test run: a hash of VRAM after each frame and the final contents of VRAM
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct TestOutput {
+    std::vector<uint64_t>   frameHashes;
+    std::vector<uint16_t>   finalVram;
+
+    bool operator == (const TestOutput& other) const noexcept {
+        return ((frameHashes == other.frameHashes) && (finalVram == other.finalVram));
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the test frames with the given number of threads (0 = immediate mode) and SIMD setting and compares the output against the golden output (if given).
+// Returns 'true' if the output matched or if there was no golden output.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool runMode(
+    const uint32_t numThreads,
+    const bool bUseSimd,
+    const uint32_t numFrames,
+    TestOutput& output,
+    const TestOutput* const pGoldenOutput
+) noexcept {
+    Gpu::Core core = {};
+    Gpu::initCore(core, VRAM_W, VRAM_H);
+    writeTestTextures(core);
+    core.bUseSimd = bUseSimd;
+
+    if (numThreads > 0) {
+        Gpu::enableDeferredMode(core, numThreads);
+    }
+
+    output.frameHashes.clear();
+    double totalTime = 0;
+
+    for (uint32_t frameIdx = 0; frameIdx < numFrames; ++frameIdx) {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        drawTestFrame(core, frameIdx);
+        const auto endTime = std::chrono::high_resolution_clock::now();
+        totalTime += std::chrono::duration<double>(endTime - startTime).count();
+
+        output.frameHashes.push_back(hashVram(core));
+    }
+
+    output.finalVram.assign(core.pRam, core.pRam + (size_t) VRAM_W * VRAM_H);
+    Gpu::destroyCore(core);
+
+    bool bMatched = true;
+
+    if (pGoldenOutput) {
+        bMatched = (output == *pGoldenOutput);
+    }
+
+    char modeName[64];
+
+    if (numThreads > 0) {
+        std::snprintf(modeName, sizeof(modeName), "deferred (%u threads)%s", numThreads, (bUseSimd) ? "" : " scalar");
+    } else {
+        std::snprintf(modeName, sizeof(modeName), "immediate%s", (bUseSimd) ? " SIMD" : "");
+    }
+
+    std::printf(
+        "%-24s %10.1f frames/s | %s\n",
+        modeName,
+        (double) numFrames / totalTime,
+        (pGoldenOutput) ? ((bMatched) ? "matches golden output" : "MISMATCH!") : "golden output"
+    );
+
+    return bMatched;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Program entrypoint
+//------------------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, const char* const argv[]) noexcept {
+    // Optionally the number of frames to draw can be specified
+    uint32_t numFrames = DEFAULT_NUM_FRAMES;
+
+    if (argc >= 2) {
+        numFrames = (uint32_t) std::strtoul(argv[1], nullptr, 10);
+
+        if (numFrames == 0) {
+            std::printf("Usage: GpuBench [NUM FRAMES]\n");
+            return 1;
+        }
+    }
+
+    // Immediate mode with scalar span shading is the golden output.
+    // Try SIMD span shading and deferred mode with various thread counts up to the hardware thread count.
+    TestOutput goldenOutput;
+    TestOutput output;
+    runMode(0, false, numFrames, goldenOutput, nullptr);
+
+    bool bAllMatched = true;
+
+    if (Gpu::isSimdSupported()) {
+        bAllMatched &= runMode(0, true, numFrames, output, &goldenOutput);
+    }
+
+    const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (uint32_t numThreads = 1; numThreads < maxThreads; numThreads *= 2) {
+        bAllMatched &= runMode(numThreads, Gpu::isSimdSupported(), numFrames, output, &goldenOutput);
+    }
+
+    bAllMatched &= runMode(maxThreads, Gpu::isSimdSupported(), numFrames, output, &goldenOutput);
+
+    // Benchmark the scalar vs SIMD span shading code on the captured stream of wall columns and floor rows
+    if (Gpu::isSimdSupported()) {
+        std::vector<CapturedSpan> spans;
+        std::vector<uint16_t> scalarVram;
+        std::vector<uint16_t> simdVram;
+
+        Gpu::Core captureCore = {};
+        Gpu::initCore(captureCore, VRAM_W, VRAM_H);
+        const uint64_t numSpanPixels = captureSpans(captureCore, spans);
+        Gpu::destroyCore(captureCore);
+
+        runSpanBenchmark(false, spans, numSpanPixels, scalarVram);
+        runSpanBenchmark(true, spans, numSpanPixels, simdVram);
+
+        const bool bSpansMatched = (scalarVram == simdVram);
+        std::printf("spans SIMD vs scalar: %s\n", (bSpansMatched) ? "output matches" : "MISMATCH!");
+        bAllMatched &= bSpansMatched;
+    }
+
+    return (bAllMatched) ? 0 : 1;
+}
@@ -0,0 +1,518 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// GpuReplay:
+//      Replays a stream of LIBGPU primitives recorded by the game (via the '-gpucapture' command line argument) on a fresh 'simple_gpu'
+//      core, with no window, game logic or disc required. Useful for benchmarking and regression testing the classic renderer using
+//      real gameplay workloads rather than synthetic ones.
+//
+//      The primitives are decoded by 'LIBGPU_CmdDecode', which is the same code the game uses for the classic renderer. The first replay
+//      pass times every record and reports a breakdown of the time spent per primitive type; the remaining passes just time whole frames.
+//      A checksum of VRAM after the last frame is reported and must be the same for every pass. The checksum can be compared between
+//      builds (or between the scalar, SIMD and multithreaded drawing modes) to check that rendering output has not changed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "Gpu.h"
+#include "PsyDoom/GpuCapture.h"
+#include "PsyDoom/LIBGPU_CmdDecode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace GpuCapture;
+
+static constexpr uint32_t NUM_RECORD_TYPES = (uint32_t) RecordType::NUM_TYPES;
+static constexpr uint32_t DEFAULT_NUM_REPEATS = 3;
+
+// Display names for each record type
+static constexpr const char* RECORD_TYPE_NAMES[NUM_RECORD_TYPES] = {
+    "FrameEnd",
+    "GpuState",
+    "ClearRect",
+    "LoadImage",
+    "MoveImage",
+    "DR_MODE",
+    "DR_TWIN",
+    "SPRT",
+    "LINE_F2",
+    "POLY_FT3",
+    "POLY_F4",
+    "POLY_FT4",
+    "FLOORROW_FT",
+    "WALLCOL_GT",
+};
+
+// A record in the capture file, validated and ready for replay
+struct Record {
+    RecordType          type;
+    uint32_t            size;
+    const std::byte*    pData;
+};
+
+// Timing stats for one record type
+struct RecordStats {
+    uint64_t    count;
+    double      totalTime;
+};
+
+// Options for how to replay
+struct ReplayOptions {
+    uint32_t    numRepeats;     // How many times to replay the capture after the first (per record timed) pass
+    uint32_t    numThreads;     // Number of threads to use for deferred drawing, or '0' for immediate mode
+    bool        bUseSimd;       // Use SIMD span shading?
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Computes a hash of the entire contents of VRAM (64-bit FNV-1a)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t hashVram(const Gpu::Core& core) noexcept {
+    const uint8_t* const pBytes = reinterpret_cast<const uint8_t*>(core.pRam);
+    const size_t numBytes = (size_t) core.ramPixelW * core.ramPixelH * sizeof(uint16_t);
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < numBytes; ++i) {
+        hash ^= pBytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the entire contents of the given file into memory.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readFile(const char* const filePath, std::vector<std::byte>& fileData) noexcept {
+    std::FILE* const pFile = std::fopen(filePath, "rb");
+
+    if (!pFile)
+        return false;
+
+    bool bSuccess = false;
+
+    if (std::fseek(pFile, 0, SEEK_END) == 0) {
+        const long fileSize = std::ftell(pFile);
+
+        if ((fileSize >= 0) && (std::fseek(pFile, 0, SEEK_SET) == 0)) {
+            fileData.resize((size_t) fileSize);
+            bSuccess = (std::fread(fileData.data(), 1, fileData.size(), pFile) == fileData.size());
+        }
+    }
+
+    std::fclose(pFile);
+    return bSuccess;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gives the data size expected for a record of the given type, or '0' if the size varies (or there is no data)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t getFixedRecordSize(const RecordType type) noexcept {
+    switch (type) {
+        case RecordType::GpuState:      return sizeof(GpuStateRecord);
+        case RecordType::ClearRect:     return sizeof(ClearRectRecord);
+        case RecordType::MoveImage:     return sizeof(MoveImageRecord);
+        case RecordType::DR_MODE:       return sizeof(DR_MODE);
+        case RecordType::DR_TWIN:       return sizeof(DR_TWIN);
+        case RecordType::SPRT:          return sizeof(SPRT);
+        case RecordType::LINE_F2:       return sizeof(LINE_F2);
+        case RecordType::POLY_FT3:      return sizeof(POLY_FT3);
+        case RecordType::POLY_F4:       return sizeof(POLY_F4);
+        case RecordType::POLY_FT4:      return sizeof(POLY_FT4);
+        case RecordType::FLOORROW_FT:   return sizeof(FLOORROW_FT);
+        case RecordType::WALLCOL_GT:    return sizeof(WALLCOL_GT);
+        default:                        return 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Validates the capture file header and splits the rest of the file into records.
+// Returns 'false' and prints an error if the file is not valid.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool parseCapture(const std::vector<std::byte>& fileData, FileHeader& header, std::vector<Record>& records) noexcept {
+    if (fileData.size() < sizeof(FileHeader)) {
+        std::printf("Capture file is too small to be valid!\n");
+        return false;
+    }
+
+    std::memcpy(&header, fileData.data(), sizeof(FileHeader));
+
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        std::printf("Not a PsyDoom GPU capture file!\n");
+        return false;
+    }
+
+    if (header.version != FILE_VERSION) {
+        std::printf("Unsupported capture file version %u! Expected version %u.\n", header.version, FILE_VERSION);
+        return false;
+    }
+
+    if ((header.bLimitRemoving != 0) != (PSYDOOM_LIMIT_REMOVING != 0)) {
+        std::printf(
+            "Capture was made by a build %s limit removing features but this tool was built %s them! The primitive layouts differ.\n",
+            (header.bLimitRemoving) ? "with" : "without",
+            (PSYDOOM_LIMIT_REMOVING) ? "with" : "without"
+        );
+
+        return false;
+    }
+
+    if ((header.vramW == 0) || (header.vramH == 0)) {
+        std::printf("Capture file has invalid VRAM dimensions!\n");
+        return false;
+    }
+
+    // Split up the records and make sure each is the size expected
+    records.clear();
+    size_t offset = sizeof(FileHeader);
+
+    while (offset < fileData.size()) {
+        if (fileData.size() - offset < sizeof(RecordHeader)) {
+            std::printf("Capture file is truncated! Ignoring the partial record at the end.\n");
+            break;
+        }
+
+        RecordHeader recordHeader = {};
+        std::memcpy(&recordHeader, fileData.data() + offset, sizeof(RecordHeader));
+        offset += sizeof(RecordHeader);
+
+        if (fileData.size() - offset < recordHeader.size) {
+            std::printf("Capture file is truncated! Ignoring the partial record at the end.\n");
+            break;
+        }
+
+        const RecordType type = recordHeader.type;
+
+        if ((uint32_t) type >= NUM_RECORD_TYPES) {
+            std::printf("Capture file contains an unknown record type (%u) at offset %zu!\n", (uint32_t) type, offset);
+            return false;
+        }
+
+        const uint32_t fixedSize = getFixedRecordSize(type);
+        bool bValidSize = true;
+
+        if (type == RecordType::FrameEnd) {
+            bValidSize = (recordHeader.size == 0);
+        } else if (type == RecordType::LoadImage) {
+            if (recordHeader.size >= sizeof(SRECT)) {
+                SRECT dstRect = {};
+                std::memcpy(&dstRect, fileData.data() + offset, sizeof(SRECT));
+                bValidSize = (
+                    (dstRect.w > 0) && (dstRect.h > 0) &&
+                    (dstRect.w <= header.vramW) && (dstRect.h <= header.vramH) &&
+                    (recordHeader.size == sizeof(SRECT) + (uint32_t) dstRect.w * (uint32_t) dstRect.h * sizeof(uint16_t))
+                );
+            } else {
+                bValidSize = false;
+            }
+        } else {
+            bValidSize = (recordHeader.size == fixedSize);
+        }
+
+        if (!bValidSize) {
+            std::printf("Capture file contains a bad '%s' record at offset %zu!\n", RECORD_TYPE_NAMES[(uint32_t) type], offset);
+            return false;
+        }
+
+        records.push_back(Record{ type, recordHeader.size, fileData.data() + offset });
+        offset += recordHeader.size;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Read a struct of the given type from the data for a record.
+// The record data is not guaranteed to be aligned, so it is copied out.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class T>
+static T readRecordData(const Record& record) noexcept {
+    T data;
+    std::memcpy(&data, record.pData, sizeof(T));
+    return data;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Replay functions for each type of record
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void replayGpuState(Gpu::Core& gpu, const GpuStateRecord& state) noexcept {
+    gpu.drawOffsetX = state.drawOffsetX;
+    gpu.drawOffsetY = state.drawOffsetY;
+    gpu.drawAreaLx = state.drawAreaLx;
+    gpu.drawAreaRx = state.drawAreaRx;
+    gpu.drawAreaTy = state.drawAreaTy;
+    gpu.drawAreaBy = state.drawAreaBy;
+    gpu.texPageX = state.texPageX;
+    gpu.texPageY = state.texPageY;
+    gpu.texPageXMask = state.texPageXMask;
+    gpu.texPageYMask = state.texPageYMask;
+    gpu.texWinX = state.texWinX;
+    gpu.texWinY = state.texWinY;
+    gpu.texWinXMask = state.texWinXMask;
+    gpu.texWinYMask = state.texWinYMask;
+    gpu.clutX = state.clutX;
+    gpu.clutY = state.clutY;
+    gpu.blendMode = (Gpu::BlendMode) state.blendMode;
+    gpu.texFmt = (Gpu::TexFmt) state.texFmt;
+    gpu.bDisableMasking = state.bDisableMasking;
+}
+
+static void replayLoadImage(Gpu::Core& gpu, const Record& record) noexcept {
+    // Same as 'LIBGPU_LoadImage': horizontal and vertical coordinates wrap around VRAM
+    const SRECT dstRect = readRecordData<SRECT>(record);
+    const std::byte* pSrcPixels = record.pData + sizeof(SRECT);
+    Gpu::flush(gpu);
+
+    for (int32_t rowIdx = 0; rowIdx < dstRect.h; ++rowIdx) {
+        const uint16_t dstY = (uint16_t)(dstRect.y + rowIdx) & gpu.ramYMask;
+        uint16_t* const pDstRow = gpu.pRam + (intptr_t) dstY * gpu.ramPixelW;
+
+        for (int32_t colIdx = 0; colIdx < dstRect.w;) {
+            const uint16_t dstX = (uint16_t)(dstRect.x + colIdx) & gpu.ramXMask;
+            const int32_t numPixels = std::min<int32_t>(dstRect.w - colIdx, gpu.ramPixelW - dstX);
+            std::memcpy(pDstRow + dstX, pSrcPixels, (size_t) numPixels * sizeof(uint16_t));
+            pSrcPixels += (size_t) numPixels * sizeof(uint16_t);
+            colIdx += numPixels;
+        }
+    }
+}
+
+static void replayMoveImage(Gpu::Core& gpu, const MoveImageRecord& move) noexcept {
+    // Same as 'LIBGPU_MoveImage' but skip copies that would go out of bounds, since the capture file is untrusted input
+    const SRECT& srcRect = move.srcRect;
+
+    const bool bValidMove = (
+        (srcRect.x >= 0) && (srcRect.y >= 0) && (srcRect.w > 0) && (srcRect.h > 0) &&
+        (srcRect.x + srcRect.w <= gpu.ramPixelW) && (srcRect.y + srcRect.h <= gpu.ramPixelH) &&
+        (move.dstX >= 0) && (move.dstY >= 0) &&
+        (move.dstX + srcRect.w <= gpu.ramPixelW) && (move.dstY + srcRect.h <= gpu.ramPixelH)
+    );
+
+    if (!bValidMove)
+        return;
+
+    Gpu::flush(gpu);
+
+    const uint16_t* pSrcRow = gpu.pRam + srcRect.x + (intptr_t) srcRect.y * gpu.ramPixelW;
+    uint16_t* pDstRow = gpu.pRam + move.dstX + (intptr_t) move.dstY * gpu.ramPixelW;
+
+    for (int32_t rowIdx = 0; rowIdx < srcRect.h; ++rowIdx) {
+        std::memcpy(pDstRow, pSrcRow, (size_t) srcRect.w * sizeof(uint16_t));
+        pSrcRow += gpu.ramPixelW;
+        pDstRow += gpu.ramPixelW;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Replays a single record on the given GPU core
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void replayRecord(Gpu::Core& gpu, const Record& record) noexcept {
+    switch (record.type) {
+        case RecordType::FrameEnd:      Gpu::flush(gpu);                                                    break;
+        case RecordType::GpuState:      replayGpuState(gpu, readRecordData<GpuStateRecord>(record));        break;
+        case RecordType::LoadImage:     replayLoadImage(gpu, record);                                       break;
+        case RecordType::MoveImage:     replayMoveImage(gpu, readRecordData<MoveImageRecord>(record));      break;
+        case RecordType::SPRT:          LIBGPU_CmdDecode::submit(gpu, readRecordData<SPRT>(record));        break;
+        case RecordType::LINE_F2:       LIBGPU_CmdDecode::submit(gpu, readRecordData<LINE_F2>(record));     break;
+        case RecordType::POLY_FT3:      LIBGPU_CmdDecode::submit(gpu, readRecordData<POLY_FT3>(record));    break;
+        case RecordType::POLY_F4:       LIBGPU_CmdDecode::submit(gpu, readRecordData<POLY_F4>(record));     break;
+        case RecordType::POLY_FT4:      LIBGPU_CmdDecode::submit(gpu, readRecordData<POLY_FT4>(record));    break;
+        case RecordType::FLOORROW_FT:   LIBGPU_CmdDecode::submit(gpu, readRecordData<FLOORROW_FT>(record)); break;
+        case RecordType::WALLCOL_GT:    LIBGPU_CmdDecode::submit(gpu, readRecordData<WALLCOL_GT>(record));  break;
+        case RecordType::DR_MODE:       LIBGPU_CmdDecode::submit(gpu, readRecordData<DR_MODE>(record));     break;
+        case RecordType::DR_TWIN:       LIBGPU_CmdDecode::submit(gpu, readRecordData<DR_TWIN>(record));     break;
+
+        case RecordType::ClearRect: {
+            const ClearRectRecord clear = readRecordData<ClearRectRecord>(record);
+            Gpu::clearRect(gpu, clear.color, clear.x, clear.y, clear.w, clear.h);
+        }   break;
+
+        default:
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Replays all of the records once on a fresh GPU core and returns the hash of VRAM at the end.
+// If record stats are given then each record is individually timed (which adds some overhead), otherwise just the total time is measured.
+// Outputs the total replay time and the number of frames replayed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t replay(
+    const FileHeader& header,
+    const std::vector<Record>& records,
+    const ReplayOptions& options,
+    RecordStats* const pRecordStats,
+    double& totalTime,
+    uint32_t& numFrames
+) noexcept {
+    Gpu::Core gpu = {};
+    Gpu::initCore(gpu, header.vramW, header.vramH);
+    gpu.bUseSimd = options.bUseSimd;
+
+    if (options.numThreads > 0) {
+        Gpu::enableDeferredMode(gpu, options.numThreads);
+    }
+
+    numFrames = 0;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    if (pRecordStats) {
+        for (const Record& record : records) {
+            const auto recordStartTime = std::chrono::high_resolution_clock::now();
+            replayRecord(gpu, record);
+            const auto recordEndTime = std::chrono::high_resolution_clock::now();
+
+            RecordStats& stats = pRecordStats[(uint32_t) record.type];
+            stats.count++;
+            stats.totalTime += std::chrono::duration<double>(recordEndTime - recordStartTime).count();
+            numFrames += (record.type == RecordType::FrameEnd) ? 1 : 0;
+        }
+    } else {
+        for (const Record& record : records) {
+            replayRecord(gpu, record);
+            numFrames += (record.type == RecordType::FrameEnd) ? 1 : 0;
+        }
+    }
+
+    Gpu::flush(gpu);
+    const auto endTime = std::chrono::high_resolution_clock::now();
+    totalTime = std::chrono::duration<double>(endTime - startTime).count();
+
+    const uint64_t vramHash = hashVram(gpu);
+    Gpu::destroyCore(gpu);
+    return vramHash;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints the program usage
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printUsage() noexcept {
+    std::printf(
+        "Usage: GpuReplay <CAPTURE FILE> [-repeat <COUNT>] [-threads <COUNT>] [-scalar]\n"
+        "\n"
+        "  -repeat <COUNT>   Number of (untimed per record) replays to do after the first pass. Default: %u.\n"
+        "  -threads <COUNT>  Use the deferred, multithreaded drawing mode with this many threads. Default: 0 (immediate mode).\n"
+        "                    Note: in deferred mode the per record times only measure queuing work; draws happen on flush.\n"
+        "  -scalar           Disable SIMD span shading.\n"
+        "\n"
+        "Captures are made by running PsyDoom with '-gpucapture <FILE> <START FRAME> <NUM FRAMES>'.\n",
+        DEFAULT_NUM_REPEATS
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Program entrypoint
+//------------------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, const char* const argv[]) noexcept {
+    // Parse the command line
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    const char* const captureFilePath = argv[1];
+
+    ReplayOptions options = {};
+    options.numRepeats = DEFAULT_NUM_REPEATS;
+    options.numThreads = 0;
+    options.bUseSimd = Gpu::isSimdSupported();
+
+    for (int argIdx = 2; argIdx < argc; ++argIdx) {
+        const char* const arg = argv[argIdx];
+
+        if ((std::strcmp(arg, "-repeat") == 0) && (argIdx + 1 < argc)) {
+            options.numRepeats = (uint32_t) std::strtoul(argv[++argIdx], nullptr, 10);
+        } else if ((std::strcmp(arg, "-threads") == 0) && (argIdx + 1 < argc)) {
+            options.numThreads = (uint32_t) std::strtoul(argv[++argIdx], nullptr, 10);
+        } else if (std::strcmp(arg, "-scalar") == 0) {
+            options.bUseSimd = false;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    // Read and validate the capture
+    std::vector<std::byte> fileData;
+
+    if (!readFile(captureFilePath, fileData)) {
+        std::printf("Failed to read capture file '%s'!\n", captureFilePath);
+        return 1;
+    }
+
+    FileHeader header = {};
+    std::vector<Record> records;
+
+    if (!parseCapture(fileData, header, records))
+        return 1;
+
+    std::printf(
+        "Replaying '%s': %zu records, VRAM %ux%u, %s, %s\n",
+        captureFilePath,
+        records.size(),
+        header.vramW,
+        header.vramH,
+        (options.numThreads > 0) ? "deferred mode" : "immediate mode",
+        (options.bUseSimd) ? "SIMD" : "scalar"
+    );
+
+    // First pass: time each record and print the breakdown by record type
+    RecordStats recordStats[NUM_RECORD_TYPES] = {};
+    double firstPassTime = 0;
+    uint32_t numFrames = 0;
+    const uint64_t vramHash = replay(header, records, options, recordStats, firstPassTime, numFrames);
+
+    double totalRecordTime = 0;
+
+    for (const RecordStats& stats : recordStats) {
+        totalRecordTime += stats.totalTime;
+    }
+
+    std::printf("\n%-12s %10s %12s %12s %8s\n", "Record", "Count", "Total ms", "Avg ns", "Time %");
+
+    for (uint32_t typeIdx = 0; typeIdx < NUM_RECORD_TYPES; ++typeIdx) {
+        const RecordStats& stats = recordStats[typeIdx];
+
+        if (stats.count == 0)
+            continue;
+
+        std::printf(
+            "%-12s %10llu %12.3f %12.1f %7.1f%%\n",
+            RECORD_TYPE_NAMES[typeIdx],
+            (unsigned long long) stats.count,
+            stats.totalTime * 1e3,
+            stats.totalTime * 1e9 / (double) stats.count,
+            (totalRecordTime > 0) ? stats.totalTime * 100.0 / totalRecordTime : 0.0
+        );
+    }
+
+    // Remaining passes: time the replay as a whole and make sure the output is the same every time
+    bool bAllMatched = true;
+    double bestTime = firstPassTime;
+
+    for (uint32_t repeatIdx = 0; repeatIdx < options.numRepeats; ++repeatIdx) {
+        double passTime = 0;
+        uint32_t passNumFrames = 0;
+        const uint64_t passVramHash = replay(header, records, options, nullptr, passTime, passNumFrames);
+
+        bestTime = (repeatIdx == 0) ? passTime : std::min(bestTime, passTime);
+        bAllMatched &= (passVramHash == vramHash);
+    }
+
+    std::printf("\nFrames: %u\n", numFrames);
+
+    if (numFrames > 0) {
+        std::printf("Best time: %.3f ms (%.3f ms/frame, %.1f frames/s)\n", bestTime * 1e3, bestTime * 1e3 / numFrames, (double) numFrames / bestTime);
+    } else {
+        std::printf("Best time: %.3f ms\n", bestTime * 1e3);
+    }
+
+    std::printf("VRAM checksum: %016llX\n", (unsigned long long) vramHash);
+
+    if (!bAllMatched) {
+        std::printf("MISMATCH! The VRAM checksum differed between replays.\n");
+        return 1;
+    }
+
+    return 0;
+}
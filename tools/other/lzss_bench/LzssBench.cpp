@@ -0,0 +1,295 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// LzssBench:
+//      Benchmark and golden output test for the WAD lump LZSS decoders in 'WadUtils'.
+//      Decompresses every compressed lump in the given WAD files (e.g 'PSXDOOM.WAD' and the 'MAPxx.WAD' files extracted from the game disc)
+//      with the original one-bit-at-a-time decoder (kept here as the reference) and with the current 'WadUtils' decoders. Verifies that
+//      all decoders produce the same output and size, checks that the bounds checked decoder rejects truncated data safely, and reports
+//      the throughput of each decoder in MiB of decompressed output per second.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "FileUtils.h"
+#include "PsyDoom/WadUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static constexpr uint32_t DEFAULT_NUM_ITERATIONS = 50;      // Default number of times to decompress all of the lumps when timing
+
+// A compressed lump to test with
+struct TestLump {
+    char                    name[MAX_WAD_LUMPNAME + 1];
+    const char*             wadFilePath;
+    std::vector<uint8_t>    compressedData;
+    int32_t                 uncompressedSize;       // As recorded in the WAD lump header
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// The original LZSS decoder from PSX Doom, used as the reference implementation
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void referenceDecompress(const void* const pSrc, void* const pDst) noexcept {
+    const uint8_t* pSrcByte = (const uint8_t*) pSrc;
+    uint8_t* pDstByte = (uint8_t*) pDst;
+
+    uint32_t idByte = 0;
+    uint32_t haveIdByte = 0;
+
+    while (true) {
+        if (haveIdByte == 0) {
+            idByte = *pSrcByte;
+            ++pSrcByte;
+        }
+
+        haveIdByte = (haveIdByte + 1) & 7;
+
+        if (idByte & 1) {
+            const uint32_t srcByte1 = pSrcByte[0];
+            const uint32_t srcByte2 = pSrcByte[1];
+            pSrcByte += 2;
+
+            const int32_t srcOffset = ((srcByte1 << 4) | (srcByte2 >> 4)) + 1;
+            const int32_t numRepeatedBytes = (srcByte2 & 0xF) + 1;
+
+            if (numRepeatedBytes == 1)
+                break;
+
+            const uint8_t* const pRepeatedBytes = pDstByte - srcOffset;
+
+            for (int32_t i = 0; i < numRepeatedBytes; ++i) {
+                *pDstByte = pRepeatedBytes[i];
+                ++pDstByte;
+            }
+        } else {
+            *pDstByte = *pSrcByte;
+            ++pSrcByte;
+            ++pDstByte;
+        }
+
+        idByte >>= 1;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads all the compressed lumps from the specified WAD file and adds them to the given list.
+// Returns 'false' if the file could not be read or is not a valid WAD.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readCompressedLumps(const char* const wadFilePath, std::vector<TestLump>& lumps) noexcept {
+    const FileData fileData = FileUtils::getContentsOfFile(wadFilePath);
+
+    if ((!fileData.bytes) || (fileData.size < 12)) {
+        std::printf("Failed to read WAD file '%s'!\n", wadFilePath);
+        return false;
+    }
+
+    const uint8_t* const pFileBytes = (const uint8_t*) fileData.bytes.get();
+    const auto readI32 = [&](const size_t offset) noexcept {
+        int32_t value;
+        std::memcpy(&value, pFileBytes + offset, sizeof(value));
+        return Endian::littleToHost(value);
+    };
+
+    const int32_t numLumps = readI32(4);
+    const int32_t lumpHdrsOffset = readI32(8);
+
+    if ((numLumps < 0) || (lumpHdrsOffset < 0) || ((size_t) lumpHdrsOffset + (size_t) numLumps * 16 > fileData.size)) {
+        std::printf("Invalid WAD file '%s'!\n", wadFilePath);
+        return false;
+    }
+
+    // Note: the last lump can't be used since it's compressed size is determined from the offset of the next lump
+    for (int32_t lumpIdx = 0; lumpIdx + 1 < numLumps; ++lumpIdx) {
+        const size_t lumpHdrOffset = (size_t) lumpHdrsOffset + (size_t) lumpIdx * 16;
+        const int32_t lumpOffset = readI32(lumpHdrOffset);
+        const int32_t uncompressedSize = readI32(lumpHdrOffset + 4);
+        const int32_t nextLumpOffset = readI32(lumpHdrOffset + 16);
+        const bool bIsCompressed = (pFileBytes[lumpHdrOffset + 8] & 0x80);
+
+        if ((!bIsCompressed) || (uncompressedSize <= 0))
+            continue;
+
+        if ((lumpOffset < 0) || (nextLumpOffset < lumpOffset) || ((size_t) nextLumpOffset > fileData.size)) {
+            std::printf("Invalid lump %d in WAD file '%s'!\n", lumpIdx, wadFilePath);
+            return false;
+        }
+
+        TestLump& lump = lumps.emplace_back();
+        std::memcpy(lump.name, pFileBytes + lumpHdrOffset + 8, MAX_WAD_LUMPNAME);
+        lump.name[0] &= 0x7F;
+        lump.name[MAX_WAD_LUMPNAME] = 0;
+        lump.wadFilePath = wadFilePath;
+        lump.compressedData.assign(pFileBytes + lumpOffset, pFileBytes + nextLumpOffset);
+        lump.uncompressedSize = uncompressedSize;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Verifies that all of the decoders agree on the output for all lumps.
+// Also checks that the bounds checked decoder safely rejects truncated input and undersized output buffers.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool verifyDecoders(const std::vector<TestLump>& lumps) noexcept {
+    std::vector<uint8_t> refOutput;
+    std::vector<uint8_t> fastOutput;
+    std::vector<uint8_t> checkedOutput;
+    bool bAllMatched = true;
+
+    for (const TestLump& lump : lumps) {
+        const uint8_t* const pSrc = lump.compressedData.data();
+        const int32_t srcSize = (int32_t) lump.compressedData.size();
+        const int32_t refSize = WadUtils::decompressLumpChecked(pSrc, srcSize, nullptr, 0);
+
+        // The reference decoder is not bounds checked, so make sure the data is valid and the output size is known before using it
+        if (refSize < 0) {
+            std::printf("  %s (%s): compressed data is corrupt!\n", lump.name, lump.wadFilePath);
+            bAllMatched = false;
+            continue;
+        }
+
+        refOutput.assign((size_t) refSize, 0);
+        fastOutput.assign((size_t) refSize, 0);
+        checkedOutput.assign((size_t) refSize, 0);
+        referenceDecompress(pSrc, refOutput.data());
+        WadUtils::decompressLump(pSrc, fastOutput.data());
+        const int32_t checkedSize = WadUtils::decompressLumpChecked(pSrc, srcSize, checkedOutput.data(), refSize);
+        const int32_t querySize = WadUtils::getDecompressedLumpSize(pSrc);
+
+        const bool bMatched = (
+            (refSize == lump.uncompressedSize) &&
+            (checkedSize == refSize) &&
+            (querySize == refSize) &&
+            (fastOutput == refOutput) &&
+            (checkedOutput == refOutput)
+        );
+
+        if (!bMatched) {
+            std::printf(
+                "  %s (%s): MISMATCH! header size %d, sizes: reference %d, checked %d, query %d\n",
+                lump.name, lump.wadFilePath, lump.uncompressedSize, refSize, checkedSize, querySize
+            );
+
+            bAllMatched = false;
+        }
+
+        // Truncated input and a too small output buffer must fail rather than read or write out of bounds
+        const bool bRejectsTruncatedInput = (WadUtils::decompressLumpChecked(pSrc, srcSize / 2, checkedOutput.data(), refSize) < 0);
+        const bool bRejectsSmallOutput = (refSize == 0) || (WadUtils::decompressLumpChecked(pSrc, srcSize, checkedOutput.data(), refSize - 1) < 0);
+
+        if ((!bRejectsTruncatedInput) || (!bRejectsSmallOutput)) {
+            std::printf("  %s (%s): bounds checked decoder did not reject bad buffers!\n", lump.name, lump.wadFilePath);
+            bAllMatched = false;
+        }
+    }
+
+    return bAllMatched;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Times decompressing all of the lumps the specified number of times with the given function and prints the throughput
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class DecodeFunc>
+static void timeDecoder(const char* const decoderName, const std::vector<TestLump>& lumps, const uint32_t numIterations, const DecodeFunc& decode) noexcept {
+    size_t maxOutputSize = 0;
+    size_t totalOutputSize = 0;
+
+    for (const TestLump& lump : lumps) {
+        maxOutputSize = std::max(maxOutputSize, (size_t) lump.uncompressedSize);
+        totalOutputSize += (size_t) lump.uncompressedSize;
+    }
+
+    std::vector<uint8_t> output(maxOutputSize);
+    uint32_t checksum = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (uint32_t iterIdx = 0; iterIdx < numIterations; ++iterIdx) {
+        for (const TestLump& lump : lumps) {
+            checksum += (uint32_t) decode(lump, output.data());
+            checksum += output[0];
+        }
+    }
+
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const double totalMiB = (double) totalOutputSize * numIterations / (1024.0 * 1024.0);
+
+    std::printf(
+        "  %-24s %8.3f ms per pass  %10.1f MiB/s  (checksum %08X)\n",
+        decoderName,
+        time * 1000.0 / numIterations,
+        (time > 0) ? totalMiB / time : 0.0,
+        checksum
+    );
+}
+
+int main(int argc, const char* const argv[]) noexcept {
+    // Read all the compressed lumps from the WAD files given
+    uint32_t numIterations = DEFAULT_NUM_ITERATIONS;
+    std::vector<const char*> wadFilePaths;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+        if ((std::strcmp(argv[argIdx], "-iterations") == 0) && (argIdx + 1 < argc)) {
+            numIterations = (uint32_t) std::max(std::atoi(argv[argIdx + 1]), 1);
+            ++argIdx;
+        } else {
+            wadFilePaths.push_back(argv[argIdx]);
+        }
+    }
+
+    if (wadFilePaths.empty()) {
+        std::printf("Usage: LzssBench [-iterations <NUM ITERATIONS>] <WAD FILE 1> [WAD FILE 2] ...\n");
+        std::printf("Example: LzssBench PSXDOOM.WAD MAP01.WAD MAP02.WAD\n");
+        return 1;
+    }
+
+    std::vector<TestLump> lumps;
+    size_t totalCompressedSize = 0;
+    size_t totalUncompressedSize = 0;
+
+    for (const char* const wadFilePath : wadFilePaths) {
+        if (!readCompressedLumps(wadFilePath, lumps))
+            return 1;
+    }
+
+    for (const TestLump& lump : lumps) {
+        totalCompressedSize += lump.compressedData.size();
+        totalUncompressedSize += (size_t) lump.uncompressedSize;
+    }
+
+    std::printf(
+        "%zu compressed lumps in %zu WAD files: %zu bytes compressed, %zu bytes uncompressed\n",
+        lumps.size(), wadFilePaths.size(), totalCompressedSize, totalUncompressedSize
+    );
+
+    if (lumps.empty())
+        return 1;
+
+    // Check the output of all decoders against the reference
+    const bool bAllMatched = verifyDecoders(lumps);
+    std::printf("Decoder output %s the reference decoder\n", (bAllMatched) ? "matches" : "DOES NOT MATCH");
+
+    if (!bAllMatched)
+        return 1;
+
+    // Time each of the decoders
+    std::printf("Timings for %u passes over all lumps:\n", numIterations);
+
+    timeDecoder("reference", lumps, numIterations, [](const TestLump& lump, uint8_t* const pOutput) noexcept {
+        referenceDecompress(lump.compressedData.data(), pOutput);
+        return lump.uncompressedSize;
+    });
+
+    timeDecoder("decompressLump", lumps, numIterations, [](const TestLump& lump, uint8_t* const pOutput) noexcept {
+        WadUtils::decompressLump(lump.compressedData.data(), pOutput);
+        return lump.uncompressedSize;
+    });
+
+    timeDecoder("decompressLumpChecked", lumps, numIterations, [](const TestLump& lump, uint8_t* const pOutput) noexcept {
+        return WadUtils::decompressLumpChecked(lump.compressedData.data(), (int32_t) lump.compressedData.size(), pOutput, lump.uncompressedSize);
+    });
+
+    timeDecoder("getDecompressedLumpSize", lumps, numIterations, [](const TestLump& lump, [[maybe_unused]] uint8_t* const pOutput) noexcept {
+        return WadUtils::getDecompressedLumpSize(lump.compressedData.data());
+    });
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// SpuBench:
+//      Microbenchmark and golden output test for the 'simple_spu' PlayStation SPU emulation.
+//      Runs a synthetic but representative workload (all voices looping or retriggering, reverb on, external input mixed) through
+//      the per-sample 'Spu::stepCore' path and the block based 'Spu::stepCoreBlock' path, with and without the SIMD decoding and
+//      interpolation routines. Verifies that the output of every path is bit-identical to the per-sample scalar path (the golden
+//      output) and reports the throughput of each in sample frames per second.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "Spu.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static constexpr uint32_t SPU_RAM_SIZE          = 2 * 1024 * 1024;      // How much SPU RAM the test cores have
+static constexpr uint32_t REVERB_AREA_SIZE      = 128 * 1024;           // Size of the reverb work area at the end of SPU RAM
+static constexpr uint32_t SOUND_NUM_BLOCKS      = 256;                  // How many ADPCM blocks are in each test sound
+static constexpr uint32_t CALLBACK_NUM_SAMPLES  = 512;                  // How many samples are requested at a time (like an audio callback does)
+static constexpr uint32_t DEFAULT_NUM_SAMPLES   = 44100 * 30;           // Default number of samples to generate: 30 seconds of audio
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Simple deterministic random number generator, so that both test cores get exactly the same input
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Rng {
+    uint32_t state;
+
+    uint32_t next() noexcept {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// External input source: generates a deterministic sawtooth wave, standing in for CD audio
+//------------------------------------------------------------------------------------------------------------------------------------------
+static Spu::StereoSample extInputCallback(void* pUserData) noexcept {
+    uint32_t& phase = *static_cast<uint32_t*>(pUserData);
+    phase += 0x00A0'0000u;
+    const int16_t sample = (int16_t)(phase >> 16);
+    return Spu::StereoSample{ sample, (int16_t)(sample / 2) };
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes a number of test sounds made from random ADPCM blocks into SPU RAM.
+// Even numbered sounds loop forever, odd numbered sounds end and silence the voice.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeTestSounds(Spu::Core& core, const uint32_t numSounds, Rng& rng) noexcept {
+    for (uint32_t soundIdx = 0; soundIdx < numSounds; ++soundIdx) {
+        std::byte* const pSound = core.pRam + soundIdx * SOUND_NUM_BLOCKS * Spu::ADPCM_BLOCK_SIZE;
+        const bool bLooped = ((soundIdx % 2) == 0);
+
+        for (uint32_t blockIdx = 0; blockIdx < SOUND_NUM_BLOCKS; ++blockIdx) {
+            std::byte* const pBlock = pSound + blockIdx * Spu::ADPCM_BLOCK_SIZE;
+            pBlock[0] = (std::byte) rng.next();     // Random filter and shift: includes the reserved values to test those too
+            pBlock[1] = {};
+
+            if (blockIdx == 0) {
+                pBlock[1] |= (std::byte) Spu::ADPCM_FLAG_LOOP_START;
+            }
+
+            if (blockIdx + 1 == SOUND_NUM_BLOCKS) {
+                pBlock[1] |= (std::byte) Spu::ADPCM_FLAG_LOOP_END;
+
+                if (bLooped) {
+                    pBlock[1] |= (std::byte) Spu::ADPCM_FLAG_REPEAT;
+                }
+            }
+
+            for (uint32_t i = 2; i < Spu::ADPCM_BLOCK_SIZE; ++i) {
+                pBlock[i] = (std::byte) rng.next();
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sets up a test SPU core with the given number of voices.
+// Cores created with the same random seed are identical.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void initTestCore(Spu::Core& core, const uint32_t numVoices, uint32_t& extInputPhase) noexcept {
+    Spu::initCore(core, SPU_RAM_SIZE, numVoices);
+
+    Rng rng = { 12345 };
+    writeTestSounds(core, numVoices, rng);
+
+    // Master settings, reverb (the 'Room' preset from the NO$PSX docs) and external input
+    core.masterVol = { 0x3FFF, 0x3FFF };
+    core.reverbVol = { 0x2000, 0x2000 };
+    core.extInputVol = { 0x1000, 0x1000 };
+    core.bUnmute = true;
+    core.bReverbWriteEnable = true;
+    core.bExtEnabled = true;
+    core.bExtReverbEnable = true;
+    core.pExtInputCallback = extInputCallback;
+    core.pExtInputUserData = &extInputPhase;
+    core.reverbBaseAddr8 = (SPU_RAM_SIZE - REVERB_AREA_SIZE) / 8;
+    core.reverbCurAddr = core.reverbBaseAddr8 * 8;
+    core.reverbRegs = {
+        0x007D, 0x005B, 0x6D80, 0x54B8, (int16_t) 0xBED0, 0x0000, 0x0000, (int16_t) 0xBA80, 0x5800, 0x5300,
+        0x04D6, 0x0333, 0x03F0, 0x0227, 0x0374, 0x01EF, 0x0334, 0x01B5, 0x0000, 0x0000, 0x0000, 0x0000,
+        0x0000, 0x0000, 0x0000, 0x0000, 0x01B4, 0x0136, 0x00B8, 0x005C, (int16_t) 0x8000, (int16_t) 0x8000
+    };
+
+    // Setup the voices: each plays it's own sound at a different pitch and volume
+    for (uint32_t voiceIdx = 0; voiceIdx < numVoices; ++voiceIdx) {
+        Spu::Voice& voice = core.pVoices[voiceIdx];
+        voice.adpcmStartAddr8 = (voiceIdx * SOUND_NUM_BLOCKS * Spu::ADPCM_BLOCK_SIZE) / 8;
+        voice.sampleRate = (uint16_t)(0x400 + rng.next() % 0x2000);
+        voice.volume = { (int16_t)(rng.next() % 0x3FFF), (int16_t)(rng.next() % 0x3FFF) };
+        voice.bDoReverb = ((voiceIdx % 3) != 0);
+        voice.env.attackShift = 8;
+        voice.env.decayShift = 6;
+        voice.env.sustainLevel = 10;
+        voice.env.sustainShift = 24;
+        voice.env.bSustainDec = true;
+        voice.env.releaseShift = 10;
+        Spu::keyOn(voice);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Key on voices which have finished playing, so that the workload stays constant.
+// This is done between audio callbacks, like the game would do.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void retriggerFinishedVoices(Spu::Core& core) noexcept {
+    for (uint32_t voiceIdx = 0; voiceIdx < core.numVoices; ++voiceIdx) {
+        Spu::Voice& voice = core.pVoices[voiceIdx];
+
+        if (voice.envPhase == Spu::EnvPhase::Off) {
+            Spu::keyOn(voice);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Generates the specified number of samples of output using either the per-sample or block SPU stepping path.
+// Returns the time taken in seconds.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static double generateOutput(Spu::Core& core, const bool bUseBlockPath, std::vector<Spu::StereoSample>& output) noexcept {
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const uint32_t numSamples = (uint32_t) output.size();
+
+    for (uint32_t startIdx = 0; startIdx < numSamples; startIdx += CALLBACK_NUM_SAMPLES) {
+        const uint32_t numCallbackSamples = std::min(numSamples - startIdx, CALLBACK_NUM_SAMPLES);
+        Spu::StereoSample* const pOutput = output.data() + startIdx;
+
+        if (bUseBlockPath) {
+            Spu::stepCoreBlock(core, pOutput, numCallbackSamples);
+        } else {
+            for (uint32_t i = 0; i < numCallbackSamples; ++i) {
+                pOutput[i] = Spu::stepCore(core);
+            }
+        }
+
+        retriggerFinishedVoices(core);
+    }
+
+    const auto endTime = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(endTime - startTime).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Runs one of the stepping paths for the given number of voices and compares it's output against the golden output (if given).
+// Returns 'true' if the output matched, or if there was no golden output to compare against.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool runPath(
+    const char* const pathName,
+    const uint32_t numVoices,
+    const bool bUseBlockPath,
+    const bool bUseSimd,
+    std::vector<Spu::StereoSample>& output,
+    std::vector<std::byte>& ram,
+    const std::vector<Spu::StereoSample>* const pGoldenOutput,
+    const std::vector<std::byte>* const pGoldenRam
+) noexcept {
+    Spu::Core core = {};
+    uint32_t extInputPhase = 0;
+    initTestCore(core, numVoices, extInputPhase);
+    core.bUseSimd = bUseSimd;
+
+    const double time = generateOutput(core, bUseBlockPath, output);
+    ram.assign(core.pRam, core.pRam + SPU_RAM_SIZE);
+    Spu::destroyCore(core);
+
+    bool bMatched = true;
+
+    if (pGoldenOutput && pGoldenRam) {
+        bMatched = (
+            (std::memcmp(output.data(), pGoldenOutput->data(), output.size() * sizeof(Spu::StereoSample)) == 0) &&
+            (ram == *pGoldenRam)
+        );
+    }
+
+    std::printf(
+        "%2u voices: %-22s %12.0f frames/s | %s\n",
+        numVoices,
+        pathName,
+        (double) output.size() / time,
+        (pGoldenOutput) ? ((bMatched) ? "matches golden output" : "MISMATCH!") : "golden output"
+    );
+
+    return bMatched;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Runs the benchmark for the given number of voices and returns 'true' if the output of all stepping paths matched
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool runBenchmark(const uint32_t numVoices, const uint32_t numSamples) noexcept {
+    std::vector<Spu::StereoSample> goldenOutput(numSamples);
+    std::vector<Spu::StereoSample> output(numSamples);
+    std::vector<std::byte> goldenRam;
+    std::vector<std::byte> ram;
+
+    bool bAllMatched = true;
+    runPath("stepCore (scalar)", numVoices, false, false, goldenOutput, goldenRam, nullptr, nullptr);
+    bAllMatched &= runPath("stepCoreBlock (scalar)", numVoices, true, false, output, ram, &goldenOutput, &goldenRam);
+
+    if (Spu::isSimdSupported()) {
+        bAllMatched &= runPath("stepCore (SIMD)", numVoices, false, true, output, ram, &goldenOutput, &goldenRam);
+        bAllMatched &= runPath("stepCoreBlock (SIMD)", numVoices, true, true, output, ram, &goldenOutput, &goldenRam);
+    }
+
+    return bAllMatched;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Program entrypoint
+//------------------------------------------------------------------------------------------------------------------------------------------
+int main(int argc, const char* const argv[]) noexcept {
+    // Optionally the number of samples to generate can be specified
+    uint32_t numSamples = DEFAULT_NUM_SAMPLES;
+
+    if (argc >= 2) {
+        numSamples = (uint32_t) std::strtoul(argv[1], nullptr, 10);
+
+        if (numSamples == 0) {
+            std::printf("Usage: SpuBench [NUM SAMPLES]\n");
+            return 1;
+        }
+    }
+
+    // Benchmark with the original PSX voice count and the limit removing voice count
+    bool bAllMatched = true;
+    bAllMatched &= runBenchmark(24, numSamples);
+    bAllMatched &= runBenchmark(64, numSamples);
+    return (bAllMatched) ? 0 : 1;
+}
@@ -0,0 +1,344 @@
+//------------------------------------------------------------------------------------------------------------------------------------------
+// ZoneBench:
+//      Benchmark and stress test for the game's zone memory allocator ('z_zone.cpp').
+//      Replays a trace of zone allocator calls recorded by the game (via the '-zonetrace' program argument) against a fresh zone heap,
+//      timing how long the replay takes and reporting on heap fragmentation at the end. Optionally checks heap integrity after every call.
+//      Traces recorded while playing back demos of big maps are a good test, since they contain lots of mobj and thinker churn.
+//      The '-checkfreed' option instead runs a regression check that freeing a block leaves its contents intact, which game code relies on.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#include "Doom/Base/z_zone.h"
+#include "FileUtils.h"
+#include "PsyDoom/ZoneTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+static constexpr uint32_t DEFAULT_NUM_ITERATIONS = 10;      // Default number of times to replay the trace when timing
+
+// Statistics for one replay of a trace
+struct ReplayStats {
+    uint32_t    numSkippedEvents;       // Events for blocks that were already purged (or unknown), which were ignored
+    int32_t     numBlocks;              // Heap state at the end of the replay: total number of blocks
+    int32_t     numFreeBlocks;          // Heap state at the end of the replay: number of free blocks (not merged)
+    int32_t     freeBytes;              // Heap state at the end of the replay: total free bytes
+    int32_t     largestFreeBlock;       // Heap state at the end of the replay: size of the largest run of free blocks (if merged)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Stand-ins for the game functions and settings used by the zone allocator
+//------------------------------------------------------------------------------------------------------------------------------------------
+[[noreturn]] void I_Error(const char* const fmtMsg, ...) noexcept {
+    std::va_list args;
+    va_start(args, fmtMsg);
+    std::printf("Zone allocator error: ");
+    std::vprintf(fmtMsg, args);
+    std::printf("\n");
+    va_end(args);
+    std::exit(1);
+}
+
+namespace Config {
+    int32_t gMainMemoryHeapSize = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the specified trace file, returning 'false' on failure
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readTrace(const char* const filePath, ZoneTrace::FileHeader& header, std::vector<ZoneTrace::Event>& events) noexcept {
+    const FileData fileData = FileUtils::getContentsOfFile(filePath);
+
+    if ((!fileData.bytes) || (fileData.size < sizeof(ZoneTrace::FileHeader))) {
+        std::printf("Failed to read trace file '%s'!\n", filePath);
+        return false;
+    }
+
+    std::memcpy(&header, fileData.bytes.get(), sizeof(header));
+
+    if ((std::memcmp(header.magic, ZoneTrace::FILE_MAGIC, sizeof(ZoneTrace::FILE_MAGIC)) != 0) || (header.version != ZoneTrace::FILE_VERSION)) {
+        std::printf("'%s' is not a zone trace file or is an unsupported version!\n", filePath);
+        return false;
+    }
+
+    // Read all the events which need to be replayed, sanity checking them so the replay doesn't need to.
+    // Purges and tic stats are skipped since they are not calls made by the game, and tic stats are followed by extra data.
+    size_t offset = sizeof(header);
+
+    while (offset + sizeof(ZoneTrace::Event) <= fileData.size) {
+        ZoneTrace::Event event = {};
+        std::memcpy(&event, fileData.bytes.get() + offset, sizeof(event));
+        offset += sizeof(event);
+
+        if ((event.type >= ZoneTrace::EventType::NUM_TYPES) || (event.size < 0)) {
+            std::printf("Trace file '%s' contains invalid events!\n", filePath);
+            return false;
+        }
+
+        if (event.type == ZoneTrace::EventType::TicStats) {
+            offset += (size_t) event.size;
+        }
+        else if (event.type != ZoneTrace::EventType::Purge) {
+            events.push_back(event);
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gathers statistics on the state of the specified zone heap
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void getHeapStats(const memzone_t& zone, ReplayStats& stats) noexcept {
+    int32_t curFreeRun = 0;
+
+    for (const memblock_t* pBlock = &zone.blocklist; pBlock; pBlock = pBlock->next) {
+        stats.numBlocks++;
+
+        if (!pBlock->user) {
+            stats.numFreeBlocks++;
+            stats.freeBytes += pBlock->size;
+            curFreeRun += pBlock->size;
+            stats.largestFreeBlock = std::max(stats.largestFreeBlock, curFreeRun);
+        } else {
+            curFreeRun = 0;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Replays the specified trace events against the given zone, optionally checking the heap after every event.
+// The given array of block pointers (indexed by block id) is used as the owner for blocks which have one.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static ReplayStats replayTrace(
+    memzone_t& zone,
+    const std::vector<ZoneTrace::Event>& events,
+    void** const pBlocks,
+    const bool bCheckHeap
+) noexcept {
+    ReplayStats stats = {};
+
+    for (const ZoneTrace::Event& event : events) {
+        // Allocations and 'FreeTags' don't need an existing block, everything else does.
+        // Note: blocks purged by the allocator will have had their pointers cleared, so events for them are skipped.
+        void** const ppBlock = &pBlocks[event.blockId];
+        void* const pBlock = *ppBlock;
+
+        switch (event.type) {
+            case ZoneTrace::EventType::Malloc:
+            case ZoneTrace::EventType::EndMalloc: {
+                void** const ppUser = (event.bHasUser) ? ppBlock : nullptr;
+                void* const pNewBlock = (event.type == ZoneTrace::EventType::Malloc) ?
+                    Z_Malloc(zone, event.size, event.tag, ppUser) :
+                    Z_EndMalloc(zone, event.size, event.tag, ppUser);
+
+                *ppBlock = pNewBlock;
+            }   break;
+
+            case ZoneTrace::EventType::FreeTags:
+                Z_FreeTags(zone, event.tag);
+                break;
+
+            default: {
+                if ((event.blockId == 0) || (!pBlock)) {
+                    stats.numSkippedEvents++;
+                    break;
+                }
+
+                if (event.type == ZoneTrace::EventType::Free) {
+                    Z_Free2(zone, pBlock);
+                    *ppBlock = nullptr;
+                }
+                else if (event.type == ZoneTrace::EventType::ChangeTag) {
+                    Z_ChangeTag(pBlock, event.tag);
+                }
+                else {
+                    Z_SetUser(pBlock, (event.bHasUser) ? ppBlock : nullptr);
+                }
+            }   break;
+        }
+
+        if (bCheckHeap) {
+            Z_CheckHeap(zone);
+        }
+    }
+
+    Z_CheckHeap(zone);
+    getHeapStats(zone, stats);
+    return stats;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Regression check for game code which reads memory after freeing it.
+// Simulates 'P_RunThinkers' as it was originally written: thinkers are freed while iterating the thinker list and the 'next' field of
+// each freed thinker is read afterwards. Freeing a block must leave its contents untouched for this to work, for every size of block.
+// Returns 'false' if the check fails.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool checkFreedBlocksIntact(const int32_t heapSize) noexcept {
+    // A stand-in for 'thinker_t', padded out by a varying amount so that blocks of all sizes are tested
+    struct Thinker {
+        Thinker*    next;
+        Thinker*    prev;
+        int32_t     bRemove;
+        int32_t     id;
+    };
+
+    std::unique_ptr<std::byte[]> heap(new std::byte[heapSize]);
+    gpMainMemZone = Z_InitZone(heap.get(), heapSize);
+
+    constexpr int32_t NUM_THINKERS = 1024;
+    constexpr int32_t NUM_PASSES = 4;
+
+    Thinker thinkerCap = {};
+    thinkerCap.next = &thinkerCap;
+    thinkerCap.prev = &thinkerCap;
+    int32_t numThinkers = 0;
+
+    for (int32_t passIdx = 0; passIdx < NUM_PASSES; ++passIdx) {
+        // Add thinkers of various sizes (which are re-using blocks freed in the previous pass) and mark some for removal
+        for (int32_t i = 0; i < NUM_THINKERS; ++i) {
+            const int32_t allocSize = (int32_t) sizeof(Thinker) + (i % 64) * 16;
+            Thinker& thinker = *(Thinker*) Z_Malloc(*gpMainMemZone, allocSize, PU_LEVEL, nullptr);
+            thinker.next = &thinkerCap;
+            thinker.prev = thinkerCap.prev;
+            thinker.bRemove = ((i + passIdx) % 3 != 0);
+            thinker.id = passIdx * NUM_THINKERS + i;
+            thinkerCap.prev->next = &thinker;
+            thinkerCap.prev = &thinker;
+            numThinkers++;
+        }
+
+        // Run the thinkers, reading the next thinker from freed thinkers like the original 'P_RunThinkers' did
+        int32_t numVisited = 0;
+        int32_t numRemaining = 0;
+
+        for (Thinker* pThinker = thinkerCap.next; pThinker != &thinkerCap; pThinker = pThinker->next) {
+            const Thinker thinkerBeforeFree = *pThinker;
+            numVisited++;
+
+            if (pThinker->bRemove) {
+                pThinker->next->prev = pThinker->prev;
+                pThinker->prev->next = pThinker->next;
+                Z_Free2(*gpMainMemZone, pThinker);
+
+                if (std::memcmp(pThinker, &thinkerBeforeFree, sizeof(Thinker)) != 0) {
+                    std::printf("Check failed: freeing thinker %d modified its contents!\n", thinkerBeforeFree.id);
+                    return false;
+                }
+            } else {
+                numRemaining++;
+            }
+        }
+
+        if (numVisited != numThinkers) {
+            std::printf("Check failed: visited %d thinkers out of %d in pass %d!\n", numVisited, numThinkers, passIdx);
+            return false;
+        }
+
+        numThinkers = numRemaining;
+        Z_CheckHeap(*gpMainMemZone);
+    }
+
+    gpMainMemZone = nullptr;
+    return true;
+}
+
+int main(int argc, const char* const argv[]) noexcept {
+    // Parse the command line
+    uint32_t numIterations = DEFAULT_NUM_ITERATIONS;
+    int32_t heapSizeOverride = 0;
+    bool bCheckHeap = false;
+    bool bCheckFreed = false;
+    const char* traceFilePath = nullptr;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+        if ((std::strcmp(argv[argIdx], "-iterations") == 0) && (argIdx + 1 < argc)) {
+            numIterations = (uint32_t) std::max(std::atoi(argv[argIdx + 1]), 1);
+            ++argIdx;
+        }
+        else if ((std::strcmp(argv[argIdx], "-heapsize") == 0) && (argIdx + 1 < argc)) {
+            heapSizeOverride = std::max(std::atoi(argv[argIdx + 1]), 0);
+            ++argIdx;
+        }
+        else if (std::strcmp(argv[argIdx], "-checkheap") == 0) {
+            bCheckHeap = true;
+        }
+        else if (std::strcmp(argv[argIdx], "-checkfreed") == 0) {
+            bCheckFreed = true;
+        }
+        else {
+            traceFilePath = argv[argIdx];
+        }
+    }
+
+    if (bCheckFreed) {
+        const int32_t heapSize = (heapSizeOverride > 0) ? heapSizeOverride : 4 * 1024 * 1024;
+
+        if (!checkFreedBlocksIntact(heapSize))
+            return 1;
+
+        std::printf("Check passed: freed blocks are left intact\n");
+        return 0;
+    }
+
+    if (!traceFilePath) {
+        std::printf("Usage: ZoneBench [-iterations <NUM ITERATIONS>] [-heapsize <HEAP SIZE BYTES>] [-checkheap] <TRACE FILE>\n");
+        std::printf("       ZoneBench [-heapsize <HEAP SIZE BYTES>] -checkfreed\n");
+        std::printf("Record a trace file by running PsyDoom with '-zonetrace <TRACE FILE>', e.g while playing back a demo.\n");
+        std::printf("Use '-checkheap' to check the integrity of the heap after every allocator call (slow).\n");
+        std::printf("Use '-checkfreed' to check that freeing a block leaves its contents intact, which some game code relies on.\n");
+        return 1;
+    }
+
+    // Read the trace and figure out how many block ids it uses
+    ZoneTrace::FileHeader header = {};
+    std::vector<ZoneTrace::Event> events;
+
+    if (!readTrace(traceFilePath, header, events))
+        return 1;
+
+    uint32_t maxBlockId = 0;
+
+    for (const ZoneTrace::Event& event : events) {
+        maxBlockId = std::max(maxBlockId, event.blockId);
+    }
+
+    const int32_t heapSize = (heapSizeOverride > 0) ? heapSizeOverride : header.heapSize;
+    std::printf("Trace '%s': %zu events, %u blocks, heap size %d bytes\n", traceFilePath, events.size(), maxBlockId, heapSize);
+
+    if (header.bLimitRemoving != ((PSYDOOM_LIMIT_REMOVING) ? 1 : 0)) {
+        std::printf("Warning: the trace was recorded by a build with a different 'PSYDOOM_LIMIT_REMOVING' setting!\n");
+    }
+
+    // Replay the trace the requested number of times and report the timings and final heap state
+    std::unique_ptr<std::byte[]> heap(new std::byte[heapSize]);
+    std::unique_ptr<void*[]> blocks(new void*[maxBlockId + 1]);
+    ReplayStats stats = {};
+    double totalTime = 0;
+    double bestTime = 0;
+
+    for (uint32_t iterIdx = 0; iterIdx < numIterations; ++iterIdx) {
+        std::fill(blocks.get(), blocks.get() + maxBlockId + 1, nullptr);
+        gpMainMemZone = Z_InitZone(heap.get(), heapSize);
+
+        const auto startTime = std::chrono::steady_clock::now();
+        stats = replayTrace(*gpMainMemZone, events, blocks.get(), bCheckHeap);
+        const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        totalTime += time;
+        bestTime = (iterIdx == 0) ? time : std::min(bestTime, time);
+    }
+
+    const double avgTime = totalTime / numIterations;
+    std::printf("Replay (%u iterations%s):\n", numIterations, (bCheckHeap) ? ", checking heap after every call" : "");
+    std::printf("  Average time:        %.3f ms (%.1f ns per call)\n", avgTime * 1000.0, (avgTime * 1e9) / std::max<size_t>(events.size(), 1));
+    std::printf("  Best time:           %.3f ms (%.1f ns per call)\n", bestTime * 1000.0, (bestTime * 1e9) / std::max<size_t>(events.size(), 1));
+    std::printf("  Skipped events:      %u (block purged by the allocator)\n", stats.numSkippedEvents);
+    std::printf("  Final heap blocks:   %d (%d free)\n", stats.numBlocks, stats.numFreeBlocks);
+    std::printf("  Final free memory:   %d bytes (largest free run %d bytes)\n", stats.freeBytes, stats.largestFreeBlock);
+    return 0;
+}
@@ -41,6 +41,7 @@ LogicalDevice::LogicalDevice(VkFuncs& vkFuncs) noexcept
     , mRingbufferMgr()
     , mRetirementMgr()
     , mTransferMgr()
+    , mPipelineCache()
     , mCmdBufferSubmitHelpers()
 {
 }
@@ -118,6 +119,7 @@ void LogicalDevice::destroy(const bool bForceIfInvalid) noexcept {
     waitUntilDeviceIdle();
 
     // Cleanup main objects
+    mPipelineCache.destroy();
     mTransferMgr.destroy();
     mRetirementMgr.destroy();
     mRingbufferMgr.destroy();
@@ -2,6 +2,7 @@
 
 #include "CmdPool.h"
 #include "DeviceMemMgr.h"
+#include "PipelineCache.h"
 #include "RetirementMgr.h"
 #include "RingbufferMgr.h"
 #include "TransferMgr.h"
@@ -49,6 +50,7 @@ public:
     inline RetirementMgr& getRetirementMgr() noexcept { return mRetirementMgr; }
     inline TransferMgr& getTransferMgr() noexcept { return mTransferMgr; }
     inline CmdPool& getCmdPool() noexcept { return mCmdPool; }
+    inline PipelineCache& getPipelineCache() noexcept { return mPipelineCache; }
 
     bool submitCmdBuffer(
         const CmdBuffer& cmdBuffer,
@@ -92,6 +94,7 @@ private:
     RingbufferMgr           mRingbufferMgr;                 // Keeps track of which ringbuffer we are on and holds sync primitives for ringbuffers
     RetirementMgr           mRetirementMgr;                 // Manages the retirement of resources that may be in used by currently processing frames
     TransferMgr             mTransferMgr;                   // Used for managing transfers to GPU memory
+    PipelineCache           mPipelineCache;                 // Used for all pipeline creation if initialized by the application, otherwise no pipeline cache is used
 
     // Temporary buffers used during command buffer submit.
     // These are re-used for each submit.
@@ -3,6 +3,7 @@
 #include "Finally.h"
 #include "LogicalDevice.h"
 #include "PhysicalDevice.h"
+#include "PipelineCache.h"
 #include "PipelineLayout.h"
 #include "RenderPass.h"
 #include "RetirementMgr.h"
@@ -258,8 +259,9 @@ bool Pipeline::initGraphicsPipeline(
     pipelineCI.basePipelineIndex = -1;                  // Used when creating derived pipelines
 
     const VkFuncs& vkFuncs = device.getVkFuncs();
+    const VkPipelineCache vkPipelineCache = device.getPipelineCache().getVkPipelineCache();
 
-    if (vkFuncs.vkCreateGraphicsPipelines(device.getVkDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mVkPipeline) != VK_SUCCESS) {
+    if (vkFuncs.vkCreateGraphicsPipelines(device.getVkDevice(), vkPipelineCache, 1, &pipelineCI, nullptr, &mVkPipeline) != VK_SUCCESS) {
         ASSERT_FAIL("Failed to create a graphics pipeline!");
         return false;
     }
@@ -319,8 +321,9 @@ bool Pipeline::initComputePipeline(
     pipelineCI.basePipelineIndex = -1;                  // Used when creating derived pipelines
 
     const VkFuncs& vkFuncs = device.getVkFuncs();
+    const VkPipelineCache vkPipelineCache = device.getPipelineCache().getVkPipelineCache();
 
-    if (vkFuncs.vkCreateComputePipelines(device.getVkDevice(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mVkPipeline) != VK_SUCCESS) {
+    if (vkFuncs.vkCreateComputePipelines(device.getVkDevice(), vkPipelineCache, 1, &pipelineCI, nullptr, &mVkPipeline) != VK_SUCCESS) {
         ASSERT_FAIL("Failed to create a compute pipeline!");
         return false;
     }
@@ -0,0 +1,232 @@
+#include "PipelineCache.h"
+
+#include "Finally.h"
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "VkFuncs.h"
+
+#include <cstring>
+
+BEGIN_NAMESPACE(vgl)
+
+// Identifies saved pipeline cache data
+static constexpr char DATA_MAGIC[8] = { 'V', 'G', 'L', 'P', 'C', 'A', 'C', 'H' };
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Header for saved pipeline cache data; the data returned by the driver immediately follows this.
+// The driver data has a header of it's own which identifies the device, but it doesn't include the driver version. Pipeline cache data
+// from an older driver is usually just ignored by the new driver but some drivers are known to misbehave, so check the version here also.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct DataHeader {
+    char        magic[8];                               // Should be 'DATA_MAGIC'
+    uint32_t    vendorId;                               // Which device vendor and device the data is for
+    uint32_t    deviceId;
+    uint32_t    driverVersion;                          // Which driver version the data is for
+    uint8_t     pipelineCacheUuid[VK_UUID_SIZE];        // Identifies the pipeline cache format used by the driver
+    uint32_t    driverDataSize;                         // Size of the driver data following the header
+    uint32_t    driverDataChecksum;                     // Checksum of the driver data following the header, for catching corruption
+};
+
+static_assert(sizeof(DataHeader) == 44);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Computes a checksum for pipeline cache data (32-bit FNV-1a hash)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t computeChecksum(const std::byte* const pData, const size_t size) noexcept {
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (uint32_t) pData[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes a header for pipeline cache data belonging to the specified device
+//------------------------------------------------------------------------------------------------------------------------------------------
+static DataHeader makeDataHeader(const PhysicalDevice& physicalDevice) noexcept {
+    const VkPhysicalDeviceProperties& props = physicalDevice.getProps();
+
+    DataHeader hdr = {};
+    std::memcpy(hdr.magic, DATA_MAGIC, sizeof(DATA_MAGIC));
+    hdr.vendorId = props.vendorID;
+    hdr.deviceId = props.deviceID;
+    hdr.driverVersion = props.driverVersion;
+    std::memcpy(hdr.pipelineCacheUuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+    return hdr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Creates an uninitialized pipeline cache
+//------------------------------------------------------------------------------------------------------------------------------------------
+PipelineCache::PipelineCache() noexcept
+    : mbIsValid(false)
+    , mbUsedInitialData(false)
+    , mpDevice(nullptr)
+    , mVkPipelineCache(VK_NULL_HANDLE)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Automatically destroys the pipeline cache
+//------------------------------------------------------------------------------------------------------------------------------------------
+PipelineCache::~PipelineCache() noexcept {
+    destroy();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Initializes the pipeline cache, optionally using data previously saved with 'getData()'.
+// If the initial data is not valid for the current device then it is ignored and the cache starts out empty.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool PipelineCache::init(LogicalDevice& device, const std::byte* const pInitialData, const size_t initialDataSize) noexcept {
+    // Preconditions
+    ASSERT_LOG((!mbIsValid), "Must call destroy() before re-initializing!");
+    ASSERT(device.getVkDevice());
+    ASSERT(device.getPhysicalDevice());
+
+    // If anything goes wrong, cleanup on exit - don't half initialize!
+    auto cleanupOnError = finally([&]{
+        if (!mbIsValid) {
+            destroy(true);
+        }
+    });
+
+    // Save for future reference
+    mpDevice = &device;
+
+    // Create the pipeline cache, using the initial data only if it's valid for this device
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (isInitialDataValid(pInitialData, initialDataSize)) {
+        createInfo.initialDataSize = initialDataSize - sizeof(DataHeader);
+        createInfo.pInitialData = pInitialData + sizeof(DataHeader);
+    }
+
+    const VkFuncs& vkFuncs = device.getVkFuncs();
+
+    if (vkFuncs.vkCreatePipelineCache(device.getVkDevice(), &createInfo, nullptr, &mVkPipelineCache) != VK_SUCCESS) {
+        ASSERT_FAIL("Failed to create a Vulkan pipeline cache!");
+        return false;
+    }
+
+    // Success!
+    mbUsedInitialData = (createInfo.initialDataSize > 0);
+    mbIsValid = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Destroys the pipeline cache and releases its resources
+//------------------------------------------------------------------------------------------------------------------------------------------
+void PipelineCache::destroy(const bool bForceIfInvalid) noexcept {
+    // Only destroy if we need to
+    if ((!mbIsValid) && (!bForceIfInvalid))
+        return;
+
+    // Preconditions
+    ASSERT_LOG((!mpDevice) || mpDevice->getVkDevice(), "Parent device must still be valid if defined!");
+
+    // Cleanup and destroy the Vulkan pipeline cache
+    mbIsValid = false;
+
+    if (mVkPipelineCache) {
+        ASSERT(mpDevice && mpDevice->getVkDevice());
+        const VkFuncs& vkFuncs = mpDevice->getVkFuncs();
+        vkFuncs.vkDestroyPipelineCache(mpDevice->getVkDevice(), mVkPipelineCache, nullptr);
+        mVkPipelineCache = VK_NULL_HANDLE;
+    }
+
+    mbUsedInitialData = false;
+    mpDevice = nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the current contents of the pipeline cache in a form that can be saved and used to initialize the cache again later.
+// Returns 'false' on failure.
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool PipelineCache::getData(std::vector<std::byte>& dataOut) const noexcept {
+    ASSERT(mbIsValid);
+    dataOut.clear();
+
+    // Ask the driver how much data there is and then retrieve it
+    const VkFuncs& vkFuncs = mpDevice->getVkFuncs();
+    const VkDevice vkDevice = mpDevice->getVkDevice();
+    size_t driverDataSize = 0;
+
+    if (vkFuncs.vkGetPipelineCacheData(vkDevice, mVkPipelineCache, &driverDataSize, nullptr) != VK_SUCCESS)
+        return false;
+
+    if (driverDataSize > UINT32_MAX)
+        return false;
+
+    dataOut.resize(sizeof(DataHeader) + driverDataSize);
+
+    if (vkFuncs.vkGetPipelineCacheData(vkDevice, mVkPipelineCache, &driverDataSize, dataOut.data() + sizeof(DataHeader)) != VK_SUCCESS) {
+        dataOut.clear();
+        return false;
+    }
+
+    // Note: the driver is allowed to return less data than it originally said it would
+    dataOut.resize(sizeof(DataHeader) + driverDataSize);
+
+    // Fill in the header identifying the device and driver
+    DataHeader hdr = makeDataHeader(*mpDevice->getPhysicalDevice());
+    hdr.driverDataSize = (uint32_t) driverDataSize;
+    hdr.driverDataChecksum = computeChecksum(dataOut.data() + sizeof(DataHeader), driverDataSize);
+    std::memcpy(dataOut.data(), &hdr, sizeof(DataHeader));
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the given previously saved pipeline cache data can be used with the current device
+//------------------------------------------------------------------------------------------------------------------------------------------
+bool PipelineCache::isInitialDataValid(const std::byte* const pInitialData, const size_t initialDataSize) const noexcept {
+    // Must at least have the header, and some driver data which the header describes
+    if ((!pInitialData) || (initialDataSize <= sizeof(DataHeader)))
+        return false;
+
+    DataHeader hdr;
+    std::memcpy(&hdr, pInitialData, sizeof(DataHeader));
+
+    const std::byte* const pDriverData = pInitialData + sizeof(DataHeader);
+    const size_t driverDataSize = initialDataSize - sizeof(DataHeader);
+
+    if ((hdr.driverDataSize != driverDataSize) || (hdr.driverDataChecksum != computeChecksum(pDriverData, driverDataSize)))
+        return false;
+
+    // Must be for the same device, driver version and pipeline cache format
+    DataHeader expectedHdr = makeDataHeader(*mpDevice->getPhysicalDevice());
+    expectedHdr.driverDataSize = hdr.driverDataSize;
+    expectedHdr.driverDataChecksum = hdr.driverDataChecksum;
+
+    if (std::memcmp(&hdr, &expectedHdr, sizeof(DataHeader)) != 0)
+        return false;
+
+    // Also check the header written by the driver agrees (see 'VkPipelineCacheHeaderVersionOne' in the Vulkan spec)
+    struct DriverDataHeader {
+        uint32_t    headerSize;
+        uint32_t    headerVersion;
+        uint32_t    vendorId;
+        uint32_t    deviceId;
+        uint8_t     pipelineCacheUuid[VK_UUID_SIZE];
+    };
+
+    if (driverDataSize < sizeof(DriverDataHeader))
+        return false;
+
+    DriverDataHeader driverHdr;
+    std::memcpy(&driverHdr, pDriverData, sizeof(DriverDataHeader));
+
+    return (
+        (driverHdr.headerSize >= sizeof(DriverDataHeader)) &&
+        (driverHdr.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE) &&
+        (driverHdr.vendorId == hdr.vendorId) &&
+        (driverHdr.deviceId == hdr.deviceId) &&
+        (std::memcmp(driverHdr.pipelineCacheUuid, hdr.pipelineCacheUuid, VK_UUID_SIZE) == 0)
+    );
+}
+
+END_NAMESPACE(vgl)
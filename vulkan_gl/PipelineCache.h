@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Macros.h"
+
+#include <cstddef>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+BEGIN_NAMESPACE(vgl)
+
+class LogicalDevice;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Represents a Vulkan pipeline cache.
+//
+// A pipeline cache lets the driver reuse the results of previous pipeline compiles, and its contents can be saved to disk so that they
+// can be reused across runs of the application. The logical device owns a pipeline cache which is used for all pipeline creation.
+//
+// When the cache is initialized with previously saved data, the data is checked against the current device first. Data from a different
+// device or driver version (or which has been corrupted) is discarded and the cache starts out empty instead.
+//------------------------------------------------------------------------------------------------------------------------------------------
+class PipelineCache {
+public:
+    PipelineCache() noexcept;
+    ~PipelineCache() noexcept;
+
+    bool init(LogicalDevice& device, const std::byte* const pInitialData, const size_t initialDataSize) noexcept;
+    void destroy(const bool bForceIfInvalid = false) noexcept;
+    bool getData(std::vector<std::byte>& dataOut) const noexcept;
+
+    inline bool isValid() const noexcept { return mbIsValid; }
+    inline bool usedInitialData() const noexcept { return mbUsedInitialData; }
+    inline LogicalDevice* getDevice() const noexcept { return mpDevice; }
+    inline VkPipelineCache getVkPipelineCache() const noexcept { return mVkPipelineCache; }
+
+private:
+    // Copy and move disallowed
+    PipelineCache(const PipelineCache& other) = delete;
+    PipelineCache(PipelineCache&& other) = delete;
+    PipelineCache& operator = (const PipelineCache& other) = delete;
+    PipelineCache& operator = (PipelineCache&& other) = delete;
+
+    bool isInitialDataValid(const std::byte* const pInitialData, const size_t initialDataSize) const noexcept;
+
+    bool                mbIsValid;
+    bool                mbUsedInitialData;      // True if the cache was created using previously saved data
+    LogicalDevice*      mpDevice;
+    VkPipelineCache     mVkPipelineCache;
+};
+
+END_NAMESPACE(vgl)
@@ -180,6 +180,7 @@ void VkFuncs::loadDeviceFuncs(const VkDevice vkDevice) noexcept {
     LOAD_DEV_FUNC(vkCreateGraphicsPipelines);
     LOAD_DEV_FUNC(vkCreateImage);
     LOAD_DEV_FUNC(vkCreateImageView);
+    LOAD_DEV_FUNC(vkCreatePipelineCache);
     LOAD_DEV_FUNC(vkCreatePipelineLayout);
     LOAD_DEV_FUNC(vkCreateRenderPass);
     LOAD_DEV_FUNC(vkCreateSampler);
@@ -195,6 +196,7 @@ void VkFuncs::loadDeviceFuncs(const VkDevice vkDevice) noexcept {
     LOAD_DEV_FUNC(vkDestroyImage);
     LOAD_DEV_FUNC(vkDestroyImageView);
     LOAD_DEV_FUNC(vkDestroyPipeline);
+    LOAD_DEV_FUNC(vkDestroyPipelineCache);
     LOAD_DEV_FUNC(vkDestroyPipelineLayout);
     LOAD_DEV_FUNC(vkDestroyRenderPass);
     LOAD_DEV_FUNC(vkDestroySampler);
@@ -209,6 +211,7 @@ void VkFuncs::loadDeviceFuncs(const VkDevice vkDevice) noexcept {
     LOAD_DEV_FUNC(vkGetDeviceQueue);
     LOAD_DEV_FUNC(vkGetFenceStatus);
     LOAD_DEV_FUNC(vkGetImageMemoryRequirements);
+    LOAD_DEV_FUNC(vkGetPipelineCacheData);
     LOAD_DEV_FUNC(vkGetSwapchainImagesKHR);
     LOAD_DEV_FUNC(vkMapMemory);
     LOAD_DEV_FUNC(vkQueuePresentKHR);
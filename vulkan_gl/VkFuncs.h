@@ -88,6 +88,7 @@ struct VkFuncs {
     DEFINE_VK_FUNC(vkCreateGraphicsPipelines)
     DEFINE_VK_FUNC(vkCreateImage)
     DEFINE_VK_FUNC(vkCreateImageView)
+    DEFINE_VK_FUNC(vkCreatePipelineCache)
     DEFINE_VK_FUNC(vkCreatePipelineLayout)
     DEFINE_VK_FUNC(vkCreateRenderPass)
     DEFINE_VK_FUNC(vkCreateSampler)
@@ -103,6 +104,7 @@ struct VkFuncs {
     DEFINE_VK_FUNC(vkDestroyImage)
     DEFINE_VK_FUNC(vkDestroyImageView)
     DEFINE_VK_FUNC(vkDestroyPipeline)
+    DEFINE_VK_FUNC(vkDestroyPipelineCache)
     DEFINE_VK_FUNC(vkDestroyPipelineLayout)
     DEFINE_VK_FUNC(vkDestroyRenderPass)
     DEFINE_VK_FUNC(vkDestroySampler)
@@ -117,6 +119,7 @@ struct VkFuncs {
     DEFINE_VK_FUNC(vkGetDeviceQueue)
     DEFINE_VK_FUNC(vkGetFenceStatus)
     DEFINE_VK_FUNC(vkGetImageMemoryRequirements)
+    DEFINE_VK_FUNC(vkGetPipelineCacheData)
     DEFINE_VK_FUNC(vkGetSwapchainImagesKHR)
     DEFINE_VK_FUNC(vkMapMemory)
     DEFINE_VK_FUNC(vkQueuePresentKHR)